@@ -0,0 +1,188 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * App-layer parsers on canned inputs.
+ *
+ * Each run parses a request and its response on a new flow, cleans up the
+ * transactions and frees the flow and the parser state.
+ */
+
+#include "suricata-common.h"
+#include "app-layer-parser.h"
+#include "flow-util.h"
+#include "stream-tcp-private.h"
+
+#include "bench.h"
+
+typedef struct BenchAppLayerCtx_ {
+    AppLayerParserThreadCtx *alp_tctx;
+    TcpSession ssn;
+    AppProto alproto;
+    uint8_t proto;
+    const uint8_t *ts;
+    uint32_t ts_len;
+    const uint8_t *tc;
+    uint32_t tc_len;
+} BenchAppLayerCtx;
+
+static const char bench_http_request[] = "GET /index.php?id=1&lang=en HTTP/1.1\r\n"
+                                         "Host: www.example.com\r\n"
+                                         "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) "
+                                         "Gecko/20100101 Firefox/128.0\r\n"
+                                         "Accept: text/html,application/xhtml+xml\r\n"
+                                         "Accept-Encoding: gzip, deflate\r\n"
+                                         "Cookie: session=0123456789abcdef\r\n"
+                                         "Connection: keep-alive\r\n"
+                                         "\r\n";
+
+static const char bench_http_response_header[] = "HTTP/1.1 200 OK\r\n"
+                                                 "Server: nginx\r\n"
+                                                 "Content-Type: text/html\r\n"
+                                                 "Content-Length: 1024\r\n"
+                                                 "Connection: keep-alive\r\n"
+                                                 "\r\n";
+
+/* www.example.com IN A, query and response */
+static const uint8_t bench_dns_request[] = { 0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x03, 'w', 'w', 'w', 0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x03,
+    'c', 'o', 'm', 0x00, 0x00, 0x01, 0x00, 0x01 };
+static const uint8_t bench_dns_response[] = { 0x12, 0x34, 0x81, 0x80, 0x00, 0x01, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0x00, 0x03, 'w', 'w', 'w', 0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x03,
+    'c', 'o', 'm', 0x00, 0x00, 0x01, 0x00, 0x01, 0xc0, 0x0c, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00,
+    0x01, 0x2c, 0x00, 0x04, 0x5d, 0xb8, 0xd7, 0x0e };
+
+static void BenchAppLayerRun(void *data)
+{
+    BenchAppLayerCtx *ctx = data;
+    Flow *f = FlowAlloc();
+    if (f == NULL)
+        FatalError("failed to allocate a flow");
+    f->flags |= FLOW_IPV4;
+    f->proto = ctx->proto;
+    f->protomap = FlowGetProtoMapping(ctx->proto);
+    f->alproto = ctx->alproto;
+    if (ctx->proto == IPPROTO_TCP) {
+        memset(&ctx->ssn, 0, sizeof(ctx->ssn));
+        f->protoctx = &ctx->ssn;
+    }
+
+    FLOWLOCK_WRLOCK(f);
+    (void)AppLayerParserParse(NULL, ctx->alp_tctx, f, ctx->alproto, STREAM_TOSERVER | STREAM_START,
+            ctx->ts, ctx->ts_len);
+    if (ctx->tc_len > 0) {
+        (void)AppLayerParserParse(NULL, ctx->alp_tctx, f, ctx->alproto,
+                STREAM_TOCLIENT | STREAM_START, ctx->tc, ctx->tc_len);
+    }
+    AppLayerParserTransactionsCleanup(f, STREAM_TOSERVER);
+    AppLayerParserTransactionsCleanup(f, STREAM_TOCLIENT);
+    FLOWLOCK_UNLOCK(f);
+
+    f->protoctx = NULL;
+    FlowFree(f);
+}
+
+/** \brief TLS 1.2 style ClientHello with SNI, as sent by most clients */
+static uint32_t BenchAppLayerClientHello(uint8_t *buf, uint32_t size)
+{
+    static const char sni[] = "www.example.com";
+    static const uint8_t suites[] = { 0x13, 0x01, 0x13, 0x02, 0x13, 0x03, 0xc0, 0x2b, 0xc0, 0x2f,
+        0xc0, 0x2c, 0xc0, 0x30, 0xcc, 0xa9, 0xcc, 0xa8, 0x00, 0x9c, 0x00, 0x9d };
+    const uint16_t sni_len = (uint16_t)strlen(sni);
+    const uint16_t ext_len = (uint16_t)(4 + 2 + 3 + sni_len);
+    const uint32_t hs_len = (uint32_t)(2 + 32 + 1 + 2 + sizeof(suites) + 2 + 2 + ext_len);
+    const uint32_t rec_len = 4 + hs_len;
+    BUG_ON(5 + rec_len > size);
+
+    uint32_t o = 0;
+    buf[o++] = 0x16; /* handshake */
+    buf[o++] = 0x03;
+    buf[o++] = 0x01;
+    buf[o++] = (uint8_t)(rec_len >> 8);
+    buf[o++] = (uint8_t)rec_len;
+    buf[o++] = 0x01; /* client hello */
+    buf[o++] = 0;
+    buf[o++] = (uint8_t)(hs_len >> 8);
+    buf[o++] = (uint8_t)hs_len;
+    buf[o++] = 0x03;
+    buf[o++] = 0x03;
+    BenchRandomFill(buf + o, 32);
+    o += 32;
+    buf[o++] = 0; /* session id */
+    buf[o++] = 0;
+    buf[o++] = (uint8_t)sizeof(suites);
+    memcpy(buf + o, suites, sizeof(suites));
+    o += sizeof(suites);
+    buf[o++] = 1; /* compression: null */
+    buf[o++] = 0;
+    buf[o++] = (uint8_t)(ext_len >> 8);
+    buf[o++] = (uint8_t)ext_len;
+    /* server_name */
+    buf[o++] = 0;
+    buf[o++] = 0;
+    buf[o++] = (uint8_t)((2 + 3 + sni_len) >> 8);
+    buf[o++] = (uint8_t)(2 + 3 + sni_len);
+    buf[o++] = (uint8_t)((3 + sni_len) >> 8);
+    buf[o++] = (uint8_t)(3 + sni_len);
+    buf[o++] = 0; /* host_name */
+    buf[o++] = (uint8_t)(sni_len >> 8);
+    buf[o++] = (uint8_t)sni_len;
+    memcpy(buf + o, sni, sni_len);
+    o += sni_len;
+    return o;
+}
+
+void BenchAppLayer(void)
+{
+    BenchAppLayerCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.alp_tctx = AppLayerParserThreadCtxAlloc();
+    if (ctx.alp_tctx == NULL)
+        FatalError("failed to allocate the app-layer parser thread ctx");
+
+    uint8_t http_response[sizeof(bench_http_response_header) - 1 + 1024];
+    memcpy(http_response, bench_http_response_header, sizeof(bench_http_response_header) - 1);
+    memset(http_response + sizeof(bench_http_response_header) - 1, 'x', 1024);
+    ctx.alproto = ALPROTO_HTTP1;
+    ctx.proto = IPPROTO_TCP;
+    ctx.ts = (const uint8_t *)bench_http_request;
+    ctx.ts_len = sizeof(bench_http_request) - 1;
+    ctx.tc = http_response;
+    ctx.tc_len = sizeof(http_response);
+    BenchRun("applayer", "http1", ctx.ts_len + ctx.tc_len, 1, BenchAppLayerRun, &ctx);
+
+    ctx.alproto = ALPROTO_DNS;
+    ctx.proto = IPPROTO_UDP;
+    ctx.ts = bench_dns_request;
+    ctx.ts_len = sizeof(bench_dns_request);
+    ctx.tc = bench_dns_response;
+    ctx.tc_len = sizeof(bench_dns_response);
+    BenchRun("applayer", "dns-udp", ctx.ts_len + ctx.tc_len, 1, BenchAppLayerRun, &ctx);
+
+    uint8_t client_hello[512];
+    ctx.alproto = ALPROTO_TLS;
+    ctx.proto = IPPROTO_TCP;
+    ctx.ts = client_hello;
+    ctx.ts_len = BenchAppLayerClientHello(client_hello, sizeof(client_hello));
+    ctx.tc = NULL;
+    ctx.tc_len = 0;
+    BenchRun("applayer", "tls-client-hello", ctx.ts_len, 1, BenchAppLayerRun, &ctx);
+
+    AppLayerParserThreadCtxFree(ctx.alp_tctx);
+}
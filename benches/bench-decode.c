@@ -0,0 +1,81 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Decoder throughput, from the ethernet header down to the L4 header.
+ *
+ * Includes setting the packet data zero copy and recycling the packet,
+ * like a capture method does for each packet.
+ */
+
+#include "suricata-common.h"
+#include "decode.h"
+#include "packet.h"
+
+#include "bench.h"
+
+typedef struct BenchDecodeCtx_ {
+    Packet *p;
+    uint8_t frame[BENCH_FRAME_MAX];
+    uint32_t len;
+} BenchDecodeCtx;
+
+static void BenchDecodeRun(void *data)
+{
+    BenchDecodeCtx *ctx = data;
+    Packet *p = ctx->p;
+    (void)PacketSetData(p, ctx->frame, ctx->len);
+    (void)DecodeEthernet(
+            BenchThreadVars(), BenchDecodeThreadVars(), p, GET_PKT_DATA(p), GET_PKT_LEN(p));
+    PacketRecycle(p);
+}
+
+void BenchDecode(void)
+{
+    BenchDecodeCtx *ctx = SCCalloc(1, sizeof(*ctx));
+    if (ctx == NULL)
+        FatalError("failed to allocate the decode context");
+    ctx->p = PacketGetFromAlloc();
+    if (ctx->p == NULL)
+        FatalError("failed to allocate a packet");
+
+    uint8_t payload[1400];
+    BenchRandomFill(payload, sizeof(payload));
+    const uint32_t src = htonl(0x0a000001);
+    const uint32_t dst = htonl(0x0a000002);
+
+    ctx->len = BenchBuildIPv4(ctx->frame, false, IPPROTO_TCP, src, dst, 40000, 80, 1, payload, 64);
+    BenchRun("decode", "ipv4-tcp-64", ctx->len, 1, BenchDecodeRun, ctx);
+
+    ctx->len = BenchBuildIPv4(
+            ctx->frame, false, IPPROTO_TCP, src, dst, 40000, 80, 1, payload, sizeof(payload));
+    BenchRun("decode", "ipv4-tcp-1400", ctx->len, 1, BenchDecodeRun, ctx);
+
+    ctx->len = BenchBuildIPv4(ctx->frame, false, IPPROTO_UDP, src, dst, 40000, 53, 0, payload, 64);
+    BenchRun("decode", "ipv4-udp-64", ctx->len, 1, BenchDecodeRun, ctx);
+
+    ctx->len = BenchBuildIPv4(ctx->frame, true, IPPROTO_TCP, src, dst, 40000, 80, 1, payload, 64);
+    BenchRun("decode", "vlan-ipv4-tcp-64", ctx->len, 1, BenchDecodeRun, ctx);
+
+    ctx->len = BenchBuildIPv6(ctx->frame, IPPROTO_TCP, src, dst, 40000, 80, 1, payload, 64);
+    BenchRun("decode", "ipv6-tcp-64", ctx->len, 1, BenchDecodeRun, ctx);
+
+    PacketFree(ctx->p);
+    SCFree(ctx);
+}
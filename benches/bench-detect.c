@@ -0,0 +1,109 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Per packet detection with Detect(), through the generic variant and
+ * through the variant for the engine mode.
+ *
+ * The generic variant is used until DetectRunSelectProfile() is called,
+ * so it is benchmarked first. It checks the engine mode and does the
+ * multi-tenant checks for each packet. The rules don't match, so the
+ * packet can be inspected again without resetting it.
+ */
+
+#include "suricata-common.h"
+#include "decode.h"
+#include "detect.h"
+#include "detect-engine.h"
+#include "detect-engine-build.h"
+#include "detect-parse.h"
+
+#include "bench.h"
+
+typedef struct BenchDetectCtx_ {
+    DetectEngineCtx *de_ctx;
+    DetectEngineThreadCtx *det_ctx;
+    Packet *p;
+} BenchDetectCtx;
+
+static void BenchDetectRun(void *data)
+{
+    BenchDetectCtx *ctx = data;
+    (void)Detect(BenchThreadVars(), ctx->p, ctx->det_ctx);
+}
+
+static void BenchDetectSetupRules(DetectEngineCtx *de_ctx)
+{
+    char rule[256];
+    uint32_t sid = 1;
+    /* prefilter rules, inspected only if their pattern is found */
+    for (uint32_t i = 0; i < 100; i++) {
+        snprintf(rule, sizeof(rule),
+                "alert udp any any -> any 53 (content:\"bench-pattern-%04u\"; sid:%u;)", i, sid);
+        if (DetectEngineAppendSig(de_ctx, rule) == NULL)
+            FatalError("failed to load rule: %s", rule);
+        sid++;
+    }
+    /* rules without a pattern, inspected for each packet */
+    for (uint32_t i = 0; i < 10; i++) {
+        snprintf(rule, sizeof(rule), "alert udp any any -> any 53 (dsize:>%u; sid:%u;)",
+                2000 + i, sid);
+        if (DetectEngineAppendSig(de_ctx, rule) == NULL)
+            FatalError("failed to load rule: %s", rule);
+        sid++;
+    }
+    if (SigGroupBuild(de_ctx) != 0)
+        FatalError("failed to build the rule groups");
+}
+
+void BenchDetect(void)
+{
+    BenchDetectCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+
+    ctx.de_ctx = DetectEngineCtxInit();
+    if (ctx.de_ctx == NULL)
+        FatalError("failed to set up the detection engine");
+    ctx.de_ctx->flags |= DE_QUIET;
+    BenchDetectSetupRules(ctx.de_ctx);
+    if (DetectEngineThreadCtxInit(BenchThreadVars(), ctx.de_ctx, (void **)&ctx.det_ctx) !=
+            TM_ECODE_OK)
+        FatalError("failed to set up the detection thread");
+
+    uint8_t payload[64];
+    BenchRandomFill(payload, sizeof(payload));
+    uint8_t frame[BENCH_FRAME_MAX];
+    const uint32_t len = BenchBuildIPv4(frame, false, IPPROTO_UDP, htonl(0x0a000001),
+            htonl(0x0a000002), 40000, 53, 0, payload, sizeof(payload));
+    ctx.p = PacketGetFromAlloc();
+    if (ctx.p == NULL)
+        FatalError("failed to allocate a packet");
+    if (PacketCopyData(ctx.p, frame, len) != 0)
+        FatalError("failed to copy the packet data");
+    (void)DecodeEthernet(
+            BenchThreadVars(), BenchDecodeThreadVars(), ctx.p, GET_PKT_DATA(ctx.p), len);
+
+    BenchRun("detect", "generic-udp-64", len, 1, BenchDetectRun, &ctx);
+    DetectRunSelectProfile();
+    BenchRun("detect", "profile-udp-64", len, 1, BenchDetectRun, &ctx);
+
+    PacketFree(ctx.p);
+    DetectEngineThreadCtxDeinit(BenchThreadVars(), ctx.det_ctx);
+    DetectEngineCtxFree(ctx.de_ctx);
+}
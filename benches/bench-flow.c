@@ -0,0 +1,98 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Flow hash lookups with FlowGetFlowFromHash().
+ *
+ * The flows are created by the warm up run, so the timed runs measure the
+ * lookup of existing flows, the common case for a busy sensor. The larger
+ * set of flows doesn't fit in the CPU caches.
+ */
+
+#include "suricata-common.h"
+#include "decode.h"
+#include "flow.h"
+#include "flow-hash.h"
+
+#include "bench.h"
+
+typedef struct BenchFlowCtx_ {
+    FlowLookupStruct fls;
+    Packet **packets;
+    uint32_t cnt;
+} BenchFlowCtx;
+
+static void BenchFlowLookup(void *data)
+{
+    BenchFlowCtx *ctx = data;
+    ThreadVars *tv = BenchThreadVars();
+    for (uint32_t i = 0; i < ctx->cnt; i++) {
+        Packet *p = ctx->packets[i];
+        Flow *f = FlowGetFlowFromHash(tv, &ctx->fls, p, &p->flow);
+        if (f != NULL) {
+            FLOWLOCK_UNLOCK(f);
+            FlowDeReference(&p->flow);
+        }
+    }
+}
+
+static void BenchFlowRun(uint32_t cnt)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "lookup-%u-flows", cnt);
+    if (BenchSkip("flow", name))
+        return;
+
+    BenchFlowCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.fls.dtv = BenchDecodeThreadVars();
+    ctx.cnt = cnt;
+    ctx.packets = SCCalloc(cnt, sizeof(Packet *));
+    if (ctx.packets == NULL)
+        FatalError("failed to allocate the packets");
+
+    uint8_t frame[BENCH_FRAME_MAX];
+    for (uint32_t i = 0; i < cnt; i++) {
+        Packet *p = PacketGetFromAlloc();
+        if (p == NULL)
+            FatalError("failed to allocate a packet");
+        const uint32_t src = htonl(0x0a000000 | (BenchRandom() & 0xffff));
+        const uint32_t dst = htonl(0xc0a80000 | (BenchRandom() & 0xffff));
+        const uint32_t len = BenchBuildIPv4(frame, false, IPPROTO_TCP, src, dst,
+                (uint16_t)(1024 + i % 60000), 443, 1, NULL, 0);
+        if (PacketCopyData(p, frame, len) != 0)
+            FatalError("failed to copy the packet data");
+        (void)DecodeEthernet(BenchThreadVars(), BenchDecodeThreadVars(), p, GET_PKT_DATA(p),
+                GET_PKT_LEN(p));
+        ctx.packets[i] = p;
+    }
+
+    BenchRun("flow", name, 0, cnt, BenchFlowLookup, &ctx);
+
+    for (uint32_t i = 0; i < cnt; i++) {
+        PacketFree(ctx.packets[i]);
+    }
+    SCFree(ctx.packets);
+}
+
+void BenchFlow(void)
+{
+    BenchFlowRun(1024);
+    BenchFlowRun(16384);
+}
@@ -0,0 +1,112 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * EVE record construction with the JSON builder, through the C API the
+ * loggers use.
+ */
+
+#include "suricata-common.h"
+#include "rust.h"
+
+#include "bench.h"
+
+typedef struct BenchJsonCtx_ {
+    SCJsonBuilder *jb;
+    char escape[512];
+    uint64_t flow_id;
+} BenchJsonCtx;
+
+/** \brief an http event, as built by the header code and the http logger */
+static void BenchJsonHttpRecord(BenchJsonCtx *ctx, SCJsonBuilder *jb)
+{
+    SCJbSetString(jb, "timestamp", "2025-03-14T15:09:26.535897+0000");
+    SCJbSetUint(jb, "flow_id", ctx->flow_id++);
+    SCJbSetString(jb, "in_iface", "eth0");
+    SCJbSetString(jb, "event_type", "http");
+    SCJbSetString(jb, "src_ip", "10.16.1.11");
+    SCJbSetUint(jb, "src_port", 49382);
+    SCJbSetString(jb, "dest_ip", "192.168.1.20");
+    SCJbSetUint(jb, "dest_port", 80);
+    SCJbSetString(jb, "proto", "TCP");
+    SCJbSetString(jb, "pkt_src", "wire/pcap");
+    SCJbSetUint(jb, "tx_id", 0);
+    SCJbOpenObject(jb, "http");
+    SCJbSetString(jb, "hostname", "www.example.com");
+    SCJbSetString(jb, "url", "/index.php?id=1&lang=en");
+    SCJbSetString(jb, "http_user_agent",
+            "Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0");
+    SCJbSetString(jb, "http_content_type", "text/html");
+    SCJbSetString(jb, "http_method", "GET");
+    SCJbSetString(jb, "protocol", "HTTP/1.1");
+    SCJbSetUint(jb, "status", 200);
+    SCJbSetUint(jb, "length", 4219);
+    SCJbClose(jb);
+    SCJbClose(jb);
+}
+
+static void BenchJsonNew(void *data)
+{
+    BenchJsonCtx *ctx = data;
+    SCJsonBuilder *jb = SCJbNewObject();
+    if (jb == NULL)
+        FatalError("failed to allocate json builder");
+    BenchJsonHttpRecord(ctx, jb);
+    SCJbFree(jb);
+}
+
+static void BenchJsonReuse(void *data)
+{
+    BenchJsonCtx *ctx = data;
+    SCJbReset(ctx->jb);
+    BenchJsonHttpRecord(ctx, ctx->jb);
+}
+
+static void BenchJsonEscape(void *data)
+{
+    BenchJsonCtx *ctx = data;
+    SCJbReset(ctx->jb);
+    SCJbSetString(ctx->jb, "value", ctx->escape);
+    SCJbClose(ctx->jb);
+}
+
+void BenchJson(void)
+{
+    BenchJsonCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.jb = SCJbNewObject();
+    if (ctx.jb == NULL)
+        FatalError("failed to allocate json builder");
+
+    BenchJsonHttpRecord(&ctx, ctx.jb);
+    const uint64_t len = SCJbLen(ctx.jb);
+
+    BenchRun("json", "http-record-new", len, 1, BenchJsonNew, &ctx);
+    BenchRun("json", "http-record-reuse", len, 1, BenchJsonReuse, &ctx);
+
+    /* a user agent or uri with quotes, backslashes and control characters */
+    static const char escapes[] = "\"\\/\t\r\n\x01";
+    for (size_t i = 0; i < sizeof(ctx.escape) - 1; i++) {
+        ctx.escape[i] = (i % 16 == 0) ? escapes[(i / 16) % (sizeof(escapes) - 1)]
+                                      : (char)('a' + i % 26);
+    }
+    BenchRun("json", "string-escape", sizeof(ctx.escape) - 1, 1, BenchJsonEscape, &ctx);
+
+    SCJbFree(ctx.jb);
+}
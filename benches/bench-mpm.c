@@ -0,0 +1,111 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Multi pattern matcher search throughput for each registered matcher.
+ */
+
+#include "suricata-common.h"
+#include "util-mpm.h"
+#include "util-prefilter.h"
+
+#include "bench.h"
+
+#define BENCH_MPM_BUFFER_LEN (64 * 1024)
+
+/* a small alphabet, so the patterns partially match the buffer often */
+static const char bench_mpm_alphabet[] = "abcdefghijklmnop/.:= ";
+
+typedef struct BenchMpmCtx_ {
+    MpmCtx mpm_ctx;
+    MpmThreadCtx mpm_thread_ctx;
+    PrefilterRuleStore pmq;
+    uint8_t matcher;
+    uint8_t *buf;
+    uint32_t buf_len;
+} BenchMpmCtx;
+
+static void BenchMpmText(uint8_t *buf, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)bench_mpm_alphabet[BenchRandom() % (sizeof(bench_mpm_alphabet) - 1)];
+    }
+}
+
+static void BenchMpmSearch(void *data)
+{
+    BenchMpmCtx *ctx = data;
+    (void)mpm_table[ctx->matcher].Search(
+            &ctx->mpm_ctx, &ctx->mpm_thread_ctx, &ctx->pmq, ctx->buf, ctx->buf_len);
+    PmqReset(&ctx->pmq);
+}
+
+static void BenchMpmMatcher(uint8_t matcher, uint32_t patterns, uint8_t *buf, uint32_t buf_len)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%s/%u-patterns", mpm_table[matcher].name, patterns);
+    if (BenchSkip("mpm", name))
+        return;
+
+    BenchMpmCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.matcher = matcher;
+    ctx.buf = buf;
+    ctx.buf_len = buf_len;
+
+    MpmInitCtx(&ctx.mpm_ctx, matcher);
+    for (uint32_t i = 0; i < patterns; i++) {
+        uint8_t pat[16];
+        const uint16_t len = (uint16_t)(4 + BenchRandom() % (sizeof(pat) - 4 + 1));
+        BenchMpmText(pat, len);
+        MpmAddPatternCS(&ctx.mpm_ctx, pat, len, 0, 0, i, i, 0);
+    }
+    if (mpm_table[matcher].Prepare(NULL, &ctx.mpm_ctx) != 0) {
+        SCLogError("%s: failed to prepare %u patterns", mpm_table[matcher].name, patterns);
+        mpm_table[matcher].DestroyCtx(&ctx.mpm_ctx);
+        return;
+    }
+    MpmInitThreadCtx(&ctx.mpm_thread_ctx, &ctx.mpm_ctx, matcher);
+    PmqSetup(&ctx.pmq);
+
+    BenchRun("mpm", name, buf_len, 0, BenchMpmSearch, &ctx);
+
+    PmqFree(&ctx.pmq);
+    MpmDestroyThreadCtx(&ctx.mpm_thread_ctx, matcher);
+    mpm_table[matcher].DestroyCtx(&ctx.mpm_ctx);
+}
+
+void BenchMpm(void)
+{
+    uint8_t *buf = SCMalloc(BENCH_MPM_BUFFER_LEN);
+    if (buf == NULL)
+        FatalError("failed to allocate the mpm buffer");
+    BenchMpmText(buf, BENCH_MPM_BUFFER_LEN);
+
+    static const uint32_t pattern_cnts[] = { 10, 1000, 10000 };
+    for (uint8_t matcher = 0; matcher < MPM_TABLE_SIZE; matcher++) {
+        if (mpm_table[matcher].name == NULL || mpm_table[matcher].Search == NULL)
+            continue;
+        for (size_t i = 0; i < ARRAY_SIZE(pattern_cnts); i++) {
+            BenchMpmMatcher(matcher, pattern_cnts[i], buf, BENCH_MPM_BUFFER_LEN);
+        }
+    }
+
+    SCFree(buf);
+}
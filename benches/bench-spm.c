@@ -0,0 +1,104 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Single pattern matcher scan throughput for each registered matcher.
+ *
+ * The needle is placed at the end of the buffer, so the whole buffer is
+ * scanned, like a content match that only succeeds late in the payload.
+ */
+
+#include "suricata-common.h"
+#include "util-spm.h"
+
+#include "bench.h"
+
+#define BENCH_SPM_BUFFER_LEN (64 * 1024)
+
+typedef struct BenchSpmCtx_ {
+    SpmCtx *ctx;
+    SpmThreadCtx *thread_ctx;
+    const uint8_t *buf;
+    uint32_t buf_len;
+} BenchSpmCtx;
+
+static void BenchSpmScan(void *data)
+{
+    BenchSpmCtx *ctx = data;
+    if (SpmScan(ctx->ctx, ctx->thread_ctx, ctx->buf, ctx->buf_len) == NULL) {
+        FatalError("spm: needle not found");
+    }
+}
+
+static void BenchSpmMatcher(uint8_t matcher, const char *needle, bool nocase, uint8_t *buf)
+{
+    const uint16_t needle_len = (uint16_t)strlen(needle);
+    char name[64];
+    snprintf(name, sizeof(name), "%s/%u-bytes%s", spm_table[matcher].name, needle_len,
+            nocase ? "-nocase" : "");
+    if (BenchSkip("spm", name))
+        return;
+
+    /* the needle at the end and partial matches of it all over the buffer */
+    for (uint32_t i = 0; i < BENCH_SPM_BUFFER_LEN; i++) {
+        buf[i] = (BenchRandom() % 8 == 0) ? (uint8_t)needle[0] : (uint8_t)('a' + i % 26);
+    }
+    memcpy(buf + BENCH_SPM_BUFFER_LEN - needle_len, needle, needle_len);
+
+    SpmGlobalThreadCtx *global_thread_ctx = SpmInitGlobalThreadCtx(matcher);
+    if (global_thread_ctx == NULL)
+        FatalError("spm: failed to set up %s", spm_table[matcher].name);
+    BenchSpmCtx ctx = {
+        .ctx = SpmInitCtx((const uint8_t *)needle, needle_len, nocase, global_thread_ctx),
+        .thread_ctx = SpmMakeThreadCtx(global_thread_ctx),
+        .buf = buf,
+        .buf_len = BENCH_SPM_BUFFER_LEN,
+    };
+    if (ctx.ctx == NULL || ctx.thread_ctx == NULL)
+        FatalError("spm: failed to set up %s", spm_table[matcher].name);
+
+    BenchRun("spm", name, BENCH_SPM_BUFFER_LEN, 0, BenchSpmScan, &ctx);
+
+    SpmDestroyCtx(ctx.ctx);
+    SpmDestroyThreadCtx(ctx.thread_ctx);
+    SpmDestroyGlobalThreadCtx(global_thread_ctx);
+}
+
+void BenchSpm(void)
+{
+    uint8_t *buf = SCMalloc(BENCH_SPM_BUFFER_LEN);
+    if (buf == NULL)
+        FatalError("failed to allocate the spm buffer");
+
+    static const char *needles[] = {
+        "\xffSMB",
+        "suricata",
+        "Content-Type: application/x-www-form-urlencoded",
+    };
+    for (uint8_t matcher = 0; matcher < SPM_TABLE_SIZE; matcher++) {
+        if (spm_table[matcher].name == NULL)
+            continue;
+        for (size_t i = 0; i < ARRAY_SIZE(needles); i++) {
+            BenchSpmMatcher(matcher, needles[i], false, buf);
+            BenchSpmMatcher(matcher, needles[i], true, buf);
+        }
+    }
+
+    SCFree(buf);
+}
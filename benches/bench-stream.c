@@ -0,0 +1,144 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * TCP reassembly with StreamTcpReassembleHandleSegment().
+ *
+ * Each run feeds the segments of a single direction into a new session
+ * and then cleans up the session, returning the segments to the pool.
+ */
+
+#include "suricata-common.h"
+#include "decode.h"
+#include "flow-util.h"
+#include "stream-tcp.h"
+#include "stream-tcp-private.h"
+#include "stream-tcp-reassemble.h"
+
+#include "bench.h"
+
+#define BENCH_STREAM_SEGMENTS    64
+#define BENCH_STREAM_SEGMENT_LEN 1400
+#define BENCH_STREAM_ISN         1000
+
+typedef struct BenchStreamCtx_ {
+    TcpReassemblyThreadCtx *ra_ctx;
+    TcpSession ssn;
+    Flow *f;
+    Packet *packets[BENCH_STREAM_SEGMENTS];
+    /** order in which the segments are fed */
+    uint32_t order[BENCH_STREAM_SEGMENTS];
+} BenchStreamCtx;
+
+static void BenchStreamSetupStream(TcpStream *s, uint32_t isn)
+{
+    memset(s, 0, sizeof(*s));
+    s->isn = isn;
+    STREAMTCP_SET_RA_BASE_SEQ(s, isn);
+    s->base_seq = isn + 1;
+    StreamingBuffer sb = STREAMING_BUFFER_INITIALIZER;
+    s->sb = sb;
+}
+
+static void BenchStreamRun(void *data)
+{
+    BenchStreamCtx *ctx = data;
+    TcpSession *ssn = &ctx->ssn;
+
+    memset(ssn, 0, sizeof(*ssn));
+    ssn->state = TCP_ESTABLISHED;
+    BenchStreamSetupStream(&ssn->client, BENCH_STREAM_ISN);
+    BenchStreamSetupStream(&ssn->server, BENCH_STREAM_ISN);
+
+    for (uint32_t i = 0; i < BENCH_STREAM_SEGMENTS; i++) {
+        Packet *p = ctx->packets[ctx->order[i]];
+        if (StreamTcpReassembleHandleSegment(
+                    BenchThreadVars(), ctx->ra_ctx, ssn, &ssn->client, p) != 0) {
+            FatalError("stream: failed to add a segment");
+        }
+        p->flags &= ~PKT_STREAM_ADD;
+    }
+
+    StreamTcpStreamCleanup(&ssn->client);
+    StreamTcpStreamCleanup(&ssn->server);
+    StreamTcpSessionCleanup(ssn);
+}
+
+void BenchStream(void)
+{
+    BenchStreamCtx *ctx = SCCalloc(1, sizeof(*ctx));
+    if (ctx == NULL)
+        FatalError("failed to allocate the stream context");
+    ctx->ra_ctx = StreamTcpReassembleInitThreadCtx(BenchThreadVars());
+    ctx->f = FlowAlloc();
+    if (ctx->ra_ctx == NULL || ctx->f == NULL)
+        FatalError("stream: setup failed");
+    ctx->f->proto = IPPROTO_TCP;
+    ctx->f->protomap = FlowGetProtoMapping(IPPROTO_TCP);
+    ctx->f->protoctx = &ctx->ssn;
+    ctx->f->flags |= FLOW_IPV4;
+
+    uint8_t payload[BENCH_STREAM_SEGMENT_LEN];
+    uint8_t frame[BENCH_FRAME_MAX];
+    BenchRandomFill(payload, sizeof(payload));
+    const uint32_t src = htonl(0x0a000001);
+    const uint32_t dst = htonl(0x0a000002);
+    for (uint32_t i = 0; i < BENCH_STREAM_SEGMENTS; i++) {
+        Packet *p = PacketGetFromAlloc();
+        if (p == NULL)
+            FatalError("failed to allocate a packet");
+        const uint32_t seq = BENCH_STREAM_ISN + 1 + i * BENCH_STREAM_SEGMENT_LEN;
+        const uint32_t len = BenchBuildIPv4(
+                frame, false, IPPROTO_TCP, src, dst, 40000, 80, seq, payload, sizeof(payload));
+        if (PacketCopyData(p, frame, len) != 0)
+            FatalError("failed to copy the packet data");
+        (void)DecodeEthernet(BenchThreadVars(), BenchDecodeThreadVars(), p, GET_PKT_DATA(p),
+                GET_PKT_LEN(p));
+        p->flow = ctx->f;
+        p->flowflags |= FLOW_PKT_TOSERVER;
+        ctx->packets[i] = p;
+    }
+
+    const uint64_t bytes = BENCH_STREAM_SEGMENTS * BENCH_STREAM_SEGMENT_LEN;
+    for (uint32_t i = 0; i < BENCH_STREAM_SEGMENTS; i++) {
+        ctx->order[i] = i;
+    }
+    BenchRun("stream", "in-order", bytes, BENCH_STREAM_SEGMENTS, BenchStreamRun, ctx);
+
+    /* every pair of segments swapped, so each odd segment fills a gap */
+    for (uint32_t i = 0; i < BENCH_STREAM_SEGMENTS; i++) {
+        ctx->order[i] = i ^ 1;
+    }
+    BenchRun("stream", "out-of-order", bytes, BENCH_STREAM_SEGMENTS, BenchStreamRun, ctx);
+
+    /* all segments in reverse, the worst case for the segment tree */
+    for (uint32_t i = 0; i < BENCH_STREAM_SEGMENTS; i++) {
+        ctx->order[i] = BENCH_STREAM_SEGMENTS - 1 - i;
+    }
+    BenchRun("stream", "reversed", bytes, BENCH_STREAM_SEGMENTS, BenchStreamRun, ctx);
+
+    for (uint32_t i = 0; i < BENCH_STREAM_SEGMENTS; i++) {
+        ctx->packets[i]->flow = NULL;
+        PacketFree(ctx->packets[i]);
+    }
+    ctx->f->protoctx = NULL;
+    FlowFree(ctx->f);
+    StreamTcpReassembleFreeThreadCtx(ctx->ra_ctx);
+    SCFree(ctx);
+}
@@ -0,0 +1,403 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Benchmark harness: engine setup, timing and result output.
+ *
+ * Every benchmark is run once to warm up, then the number of calls per
+ * sample is calibrated so that a sample takes about `-t` msecs. Of the
+ * `-n` samples, the median is reported along with the fastest and slowest
+ * sample, so noisy runs can be recognized.
+ */
+
+#include "suricata-common.h"
+#include "suricata.h"
+#include "conf-yaml-loader.h"
+#include "counters.h"
+#include "decode.h"
+#include "util-conf.h"
+#include "rust.h"
+
+#include "bench.h"
+
+static const char bench_config[] = "\
+%YAML 1.1\n\
+---\n\
+flow:\n\
+  memcap: 1 GiB\n\
+  hash-size: 65536\n\
+  prealloc: 10000\n\
+stream:\n\
+  memcap: 1 GiB\n\
+  checksum-validation: no\n\
+  reassembly:\n\
+    memcap: 1 GiB\n\
+    depth: 0\n\
+";
+
+static const char *bench_filter = NULL;
+static bool bench_list = false;
+#define BENCH_SAMPLES_MAX 99
+
+static uint32_t bench_samples = 7;
+static uint64_t bench_sample_ns = 200 * 1000000ULL;
+
+static ThreadVars *bench_tv = NULL;
+static DecodeThreadVars *bench_dtv = NULL;
+static uint32_t bench_seed = 0x9e3779b9;
+
+static SCInstance bench_suri;
+
+static inline uint64_t BenchNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int BenchCompareU64(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static bool BenchSelected(const char *group, const char *name)
+{
+    if (bench_filter == NULL)
+        return true;
+    char full[256];
+    snprintf(full, sizeof(full), "%s/%s", group, name);
+    return strstr(full, bench_filter) != NULL;
+}
+
+bool BenchGroupSelected(const char *group)
+{
+    if (bench_filter == NULL || bench_list)
+        return true;
+    /* "mpm/ac" selects group "mpm", "ac" may match a benchmark of any group */
+    const size_t len = strlen(group);
+    if (strncmp(bench_filter, group, len) == 0 &&
+            (bench_filter[len] == '\0' || bench_filter[len] == '/'))
+        return true;
+    return strchr(bench_filter, '/') == NULL;
+}
+
+static uint64_t BenchSample(void (*Run)(void *ctx), void *ctx, uint64_t iterations)
+{
+    const uint64_t start = BenchNow();
+    for (uint64_t i = 0; i < iterations; i++) {
+        Run(ctx);
+    }
+    return BenchNow() - start;
+}
+
+bool BenchSkip(const char *group, const char *name)
+{
+    if (!BenchSelected(group, name))
+        return true;
+    if (bench_list) {
+        printf("%s/%s\n", group, name);
+        return true;
+    }
+    return false;
+}
+
+void BenchRun(const char *group, const char *name, uint64_t bytes, uint64_t items,
+        void (*Run)(void *ctx), void *ctx)
+{
+    if (BenchSkip(group, name))
+        return;
+
+    /* warm up caches and lazily allocated state */
+    Run(ctx);
+
+    uint64_t iterations = 1;
+    for (;;) {
+        const uint64_t ns = BenchSample(Run, ctx, iterations);
+        if (ns >= bench_sample_ns / 4 || iterations >= (1ULL << 40))
+            break;
+        iterations *= 2;
+    }
+    const uint64_t ns = BenchSample(Run, ctx, iterations);
+    if (ns > 0 && ns < bench_sample_ns) {
+        iterations = MAX(1, iterations * bench_sample_ns / ns);
+    }
+
+    uint64_t samples[BENCH_SAMPLES_MAX];
+    for (uint32_t i = 0; i < bench_samples; i++) {
+        samples[i] = BenchSample(Run, ctx, iterations);
+    }
+    qsort(samples, bench_samples, sizeof(samples[0]), BenchCompareU64);
+
+    const double median = (double)samples[bench_samples / 2] / (double)iterations;
+    const double min = (double)samples[0] / (double)iterations;
+    const double max = (double)samples[bench_samples - 1] / (double)iterations;
+
+    SCJsonBuilder *jb = SCJbNewObject();
+    if (jb == NULL)
+        FatalError("failed to allocate json builder");
+    SCJbSetString(jb, "group", group);
+    SCJbSetString(jb, "name", name);
+    SCJbSetString(jb, "version", PROG_VER);
+    SCJbSetUint(jb, "samples", bench_samples);
+    SCJbSetUint(jb, "iterations", iterations);
+    SCJbSetFloat(jb, "ns_median", median);
+    SCJbSetFloat(jb, "ns_min", min);
+    SCJbSetFloat(jb, "ns_max", max);
+    if (bytes > 0) {
+        SCJbSetUint(jb, "bytes", bytes);
+        SCJbSetFloat(jb, "mib_per_sec", (double)bytes * 1e9 / median / (1024.0 * 1024.0));
+    }
+    if (items > 0) {
+        SCJbSetUint(jb, "items", items);
+        SCJbSetFloat(jb, "items_per_sec", (double)items * 1e9 / median);
+    }
+    SCJbClose(jb);
+    fwrite(SCJbPtr(jb), SCJbLen(jb), 1, stdout);
+    fputc('\n', stdout);
+    fflush(stdout);
+    SCJbFree(jb);
+}
+
+ThreadVars *BenchThreadVars(void)
+{
+    return bench_tv;
+}
+
+DecodeThreadVars *BenchDecodeThreadVars(void)
+{
+    return bench_dtv;
+}
+
+uint32_t BenchRandom(void)
+{
+    /* xorshift32 */
+    bench_seed ^= bench_seed << 13;
+    bench_seed ^= bench_seed >> 17;
+    bench_seed ^= bench_seed << 5;
+    return bench_seed;
+}
+
+void BenchRandomFill(uint8_t *buf, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)BenchRandom();
+    }
+}
+
+static uint16_t BenchIPv4Checksum(const uint8_t *hdr)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < 20; i += 2) {
+        sum += (uint32_t)(hdr[i] << 8 | hdr[i + 1]);
+    }
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+static uint32_t BenchBuildL4(uint8_t *buf, uint8_t proto, uint16_t sp, uint16_t dp, uint32_t seq,
+        const uint8_t *payload, uint16_t payload_len)
+{
+    uint32_t hlen;
+    if (proto == IPPROTO_TCP) {
+        hlen = 20;
+        memset(buf, 0, hlen);
+        buf[4] = (uint8_t)(seq >> 24);
+        buf[5] = (uint8_t)(seq >> 16);
+        buf[6] = (uint8_t)(seq >> 8);
+        buf[7] = (uint8_t)seq;
+        buf[11] = 1; /* ack */
+        buf[12] = 0x50;
+        buf[13] = 0x18; /* PSH|ACK */
+        buf[14] = buf[15] = 0xff;
+    } else {
+        hlen = 8;
+        memset(buf, 0, hlen);
+        buf[4] = (uint8_t)((hlen + payload_len) >> 8);
+        buf[5] = (uint8_t)(hlen + payload_len);
+    }
+    buf[0] = (uint8_t)(sp >> 8);
+    buf[1] = (uint8_t)sp;
+    buf[2] = (uint8_t)(dp >> 8);
+    buf[3] = (uint8_t)dp;
+    if (payload_len > 0)
+        memcpy(buf + hlen, payload, payload_len);
+    return hlen + payload_len;
+}
+
+static uint32_t BenchBuildEthernet(uint8_t *buf, bool vlan, uint16_t type)
+{
+    static const uint8_t macs[12] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x00, 0x0a, 0x0b, 0x0c,
+        0x0d, 0x0e };
+    memcpy(buf, macs, sizeof(macs));
+    uint32_t len = 12;
+    if (vlan) {
+        buf[len++] = 0x81;
+        buf[len++] = 0x00;
+        buf[len++] = 0x00;
+        buf[len++] = 0x64; /* vlan 100 */
+    }
+    buf[len++] = (uint8_t)(type >> 8);
+    buf[len++] = (uint8_t)type;
+    return len;
+}
+
+uint32_t BenchBuildIPv4(uint8_t *buf, bool vlan, uint8_t proto, uint32_t src, uint32_t dst,
+        uint16_t sp, uint16_t dp, uint32_t seq, const uint8_t *payload, uint16_t payload_len)
+{
+    const uint32_t eth_len = BenchBuildEthernet(buf, vlan, ETHERNET_TYPE_IP);
+    uint8_t *ip = buf + eth_len;
+    const uint32_t l4_len = BenchBuildL4(ip + 20, proto, sp, dp, seq, payload, payload_len);
+    const uint32_t ip_len = 20 + l4_len;
+
+    memset(ip, 0, 20);
+    ip[0] = 0x45;
+    ip[2] = (uint8_t)(ip_len >> 8);
+    ip[3] = (uint8_t)ip_len;
+    ip[6] = 0x40; /* DF */
+    ip[8] = 64;
+    ip[9] = proto;
+    memcpy(ip + 12, &src, 4);
+    memcpy(ip + 16, &dst, 4);
+    const uint16_t csum = BenchIPv4Checksum(ip);
+    ip[10] = (uint8_t)(csum >> 8);
+    ip[11] = (uint8_t)csum;
+    return eth_len + ip_len;
+}
+
+uint32_t BenchBuildIPv6(uint8_t *buf, uint8_t proto, uint32_t src, uint32_t dst, uint16_t sp,
+        uint16_t dp, uint32_t seq, const uint8_t *payload, uint16_t payload_len)
+{
+    const uint32_t eth_len = BenchBuildEthernet(buf, false, ETHERNET_TYPE_IPV6);
+    uint8_t *ip = buf + eth_len;
+    const uint32_t l4_len = BenchBuildL4(ip + 40, proto, sp, dp, seq, payload, payload_len);
+
+    memset(ip, 0, 40);
+    ip[0] = 0x60;
+    ip[4] = (uint8_t)(l4_len >> 8);
+    ip[5] = (uint8_t)l4_len;
+    ip[6] = proto;
+    ip[7] = 64;
+    /* 2001:db8::<addr> */
+    ip[8] = ip[24] = 0x20;
+    ip[9] = ip[25] = 0x01;
+    ip[10] = ip[26] = 0x0d;
+    ip[11] = ip[27] = 0xb8;
+    memcpy(ip + 20, &src, 4);
+    memcpy(ip + 36, &dst, 4);
+    return eth_len + 40 + l4_len;
+}
+
+static void BenchSetup(void)
+{
+    /* keep stdout for the results */
+    setenv("SC_LOG_LEVEL", "Error", 0);
+
+    InitGlobal();
+    SCRunmodeSet(RUNMODE_PCAP_FILE);
+    GlobalsInitPreConfig();
+    ConfigSetLogDirectory("/tmp/");
+    if (SCConfYamlLoadString(bench_config, strlen(bench_config)) != 0) {
+        FatalError("failed to load the benchmark configuration");
+    }
+    if (PostConfLoadedSetup(&bench_suri) != TM_ECODE_OK) {
+        FatalError("engine setup failed");
+    }
+    PreRunInit(RUNMODE_PCAP_FILE);
+
+    bench_tv = SCCalloc(1, sizeof(ThreadVars));
+    if (bench_tv == NULL)
+        FatalError("failed to allocate thread vars");
+    strlcpy(bench_tv->name, "bench", sizeof(bench_tv->name));
+    StatsThreadInit(&bench_tv->stats);
+    bench_dtv = DecodeThreadVarsAlloc(bench_tv);
+    if (bench_dtv == NULL)
+        FatalError("failed to allocate decode thread vars");
+    DecodeRegisterPerfCounters(bench_dtv, bench_tv);
+    if (StatsSetupPrivate(&bench_tv->stats, bench_tv->name) != 0)
+        FatalError("failed to set up the counters");
+}
+
+static void BenchUsage(const char *progname)
+{
+    printf("USAGE: %s [-l] [-n <samples>] [-t <msecs>] [<filter>]\n\n", progname);
+    printf("\t-l            list the benchmarks\n");
+    printf("\t-n <samples>  number of samples per benchmark (default: 7)\n");
+    printf("\t-t <msecs>    duration of a sample (default: 200)\n");
+    printf("\t<filter>      only run benchmarks with <filter> in \"group/name\"\n");
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "hln:t:")) != -1) {
+        switch (opt) {
+            case 'l':
+                bench_list = true;
+                break;
+            case 'n':
+                bench_samples = (uint32_t)atoi(optarg);
+                if (bench_samples < 1 || bench_samples > BENCH_SAMPLES_MAX) {
+                    fprintf(stderr, "invalid number of samples: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 't': {
+                const int ms = atoi(optarg);
+                if (ms < 1 || ms > 60000) {
+                    fprintf(stderr, "invalid sample duration: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                bench_sample_ns = (uint64_t)ms * 1000000ULL;
+                break;
+            }
+            case 'h':
+                BenchUsage(argv[0]);
+                exit(EXIT_SUCCESS);
+            default:
+                BenchUsage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind < argc)
+        bench_filter = argv[optind];
+
+    BenchSetup();
+
+    if (BenchGroupSelected("mpm"))
+        BenchMpm();
+    if (BenchGroupSelected("spm"))
+        BenchSpm();
+    if (BenchGroupSelected("decode"))
+        BenchDecode();
+    if (BenchGroupSelected("flow"))
+        BenchFlow();
+    if (BenchGroupSelected("stream"))
+        BenchStream();
+    if (BenchGroupSelected("json"))
+        BenchJson();
+    if (BenchGroupSelected("applayer"))
+        BenchAppLayer();
+    if (BenchGroupSelected("detect"))
+        BenchDetect();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Benchmark harness for the hot paths of the engine.
+ *
+ * Each group sets up its inputs and then calls BenchRun() for each of its
+ * benchmarks. Only the `Run` callback is timed. Results are written to
+ * stdout as one JSON object per line.
+ */
+
+#ifndef SURICATA_BENCH_H
+#define SURICATA_BENCH_H
+
+#include "suricata-common.h"
+#include "threadvars.h"
+#include "decode.h"
+
+/**
+ * \brief time a benchmark and print its result
+ *
+ * \param group name of the group, e.g. "mpm"
+ * \param name name of the benchmark within the group
+ * \param bytes bytes processed per call to `Run`, 0 if not applicable
+ * \param items items (packets, patterns, records) per call to `Run`
+ */
+void BenchRun(const char *group, const char *name, uint64_t bytes, uint64_t items,
+        void (*Run)(void *ctx), void *ctx);
+
+/**
+ * \brief check if a benchmark should be skipped
+ *
+ * For groups with an expensive setup per benchmark. Lists the benchmark
+ * if only listing was requested.
+ */
+bool BenchSkip(const char *group, const char *name);
+
+/** \brief true if any benchmark of the group is selected */
+bool BenchGroupSelected(const char *group);
+
+ThreadVars *BenchThreadVars(void);
+DecodeThreadVars *BenchDecodeThreadVars(void);
+
+/** \brief deterministic pseudo random numbers, so runs use the same inputs */
+uint32_t BenchRandom(void);
+void BenchRandomFill(uint8_t *buf, uint32_t len);
+
+/* packet builders, return the frame length */
+uint32_t BenchBuildIPv4(uint8_t *buf, bool vlan, uint8_t proto, uint32_t src, uint32_t dst,
+        uint16_t sp, uint16_t dp, uint32_t seq, const uint8_t *payload, uint16_t payload_len);
+uint32_t BenchBuildIPv6(uint8_t *buf, uint8_t proto, uint32_t src, uint32_t dst, uint16_t sp,
+        uint16_t dp, uint32_t seq, const uint8_t *payload, uint16_t payload_len);
+
+#define BENCH_FRAME_MAX 1600
+
+void BenchMpm(void);
+void BenchSpm(void);
+void BenchDecode(void);
+void BenchFlow(void);
+void BenchStream(void);
+void BenchJson(void);
+void BenchAppLayer(void);
+void BenchDetect(void);
+
+#endif /* SURICATA_BENCH_H */
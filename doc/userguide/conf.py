@@ -306,6 +306,8 @@ man_pages = [
      "Suricata Control", [], 1),
     ("manpages/suricatactl-filestore", "suricatactl-filestore",
      "Perform actions on filestore", [], 1),
+    ("manpages/suricatactl-stats", "suricatactl-stats",
+     "Read the shared memory stats", [], 1),
 ]
 
 # If true, show URL addresses after external links.
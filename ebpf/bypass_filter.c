@@ -31,6 +31,11 @@
 /* vlan tracking: set it to 0 if you don't use VLAN for flow tracking */
 #define VLAN_TRACKING    1
 
+/* Set it to 0 if your kernel doesn't have BPF ring buffers (before 5.8).
+ * If set, the end of the bypassed TCP flows is sent to Suricata so the
+ * entries are removed without waiting for the flow timeout. */
+#define USE_FLOW_EVENTS  1
+
 #define LINUX_VERSION_CODE 263682
 
 struct flowv4_keys {
@@ -62,6 +67,18 @@ struct pair {
     __u64 bytes;
 };
 
+#define FLOW_EVENT_END  1
+
+struct flow_event {
+    __u8 type;
+    __u8 family;
+    __u16 pad;
+    union {
+        struct flowv4_keys v4;
+        struct flowv6_keys v6;
+    } key;
+};
+
 struct {
     __uint(type, BPF_MAP_TYPE_PERCPU_HASH);
     __type(key, struct flowv4_keys);
@@ -76,11 +93,43 @@ struct {
     __uint(max_entries, 32768);
 } flow_table_v6 SEC(".maps");
 
+#if USE_FLOW_EVENTS
+struct {
+    __uint(type, BPF_MAP_TYPE_RINGBUF);
+    __uint(max_entries, 1 << 20);
+} flow_events SEC(".maps");
+#endif
+
 struct vlan_hdr {
     __u16	h_vlan_TCI;
     __u16	h_vlan_encapsulated_proto;
 };
 
+#if USE_FLOW_EVENTS
+/* tell Suricata a bypassed TCP half flow is over */
+static __always_inline void send_flow_end(struct __sk_buff *skb, __u32 thoff,
+        void *tuple, __u32 tuple_size, __u8 family)
+{
+    struct flow_event *ev;
+    /* FIN is 0x01 and RST is 0x04 in the flags byte of the TCP header */
+    __u8 flags = load_byte(skb, thoff + 13);
+
+    if (!(flags & 0x05))
+        return;
+    ev = bpf_ringbuf_reserve(&flow_events, sizeof(*ev), 0);
+    if (!ev)
+        return;
+    __builtin_memset(ev, 0, sizeof(*ev));
+    ev->type = FLOW_EVENT_END;
+    ev->family = family;
+    if (tuple_size == sizeof(struct flowv4_keys))
+        __builtin_memcpy(&ev->key.v4, tuple, sizeof(struct flowv4_keys));
+    else
+        __builtin_memcpy(&ev->key.v6, tuple, sizeof(struct flowv6_keys));
+    bpf_ringbuf_submit(ev, 0);
+}
+#endif
+
 /**
  * IPv4 filter
  *
@@ -143,6 +192,10 @@ static __always_inline int ipv4_filter(struct __sk_buff *skb, __u16 vlan0, __u16
 #endif
         value->packets++;
         value->bytes += skb->len;
+#if USE_FLOW_EVENTS
+        if (tuple.ip_proto)
+            send_flow_end(skb, nhoff, &tuple, sizeof(tuple), 4);
+#endif
         return 0;
     }
     return -1;
@@ -205,6 +258,10 @@ static __always_inline int ipv6_filter(struct __sk_buff *skb, __u16 vlan0, __u16
         //bpf_trace_printk(fmt, sizeof(fmt), tuple.port16[0], tuple.port16[1]);
         value->packets++;
         value->bytes += skb->len;
+#if USE_FLOW_EVENTS
+        if (tuple.ip_proto)
+            send_flow_end(skb, nhoff + 40, &tuple, sizeof(tuple), 6);
+#endif
         return 0;
     }
     return -1;
@@ -61,6 +61,11 @@
  * also be used as workaround of some hardware offload issue */
 #define VLAN_TRACKING    1
 
+/* Set it to 0 if your kernel doesn't have BPF ring buffers (before 5.8).
+ * If set, the end of the bypassed TCP flows is sent to Suricata so the
+ * entries are removed without waiting for the flow timeout. */
+#define USE_FLOW_EVENTS  1
+
 struct vlan_hdr {
     __u16	h_vlan_TCI;
     __u16	h_vlan_encapsulated_proto;
@@ -95,6 +100,18 @@ struct pair {
     __u64 bytes;
 };
 
+#define FLOW_EVENT_END  1
+
+struct flow_event {
+    __u8 type;
+    __u8 family;
+    __u16 pad;
+    union {
+        struct flowv4_keys v4;
+        struct flowv6_keys v6;
+    } key;
+};
+
 struct {
 #if USE_PERCPU_HASH
     __uint(type, BPF_MAP_TYPE_PERCPU_HASH);
@@ -117,6 +134,13 @@ struct {
     __uint(max_entries, 32768);
 } flow_table_v6 SEC(".maps");
 
+#if USE_FLOW_EVENTS
+struct {
+    __uint(type, BPF_MAP_TYPE_RINGBUF);
+    __uint(max_entries, 1 << 20);
+} flow_events SEC(".maps");
+#endif
+
 #if ENCRYPTED_TLS_BYPASS
 struct {
 #if USE_PERCPU_HASH
@@ -232,6 +256,32 @@ static __always_inline int get_dport(void *trans_data, void *data_end,
     }
 }
 
+#if USE_FLOW_EVENTS
+/* tell Suricata a bypassed TCP half flow is over */
+static __always_inline void send_flow_end(void *trans_data, void *data_end,
+        void *tuple, __u32 tuple_size, __u8 family)
+{
+    struct tcphdr *th = (struct tcphdr *)trans_data;
+    struct flow_event *ev;
+
+    if ((void *)(th + 1) > data_end)
+        return;
+    if (!(th->fin || th->rst))
+        return;
+    ev = bpf_ringbuf_reserve(&flow_events, sizeof(*ev), 0);
+    if (!ev)
+        return;
+    __builtin_memset(ev, 0, sizeof(*ev));
+    ev->type = FLOW_EVENT_END;
+    ev->family = family;
+    if (tuple_size == sizeof(struct flowv4_keys))
+        __builtin_memcpy(&ev->key.v4, tuple, sizeof(struct flowv4_keys));
+    else
+        __builtin_memcpy(&ev->key.v6, tuple, sizeof(struct flowv6_keys));
+    bpf_ringbuf_submit(ev, 0);
+}
+#endif
+
 static int __always_inline filter_ipv4(struct xdp_md *ctx, void *data, __u64 nh_off, void *data_end, __u16 vlan0, __u16 vlan1)
 {
     struct iphdr *iph = data + nh_off;
@@ -305,6 +355,10 @@ static int __always_inline filter_ipv4(struct xdp_md *ctx, void *data, __u64 nh_
         __sync_fetch_and_add(&value->packets, 1);
         __sync_fetch_and_add(&value->bytes, data_end - data);
 #endif
+#if USE_FLOW_EVENTS
+        if (tuple.ip_proto)
+            send_flow_end(iph + 1, data_end, &tuple, sizeof(tuple), 4);
+#endif
 
 #if GOT_TX_PEER
         iface_peer = bpf_map_lookup_elem(&tx_peer_int, &key0);
@@ -436,6 +490,10 @@ static int __always_inline filter_ipv6(struct xdp_md *ctx, void *data, __u64 nh_
         __sync_fetch_and_add(&value->packets, 1);
         __sync_fetch_and_add(&value->bytes, data_end - data);
 #endif
+#if USE_FLOW_EVENTS
+        if (tuple.ip_proto)
+            send_flow_end(ip6h + 1, data_end, &tuple, sizeof(tuple), 6);
+#endif
 
 #if GOT_TX_PEER
         iface_peer = bpf_map_lookup_elem(&tx_peer_int, &key0);
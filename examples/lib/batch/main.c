@@ -0,0 +1,369 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "suricata.h"
+#include "detect-engine.h"
+#include "runmodes.h"
+#include "conf.h"
+#include "pcap.h"
+#include "runmode-lib.h"
+#include "tm-threads.h"
+#include "threadvars.h"
+#include "util-device.h"
+
+#include <time.h>
+
+#define DEFAULT_BATCH_SIZE 32
+
+static int worker_id = 1;
+
+/* ThreadVars created during runmode setup, before thread sealing. */
+static ThreadVars *g_worker_tv = NULL;
+
+/**
+ * The packets of the pcap, read into memory before the timed run. This
+ * stands in for the ring buffer of a capture appliance: Suricata reads
+ * the packets from here without copying them.
+ */
+struct Packets {
+    uint8_t **data;
+    uint32_t *len;
+    SCTime_t *ts;
+    uint32_t cnt;
+    int datalink;
+};
+
+/**
+ * Struct to pass arguments into a worker thread.
+ */
+struct WorkerArgs {
+    ThreadVars *tv;
+    struct Packets *packets;
+    uint32_t batch_size;
+    uint32_t repeat;
+    /* set by the worker: each injected packet was released exactly once */
+    bool release_ok;
+};
+
+/**
+ * Counters updated by the release callback.
+ */
+struct ReleaseStats {
+    uint64_t released;
+    uint64_t dropped;
+    /* callbacks for a buffer that was not in flight */
+    uint64_t unexpected;
+};
+
+/**
+ * Release callback.
+ *
+ * Called once Suricata is done with a buffer. A capture appliance would
+ * return the ring buffer slot in "user" here, and forward or drop the
+ * packet based on the verdict when running inline. This example passes
+ * the in flight flag of the buffer, to check it is released only once.
+ */
+static void ReleaseBuffer(void *user, SCLibVerdict verdict, void *arg)
+{
+    struct ReleaseStats *stats = arg;
+    uint8_t *in_flight = user;
+    if (*in_flight == 0) {
+        stats->unexpected++;
+        return;
+    }
+    *in_flight = 0;
+    stats->released++;
+    if (verdict == SC_LIB_VERDICT_DROP) {
+        stats->dropped++;
+    }
+}
+
+static int ReadPcap(const char *filename, struct Packets *packets)
+{
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_t *fp = pcap_open_offline(filename, errbuf);
+    if (fp == NULL) {
+        SCLogError("failed to open %s: %s", filename, errbuf);
+        return -1;
+    }
+    packets->datalink = pcap_datalink(fp);
+
+    uint32_t size = 0;
+    struct pcap_pkthdr *pkthdr;
+    const u_char *packet;
+    while (pcap_next_ex(fp, &pkthdr, &packet) == 1) {
+        if (packets->cnt == size) {
+            size = size ? size * 2 : 1024;
+            packets->data = SCRealloc(packets->data, size * sizeof(uint8_t *));
+            packets->len = SCRealloc(packets->len, size * sizeof(uint32_t));
+            packets->ts = SCRealloc(packets->ts, size * sizeof(SCTime_t));
+            if (packets->data == NULL || packets->len == NULL || packets->ts == NULL) {
+                FatalError("out of memory");
+            }
+        }
+        uint8_t *data = SCMalloc(pkthdr->caplen);
+        if (data == NULL) {
+            FatalError("out of memory");
+        }
+        memcpy(data, packet, pkthdr->caplen);
+        packets->data[packets->cnt] = data;
+        packets->len[packets->cnt] = pkthdr->caplen;
+        packets->ts[packets->cnt] = SCTIME_FROM_TIMEVAL(&pkthdr->ts);
+        packets->cnt++;
+    }
+    pcap_close(fp);
+    return packets->cnt > 0 ? 0 : -1;
+}
+
+static void FreePackets(struct Packets *packets)
+{
+    for (uint32_t i = 0; i < packets->cnt; i++) {
+        SCFree(packets->data[i]);
+    }
+    SCFree(packets->data);
+    SCFree(packets->len);
+    SCFree(packets->ts);
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Suricata worker thread in library mode, injecting the packets in
+ * batches.
+ */
+static void *BatchWorker(void *arg)
+{
+    struct WorkerArgs *args = arg;
+    ThreadVars *tv = args->tv;
+    struct Packets *packets = args->packets;
+    struct ReleaseStats stats = { 0, 0, 0 };
+    SCLibPacket *batch = NULL;
+    uint8_t *in_flight = NULL;
+    SCLibInjector *inj = NULL;
+    uint64_t injected = 0;
+    uint64_t bytes = 0;
+
+    /* Start worker. */
+    if (SCRunModeLibSpawnWorker(tv) != 0) {
+        pthread_exit(NULL);
+    }
+
+    inj = SCRunModeLibInjectorNew(
+            tv, LiveGetDevice("lib0"), packets->datalink, ReleaseBuffer, &stats);
+    batch = SCCalloc(args->batch_size, sizeof(SCLibPacket));
+    in_flight = SCCalloc(packets->cnt, sizeof(uint8_t));
+    if (inj == NULL || batch == NULL || in_flight == NULL) {
+        goto done;
+    }
+
+    /* Each repetition is shifted in time past the end of the previous one,
+     * so flows time out and are recreated like in a longer capture. */
+    const uint64_t span =
+            SCTIME_SECS(packets->ts[packets->cnt - 1]) - SCTIME_SECS(packets->ts[0]) + 3600;
+
+    const double start = Now();
+    for (uint32_t r = 0; r < args->repeat; r++) {
+        for (uint32_t i = 0; i < packets->cnt; i += args->batch_size) {
+            uint32_t cnt = MIN(args->batch_size, packets->cnt - i);
+            for (uint32_t j = 0; j < cnt; j++) {
+                batch[j].data = packets->data[i + j];
+                batch[j].len = packets->len[i + j];
+                batch[j].ts = SCTIME_ADD_SECS(packets->ts[i + j], r * span);
+                batch[j].user = &in_flight[i + j];
+                in_flight[i + j] = 1;
+                bytes += packets->len[i + j];
+            }
+            uint32_t n = SCRunModeLibInject(inj, batch, cnt);
+            injected += n;
+            if (n < cnt) {
+                /* the packets that were not injected are not released */
+                for (uint32_t j = n; j < cnt; j++) {
+                    in_flight[i + j] = 0;
+                }
+                goto done;
+            }
+        }
+    }
+    const double elapsed = Now() - start;
+
+    SCLogNotice("injected %" PRIu64 " packets in batches of %u in %.3f secs: "
+                "%.0f packets/sec, %.1f Mbit/sec",
+            injected, args->batch_size, elapsed, (double)injected / elapsed,
+            (double)bytes * 8 / elapsed / 1e6);
+
+done:
+    SCLogNotice("released %" PRIu64 " packets, %" PRIu64 " dropped", stats.released,
+            stats.dropped);
+    SCFree(batch);
+
+    /* Stop the engine. */
+    EngineStop();
+
+    /* Cleanup.
+     *
+     * Note that there is some thread synchronization between this
+     * function and SuricataShutdown such that they must be run
+     * concurrently at this time before either will exit. */
+    SCTmThreadsSlotPacketLoopFinish(tv);
+
+    /* All packets are released once the worker is done. */
+    SCRunModeLibInjectorFree(inj);
+
+    args->release_ok = stats.released == injected && stats.unexpected == 0;
+    if (!args->release_ok) {
+        SCLogError("injected %" PRIu64 " packets, released %" PRIu64 ", %" PRIu64
+                   " unexpected release callbacks",
+                injected, stats.released, stats.unexpected);
+    }
+    SCFree(in_flight);
+
+    SCLogNotice("Worker thread exiting");
+    pthread_exit(NULL);
+}
+
+/**
+ * Application runmode setup that creates ThreadVars before thread
+ * sealing.
+ */
+static int AppRunModeSetup(void)
+{
+    /* This example replays a pcap, so set time mode to offline. */
+    TimeModeSetOffline();
+
+    g_worker_tv = SCRunModeLibCreateThreadVars(worker_id++);
+    if (!g_worker_tv) {
+        SCLogError("Failed to create ThreadVars");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void Usage(void)
+{
+    fprintf(stderr, "Usage: batch [suricata options] -- [-b batch-size] [-r repeat] "
+                    "filename.pcap\n");
+}
+
+int main(int argc, char **argv)
+{
+    SuricataPreInit(argv[0]);
+
+    /* Parse command line options. This is optional, you could
+     * directly configure Suricata through the Conf API. */
+    SCParseCommandLine(argc, argv);
+
+    /* Find our own arguments, after the "--". */
+    while (argc) {
+        bool end = strncmp(argv[0], "--", 2) == 0;
+        argv++;
+        argc--;
+        if (end) {
+            break;
+        }
+    }
+    struct WorkerArgs args = {
+        .batch_size = DEFAULT_BATCH_SIZE,
+        .repeat = 1,
+    };
+    const char *filename = NULL;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            args.batch_size = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            args.repeat = (uint32_t)atoi(argv[++i]);
+        } else {
+            filename = argv[i];
+        }
+    }
+    if (filename == NULL || args.batch_size == 0 || args.repeat == 0) {
+        Usage();
+        return 1;
+    }
+
+    struct Packets packets;
+    memset(&packets, 0, sizeof(packets));
+    if (ReadPcap(filename, &packets) != 0) {
+        fprintf(stderr, "ERROR: no packets read from %s\n", filename);
+        return 1;
+    }
+    args.packets = &packets;
+
+    /* Set the runmode to library mode. */
+    SCRunmodeSet(RUNMODE_LIB);
+
+    /* Validate/finalize the runmode. */
+    if (SCFinalizeRunMode(argc) != TM_ECODE_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    /* Load configuration file. */
+    if (SCLoadYamlConfig() != TM_ECODE_OK) {
+        exit(EXIT_FAILURE);
+    }
+
+    SCEnableDefaultSignalHandlers();
+
+    /* Register our own library run mode. */
+    RunModeRegisterNewRunMode(
+            RUNMODE_LIB, "batch", "Batch injection application run mode", AppRunModeSetup, NULL);
+
+    if (!SCConfSetFromString("runmode=batch", 1)) {
+        exit(EXIT_FAILURE);
+    }
+
+    /* Force logging to the current directory. */
+    SCConfSetFromString("default-log-dir=.", 1);
+
+    if (LiveRegisterDevice("lib0") < 0) {
+        fprintf(stderr, "LiveRegisterDevice failed");
+        exit(1);
+    }
+
+    /* SuricataInit will call our AppRunModeSetup, when it returns our
+     * ThreadVars will be ready. */
+    SuricataInit();
+
+    /* Spawn our worker thread. */
+    pthread_t worker;
+    args.tv = g_worker_tv;
+    if (pthread_create(&worker, NULL, BatchWorker, &args) != 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    SuricataPostInit();
+
+    /* Run the main loop, this just waits for the worker thread to
+     * call EngineStop signalling Suricata that it is done. */
+    SuricataMainLoop();
+
+    /* Shutdown engine. */
+    SCLogNotice("Shutting down");
+
+    SuricataShutdown();
+
+    GlobalsDestroy();
+
+    FreePackets(&packets);
+
+    return args.release_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
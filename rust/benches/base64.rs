@@ -0,0 +1,166 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+//! Base64 decoding throughput on MIME style attachments.
+//!
+//! Run with `cargo bench --bench base64`. The decoder module is included
+//! directly so that the benchmark does not need to link against the C parts
+//! of Suricata.
+
+#[allow(dead_code)]
+#[path = "../src/utils/base64.rs"]
+mod base64;
+
+use std::hint::black_box;
+use std::time::Instant;
+
+const ALPHABET: &[u8; 64] = b"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/// Encode `len` bytes of pseudo random data, optionally wrapped in 76
+/// character lines.
+fn attachment(len: usize, wrap: bool) -> Vec<u8> {
+    let mut seed: u32 = 0x1234_5678;
+    let plain: Vec<u8> = (0..len)
+        .map(|_| {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            seed as u8
+        })
+        .collect();
+    let mut enc = Vec::with_capacity(len * 4 / 3 + len / 38 + 4);
+    let mut line = 0;
+    for c in plain.chunks(3) {
+        let v = (c[0] as u32) << 16
+            | (*c.get(1).unwrap_or(&0) as u32) << 8
+            | *c.get(2).unwrap_or(&0) as u32;
+        enc.push(ALPHABET[(v >> 18) as usize & 0x3f]);
+        enc.push(ALPHABET[(v >> 12) as usize & 0x3f]);
+        enc.push(if c.len() > 1 {
+            ALPHABET[(v >> 6) as usize & 0x3f]
+        } else {
+            b'='
+        });
+        enc.push(if c.len() > 2 {
+            ALPHABET[v as usize & 0x3f]
+        } else {
+            b'='
+        });
+        line += 4;
+        if wrap && line == 76 {
+            enc.extend_from_slice(b"\r\n");
+            line = 0;
+        }
+    }
+    enc
+}
+
+/// Byte per byte decoder, as used before the vectorized path was added.
+fn reference_map(input: u8) -> Option<u8> {
+    match input {
+        b'A'..=b'Z' => Some(input - b'A'),
+        b'a'..=b'z' => Some(input - b'a' + 26),
+        b'0'..=b'9' => Some(input - b'0' + 52),
+        b'+' => Some(62),
+        b'/' => Some(63),
+        _ => None,
+    }
+}
+
+fn reference_rfc2045(input: &[u8], output: &mut [u8]) -> usize {
+    let mut tmp = [0u8; 4];
+    let mut nb = 0;
+    let mut offset = 0;
+    for &b in input {
+        let v = match reference_map(b) {
+            Some(v) => v,
+            None if b == b'=' => 0xff,
+            None => continue,
+        };
+        tmp[nb] = v;
+        nb += 1;
+        if nb == 4 {
+            output[offset] = (tmp[0] << 2) | (tmp[1] >> 4);
+            offset += 1;
+            if tmp[2] != 0xff {
+                output[offset] = (tmp[1] << 4) | (tmp[2] >> 2);
+                offset += 1;
+                if tmp[3] != 0xff {
+                    output[offset] = (tmp[2] << 6) | tmp[3];
+                    offset += 1;
+                }
+            }
+            nb = 0;
+        }
+    }
+    offset
+}
+
+fn run(name: &str, input: &[u8], iterations: u32, f: &dyn Fn(&[u8], &mut [u8]) -> usize) {
+    let mut output = vec![0; input.len()];
+    let start = Instant::now();
+    let mut decoded = 0;
+    for _ in 0..iterations {
+        decoded = f(black_box(input), &mut output);
+        black_box(&output);
+    }
+    let secs = start.elapsed().as_secs_f64();
+    let mbps = (input.len() as f64 * iterations as f64) / secs / (1024.0 * 1024.0);
+    println!(
+        "{:<24} {:>8} bytes -> {:>8} bytes: {:>9.1} MiB/s",
+        name,
+        input.len(),
+        decoded,
+        mbps
+    );
+}
+
+fn main() {
+    for size in [64 * 1024, 1024 * 1024, 8 * 1024 * 1024] {
+        let input = attachment(size, true);
+        let iterations = (256 * 1024 * 1024 / input.len()) as u32;
+
+        run("reference", &input, iterations, &|i, o| {
+            reference_rfc2045(i, o)
+        });
+        run("rfc2045 per line", &input, iterations, &|i, o| {
+            // feed the decoder line by line, like the SMTP MIME parser does
+            let mut decoder = base64::Decoder::new();
+            let mut offset = 0;
+            for line in i.split(|&b| b == b'\n') {
+                let mut decoded = 0;
+                let _ = base64::decode_rfc2045(&mut decoder, line, &mut o[offset..], &mut decoded);
+                offset += decoded as usize;
+            }
+            offset
+        });
+        run("rfc2045 buffer", &input, iterations, &|i, o| {
+            let mut decoder = base64::Decoder::new();
+            let mut decoded = 0;
+            let _ = base64::decode_rfc2045(&mut decoder, i, o, &mut decoded);
+            decoded as usize
+        });
+
+        let input = attachment(size, false);
+        run("unwrapped scalar", &input, iterations, &|i, o| {
+            base64::decode_quanta_scalar(i, o).1
+        });
+        run("unwrapped vectorized", &input, iterations, &|i, o| {
+            base64::decode_quanta(i, o).1
+        });
+    }
+}
@@ -0,0 +1,240 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+//! HPACK Huffman decoding throughput on HEADERS frame payloads.
+//!
+//! Run with `cargo bench --bench hpack`. The decoder module is included
+//! directly so that the benchmark does not need to link against the C parts
+//! of Suricata.
+
+#[allow(dead_code)]
+#[path = "../src/http2/huffman.rs"]
+mod huffman;
+
+use std::hint::black_box;
+use std::time::Instant;
+
+/// Header blocks from the examples of RFC 7541 C.4 and C.6, as sent in the
+/// HEADERS frames of a browser session.
+const RFC7541_BLOCKS: &[&str] = &[
+    "828684418cf1e3c2e5f23a6ba0ab90f4ff",
+    "828684be5886a8eb10649cbf",
+    "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf",
+    "488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1bff6e919d29ad171863c78f0b97c8e9ae82ae43d3",
+    "4883640effc1c0bf",
+    "88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad94e7821dd7f2e6c7b335dfdfcd5b3960d5af27087f3672c1ab270fb5291f9587316065c003ed4ee5b1063d5007",
+];
+
+/// Typical browser request and response headers, encoded as literals.
+const HEADERS: &[(&str, &str)] = &[
+    (":authority", "www.example.com"),
+    (":path", "/static/js/app.3f2a9c1e.min.js?v=20250101"),
+    (
+        "user-agent",
+        "Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0",
+    ),
+    (
+        "accept",
+        "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8",
+    ),
+    ("accept-language", "en-US,en;q=0.5"),
+    ("accept-encoding", "gzip, deflate, br, zstd"),
+    (
+        "cookie",
+        "session=8f14e45fceea167a5a36dedd4bea2543; _ga=GA1.2.1234567890.1700000000; theme=dark",
+    ),
+    ("referer", "https://www.example.com/index.html"),
+    ("content-type", "text/javascript; charset=utf-8"),
+    ("cache-control", "public, max-age=31536000, immutable"),
+    ("etag", "\"5f3e-62a1b0c4d8e00\""),
+    ("last-modified", "Wed, 01 Jan 2025 00:00:00 GMT"),
+];
+
+fn unhex(s: &str) -> Vec<u8> {
+    (0..s.len())
+        .step_by(2)
+        .map(|i| u8::from_str_radix(&s[i..i + 2], 16).unwrap())
+        .collect()
+}
+
+fn huffman_encode(input: &[u8], out: &mut Vec<u8>) {
+    let mut acc = 0u64;
+    let mut nbits = 0;
+    for &c in input {
+        let (code, len) = huffman::HUFFMAN_CODES[c as usize];
+        acc = acc << len | code as u64;
+        nbits += len;
+        while nbits >= 8 {
+            nbits -= 8;
+            out.push((acc >> nbits) as u8);
+        }
+    }
+    if nbits > 0 {
+        out.push((acc << (8 - nbits)) as u8 | (0xff >> nbits));
+    }
+}
+
+fn encode_int(out: &mut Vec<u8>, flags: u8, prefix: u8, mut value: usize) {
+    let max = (1usize << prefix) - 1;
+    if value < max {
+        out.push(flags | value as u8);
+        return;
+    }
+    out.push(flags | max as u8);
+    value -= max;
+    while value >= 0x80 {
+        out.push(0x80 | (value & 0x7f) as u8);
+        value >>= 7;
+    }
+    out.push(value as u8);
+}
+
+/// Header block with all of `HEADERS` as literals without indexing and
+/// Huffman encoded names and values.
+fn literal_block() -> Vec<u8> {
+    let mut block = Vec::new();
+    for (name, value) in HEADERS {
+        block.push(0);
+        for s in [name, value] {
+            let mut enc = Vec::new();
+            huffman_encode(s.as_bytes(), &mut enc);
+            encode_int(&mut block, 0x80, 7, enc.len());
+            block.extend_from_slice(&enc);
+        }
+    }
+    block
+}
+
+fn decode_int(input: &[u8], pos: &mut usize, prefix: u8) -> usize {
+    let max = (1usize << prefix) - 1;
+    let mut value = (input[*pos] as usize) & max;
+    *pos += 1;
+    if value < max {
+        return value;
+    }
+    let mut shift = 0;
+    loop {
+        let b = input[*pos];
+        *pos += 1;
+        value += ((b & 0x7f) as usize) << shift;
+        shift += 7;
+        if b & 0x80 == 0 {
+            return value;
+        }
+    }
+}
+
+/// Collect the Huffman encoded strings of a header block.
+fn huffman_strings(block: &[u8]) -> Vec<Vec<u8>> {
+    let mut strings = Vec::new();
+    let mut pos = 0;
+    while pos < block.len() {
+        let b = block[pos];
+        let (prefix, literal) = if b & 0x80 != 0 {
+            (7, false)
+        } else if b & 0x40 != 0 {
+            (6, true)
+        } else if b & 0x20 != 0 {
+            (5, false)
+        } else {
+            (4, true)
+        };
+        let index = decode_int(block, &mut pos, prefix);
+        if !literal {
+            continue;
+        }
+        let nstrings = if index == 0 { 2 } else { 1 };
+        for _ in 0..nstrings {
+            let huffman = block[pos] & 0x80 != 0;
+            let len = decode_int(block, &mut pos, 7);
+            if huffman {
+                strings.push(block[pos..pos + len].to_vec());
+            }
+            pos += len;
+        }
+    }
+    strings
+}
+
+/// Bit by bit decoder, as a baseline for the table driven one.
+fn reference_decode(input: &[u8]) -> Vec<u8> {
+    let mut out = Vec::new();
+    let mut code = 0u32;
+    let mut len = 0;
+    for i in 0..input.len() * 8 {
+        code = code << 1 | ((input[i / 8] >> (7 - i % 8)) & 1) as u32;
+        len += 1;
+        if let Some(sym) = huffman::HUFFMAN_CODES
+            .iter()
+            .position(|&(c, l)| l == len && c == code)
+        {
+            if sym == 256 {
+                break;
+            }
+            out.push(sym as u8);
+            code = 0;
+            len = 0;
+        }
+    }
+    out
+}
+
+fn run(name: &str, strings: &[Vec<u8>], iterations: u32, f: &dyn Fn(&[u8]) -> Vec<u8>) {
+    let input: usize = strings.iter().map(|s| s.len()).sum();
+    let start = Instant::now();
+    let mut decoded = 0;
+    for _ in 0..iterations {
+        decoded = 0;
+        for s in strings {
+            decoded += black_box(f(black_box(s))).len();
+        }
+    }
+    let secs = start.elapsed().as_secs_f64();
+    let mbps = (input as f64 * iterations as f64) / secs / (1024.0 * 1024.0);
+    println!(
+        "{:<24} {:>8} bytes -> {:>8} bytes: {:>9.1} MiB/s",
+        name, input, decoded, mbps
+    );
+}
+
+fn main() {
+    let rfc: Vec<Vec<u8>> = RFC7541_BLOCKS
+        .iter()
+        .flat_map(|b| huffman_strings(&unhex(b)))
+        .collect();
+    let browser = huffman_strings(&literal_block());
+    for strings in [&rfc, &browser] {
+        for s in strings.iter() {
+            assert_eq!(huffman::http2_decode_huffman(s), reference_decode(s));
+        }
+    }
+
+    run("rfc7541 reference", &rfc, 20_000, &reference_decode);
+    run(
+        "rfc7541 table",
+        &rfc,
+        200_000,
+        &huffman::http2_decode_huffman,
+    );
+    run("browser reference", &browser, 2_000, &reference_decode);
+    run(
+        "browser table",
+        &browser,
+        50_000,
+        &huffman::http2_decode_huffman,
+    );
+}
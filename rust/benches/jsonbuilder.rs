@@ -0,0 +1,149 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+//! JsonBuilder throughput on EVE style records.
+//!
+//! Run with `cargo bench --bench jsonbuilder`. The builder module is
+//! included directly so that the benchmark does not need to link against
+//! the C parts of Suricata. The results are printed as one JSON object per
+//! line, in the same format as `benches/suricata-bench`.
+
+// normally provided by suricata-ffi
+macro_rules! debug_validate_fail {
+    ($msg:expr) => {};
+}
+
+#[allow(dead_code)]
+#[path = "../src/jsonbuilder.rs"]
+mod jsonbuilder;
+
+use jsonbuilder::{JsonBuilder, JsonError};
+use std::hint::black_box;
+use std::time::{Duration, Instant};
+
+const SAMPLES: usize = 7;
+const SAMPLE_TIME: Duration = Duration::from_millis(200);
+
+fn http_record(js: &mut JsonBuilder, flow_id: u64) -> Result<(), JsonError> {
+    js.set_string("timestamp", "2025-03-14T15:09:26.535897+0000")?;
+    js.set_uint("flow_id", flow_id)?;
+    js.set_string("in_iface", "eth0")?;
+    js.set_string("event_type", "http")?;
+    js.set_string("src_ip", "10.16.1.11")?;
+    js.set_uint("src_port", 49382u64)?;
+    js.set_string("dest_ip", "192.168.1.20")?;
+    js.set_uint("dest_port", 80u64)?;
+    js.set_string("proto", "TCP")?;
+    js.set_string("pkt_src", "wire/pcap")?;
+    js.set_uint("tx_id", 0u64)?;
+    js.open_object("http")?;
+    js.set_string("hostname", "www.example.com")?;
+    js.set_string("url", "/index.php?id=1&lang=en")?;
+    js.set_string(
+        "http_user_agent",
+        "Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0",
+    )?;
+    js.set_string("http_content_type", "text/html")?;
+    js.set_string("http_method", "GET")?;
+    js.set_string("protocol", "HTTP/1.1")?;
+    js.set_uint("status", 200u64)?;
+    js.set_uint("length", 4219u64)?;
+    js.close()?;
+    js.close()?;
+    Ok(())
+}
+
+/// Time `f` like the C harness: calibrate the iterations per sample, then
+/// report the median, fastest and slowest sample.
+fn run(name: &str, bytes: usize, f: &mut dyn FnMut()) {
+    f();
+    let mut iterations: u64 = 1;
+    loop {
+        let start = Instant::now();
+        for _ in 0..iterations {
+            f();
+        }
+        let elapsed = start.elapsed();
+        if elapsed >= SAMPLE_TIME {
+            break;
+        }
+        iterations *= 2;
+    }
+    let mut samples: Vec<f64> = (0..SAMPLES)
+        .map(|_| {
+            let start = Instant::now();
+            for _ in 0..iterations {
+                f();
+            }
+            start.elapsed().as_nanos() as f64 / iterations as f64
+        })
+        .collect();
+    samples.sort_by(|a, b| a.partial_cmp(b).unwrap());
+    let median = samples[SAMPLES / 2];
+    println!(
+        "{{\"group\":\"json-rust\",\"name\":\"{}\",\"samples\":{},\"iterations\":{},\
+         \"ns_median\":{:.1},\"ns_min\":{:.1},\"ns_max\":{:.1},\"bytes\":{},\
+         \"mib_per_sec\":{:.1},\"items\":1,\"items_per_sec\":{:.0}}}",
+        name,
+        SAMPLES,
+        iterations,
+        median,
+        samples[0],
+        samples[SAMPLES - 1],
+        bytes,
+        bytes as f64 * 1e9 / median / (1024.0 * 1024.0),
+        1e9 / median
+    );
+}
+
+fn main() {
+    let mut js = JsonBuilder::try_new_object().unwrap();
+    http_record(&mut js, 0).unwrap();
+    let len = unsafe { jsonbuilder::SCJbLen(&js) };
+
+    let mut flow_id = 0;
+    run("http-record-new", len, &mut || {
+        let mut js = JsonBuilder::try_new_object().unwrap();
+        flow_id += 1;
+        http_record(&mut js, flow_id).unwrap();
+        black_box(&js);
+    });
+    run("http-record-reuse", len, &mut || {
+        js.reset();
+        flow_id += 1;
+        http_record(&mut js, flow_id).unwrap();
+        black_box(&js);
+    });
+
+    // a user agent or uri with quotes, backslashes and control characters
+    let escapes = b"\"\\/\t\r\n\x01";
+    let value: String = (0..511)
+        .map(|i| {
+            if i % 16 == 0 {
+                escapes[(i / 16) % escapes.len()] as char
+            } else {
+                (b'a' + (i % 26) as u8) as char
+            }
+        })
+        .collect();
+    run("string-escape", value.len(), &mut || {
+        js.reset();
+        js.set_string("value", &value).unwrap();
+        js.close().unwrap();
+        black_box(&js);
+    });
+}
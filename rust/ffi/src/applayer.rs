@@ -63,6 +63,7 @@ pub const APP_LAYER_PARSER_SFRAME_TC: u16 = 1 << 10;
 
 /* Flags for AppLayerParserProtoCtx. */
 pub const APP_LAYER_PARSER_OPT_ACCEPT_GAPS: u32 = 1 << 0;
+pub const APP_LAYER_PARSER_OPT_TX_READY_QUEUE: u32 = 1 << 1;
 
 // Other flags are defined in C app-layer-parser.h
 /** should inspection be skipped in that direction */
@@ -98,6 +98,18 @@ pub unsafe extern "C" fn htp_connp_set_user_data(
     }
 }
 
+/// Enable or disable decompression of the response bodies that start after this call.
+/// # Safety
+/// When calling this method, you have to ensure that connp is either properly initialized or NULL
+#[no_mangle]
+pub unsafe extern "C" fn htp_connp_set_response_decompression(
+    connp: *mut ConnectionParser, enabled: libc::c_int,
+) {
+    if let Some(connp) = connp.as_mut() {
+        connp.response_decompression_enabled = enabled == 1
+    }
+}
+
 /// Opens connection.
 ///
 /// timestamp is optional
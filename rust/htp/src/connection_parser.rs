@@ -351,6 +351,9 @@ pub struct ConnectionParser {
     pub(crate) response_state_previous: State,
     /// The hook that should be receiving raw connection data.
     pub(crate) response_data_receiver_hook: Option<DataHook>,
+    /// Whether to decompress compressed response bodies. Evaluated once per
+    /// response, when the response headers have been parsed.
+    pub(crate) response_decompression_enabled: bool,
 
     /// Transactions processed by this parser
     transactions: Transactions,
@@ -402,6 +405,7 @@ impl ConnectionParser {
             response_state: State::Idle,
             response_state_previous: State::None,
             response_data_receiver_hook: None,
+            response_decompression_enabled: true,
             transactions: Transactions::new(cfg, &logger),
         }
     }
@@ -1121,6 +1121,7 @@ impl ConnectionParser {
     ///    forces decompression by setting response_content_encoding to one of the
     ///    supported algorithms.
     pub(crate) fn response_initialize_decompressors(&mut self) -> Result<()> {
+        let decompression_enabled = self.response_decompression_enabled;
         let resp = self.response_mut();
         if resp.is_none() {
             return Err(HtpStatus::ERROR);
@@ -1154,8 +1155,13 @@ impl ConnectionParser {
             HtpContentEncoding::None
         };
 
-        // Configure decompression, if enabled in the configuration.
-        resp.response_content_encoding_processing = resp.response_content_encoding;
+        // Configure decompression, unless the user has disabled it for this response.
+        resp.response_content_encoding_processing = if decompression_enabled {
+            resp.response_content_encoding
+        } else {
+            slow_path = false;
+            HtpContentEncoding::None
+        };
 
         let response_content_encoding_processing = resp.response_content_encoding_processing;
         let compression_options = self.cfg.compression_options;
@@ -4,6 +4,7 @@ use crate::{
     config::HtpServerPersonality,
     connection::ConnectionFlags,
     connection_parser::ParserData,
+    decompressors::HtpContentEncoding,
     error::Result,
     log::HtpLogCode,
     transaction::{
@@ -369,6 +370,31 @@ fn CompressedResponseChunked() {
     assert_eq!(159_590, tx.response_entity_len);
 }
 
+#[test]
+fn CompressedResponseChunkedNoDecompression() {
+    let mut t = Test::new(TestConfig());
+    t.connp.response_decompression_enabled = false;
+    assert!(t.run_file("14-compressed-response-gzip-chunked.t").is_ok());
+
+    assert_eq!(1, t.connp.tx_size());
+
+    let tx = t.connp.tx(0).unwrap();
+
+    assert!(tx.is_complete());
+
+    assert_eq!(HtpContentEncoding::Gzip, tx.response_content_encoding);
+    assert_eq!(
+        HtpContentEncoding::None,
+        tx.response_content_encoding_processing
+    );
+
+    // same message length as with decompression
+    assert_eq!(28261, tx.response_message_len);
+
+    // body is passed on undecoded, like in passthrough mode
+    assert!(tx.response_entity_len <= tx.response_message_len);
+}
+
 #[test]
 fn SuccessfulConnectRequest() {
     let mut t = Test::new(TestConfig());
@@ -242,8 +242,8 @@ pub fn applayer_register_protocol_detection(
 pub use suricata_ffi::applayer::{
     APP_LAYER_PARSER_BYPASS_READY, APP_LAYER_PARSER_EOF_TC, APP_LAYER_PARSER_EOF_TS,
     APP_LAYER_PARSER_NO_INSPECTION, APP_LAYER_PARSER_NO_INSPECTION_PAYLOAD,
-    APP_LAYER_PARSER_NO_REASSEMBLY, APP_LAYER_PARSER_OPT_ACCEPT_GAPS, APP_LAYER_TX_SKIP_INSPECT_TC,
-    APP_LAYER_TX_SKIP_INSPECT_TS,
+    APP_LAYER_PARSER_NO_REASSEMBLY, APP_LAYER_PARSER_OPT_ACCEPT_GAPS,
+    APP_LAYER_PARSER_OPT_TX_READY_QUEUE, APP_LAYER_TX_SKIP_INSPECT_TC, APP_LAYER_TX_SKIP_INSPECT_TS,
 };
 
 pub const _APP_LAYER_TX_INSPECTED_TS: u8 = BIT_U8!(2);
@@ -19,7 +19,9 @@
 
 #[cfg(not(test))]
 use suricata_sys::sys::SCAppLayerParserTriggerRawStreamInspection;
-use suricata_sys::sys::{AppProto, AppProtoEnum};
+#[cfg(not(test))]
+use suricata_sys::sys::SCAppLayerParserTxReady;
+use suricata_sys::sys::{AppLayerParserState, AppProto, AppProtoEnum};
 
 use crate::flow::Flow;
 
@@ -85,3 +87,14 @@ pub(crate) fn sc_app_layer_parser_trigger_raw_stream_inspection(
     _flow: *const Flow, _direction: i32,
 ) {
 }
+
+/// SCAppLayerParserTxReady wrapper
+#[cfg(not(test))]
+pub(crate) fn sc_app_layer_parser_tx_ready(pstate: *mut AppLayerParserState, tx_id: u64) {
+    unsafe {
+        SCAppLayerParserTxReady(pstate, tx_id);
+    }
+}
+
+#[cfg(test)]
+pub(crate) fn sc_app_layer_parser_tx_ready(_pstate: *mut AppLayerParserState, _tx_id: u64) {}
@@ -16,12 +16,15 @@
  */
 
 use std;
+use std::cell::OnceCell;
 use std::collections::HashMap;
 use std::collections::VecDeque;
 use std::ffi::CString;
 use std::os::raw::c_void;
+use std::rc::Rc;
 
 use crate::applayer::*;
+use crate::conf::conf_get_bool;
 use crate::core::{self, *};
 use crate::direction::Direction;
 use crate::direction::DIR_BOTH;
@@ -258,15 +261,72 @@ pub enum DNSRData {
     Unknown(Vec<u8>),
 }
 
-#[derive(Debug, PartialEq, Eq)]
+/// Record data that has not been decoded yet, with the message it is
+/// part of so that compressed names can be resolved.
+#[derive(Debug)]
+pub(crate) struct DNSRawRData {
+    pub(crate) message: Rc<[u8]>,
+    pub(crate) offset: usize,
+    pub(crate) len: usize,
+}
+
+#[derive(Debug)]
 pub struct DNSAnswerEntry {
     pub name: DNSName,
     pub rrtype: u16,
     pub rrclass: u16,
     pub ttl: u32,
-    pub data: DNSRData,
+    data: OnceCell<DNSRData>,
+    raw: Option<DNSRawRData>,
+}
+
+impl DNSAnswerEntry {
+    pub fn new(name: DNSName, rrtype: u16, rrclass: u16, ttl: u32, data: DNSRData) -> Self {
+        Self {
+            name,
+            rrtype,
+            rrclass,
+            ttl,
+            data: OnceCell::from(data),
+            raw: None,
+        }
+    }
+
+    pub(crate) fn new_lazy(
+        name: DNSName, rrtype: u16, rrclass: u16, ttl: u32, raw: DNSRawRData,
+    ) -> Self {
+        Self {
+            name,
+            rrtype,
+            rrclass,
+            ttl,
+            data: OnceCell::new(),
+            raw: Some(raw),
+        }
+    }
+
+    /// Get the record data, decoding it on first use if the message was
+    /// parsed lazily.
+    pub fn data(&self) -> &DNSRData {
+        self.data.get_or_init(|| match &self.raw {
+            Some(raw) => parser::dns_decode_rdata(raw, self.rrtype),
+            None => DNSRData::Unknown(Vec::new()),
+        })
+    }
 }
 
+impl PartialEq for DNSAnswerEntry {
+    fn eq(&self, other: &Self) -> bool {
+        self.name == other.name
+            && self.rrtype == other.rrtype
+            && self.rrclass == other.rrclass
+            && self.ttl == other.ttl
+            && self.data() == other.data()
+    }
+}
+
+impl Eq for DNSAnswerEntry {}
+
 #[derive(Debug)]
 pub struct DNSMessage {
     pub header: DNSHeader,
@@ -421,6 +481,14 @@ pub(crate) enum DNSParseError {
     OtherError,
 }
 
+/// Only decode record data when it is used. Applies to unicast DNS,
+/// including DNS over HTTP/2.
+static mut DNS_LAZY_RDATA: bool = false;
+
+fn dns_lazy_rdata(variant: &DnsVariant) -> bool {
+    variant.is_dns() && unsafe { DNS_LAZY_RDATA }
+}
+
 pub(crate) fn dns_parse_request(
     input: &[u8], variant: &DnsVariant,
 ) -> Result<DNSTransaction, DNSParseError> {
@@ -430,7 +498,7 @@ pub(crate) fn dns_parse_request(
         return Err(DNSParseError::HeaderValidation);
     };
 
-    match parser::dns_parse_body(body, input, header) {
+    match parser::dns_parse_body(body, input, header, dns_lazy_rdata(variant)) {
         Ok((_, (request, parse_flags))) => {
             if variant.is_dns() && request.header.flags & 0x8000 != 0 {
                 SCLogDebug!("DNS message is not a request");
@@ -491,13 +559,19 @@ pub(crate) fn dns_parse_request(
 }
 
 pub(crate) fn dns_parse_response(input: &[u8]) -> Result<DNSTransaction, DNSParseError> {
+    dns_parse_response_variant(input, &DnsVariant::Dns)
+}
+
+fn dns_parse_response_variant(
+    input: &[u8], variant: &DnsVariant,
+) -> Result<DNSTransaction, DNSParseError> {
     let (body, header) = if let Some((body, header)) = dns_validate_header(input) {
         (body, header)
     } else {
         return Err(DNSParseError::HeaderValidation);
     };
 
-    match parser::dns_parse_body(body, input, header) {
+    match parser::dns_parse_body(body, input, header, dns_lazy_rdata(variant)) {
         Ok((_, (response, parse_flags))) => {
             SCLogDebug!("Response header flags: {}", response.header.flags);
             let z_flag = response.header.flags & 0x0040 != 0;
@@ -671,7 +745,7 @@ impl DNSState {
     fn parse_response(
         &mut self, input: &[u8], is_tcp: bool, frame: Option<Frame>, flow: *const Flow,
     ) -> bool {
-        match dns_parse_response(input) {
+        match dns_parse_response_variant(input, &self.variant) {
             Ok(mut tx) => {
                 self.tx_id += 1;
                 tx.id = self.tx_id;
@@ -890,7 +964,7 @@ fn probe(input: &[u8], dlen: usize) -> (bool, bool, bool) {
     }
 
     match parser::dns_parse_header(input) {
-        Ok((body, header)) => match parser::dns_parse_body(body, input, header) {
+        Ok((body, header)) => match parser::dns_parse_body(body, input, header, false) {
             Ok((_, (request, _flags))) => probe_header_validity(&request.header, dlen),
             Err(Err::Incomplete(_)) => (false, false, true),
             Err(_) => (false, false, false),
@@ -1150,7 +1224,7 @@ pub unsafe extern "C" fn SCDnsTxGetAnswerRdata(
 
     if let Some(response) = &tx.response {
         if let Some(record) = response.answers.get(index) {
-            if let Some(name) = get_rdata_name(&record.data) {
+            if let Some(name) = get_rdata_name(record.data()) {
                 if !name.value.is_empty() {
                     *buf = name.value.as_ptr();
                     *len = name.value.len() as u32;
@@ -1172,7 +1246,7 @@ pub unsafe extern "C" fn SCDnsTxGetAuthorityRdata(
 
     if let Some(response) = &tx.response {
         if let Some(record) = response.authorities.get(index) {
-            if let Some(name) = get_rdata_name(&record.data) {
+            if let Some(name) = get_rdata_name(record.data()) {
                 if !name.value.is_empty() {
                     *buf = name.value.as_ptr();
                     *len = name.value.len() as u32;
@@ -1194,7 +1268,7 @@ pub unsafe extern "C" fn SCDnsTxGetAdditionalRdata(
 
     if let Some(response) = &tx.response {
         if let Some(record) = response.additionals.get(index) {
-            if let Some(name) = get_rdata_name(&record.data) {
+            if let Some(name) = get_rdata_name(record.data()) {
                 if !name.value.is_empty() {
                     *buf = name.value.as_ptr();
                     *len = name.value.len() as u32;
@@ -1272,6 +1346,14 @@ unsafe extern "C" fn apply_tx_config(
     }
 }
 
+fn dns_parse_config() {
+    if conf_get_bool("app-layer.protocols.dns.lazy-rdata") {
+        unsafe {
+            DNS_LAZY_RDATA = true;
+        }
+    }
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn SCRegisterDnsUdpParser() {
     let default_port = std::ffi::CString::new("[53]").unwrap();
@@ -1314,6 +1396,7 @@ pub unsafe extern "C" fn SCRegisterDnsUdpParser() {
         let alproto = applayer_register_protocol_detection(&parser, 1);
         ALPROTO_DNS = alproto;
         if SCAppLayerParserConfParserEnabled(ip_proto_str.as_ptr(), parser.name) != 0 {
+            dns_parse_config();
             let _ = AppLayerRegisterParser(&parser, alproto);
         }
     }
@@ -1361,6 +1444,7 @@ pub unsafe extern "C" fn SCRegisterDnsTcpParser() {
         let alproto = applayer_register_protocol_detection(&parser, 1);
         ALPROTO_DNS = alproto;
         if SCAppLayerParserConfParserEnabled(ip_proto_str.as_ptr(), parser.name) != 0 {
+            dns_parse_config();
             let _ = AppLayerRegisterParser(&parser, alproto);
         }
     }
@@ -399,7 +399,7 @@ fn dns_log_json_answer_detail(answer: &DNSAnswerEntry, i: usize) -> Result<JsonB
     jsa.set_string("rrtype", &dns_rrtype_string(answer.rrtype))?;
     jsa.set_uint("ttl", answer.ttl as u64)?;
 
-    match &answer.data {
+    match answer.data() {
         DNSRData::A(addr) | DNSRData::AAAA(addr) => {
             jsa.set_string("rdata", &dns_print_addr(addr))?;
         }
@@ -490,7 +490,7 @@ fn dns_log_json_answer(
         for answer in &response.answers {
             if flags & LOG_FORMAT_GROUPED != 0 {
                 let type_string = dns_rrtype_string(answer.rrtype);
-                match &answer.data {
+                match answer.data() {
                     DNSRData::A(addr) | DNSRData::AAAA(addr) => {
                         if !answer_types.contains_key(&type_string) {
                             answer_types
@@ -565,7 +565,7 @@ fn dns_log_json_answer(
             }
 
             if flags & LOG_FORMAT_DETAILED != 0 {
-                match &answer.data {
+                match answer.data() {
                     DNSRData::TXT(asdf) => {
                         for i in 0..asdf.len() {
                             js_answers.append_object(&dns_log_json_answer_detail(answer, i)?)?;
@@ -597,7 +597,7 @@ fn dns_log_json_answer(
     if !response.authorities.is_empty() {
         js.open_array("authorities")?;
         for auth in &response.authorities {
-            match &auth.data {
+            match auth.data() {
                 DNSRData::TXT(txt) => {
                     for i in 0..txt.len() {
                         let auth_detail = dns_log_json_answer_detail(auth, i)?;
@@ -616,7 +616,7 @@ fn dns_log_json_answer(
     if !response.additionals.is_empty() {
         let mut is_js_open = false;
         for add in &response.additionals {
-            if let DNSRData::OPT(rdata) = &add.data {
+            if let DNSRData::OPT(rdata) = add.data() {
                 if rdata.is_empty() {
                     continue;
                 }
@@ -625,7 +625,7 @@ fn dns_log_json_answer(
                 js.open_array("additionals")?;
                 is_js_open = true;
             }
-            match &add.data {
+            match add.data() {
                 DNSRData::TXT(txt) => {
                     for i in 0..txt.len() {
                         let add_detail = dns_log_json_answer_detail(add, i)?;
@@ -659,7 +659,7 @@ fn dns_log_json_answers(
         for answer in &response.answers {
             if flags & LOG_FORMAT_GROUPED != 0 {
                 let type_string = dns_rrtype_string(answer.rrtype);
-                match &answer.data {
+                match answer.data() {
                     DNSRData::A(addr) | DNSRData::AAAA(addr) => {
                         if !answer_types.contains_key(&type_string) {
                             answer_types
@@ -733,7 +733,7 @@ fn dns_log_json_answers(
             }
 
             if flags & LOG_FORMAT_DETAILED != 0 {
-                match &answer.data {
+                match answer.data() {
                     DNSRData::TXT(txt) => {
                         for i in 0..txt.len() {
                             js_answers.append_object(&dns_log_json_answer_detail(answer, i)?)?;
@@ -883,7 +883,7 @@ fn log_json(tx: &DNSTransaction, flags: u64, jb: &mut JsonBuilder) -> Result<(),
     if !message.authorities.is_empty() {
         jb.open_array("authorities")?;
         for auth in &message.authorities {
-            match &auth.data {
+            match auth.data() {
                 DNSRData::TXT(txt) => {
                     for i in 0..txt.len() {
                         let auth_detail = dns_log_json_answer_detail(auth, i)?;
@@ -902,7 +902,7 @@ fn log_json(tx: &DNSTransaction, flags: u64, jb: &mut JsonBuilder) -> Result<(),
     if !message.additionals.is_empty() {
         let mut is_jb_open = false;
         for add in &message.additionals {
-            if let DNSRData::OPT(rdata) = &add.data {
+            if let DNSRData::OPT(rdata) = add.data() {
                 if rdata.is_empty() {
                     continue;
                 }
@@ -911,7 +911,7 @@ fn log_json(tx: &DNSTransaction, flags: u64, jb: &mut JsonBuilder) -> Result<(),
                 jb.open_array("additionals")?;
                 is_jb_open = true;
             }
-            match &add.data {
+            match add.data() {
                 DNSRData::TXT(txt) => {
                     for i in 0..txt.len() {
                         let add_detail = dns_log_json_answer_detail(add, i)?;
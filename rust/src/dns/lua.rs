@@ -144,7 +144,7 @@ pub extern "C" fn SCDnsLuaGetAnswerTable(clua: &mut CLuaState, tx: &mut DNSTrans
             lua.settable(-3);
 
             // All rdata types are pushed to "addr" for backwards compatibility
-            match &answer.data {
+            match answer.data() {
                 DNSRData::A(ref bytes) | DNSRData::AAAA(ref bytes) => {
                     if !bytes.is_empty() {
                         lua.pushstring("addr");
@@ -24,6 +24,7 @@ use nom8::error::ErrorKind;
 use nom8::multi::{count, length_data};
 use nom8::number::streaming::{be_u16, be_u32, be_u8};
 use nom8::{error_position, Err, IResult, Parser};
+use std::rc::Rc;
 
 // Set a maximum assembled hostname length of 1025, this value was
 // chosen as its what DNSMasq uses, a popular DNS server, even if most
@@ -171,8 +172,13 @@ fn dns_parse_name<'b>(
 /// This function could be a made a whole lot simpler if we logged a
 /// multi-string TXT entry as a single quote string, similar to the
 /// output of dig. Something to consider for a future version.
+///
+/// In lazy mode the record data is not decoded. The entry refers to
+/// it in a copy of the message that is shared by all the records of
+/// the message, and it is decoded when it is first asked for.
 fn dns_parse_answer<'a>(
-    slice: &'a [u8], message: &'a [u8], count: usize, flags: &mut DNSNameFlags,
+    slice: &'a [u8], message: &'a [u8], count: usize, flags: &mut DNSNameFlags, lazy: bool,
+    shared: &mut Option<Rc<[u8]>>,
 ) -> IResult<&'a [u8], Vec<DNSAnswerEntry>> {
     let mut answers = Vec::new();
     let mut input = slice;
@@ -209,24 +215,46 @@ fn dns_parse_answer<'a>(
                 // edge case for additional section of type=OPT
                 // with empty data (data length = 0x0000)
                 if val.data.is_empty() && val.rrtype == DNSRecordType::OPT as u16 {
-                    answers.push(DNSAnswerEntry {
-                        name: val.name.clone(),
-                        rrtype: val.rrtype,
-                        rrclass: val.rrclass,
-                        ttl: val.ttl,
-                        data: DNSRData::OPT(Vec::new()),
-                    });
+                    answers.push(DNSAnswerEntry::new(
+                        val.name,
+                        val.rrtype,
+                        val.rrclass,
+                        val.ttl,
+                        DNSRData::OPT(Vec::new()),
+                    ));
                     input = rem;
                     continue;
                 }
+                if lazy && !val.data.is_empty() {
+                    let offset =
+                        (val.data.as_ptr() as usize).wrapping_sub(message.as_ptr() as usize);
+                    // The record data is always part of the message, but
+                    // decode it right away if it is not.
+                    if offset < message.len() && message.len() - offset >= val.data.len() {
+                        let shared_message = shared.get_or_insert_with(|| Rc::from(message));
+                        answers.push(DNSAnswerEntry::new_lazy(
+                            val.name,
+                            val.rrtype,
+                            val.rrclass,
+                            val.ttl,
+                            DNSRawRData {
+                                message: shared_message.clone(),
+                                offset,
+                                len: val.data.len(),
+                            },
+                        ));
+                        input = rem;
+                        continue;
+                    }
+                }
                 let (_, rdata) = dns_parse_rdata(val.data, message, val.rrtype, flags)?;
-                answers.push(DNSAnswerEntry {
-                    name: val.name.clone(),
-                    rrtype: val.rrtype,
-                    rrclass: val.rrclass,
-                    ttl: val.ttl,
-                    data: rdata,
-                });
+                answers.push(DNSAnswerEntry::new(
+                    val.name,
+                    val.rrtype,
+                    val.rrclass,
+                    val.ttl,
+                    rdata,
+                ));
                 input = rem;
             }
             Err(e) => {
@@ -412,6 +440,19 @@ fn dns_parse_rdata<'a>(
     }
 }
 
+/// Decode record data that was skipped by a lazy parse. Data that fails
+/// to decode is returned as is.
+pub(crate) fn dns_decode_rdata(raw: &DNSRawRData, rrtype: u16) -> DNSRData {
+    let message = &raw.message[..];
+    let input = &message[raw.offset..raw.offset + raw.len];
+    // Name anomalies are only raised as events while parsing.
+    let mut flags = DNSNameFlags::default();
+    match dns_parse_rdata(input, message, rrtype, &mut flags) {
+        Ok((_, rdata)) => rdata,
+        Err(_) => DNSRData::Unknown(input.to_vec()),
+    }
+}
+
 // Parse a DNS header.
 pub fn dns_parse_header(i: &[u8]) -> IResult<&[u8], DNSHeader> {
     let (i, tx_id) = be_u16(i)?;
@@ -433,21 +474,40 @@ pub fn dns_parse_header(i: &[u8]) -> IResult<&[u8], DNSHeader> {
     ))
 }
 
+/// Parse the body of a DNS message.
+///
+/// With `lazy` set, the data of the resource records is only decoded
+/// when it is used. See [`DNSAnswerEntry::data`].
 pub fn dns_parse_body<'a>(
-    i: &'a [u8], message: &'a [u8], header: DNSHeader,
+    i: &'a [u8], message: &'a [u8], header: DNSHeader, lazy: bool,
 ) -> IResult<&'a [u8], (DNSMessage, DNSNameFlags)> {
     let mut flags = DNSNameFlags::default();
+    let mut shared = None;
     let (i, queries) = count(
         |b| dns_parse_query(b, message, &mut flags),
         header.questions as usize,
     )
     .parse(i)?;
-    let (i, answers) = dns_parse_answer(i, message, header.answer_rr as usize, &mut flags)?;
+    let (i, answers) = dns_parse_answer(
+        i,
+        message,
+        header.answer_rr as usize,
+        &mut flags,
+        lazy,
+        &mut shared,
+    )?;
 
     let mut invalid_authorities = false;
     let mut authorities = Vec::new();
     let mut i_next = i;
-    let authorities_parsed = dns_parse_answer(i, message, header.authority_rr as usize, &mut flags);
+    let authorities_parsed = dns_parse_answer(
+        i,
+        message,
+        header.authority_rr as usize,
+        &mut flags,
+        lazy,
+        &mut shared,
+    );
     if let Ok((i, authorities_ok)) = authorities_parsed {
         authorities = authorities_ok;
         i_next = i;
@@ -458,8 +518,14 @@ pub fn dns_parse_body<'a>(
     let mut invalid_additionals = false;
     let mut additionals = Vec::new();
     if !invalid_authorities {
-        let additionals_parsed =
-            dns_parse_answer(i_next, message, header.additional_rr as usize, &mut flags);
+        let additionals_parsed = dns_parse_answer(
+            i_next,
+            message,
+            header.additional_rr as usize,
+            &mut flags,
+            lazy,
+            &mut shared,
+        );
         if let Ok((i, additionals_ok)) = additionals_parsed {
             additionals = additionals_ok;
             i_next = i;
@@ -653,7 +719,7 @@ mod tests {
         ];
 
         let (body, header) = dns_parse_header(pkt).unwrap();
-        let res = dns_parse_body(body, pkt, header);
+        let res = dns_parse_body(body, pkt, header, false);
         let (rem, (request, _flags)) = res.unwrap();
         // The request should be fully parsed.
         assert!(rem.is_empty());
@@ -683,16 +749,16 @@ mod tests {
         let additional = &request.additionals[0];
         assert_eq!(
             additional,
-            &DNSAnswerEntry {
-                name: DNSName {
+            &DNSAnswerEntry::new(
+                DNSName {
                     value: vec![],
                     flags: DNSNameFlags::default()
                 },
-                rrtype: DNSRecordType::OPT as u16,
-                rrclass: 0x1000,             // for OPT this is UDP payload size
-                ttl: 0,                      // for OPT this is extended RCODE and flags
-                data: DNSRData::OPT(vec![]), // empty rdata
-            }
+                DNSRecordType::OPT as u16,
+                0x1000,                // for OPT this is UDP payload size
+                0,                     // for OPT this is extended RCODE and flags
+                DNSRData::OPT(vec![]), // empty rdata
+            )
         );
     }
 
@@ -715,7 +781,7 @@ mod tests {
         ];
 
         let (body, header) = dns_parse_header(pkt).unwrap();
-        let res = dns_parse_body(body, pkt, header);
+        let res = dns_parse_body(body, pkt, header, false);
         let (rem, (request, _flags)) = res.unwrap();
 
         assert!(rem.is_empty());
@@ -744,16 +810,16 @@ mod tests {
         let additional = &request.additionals[0];
         assert_eq!(
             additional,
-            &DNSAnswerEntry {
-                name: DNSName {
+            &DNSAnswerEntry::new(
+                DNSName {
                     value: vec![],
                     flags: DNSNameFlags::default()
                 },
-                rrtype: DNSRecordType::OPT as u16,
-                rrclass: 0x1000, // for OPT this is requestor's UDP payload size
-                ttl: 0,          // for OPT this is extended RCODE and flags
+                DNSRecordType::OPT as u16,
+                0x1000, // for OPT this is requestor's UDP payload size
+                0,      // for OPT this is extended RCODE and flags
                 // verify two options
-                data: DNSRData::OPT(vec![
+                DNSRData::OPT(vec![
                     DNSRDataOPT {
                         code: 0x000a,
                         data: vec![0x7f, 0x86, 0xcf, 0x8b, 0x81, 0xf6, 0xf9, 0x55]
@@ -763,7 +829,7 @@ mod tests {
                         data: vec![]
                     },
                 ])
-            }
+            )
         );
     }
 
@@ -771,7 +837,7 @@ mod tests {
     fn dns_parse_response(message: &[u8]) -> IResult<&[u8], (DNSMessage, DNSNameFlags)> {
         let i = message;
         let (i, header) = dns_parse_header(i)?;
-        dns_parse_body(i, message, header)
+        dns_parse_body(i, message, header, false)
     }
 
     #[test]
@@ -820,7 +886,7 @@ mod tests {
         assert_eq!(answer1.rrclass, 1);
         assert_eq!(answer1.ttl, 3544);
         assert_eq!(
-            answer1.data,
+            *answer1.data(),
             DNSRData::CNAME(DNSName {
                 value: "suricata-ids.org".as_bytes().to_vec(),
                 flags: DNSNameFlags::default()
@@ -830,31 +896,31 @@ mod tests {
         let answer2 = &response.answers[1];
         assert_eq!(
             answer2,
-            &DNSAnswerEntry {
-                name: DNSName {
+            &DNSAnswerEntry::new(
+                DNSName {
                     value: "suricata-ids.org".as_bytes().to_vec(),
                     flags: DNSNameFlags::default()
                 },
-                rrtype: 1,
-                rrclass: 1,
-                ttl: 244,
-                data: DNSRData::A([192, 0, 78, 24].to_vec()),
-            }
+                1,
+                1,
+                244,
+                DNSRData::A([192, 0, 78, 24].to_vec()),
+            )
         );
 
         let answer3 = &response.answers[2];
         assert_eq!(
             answer3,
-            &DNSAnswerEntry {
-                name: DNSName {
+            &DNSAnswerEntry::new(
+                DNSName {
                     value: "suricata-ids.org".as_bytes().to_vec(),
                     flags: DNSNameFlags::default()
                 },
-                rrtype: 1,
-                rrclass: 1,
-                ttl: 244,
-                data: DNSRData::A([192, 0, 78, 25].to_vec()),
-            }
+                1,
+                1,
+                244,
+                DNSRData::A([192, 0, 78, 25].to_vec()),
+            )
         )
     }
 
@@ -905,7 +971,7 @@ mod tests {
         assert_eq!(authority.rrclass, 1);
         assert_eq!(authority.ttl, 899);
         assert_eq!(
-            authority.data,
+            *authority.data(),
             DNSRData::SOA(DNSRDataSOA {
                 mname: DNSName {
                     value: "ns-110.awsdns-13.com".as_bytes().to_vec(),
@@ -929,16 +995,60 @@ mod tests {
         let additional = &response.additionals[0];
         assert_eq!(
             additional,
-            &DNSAnswerEntry {
-                name: DNSName {
+            &DNSAnswerEntry::new(
+                DNSName {
                     value: vec![],
                     flags: DNSNameFlags::default()
                 },
-                rrtype: DNSRecordType::OPT as u16,
-                rrclass: 0x0200,             // for OPT this is UDP payload size
-                ttl: 0,                      // for OPT this is extended RCODE and flags
-                data: DNSRData::OPT(vec![]), // no rdata
-            }
+                DNSRecordType::OPT as u16,
+                0x0200,                // for OPT this is UDP payload size
+                0,                     // for OPT this is extended RCODE and flags
+                DNSRData::OPT(vec![]), // no rdata
+            )
+        );
+    }
+
+    /// A lazily parsed message decodes to the same records, including
+    /// names compressed with pointers into the rest of the message.
+    #[test]
+    fn test_dns_parse_response_lazy() {
+        let pkt: &[u8] = &[
+            0x82, 0x95, 0x81, 0x83, 0x00, 0x01, /* j....... */
+            0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x03, 0x64, /* .......d */
+            0x6e, 0x65, 0x04, 0x6f, 0x69, 0x73, 0x66, 0x03, /* ne.oisf. */
+            0x6e, 0x65, 0x74, 0x00, 0x00, 0x01, 0x00, 0x01, /* net..... */
+            0xc0, 0x10, 0x00, 0x06, 0x00, 0x01, 0x00, 0x00, /* ........ */
+            0x03, 0x83, 0x00, 0x45, 0x06, 0x6e, 0x73, 0x2d, /* ...E.ns- */
+            0x31, 0x31, 0x30, 0x09, 0x61, 0x77, 0x73, 0x64, /* 110.awsd */
+            0x6e, 0x73, 0x2d, 0x31, 0x33, 0x03, 0x63, 0x6f, /* ns-13.co */
+            0x6d, 0x00, 0x11, 0x61, 0x77, 0x73, 0x64, 0x6e, /* m..awsdn */
+            0x73, 0x2d, 0x68, 0x6f, 0x73, 0x74, 0x6d, 0x61, /* s-hostma */
+            0x73, 0x74, 0x65, 0x72, 0x06, 0x61, 0x6d, 0x61, /* ster.ama */
+            0x7a, 0x6f, 0x6e, 0xc0, 0x3b, 0x00, 0x00, 0x00, /* zon.;... */
+            0x01, 0x00, 0x00, 0x1c, 0x20, 0x00, 0x00, 0x03, /* .... ... */
+            0x84, 0x00, 0x12, 0x75, 0x00, 0x00, 0x01, 0x51, /* ...u...Q */
+            0x80, 0x00, 0x00, 0x29, 0x02, 0x00, 0x00, 0x00, /* ...).... */
+            0x00, 0x00, 0x00, 0x00, /* .... */
+        ];
+
+        let (_, header) = dns_parse_header(pkt).unwrap();
+        let (_, (eager, _)) = dns_parse_body(&pkt[12..], pkt, header, false).unwrap();
+        let (_, header) = dns_parse_header(pkt).unwrap();
+        let (_, (lazy, _)) = dns_parse_body(&pkt[12..], pkt, header, true).unwrap();
+
+        assert_eq!(lazy.authorities.len(), 1);
+        assert_eq!(lazy.authorities, eager.authorities);
+        assert_eq!(lazy.additionals, eager.additionals);
+        assert!(matches!(lazy.authorities[0].data(), DNSRData::SOA(_)));
+
+        // record data that fails to decode is kept as is
+        let mut truncated = pkt.to_vec();
+        truncated[41] = 0x02;
+        let (_, header) = dns_parse_header(&truncated).unwrap();
+        let (_, (lazy, _)) = dns_parse_body(&truncated[12..], &truncated, header, true).unwrap();
+        assert_eq!(
+            *lazy.authorities[0].data(),
+            DNSRData::Unknown(vec![0x06, 0x6e])
         );
     }
 
@@ -994,7 +1104,7 @@ mod tests {
         assert_eq!(answer.rrclass, 1);
         assert_eq!(answer.ttl, 0);
         assert_eq!(
-            answer.data,
+            *answer.data(),
             DNSRData::NULL(vec![
                 0x56, 0x41, 0x43, 0x4b, /* VACK */
                 0x44, 0x03, 0xc5, 0xe9, 0x01, /* D.... */
@@ -1066,7 +1176,7 @@ mod tests {
         assert_eq!(response.answers.len(), 2);
 
         let answer1 = &response.answers[0];
-        if let DNSRData::SRV(srv) = &answer1.data {
+        if let DNSRData::SRV(srv) = answer1.data() {
             assert_eq!(srv.priority, 20);
             assert_eq!(srv.weight, 1);
             assert_eq!(srv.port, 5060);
@@ -1078,7 +1188,7 @@ mod tests {
             panic!("Expected DNSRData::SRV");
         }
         let answer2 = &response.answers[1];
-        if let DNSRData::SRV(srv) = &answer2.data {
+        if let DNSRData::SRV(srv) = answer2.data() {
             assert_eq!(srv.priority, 10);
             assert_eq!(srv.weight, 1);
             assert_eq!(srv.port, 5060);
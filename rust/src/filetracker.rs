@@ -25,12 +25,67 @@
 //! of order, but cannot be transferred in parallel. So only one
 //! chunk at a time.
 //!
+//! Out of order chunks are kept in memory until the gap before them is
+//! filled. Protocols can account that memory against a memcap shared by
+//! all their trackers. If it is reached the file is truncated and flagged
+//! as having gaps.
+//!
 //! Author: Victor Julien <victor@inliniac.net>
 
 use crate::core::*;
 use crate::filecontainer::*;
 use std::collections::hash_map::Entry::{Occupied, Vacant};
 use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+// util-file.h::FILE_HAS_GAPS
+const FILE_HAS_GAPS: u16 = 1 << 15;
+
+/// Memory use of the queued out of order chunks of a protocol.
+#[derive(Debug, Default)]
+pub struct FileChunkMemcap {
+    /// 0 means unlimited
+    memcap: AtomicU64,
+    memuse: AtomicU64,
+    /// number of files that hit the memcap
+    memcap_reached: AtomicU64,
+}
+
+impl FileChunkMemcap {
+    pub const fn new(memcap: u64) -> Self {
+        Self {
+            memcap: AtomicU64::new(memcap),
+            memuse: AtomicU64::new(0),
+            memcap_reached: AtomicU64::new(0),
+        }
+    }
+
+    pub fn set_memcap(&self, memcap: u64) {
+        self.memcap.store(memcap, Ordering::Relaxed);
+    }
+
+    pub fn memuse(&self) -> u64 {
+        self.memuse.load(Ordering::Relaxed)
+    }
+
+    pub fn memcap_reached(&self) -> u64 {
+        self.memcap_reached.load(Ordering::Relaxed)
+    }
+
+    fn reserve(&self, size: u64) -> bool {
+        let memcap = self.memcap.load(Ordering::Relaxed);
+        let memuse = self.memuse.fetch_add(size, Ordering::Relaxed) + size;
+        if memcap != 0 && memuse > memcap {
+            self.memuse.fetch_sub(size, Ordering::Relaxed);
+            return false;
+        }
+        true
+    }
+
+    fn release(&self, size: u64) {
+        self.memuse.fetch_sub(size, Ordering::Relaxed);
+    }
+}
 
 #[derive(Debug)]
 struct FileChunk {
@@ -70,14 +125,27 @@ pub struct FileTransferTracker {
     cur_ooo_chunk_offset: u64,
 
     in_flight: u64,
+    memcap: Option<&'static FileChunkMemcap>,
+    /// memcap was hit, no more data is queued for this file
+    memcap_hit: bool,
+}
+
+impl Drop for FileTransferTracker {
+    fn drop(&mut self) {
+        self.release_chunks();
+    }
 }
 
 impl FileTransferTracker {
     pub fn new() -> FileTransferTracker {
-        FileTransferTracker {
-            chunks: HashMap::new(),
-            ..Default::default()
-        }
+        Self::default()
+    }
+
+    /// New tracker with its queued chunks accounted in `memcap`.
+    pub fn with_memcap(memcap: &'static FileChunkMemcap) -> FileTransferTracker {
+        let mut tracker = Self::new();
+        tracker.memcap = Some(memcap);
+        tracker
     }
 
     pub fn is_done(&self) -> bool {
@@ -110,18 +178,49 @@ impl FileTransferTracker {
     }
 
     pub fn trunc(&mut self, config: &'static SuricataFileContext) {
+        self.trunc_flags(config, 0);
+    }
+
+    fn trunc_flags(&mut self, config: &'static SuricataFileContext, flags: u16) {
         if self.file_is_truncated || !self.file_open {
             return;
         }
-        let myflags = self.file_flags | 1; // TODO util-file.c::FILE_TRUNCATED
+        let myflags = self.file_flags | flags | 1; // TODO util-file.c::FILE_TRUNCATED
         self.file.file_close(config, &self.track_id, myflags);
         SCLogDebug!("truncated file");
         self.file_is_truncated = true;
+        self.release_chunks();
+    }
+
+    fn release_chunks(&mut self) {
+        if let Some(memcap) = self.memcap {
+            memcap.release(self.in_flight);
+        }
         self.chunks.clear();
         self.in_flight = 0;
         self.cur_ooo = 0;
     }
 
+    /// Account for `size` more bytes of out of order data. If this would
+    /// exceed the memcap, the file is truncated instead. As the queued data
+    /// is dropped, the file is flagged as having gaps.
+    fn queue_reserve(&mut self, config: &'static SuricataFileContext, size: usize) -> bool {
+        if let Some(memcap) = self.memcap {
+            if self.memcap_hit {
+                return false;
+            }
+            if !memcap.reserve(size as u64) {
+                SCLogDebug!("file chunk memcap reached: truncating");
+                // count the file once, also if it could not be truncated
+                memcap.memcap_reached.fetch_add(1, Ordering::Relaxed);
+                self.memcap_hit = true;
+                self.trunc_flags(config, FILE_HAS_GAPS);
+                return false;
+            }
+        }
+        true
+    }
+
     pub fn new_chunk(
         &mut self, config: &'static SuricataFileContext, name: &[u8], data: &[u8],
         chunk_offset: u64, chunk_size: u32, fill_bytes: u8, is_last: bool, xid: &u32,
@@ -240,7 +339,7 @@ impl FileTransferTracker {
                     }
 
                     self.tracked += self.chunk_left as u64;
-                } else {
+                } else if self.queue_reserve(config, d.len()) {
                     SCLogDebug!(
                         "UPDATE: appending data {} to ooo chunk at offset {}/{}",
                         d.len(),
@@ -281,6 +380,9 @@ impl FileTransferTracker {
                             match self.chunks.remove(&self.tracked) {
                                 Some(c) => {
                                     self.in_flight -= c.chunk.len() as u64;
+                                    if let Some(memcap) = self.memcap {
+                                        memcap.release(c.chunk.len() as u64);
+                                    }
 
                                     let res = self.file.file_append(
                                         config,
@@ -344,7 +446,7 @@ impl FileTransferTracker {
                         }
                     }
                     self.tracked += data.len() as u64;
-                } else {
+                } else if self.queue_reserve(config, data.len()) {
                     let c = match self.chunks.entry(self.cur_ooo_chunk_offset) {
                         Vacant(entry) => entry.insert(FileChunk::new(32768)),
                         Occupied(entry) => entry.into_mut(),
@@ -373,3 +475,78 @@ impl FileTransferTracker {
         self.chunks.len()
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_file_chunk_memcap() {
+        let m = FileChunkMemcap::new(100);
+        assert!(m.reserve(60));
+        assert!(!m.reserve(41));
+        assert_eq!(m.memuse(), 60);
+        assert!(m.reserve(40));
+        m.release(100);
+        assert_eq!(m.memuse(), 0);
+        m.set_memcap(0);
+        assert!(m.reserve(1 << 40));
+    }
+
+    fn test_file_context() -> &'static SuricataFileContext {
+        let sbcfg: &'static StreamingBufferConfig = Box::leak(Box::default());
+        Box::leak(Box::new(SuricataFileContext { files_sbcfg: sbcfg }))
+    }
+
+    #[test]
+    fn test_file_tracker_memcap() {
+        static MEMCAP: FileChunkMemcap = FileChunkMemcap::new(100);
+        let config = test_file_context();
+        let mut ft = FileTransferTracker::with_memcap(&MEMCAP);
+
+        // out of order chunk is queued
+        let data = [0x41_u8; 80];
+        assert_eq!(
+            ft.new_chunk(config, b"f", &data, 1000, 80, 0, false, &1),
+            80
+        );
+        assert!(ft.file_open);
+        assert_eq!(ft.get_inflight_size(), 80);
+        assert_eq!(MEMCAP.memuse(), 80);
+
+        // next one does not fit: the file is truncated and its queue freed
+        assert_eq!(
+            ft.new_chunk(config, b"f", &data, 2000, 80, 0, false, &1),
+            80
+        );
+        assert!(ft.file_is_truncated);
+        assert!(ft.memcap_hit);
+        assert_eq!(ft.get_inflight_size(), 0);
+        assert_eq!(ft.get_inflight_cnt(), 0);
+        assert_eq!(MEMCAP.memuse(), 0);
+        assert_eq!(MEMCAP.memcap_reached(), 1);
+
+        drop(ft);
+        assert_eq!(MEMCAP.memuse(), 0);
+    }
+
+    #[test]
+    fn test_file_tracker_memcap_count_once() {
+        static MEMCAP: FileChunkMemcap = FileChunkMemcap::new(100);
+        let config = test_file_context();
+        // file not open, so truncating it is a no-op
+        let mut ft = FileTransferTracker::with_memcap(&MEMCAP);
+        assert!(!ft.queue_reserve(config, 200));
+        assert!(!ft.queue_reserve(config, 200));
+        assert!(!ft.queue_reserve(config, 10));
+        assert_eq!(MEMCAP.memcap_reached(), 1);
+        assert_eq!(MEMCAP.memuse(), 0);
+
+        // other files still get to use the memcap
+        let mut ft2 = FileTransferTracker::with_memcap(&MEMCAP);
+        assert!(ft2.queue_reserve(config, 10));
+        assert_eq!(MEMCAP.memuse(), 10);
+        assert_eq!(MEMCAP.memcap_reached(), 1);
+        MEMCAP.release(10);
+    }
+}
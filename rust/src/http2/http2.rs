@@ -35,10 +35,12 @@ use crate::dns::dns::{dns_parse_request, dns_parse_response, DNSTransaction};
 
 use nom7::Err;
 use std;
+use std::cell::OnceCell;
 use std::collections::VecDeque;
 use std::ffi::CString;
 use std::fmt;
 use std::io;
+use std::rc::Rc;
 use suricata_sys::sys::AppProtoEnum::ALPROTO_HTTP1;
 use suricata_sys::sys::{
     AppLayerParserState, AppProto, HttpRangeContainerBlock, SCAppLayerForceProtocolChange,
@@ -561,6 +563,9 @@ pub enum HTTP2Event {
 
 pub struct HTTP2DynTable {
     pub table: Vec<parser::HTTP2FrameHeaderBlock>,
+    /// Static table entries referenced so far on this connection, shared by
+    /// all the header blocks using them.
+    pub static_table: [OnceCell<(Rc<Vec<u8>>, Rc<Vec<u8>>)>; parser::HTTP2_STATIC_HEADERS_NUMBER],
     pub current_size: usize,
     pub max_size: usize,
     pub overflow: u8,
@@ -576,6 +581,7 @@ impl HTTP2DynTable {
     pub fn new() -> Self {
         Self {
             table: Vec::with_capacity(64),
+            static_table: std::array::from_fn(|_| OnceCell::new()),
             current_size: 0,
             max_size: 4096, //default value
             overflow: 0,
@@ -604,6 +610,10 @@ pub struct HTTP2State {
 
     c2s_buf: HTTP2HeaderReassemblyBuffer,
     s2c_buf: HTTP2HeaderReassemblyBuffer,
+
+    /// ids of the txs updated by the current parser call, handed to the
+    /// engine tx ready queue once parsing is done
+    tx_ready: Vec<u64>,
 }
 
 impl State<HTTP2Transaction> for HTTP2State {
@@ -640,6 +650,21 @@ impl HTTP2State {
             decomp_len: 0,
             c2s_buf: HTTP2HeaderReassemblyBuffer::default(),
             s2c_buf: HTTP2HeaderReassemblyBuffer::default(),
+            tx_ready: Vec::new(),
+        }
+    }
+
+    /// Record a tx as updated. `tx_id` is our internal 1 based id.
+    fn set_tx_ready(&mut self, tx_id: u64) {
+        if self.tx_ready.last() != Some(&(tx_id - 1)) {
+            self.tx_ready.push(tx_id - 1);
+        }
+    }
+
+    /// Hand the updated txs over to the engine.
+    fn flush_tx_ready(&mut self, pstate: *mut AppLayerParserState) {
+        for tx_id in self.tx_ready.drain(..) {
+            sc_app_layer_parser_tx_ready(pstate, tx_id);
         }
     }
 
@@ -672,6 +697,7 @@ impl HTTP2State {
         if len == 0 {
             return;
         }
+        self.set_tx_ready(self.transactions[len - 1].tx_id);
         let tx = &mut self.transactions[len - 1];
         tx.tx_data.set_event(event as u8);
     }
@@ -754,6 +780,7 @@ impl HTTP2State {
         tx.tx_data = AppLayerTxData::for_direction(dir);
         self.tx_id += 1;
         tx.tx_id = self.tx_id;
+        self.set_tx_ready(tx.tx_id);
         tx.progress_tc = HTTP2TxProgress::HTTP2ProgGlobal;
         tx.progress_ts = HTTP2TxProgress::HTTP2ProgGlobal;
         // a global tx (stream id 0) does not hold files cf RFC 9113 section 5.1.1
@@ -778,6 +805,7 @@ impl HTTP2State {
                     tx_old.to_drop = true;
                     tx_old.tx_data.0.updated_tc = true;
                     tx_old.tx_data.0.updated_ts = true;
+                    self.tx_ready.push(tx_old.tx_id - 1);
                 }
                 return None;
             }
@@ -810,6 +838,7 @@ impl HTTP2State {
                 }
             }
 
+            self.set_tx_ready(self.transactions[index - 1].tx_id);
             let tx = &mut self.transactions[index - 1];
             tx.tx_data.update_file_flags(self.state_data.file_flags);
             tx.update_file_flags(tx.tx_data.0.file_flags);
@@ -831,12 +860,14 @@ impl HTTP2State {
                     tx_old.to_drop = true;
                     tx_old.tx_data.0.updated_tc = true;
                     tx_old.tx_data.0.updated_ts = true;
+                    self.tx_ready.push(tx_old.tx_id - 1);
                 }
                 return None;
             }
             let mut tx = HTTP2Transaction::new();
             self.tx_id += 1;
             tx.tx_id = self.tx_id;
+            self.set_tx_ready(tx.tx_id);
             tx.stream_id = sid;
             tx.tx_data.update_file_flags(self.state_data.file_flags);
             tx.update_file_flags(tx.tx_data.0.file_flags);
@@ -1490,19 +1521,23 @@ unsafe extern "C" fn http2_state_tx_free(state: *mut std::os::raw::c_void, tx_id
 }
 
 unsafe extern "C" fn http2_parse_ts(
-    flow: *mut Flow, state: *mut std::os::raw::c_void, _pstate: *mut AppLayerParserState,
+    flow: *mut Flow, state: *mut std::os::raw::c_void, pstate: *mut AppLayerParserState,
     stream_slice: StreamSlice, _data: *mut std::os::raw::c_void,
 ) -> AppLayerResult {
     let state = cast_pointer!(state, HTTP2State);
-    return state.parse_ts(flow, stream_slice);
+    let r = state.parse_ts(flow, stream_slice);
+    state.flush_tx_ready(pstate);
+    return r;
 }
 
 unsafe extern "C" fn http2_parse_tc(
-    flow: *mut Flow, state: *mut std::os::raw::c_void, _pstate: *mut AppLayerParserState,
+    flow: *mut Flow, state: *mut std::os::raw::c_void, pstate: *mut AppLayerParserState,
     stream_slice: StreamSlice, _data: *mut std::os::raw::c_void,
 ) -> AppLayerResult {
     let state = cast_pointer!(state, HTTP2State);
-    return state.parse_tc(flow, stream_slice);
+    let r = state.parse_tc(flow, stream_slice);
+    state.flush_tx_ready(pstate);
+    return r;
 }
 
 unsafe extern "C" fn http2_state_get_tx(
@@ -1588,7 +1623,7 @@ pub unsafe extern "C" fn SCRegisterHttp2Parser() {
         get_tx_data: http2_get_tx_data,
         get_state_data: http2_get_state_data,
         apply_tx_config: None,
-        flags: 0,
+        flags: APP_LAYER_PARSER_OPT_TX_READY_QUEUE,
         get_frame_id_by_name: Some(Http2FrameType::ffi_id_from_name),
         get_frame_name_by_id: Some(Http2FrameType::ffi_name_from_id),
         get_state_id_by_name: None,
@@ -15,513 +15,478 @@
  * 02110-1301, USA.
  */
 
-use nom7::bits::streaming::take as take_bits;
-use nom7::branch::alt;
-use nom7::combinator::{complete, map_opt};
-use nom7::error::{make_error, ErrorKind};
-use nom7::{Err, IResult};
-
-fn http2_huffman_table_len5(n: u32) -> Option<u8> {
-    match n {
-        0 => Some(48),
-        1 => Some(49),
-        2 => Some(50),
-        3 => Some(97),
-        4 => Some(99),
-        5 => Some(101),
-        6 => Some(105),
-        7 => Some(111),
-        8 => Some(115),
-        9 => Some(116),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len5(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(5u32), http2_huffman_table_len5))(input)
-}
-
-fn http2_huffman_table_len6(n: u32) -> Option<u8> {
-    match n {
-        0x14 => Some(32),
-        0x15 => Some(37),
-        0x16 => Some(45),
-        0x17 => Some(46),
-        0x18 => Some(47),
-        0x19 => Some(51),
-        0x1a => Some(52),
-        0x1b => Some(53),
-        0x1c => Some(54),
-        0x1d => Some(55),
-        0x1e => Some(56),
-        0x1f => Some(57),
-        0x20 => Some(61),
-        0x21 => Some(65),
-        0x22 => Some(95),
-        0x23 => Some(98),
-        0x24 => Some(100),
-        0x25 => Some(102),
-        0x26 => Some(103),
-        0x27 => Some(104),
-        0x28 => Some(108),
-        0x29 => Some(109),
-        0x2a => Some(110),
-        0x2b => Some(112),
-        0x2c => Some(114),
-        0x2d => Some(117),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len6(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(6u32), http2_huffman_table_len6))(input)
-}
-
-fn http2_huffman_table_len7(n: u32) -> Option<u8> {
-    match n {
-        0x5c => Some(58),
-        0x5d => Some(66),
-        0x5e => Some(67),
-        0x5f => Some(68),
-        0x60 => Some(69),
-        0x61 => Some(70),
-        0x62 => Some(71),
-        0x63 => Some(72),
-        0x64 => Some(73),
-        0x65 => Some(74),
-        0x66 => Some(75),
-        0x67 => Some(76),
-        0x68 => Some(77),
-        0x69 => Some(78),
-        0x6a => Some(79),
-        0x6b => Some(80),
-        0x6c => Some(81),
-        0x6d => Some(82),
-        0x6e => Some(83),
-        0x6f => Some(84),
-        0x70 => Some(85),
-        0x71 => Some(86),
-        0x72 => Some(87),
-        0x73 => Some(89),
-        0x74 => Some(106),
-        0x75 => Some(107),
-        0x76 => Some(113),
-        0x77 => Some(118),
-        0x78 => Some(119),
-        0x79 => Some(120),
-        0x7a => Some(121),
-        0x7b => Some(122),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len7(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(7u32), http2_huffman_table_len7))(input)
-}
-
-fn http2_huffman_table_len8(n: u32) -> Option<u8> {
-    match n {
-        0xf8 => Some(38),
-        0xf9 => Some(42),
-        0xfa => Some(44),
-        0xfb => Some(59),
-        0xfc => Some(88),
-        0xfd => Some(90),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len8(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(8u32), http2_huffman_table_len8))(input)
-}
-
-fn http2_huffman_table_len10(n: u32) -> Option<u8> {
-    match n {
-        0x3f8 => Some(33),
-        0x3f9 => Some(34),
-        0x3fa => Some(40),
-        0x3fb => Some(41),
-        0x3fc => Some(63),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len10(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(10u32), http2_huffman_table_len10))(input)
-}
-
-fn http2_huffman_table_len11(n: u32) -> Option<u8> {
-    match n {
-        0x7fa => Some(39),
-        0x7fb => Some(43),
-        0x7fc => Some(124),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len11(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(11u32), http2_huffman_table_len11))(input)
-}
-
-fn http2_huffman_table_len12(n: u32) -> Option<u8> {
-    match n {
-        0xffa => Some(35),
-        0xffb => Some(62),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len12(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(12u32), http2_huffman_table_len12))(input)
-}
-
-fn http2_huffman_table_len13(n: u32) -> Option<u8> {
-    match n {
-        0x1ff8 => Some(0),
-        0x1ff9 => Some(36),
-        0x1ffa => Some(64),
-        0x1ffb => Some(91),
-        0x1ffc => Some(93),
-        0x1ffd => Some(126),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len13(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(13u32), http2_huffman_table_len13))(input)
-}
-
-fn http2_huffman_table_len14(n: u32) -> Option<u8> {
-    match n {
-        0x3ffc => Some(94),
-        0x3ffd => Some(125),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len14(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(14u32), http2_huffman_table_len14))(input)
-}
-
-fn http2_huffman_table_len15(n: u32) -> Option<u8> {
-    match n {
-        0x7ffc => Some(60),
-        0x7ffd => Some(96),
-        0x7ffe => Some(123),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len15(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(15u32), http2_huffman_table_len15))(input)
-}
-
-fn http2_huffman_table_len19(n: u32) -> Option<u8> {
-    match n {
-        0x7fff0 => Some(92),
-        0x7fff1 => Some(195),
-        0x7fff2 => Some(208),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len19(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(19u32), http2_huffman_table_len19))(input)
-}
-
-fn http2_huffman_table_len20(n: u32) -> Option<u8> {
-    match n {
-        0xfffe6 => Some(128),
-        0xfffe7 => Some(130),
-        0xfffe8 => Some(131),
-        0xfffe9 => Some(162),
-        0xfffea => Some(184),
-        0xfffeb => Some(194),
-        0xfffec => Some(224),
-        0xfffed => Some(226),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len20(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(20u32), http2_huffman_table_len20))(input)
-}
-
-fn http2_huffman_table_len21(n: u32) -> Option<u8> {
-    match n {
-        0x1fffdc => Some(153),
-        0x1fffdd => Some(161),
-        0x1fffde => Some(167),
-        0x1fffdf => Some(172),
-        0x1fffe0 => Some(176),
-        0x1fffe1 => Some(177),
-        0x1fffe2 => Some(179),
-        0x1fffe3 => Some(209),
-        0x1fffe4 => Some(216),
-        0x1fffe5 => Some(217),
-        0x1fffe6 => Some(227),
-        0x1fffe7 => Some(229),
-        0x1fffe8 => Some(230),
-        _ => None,
-    }
-}
-
-fn http2_decode_huffman_len21(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(21u32), http2_huffman_table_len21))(input)
-}
-
-fn http2_huffman_table_len22(n: u32) -> Option<u8> {
-    match n {
-        0x3fffd2 => Some(129),
-        0x3fffd3 => Some(132),
-        0x3fffd4 => Some(133),
-        0x3fffd5 => Some(134),
-        0x3fffd6 => Some(136),
-        0x3fffd7 => Some(146),
-        0x3fffd8 => Some(154),
-        0x3fffd9 => Some(156),
-        0x3fffda => Some(160),
-        0x3fffdb => Some(163),
-        0x3fffdc => Some(164),
-        0x3fffdd => Some(169),
-        0x3fffde => Some(170),
-        0x3fffdf => Some(173),
-        0x3fffe0 => Some(178),
-        0x3fffe1 => Some(181),
-        0x3fffe2 => Some(185),
-        0x3fffe3 => Some(186),
-        0x3fffe4 => Some(187),
-        0x3fffe5 => Some(189),
-        0x3fffe6 => Some(190),
-        0x3fffe7 => Some(196),
-        0x3fffe8 => Some(198),
-        0x3fffe9 => Some(228),
-        0x3fffea => Some(232),
-        0x3fffeb => Some(233),
-        _ => None,
+//! HPACK Huffman decoding (RFC 7541 section 5.2).
+//!
+//! Codes of up to 8 bits, which cover the characters found in most header
+//! names and values, are resolved with a single lookup on the next byte of
+//! input. The HPACK code is canonical, so longer codes are resolved by
+//! comparing the next bits against the first code of each length.
+
+/// Code and length in bits of each symbol, from RFC 7541 Appendix B.
+/// The last entry is the EOS symbol.
+pub const HUFFMAN_CODES: [(u32, u8); 257] = [
+    (0x1ff8, 13),
+    (0x7fffd8, 23),
+    (0xfffffe2, 28),
+    (0xfffffe3, 28),
+    (0xfffffe4, 28),
+    (0xfffffe5, 28),
+    (0xfffffe6, 28),
+    (0xfffffe7, 28),
+    (0xfffffe8, 28),
+    (0xffffea, 24),
+    (0x3ffffffc, 30),
+    (0xfffffe9, 28),
+    (0xfffffea, 28),
+    (0x3ffffffd, 30),
+    (0xfffffeb, 28),
+    (0xfffffec, 28),
+    (0xfffffed, 28),
+    (0xfffffee, 28),
+    (0xfffffef, 28),
+    (0xffffff0, 28),
+    (0xffffff1, 28),
+    (0xffffff2, 28),
+    (0x3ffffffe, 30),
+    (0xffffff3, 28),
+    (0xffffff4, 28),
+    (0xffffff5, 28),
+    (0xffffff6, 28),
+    (0xffffff7, 28),
+    (0xffffff8, 28),
+    (0xffffff9, 28),
+    (0xffffffa, 28),
+    (0xffffffb, 28),
+    (0x14, 6),
+    (0x3f8, 10),
+    (0x3f9, 10),
+    (0xffa, 12),
+    (0x1ff9, 13),
+    (0x15, 6),
+    (0xf8, 8),
+    (0x7fa, 11),
+    (0x3fa, 10),
+    (0x3fb, 10),
+    (0xf9, 8),
+    (0x7fb, 11),
+    (0xfa, 8),
+    (0x16, 6),
+    (0x17, 6),
+    (0x18, 6),
+    (0x0, 5),
+    (0x1, 5),
+    (0x2, 5),
+    (0x19, 6),
+    (0x1a, 6),
+    (0x1b, 6),
+    (0x1c, 6),
+    (0x1d, 6),
+    (0x1e, 6),
+    (0x1f, 6),
+    (0x5c, 7),
+    (0xfb, 8),
+    (0x7ffc, 15),
+    (0x20, 6),
+    (0xffb, 12),
+    (0x3fc, 10),
+    (0x1ffa, 13),
+    (0x21, 6),
+    (0x5d, 7),
+    (0x5e, 7),
+    (0x5f, 7),
+    (0x60, 7),
+    (0x61, 7),
+    (0x62, 7),
+    (0x63, 7),
+    (0x64, 7),
+    (0x65, 7),
+    (0x66, 7),
+    (0x67, 7),
+    (0x68, 7),
+    (0x69, 7),
+    (0x6a, 7),
+    (0x6b, 7),
+    (0x6c, 7),
+    (0x6d, 7),
+    (0x6e, 7),
+    (0x6f, 7),
+    (0x70, 7),
+    (0x71, 7),
+    (0x72, 7),
+    (0xfc, 8),
+    (0x73, 7),
+    (0xfd, 8),
+    (0x1ffb, 13),
+    (0x7fff0, 19),
+    (0x1ffc, 13),
+    (0x3ffc, 14),
+    (0x22, 6),
+    (0x7ffd, 15),
+    (0x3, 5),
+    (0x23, 6),
+    (0x4, 5),
+    (0x24, 6),
+    (0x5, 5),
+    (0x25, 6),
+    (0x26, 6),
+    (0x27, 6),
+    (0x6, 5),
+    (0x74, 7),
+    (0x75, 7),
+    (0x28, 6),
+    (0x29, 6),
+    (0x2a, 6),
+    (0x7, 5),
+    (0x2b, 6),
+    (0x76, 7),
+    (0x2c, 6),
+    (0x8, 5),
+    (0x9, 5),
+    (0x2d, 6),
+    (0x77, 7),
+    (0x78, 7),
+    (0x79, 7),
+    (0x7a, 7),
+    (0x7b, 7),
+    (0x7ffe, 15),
+    (0x7fc, 11),
+    (0x3ffd, 14),
+    (0x1ffd, 13),
+    (0xffffffc, 28),
+    (0xfffe6, 20),
+    (0x3fffd2, 22),
+    (0xfffe7, 20),
+    (0xfffe8, 20),
+    (0x3fffd3, 22),
+    (0x3fffd4, 22),
+    (0x3fffd5, 22),
+    (0x7fffd9, 23),
+    (0x3fffd6, 22),
+    (0x7fffda, 23),
+    (0x7fffdb, 23),
+    (0x7fffdc, 23),
+    (0x7fffdd, 23),
+    (0x7fffde, 23),
+    (0xffffeb, 24),
+    (0x7fffdf, 23),
+    (0xffffec, 24),
+    (0xffffed, 24),
+    (0x3fffd7, 22),
+    (0x7fffe0, 23),
+    (0xffffee, 24),
+    (0x7fffe1, 23),
+    (0x7fffe2, 23),
+    (0x7fffe3, 23),
+    (0x7fffe4, 23),
+    (0x1fffdc, 21),
+    (0x3fffd8, 22),
+    (0x7fffe5, 23),
+    (0x3fffd9, 22),
+    (0x7fffe6, 23),
+    (0x7fffe7, 23),
+    (0xffffef, 24),
+    (0x3fffda, 22),
+    (0x1fffdd, 21),
+    (0xfffe9, 20),
+    (0x3fffdb, 22),
+    (0x3fffdc, 22),
+    (0x7fffe8, 23),
+    (0x7fffe9, 23),
+    (0x1fffde, 21),
+    (0x7fffea, 23),
+    (0x3fffdd, 22),
+    (0x3fffde, 22),
+    (0xfffff0, 24),
+    (0x1fffdf, 21),
+    (0x3fffdf, 22),
+    (0x7fffeb, 23),
+    (0x7fffec, 23),
+    (0x1fffe0, 21),
+    (0x1fffe1, 21),
+    (0x3fffe0, 22),
+    (0x1fffe2, 21),
+    (0x7fffed, 23),
+    (0x3fffe1, 22),
+    (0x7fffee, 23),
+    (0x7fffef, 23),
+    (0xfffea, 20),
+    (0x3fffe2, 22),
+    (0x3fffe3, 22),
+    (0x3fffe4, 22),
+    (0x7ffff0, 23),
+    (0x3fffe5, 22),
+    (0x3fffe6, 22),
+    (0x7ffff1, 23),
+    (0x3ffffe0, 26),
+    (0x3ffffe1, 26),
+    (0xfffeb, 20),
+    (0x7fff1, 19),
+    (0x3fffe7, 22),
+    (0x7ffff2, 23),
+    (0x3fffe8, 22),
+    (0x1ffffec, 25),
+    (0x3ffffe2, 26),
+    (0x3ffffe3, 26),
+    (0x3ffffe4, 26),
+    (0x7ffffde, 27),
+    (0x7ffffdf, 27),
+    (0x3ffffe5, 26),
+    (0xfffff1, 24),
+    (0x1ffffed, 25),
+    (0x7fff2, 19),
+    (0x1fffe3, 21),
+    (0x3ffffe6, 26),
+    (0x7ffffe0, 27),
+    (0x7ffffe1, 27),
+    (0x3ffffe7, 26),
+    (0x7ffffe2, 27),
+    (0xfffff2, 24),
+    (0x1fffe4, 21),
+    (0x1fffe5, 21),
+    (0x3ffffe8, 26),
+    (0x3ffffe9, 26),
+    (0xffffffd, 28),
+    (0x7ffffe3, 27),
+    (0x7ffffe4, 27),
+    (0x7ffffe5, 27),
+    (0xfffec, 20),
+    (0xfffff3, 24),
+    (0xfffed, 20),
+    (0x1fffe6, 21),
+    (0x3fffe9, 22),
+    (0x1fffe7, 21),
+    (0x1fffe8, 21),
+    (0x7ffff3, 23),
+    (0x3fffea, 22),
+    (0x3fffeb, 22),
+    (0x1ffffee, 25),
+    (0x1ffffef, 25),
+    (0xfffff4, 24),
+    (0xfffff5, 24),
+    (0x3ffffea, 26),
+    (0x7ffff4, 23),
+    (0x3ffffeb, 26),
+    (0x7ffffe6, 27),
+    (0x3ffffec, 26),
+    (0x3ffffed, 26),
+    (0x7ffffe7, 27),
+    (0x7ffffe8, 27),
+    (0x7ffffe9, 27),
+    (0x7ffffea, 27),
+    (0x7ffffeb, 27),
+    (0xffffffe, 28),
+    (0x7ffffec, 27),
+    (0x7ffffed, 27),
+    (0x7ffffee, 27),
+    (0x7ffffef, 27),
+    (0x7fffff0, 27),
+    (0x3ffffee, 26),
+    (0x3fffffff, 30),
+];
+
+const HUFFMAN_EOS: u16 = 256;
+const HUFFMAN_MAX_LEN: usize = 30;
+
+/// Decoded symbol for each value of the next 8 bits of input, as
+/// `length << 8 | symbol`, or 0 if the code is longer than 8 bits.
+static HUFFMAN_LOOKUP: [u16; 256] = huffman_build_lookup();
+
+struct HuffmanCanonical {
+    /// First code of each length.
+    first: [u32; HUFFMAN_MAX_LEN + 1],
+    /// One past the last code of each length.
+    limit: [u32; HUFFMAN_MAX_LEN + 1],
+    /// Index in `symbols` of the first code of each length.
+    offset: [u16; HUFFMAN_MAX_LEN + 1],
+    /// Symbols sorted by code.
+    symbols: [u16; 257],
+}
+
+static HUFFMAN_CANONICAL: HuffmanCanonical = huffman_build_canonical();
+
+const fn huffman_build_lookup() -> [u16; 256] {
+    let mut table = [0u16; 256];
+    let mut sym = 0;
+    while sym < 256 {
+        let (code, len) = HUFFMAN_CODES[sym];
+        if len <= 8 {
+            let shift = 8 - len;
+            let base = (code << shift) as usize;
+            let mut i = 0;
+            while i < (1 << shift) {
+                table[base + i] = (len as u16) << 8 | sym as u16;
+                i += 1;
+            }
+        }
+        sym += 1;
     }
-}
-
-fn http2_decode_huffman_len22(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(22u32), http2_huffman_table_len22))(input)
-}
-
-fn http2_huffman_table_len23(n: u32) -> Option<u8> {
-    match n {
-        0x7fffd8 => Some(1),
-        0x7fffd9 => Some(135),
-        0x7fffda => Some(137),
-        0x7fffdb => Some(138),
-        0x7fffdc => Some(139),
-        0x7fffdd => Some(140),
-        0x7fffde => Some(141),
-        0x7fffdf => Some(143),
-        0x7fffe0 => Some(147),
-        0x7fffe1 => Some(149),
-        0x7fffe2 => Some(150),
-        0x7fffe3 => Some(151),
-        0x7fffe4 => Some(152),
-        0x7fffe5 => Some(155),
-        0x7fffe6 => Some(157),
-        0x7fffe7 => Some(158),
-        0x7fffe8 => Some(165),
-        0x7fffe9 => Some(166),
-        0x7fffea => Some(168),
-        0x7fffeb => Some(174),
-        0x7fffec => Some(175),
-        0x7fffed => Some(180),
-        0x7fffee => Some(182),
-        0x7fffef => Some(183),
-        0x7ffff0 => Some(188),
-        0x7ffff1 => Some(191),
-        0x7ffff2 => Some(197),
-        0x7ffff3 => Some(231),
-        0x7ffff4 => Some(239),
-        _ => None,
+    table
+}
+
+const fn huffman_build_canonical() -> HuffmanCanonical {
+    let mut t = HuffmanCanonical {
+        first: [0; HUFFMAN_MAX_LEN + 1],
+        limit: [0; HUFFMAN_MAX_LEN + 1],
+        offset: [0; HUFFMAN_MAX_LEN + 1],
+        symbols: [0; 257],
+    };
+    let mut code = 0;
+    let mut n = 0;
+    let mut len = 1;
+    while len <= HUFFMAN_MAX_LEN {
+        t.first[len] = code;
+        t.offset[len] = n as u16;
+        let mut sym = 0;
+        while sym < HUFFMAN_CODES.len() {
+            if HUFFMAN_CODES[sym].1 as usize == len {
+                t.symbols[n] = sym as u16;
+                n += 1;
+                code += 1;
+            }
+            sym += 1;
+        }
+        t.limit[len] = code;
+        code <<= 1;
+        len += 1;
     }
-}
-
-fn http2_decode_huffman_len23(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(23u32), http2_huffman_table_len23))(input)
-}
-
-fn http2_huffman_table_len24(n: u32) -> Option<u8> {
-    match n {
-        0xffffea => Some(9),
-        0xffffeb => Some(142),
-        0xffffec => Some(144),
-        0xffffed => Some(145),
-        0xffffee => Some(148),
-        0xffffef => Some(159),
-        0xfffff0 => Some(171),
-        0xfffff1 => Some(206),
-        0xfffff2 => Some(215),
-        0xfffff3 => Some(225),
-        0xfffff4 => Some(236),
-        0xfffff5 => Some(237),
-        _ => None,
+    t
+}
+
+/// Decode a Huffman encoded string.
+///
+/// Decoding stops at the EOS symbol or when the remaining bits do not make
+/// up a full code, which covers the padding at the end of the string.
+pub fn http2_decode_huffman(input: &[u8]) -> Vec<u8> {
+    // codes are at least 5 bits long
+    let mut out = Vec::with_capacity(input.len() * 8 / 5);
+    // pending bits, most significant first
+    let mut acc: u64 = 0;
+    let mut nbits: usize = 0;
+    let mut pos = 0;
+    loop {
+        while nbits <= 56 && pos < input.len() {
+            acc |= (input[pos] as u64) << (56 - nbits);
+            nbits += 8;
+            pos += 1;
+        }
+        let entry = HUFFMAN_LOOKUP[(acc >> 56) as usize];
+        let mut len = (entry >> 8) as usize;
+        let sym = if len != 0 {
+            entry & 0xff
+        } else {
+            let t = &HUFFMAN_CANONICAL;
+            len = 9;
+            while len <= nbits && (acc >> (64 - len)) as u32 >= t.limit[len] {
+                len += 1;
+            }
+            if len > nbits {
+                break;
+            }
+            let code = (acc >> (64 - len)) as u32;
+            t.symbols[t.offset[len] as usize + (code - t.first[len]) as usize]
+        };
+        if len > nbits || sym == HUFFMAN_EOS {
+            break;
+        }
+        out.push(sym as u8);
+        acc <<= len;
+        nbits -= len;
     }
-}
-
-fn http2_decode_huffman_len24(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(24u32), http2_huffman_table_len24))(input)
-}
-
-fn http2_huffman_table_len25(n: u32) -> Option<u8> {
-    match n {
-        0x1ffffec => Some(199),
-        0x1ffffed => Some(207),
-        0x1ffffee => Some(234),
-        0x1ffffef => Some(235),
-        _ => None,
+    out
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Bit by bit decoder, to check the table driven one against.
+    fn reference_decode(input: &[u8]) -> Vec<u8> {
+        let mut out = Vec::new();
+        let mut code = 0u32;
+        let mut len = 0;
+        for i in 0..input.len() * 8 {
+            code = code << 1 | ((input[i / 8] >> (7 - i % 8)) & 1) as u32;
+            len += 1;
+            if let Some(sym) = HUFFMAN_CODES
+                .iter()
+                .position(|&(c, l)| l == len && c == code)
+            {
+                if sym == HUFFMAN_EOS as usize {
+                    break;
+                }
+                out.push(sym as u8);
+                code = 0;
+                len = 0;
+            }
+        }
+        out
     }
-}
-
-fn http2_decode_huffman_len25(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(25u32), http2_huffman_table_len25))(input)
-}
 
-fn http2_huffman_table_len26(n: u32) -> Option<u8> {
-    match n {
-        0x3ffffe0 => Some(192),
-        0x3ffffe1 => Some(193),
-        0x3ffffe2 => Some(200),
-        0x3ffffe3 => Some(201),
-        0x3ffffe4 => Some(202),
-        0x3ffffe5 => Some(205),
-        0x3ffffe6 => Some(210),
-        0x3ffffe7 => Some(213),
-        0x3ffffe8 => Some(218),
-        0x3ffffe9 => Some(219),
-        0x3ffffea => Some(238),
-        0x3ffffeb => Some(240),
-        0x3ffffec => Some(242),
-        0x3ffffed => Some(243),
-        0x3ffffee => Some(255),
-        _ => None,
+    fn encode(input: &[u8], eos: bool) -> Vec<u8> {
+        let mut syms: Vec<usize> = input.iter().map(|&c| c as usize).collect();
+        if eos {
+            syms.push(HUFFMAN_EOS as usize);
+        }
+        let mut out = Vec::new();
+        let mut acc = 0u64;
+        let mut nbits = 0;
+        for sym in syms {
+            let (code, len) = HUFFMAN_CODES[sym];
+            acc = acc << len | code as u64;
+            nbits += len;
+            while nbits >= 8 {
+                nbits -= 8;
+                out.push((acc >> nbits) as u8);
+            }
+        }
+        if nbits > 0 {
+            // pad with the most significant bits of EOS
+            out.push((acc << (8 - nbits)) as u8 | (0xff >> nbits));
+        }
+        out
     }
-}
-
-fn http2_decode_huffman_len26((i, bit_offset): (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(26u32), http2_huffman_table_len26))((i, bit_offset))
-}
 
-fn http2_huffman_table_len27(n: u32) -> Option<u8> {
-    match n {
-        0x7ffffde => Some(203),
-        0x7ffffdf => Some(204),
-        0x7ffffe0 => Some(211),
-        0x7ffffe1 => Some(212),
-        0x7ffffe2 => Some(214),
-        0x7ffffe3 => Some(221),
-        0x7ffffe4 => Some(222),
-        0x7ffffe5 => Some(223),
-        0x7ffffe6 => Some(241),
-        0x7ffffe7 => Some(244),
-        0x7ffffe8 => Some(245),
-        0x7ffffe9 => Some(246),
-        0x7ffffea => Some(247),
-        0x7ffffeb => Some(248),
-        0x7ffffec => Some(250),
-        0x7ffffed => Some(251),
-        0x7ffffee => Some(252),
-        0x7ffffef => Some(253),
-        0x7fffff0 => Some(254),
-        _ => None,
+    #[test]
+    fn test_http2_decode_huffman() {
+        // RFC 7541 C.4.1
+        let buf = [
+            0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff,
+        ];
+        assert_eq!(http2_decode_huffman(&buf), b"www.example.com");
+        // RFC 7541 C.4.3
+        let buf = [0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf];
+        assert_eq!(http2_decode_huffman(&buf), b"custom-value");
+        assert_eq!(http2_decode_huffman(&[]), b"");
+        // padding only
+        assert_eq!(http2_decode_huffman(&[0xff]), b"");
     }
-}
-
-fn http2_decode_huffman_len27(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(27u32), http2_huffman_table_len27))(input)
-}
 
-fn http2_huffman_table_len28(n: u32) -> Option<u8> {
-    match n {
-        0xfffffe2 => Some(2),
-        0xfffffe3 => Some(3),
-        0xfffffe4 => Some(4),
-        0xfffffe5 => Some(5),
-        0xfffffe6 => Some(6),
-        0xfffffe7 => Some(7),
-        0xfffffe8 => Some(8),
-        0xfffffe9 => Some(11),
-        0xfffffea => Some(12),
-        0xfffffeb => Some(14),
-        0xfffffec => Some(15),
-        0xfffffed => Some(16),
-        0xfffffee => Some(17),
-        0xfffffef => Some(18),
-        0xffffff0 => Some(19),
-        0xffffff1 => Some(20),
-        0xffffff2 => Some(21),
-        0xffffff3 => Some(23),
-        0xffffff4 => Some(24),
-        0xffffff5 => Some(25),
-        0xffffff6 => Some(26),
-        0xffffff7 => Some(27),
-        0xffffff8 => Some(28),
-        0xffffff9 => Some(29),
-        0xffffffa => Some(30),
-        0xffffffb => Some(31),
-        0xffffffc => Some(127),
-        0xffffffd => Some(220),
-        0xffffffe => Some(249),
-        _ => None,
+    #[test]
+    fn test_http2_decode_huffman_all_symbols() {
+        let all: Vec<u8> = (0..=255).collect();
+        let enc = encode(&all, false);
+        assert_eq!(http2_decode_huffman(&enc), all);
+        assert_eq!(reference_decode(&enc), all);
+        // nothing is decoded past EOS
+        let mut enc = encode(b"abc", true);
+        enc.extend_from_slice(&encode(b"def", false));
+        assert_eq!(http2_decode_huffman(&enc), b"abc");
+        assert_eq!(reference_decode(&enc), b"abc");
     }
-}
-
-fn http2_decode_huffman_len28(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(28u32), http2_huffman_table_len28))(input)
-}
 
-fn http2_huffman_table_len30(n: u32) -> Option<u8> {
-    match n {
-        0x3ffffffc => Some(10),
-        0x3ffffffd => Some(13),
-        0x3ffffffe => Some(22),
-        // 0x3fffffff => Some(256),
-        _ => None,
+    #[test]
+    fn test_http2_decode_huffman_reference() {
+        let mut seed: u32 = 0x1234_5678;
+        for len in 0..512 {
+            let buf: Vec<u8> = (0..len)
+                .map(|_| {
+                    seed ^= seed << 13;
+                    seed ^= seed >> 17;
+                    seed ^= seed << 5;
+                    seed as u8
+                })
+                .collect();
+            assert_eq!(http2_decode_huffman(&buf), reference_decode(&buf));
+        }
     }
 }
-
-fn http2_decode_huffman_len30(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    complete(map_opt(take_bits(30u32), http2_huffman_table_len30))(input)
-}
-
-//hack to end many0 even if some bits are remaining
-fn http2_decode_huffman_end(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    return Err(Err::Error(make_error(input, ErrorKind::Eof)));
-}
-
-//we could profile and optimize performance here
-pub fn http2_decode_huffman(input: (&[u8], usize)) -> IResult<(&[u8], usize), u8> {
-    // trait nom::branch::Alt is implemented for lists up to size 20,
-    // so use nested `alt` as a workaround (see nom documentation for `alt`)
-    alt((
-        http2_decode_huffman_len5,
-        http2_decode_huffman_len6,
-        http2_decode_huffman_len7,
-        http2_decode_huffman_len8,
-        http2_decode_huffman_len10,
-        http2_decode_huffman_len11,
-        http2_decode_huffman_len12,
-        http2_decode_huffman_len13,
-        http2_decode_huffman_len14,
-        http2_decode_huffman_len15,
-        http2_decode_huffman_len19,
-        http2_decode_huffman_len20,
-        http2_decode_huffman_len21,
-        http2_decode_huffman_len21,
-        http2_decode_huffman_len22,
-        http2_decode_huffman_len23,
-        http2_decode_huffman_len24,
-        http2_decode_huffman_len25,
-        http2_decode_huffman_len26,
-        http2_decode_huffman_len27,
-        alt((
-            http2_decode_huffman_len28,
-            http2_decode_huffman_len30,
-            http2_decode_huffman_end,
-        )),
-    ))(input)
-}
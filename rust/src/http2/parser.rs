@@ -175,75 +175,82 @@ pub fn http2_parse_headers_priority(i: &[u8]) -> IResult<&[u8], HTTP2FrameHeader
 
 pub const HTTP2_STATIC_HEADERS_NUMBER: usize = 61;
 
+const HTTP2_STATIC_HEADERS: [(&str, &str); HTTP2_STATIC_HEADERS_NUMBER] = [
+    (":authority", ""),
+    (":method", "GET"),
+    (":method", "POST"),
+    (":path", "/"),
+    (":path", "/index.html"),
+    (":scheme", "http"),
+    (":scheme", "https"),
+    (":status", "200"),
+    (":status", "204"),
+    (":status", "206"),
+    (":status", "304"),
+    (":status", "400"),
+    (":status", "404"),
+    (":status", "500"),
+    ("accept-charset", ""),
+    ("accept-encoding", "gzip, deflate"),
+    ("accept-language", ""),
+    ("accept-ranges", ""),
+    ("accept", ""),
+    ("access-control-allow-origin", ""),
+    ("age", ""),
+    ("allow", ""),
+    ("authorization", ""),
+    ("cache-control", ""),
+    ("content-disposition", ""),
+    ("content-encoding", ""),
+    ("content-language", ""),
+    ("content-length", ""),
+    ("content-location", ""),
+    ("content-range", ""),
+    ("content-type", ""),
+    ("cookie", ""),
+    ("date", ""),
+    ("etag", ""),
+    ("expect", ""),
+    ("expires", ""),
+    ("from", ""),
+    ("host", ""),
+    ("if-match", ""),
+    ("if-modified-since", ""),
+    ("if-none-match", ""),
+    ("if-range", ""),
+    ("if-unmodified-since", ""),
+    ("last-modified", ""),
+    ("link", ""),
+    ("location", ""),
+    ("max-forwards", ""),
+    ("proxy-authenticate", ""),
+    ("proxy-authorization", ""),
+    ("range", ""),
+    ("referer", ""),
+    ("refresh", ""),
+    ("retry-after", ""),
+    ("server", ""),
+    ("set-cookie", ""),
+    ("strict-transport-security", ""),
+    ("transfer-encoding", ""),
+    ("user-agent", ""),
+    ("vary", ""),
+    ("via", ""),
+    ("www-authenticate", ""),
+];
+
 fn http2_frame_header_static(n: u64, dyn_headers: &HTTP2DynTable) -> Option<HTTP2FrameHeaderBlock> {
-    let (name, value) = match n {
-        1 => (":authority", ""),
-        2 => (":method", "GET"),
-        3 => (":method", "POST"),
-        4 => (":path", "/"),
-        5 => (":path", "/index.html"),
-        6 => (":scheme", "http"),
-        7 => (":scheme", "https"),
-        8 => (":status", "200"),
-        9 => (":status", "204"),
-        10 => (":status", "206"),
-        11 => (":status", "304"),
-        12 => (":status", "400"),
-        13 => (":status", "404"),
-        14 => (":status", "500"),
-        15 => ("accept-charset", ""),
-        16 => ("accept-encoding", "gzip, deflate"),
-        17 => ("accept-language", ""),
-        18 => ("accept-ranges", ""),
-        19 => ("accept", ""),
-        20 => ("access-control-allow-origin", ""),
-        21 => ("age", ""),
-        22 => ("allow", ""),
-        23 => ("authorization", ""),
-        24 => ("cache-control", ""),
-        25 => ("content-disposition", ""),
-        26 => ("content-encoding", ""),
-        27 => ("content-language", ""),
-        28 => ("content-length", ""),
-        29 => ("content-location", ""),
-        30 => ("content-range", ""),
-        31 => ("content-type", ""),
-        32 => ("cookie", ""),
-        33 => ("date", ""),
-        34 => ("etag", ""),
-        35 => ("expect", ""),
-        36 => ("expires", ""),
-        37 => ("from", ""),
-        38 => ("host", ""),
-        39 => ("if-match", ""),
-        40 => ("if-modified-since", ""),
-        41 => ("if-none-match", ""),
-        42 => ("if-range", ""),
-        43 => ("if-unmodified-since", ""),
-        44 => ("last-modified", ""),
-        45 => ("link", ""),
-        46 => ("location", ""),
-        47 => ("max-forwards", ""),
-        48 => ("proxy-authenticate", ""),
-        49 => ("proxy-authorization", ""),
-        50 => ("range", ""),
-        51 => ("referer", ""),
-        52 => ("refresh", ""),
-        53 => ("retry-after", ""),
-        54 => ("server", ""),
-        55 => ("set-cookie", ""),
-        56 => ("strict-transport-security", ""),
-        57 => ("transfer-encoding", ""),
-        58 => ("user-agent", ""),
-        59 => ("vary", ""),
-        60 => ("via", ""),
-        61 => ("www-authenticate", ""),
-        _ => ("", ""),
-    };
-    if !name.is_empty() {
+    if (1..=HTTP2_STATIC_HEADERS_NUMBER as u64).contains(&n) {
+        let (name, value) = dyn_headers.static_table[n as usize - 1].get_or_init(|| {
+            let (name, value) = HTTP2_STATIC_HEADERS[n as usize - 1];
+            (
+                Rc::new(name.as_bytes().to_vec()),
+                Rc::new(value.as_bytes().to_vec()),
+            )
+        });
         return Some(HTTP2FrameHeaderBlock {
-            name: Rc::new(name.as_bytes().to_vec()),
-            value: Rc::new(value.as_bytes().to_vec()),
+            name: name.clone(),
+            value: value.clone(),
             error: HTTP2HeaderDecodeStatus::HTTP2HeaderDecodeSuccess,
             sizeupdate: 0,
         });
@@ -330,8 +337,7 @@ fn http2_parse_headers_block_string(input: &[u8]) -> IResult<&[u8], Vec<u8>> {
     if huffslen.0 == 0 {
         return Ok((i3, data.to_vec()));
     } else {
-        let (_, val) = bits(many0(huffman::http2_decode_huffman))(data)?;
-        return Ok((i3, val));
+        return Ok((i3, huffman::http2_decode_huffman(data)));
     }
 }
 
@@ -0,0 +1,124 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+*
+* You can copy, redistribute or modify this Program under the terms of
+* the GNU General Public License version 2 as published by the Free
+* Software Foundation.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* version 2 along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+* 02110-1301, USA.
+*/
+
+//! JA3 hashing with a per-thread cache of recent results.
+//!
+//! Most handshakes are made by a handful of client and server
+//! implementations, so the same JA3 strings show up over and over. The MD5
+//! of those is only computed once per thread.
+
+use digest::Digest;
+use digest::Update;
+use lru::LruCache;
+use md5::Md5;
+use std::cell::RefCell;
+use std::num::NonZeroUsize;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use crate::jsonbuilder::HEX;
+
+pub const JA3_HEX_LEN: usize = 32;
+
+/// Number of JA3 hashes remembered per thread. 0 disables the cache.
+static mut JA3_CACHE_SIZE: usize = 64;
+
+static JA3_CACHE_HITS: AtomicU64 = AtomicU64::new(0);
+static JA3_CACHE_MISSES: AtomicU64 = AtomicU64::new(0);
+
+thread_local! {
+    static JA3_CACHE: RefCell<Option<LruCache<Vec<u8>, [u8; JA3_HEX_LEN]>>> = const { RefCell::new(None) };
+}
+
+fn ja3_md5_hex(ja3: &[u8]) -> [u8; JA3_HEX_LEN] {
+    let digest = Md5::new().chain(ja3).finalize();
+    let mut out = [0u8; JA3_HEX_LEN];
+    for (i, b) in digest.iter().enumerate() {
+        out[i * 2] = HEX[(b >> 4) as usize];
+        out[i * 2 + 1] = HEX[(b & 0xf) as usize];
+    }
+    out
+}
+
+/// Get the lowercase hex MD5 of a JA3 string.
+pub fn ja3_hash(ja3: &[u8]) -> [u8; JA3_HEX_LEN] {
+    let size = unsafe { JA3_CACHE_SIZE };
+    let Some(size) = NonZeroUsize::new(size) else {
+        return ja3_md5_hex(ja3);
+    };
+    JA3_CACHE.with(|cache| {
+        let mut cache = cache.borrow_mut();
+        let cache = cache.get_or_insert_with(|| LruCache::new(size));
+        if let Some(hash) = cache.get(ja3) {
+            JA3_CACHE_HITS.fetch_add(1, Ordering::Relaxed);
+            return *hash;
+        }
+        JA3_CACHE_MISSES.fetch_add(1, Ordering::Relaxed);
+        let hash = ja3_md5_hex(ja3);
+        cache.put(ja3.to_vec(), hash);
+        hash
+    })
+}
+
+// C ABI
+
+/// Set the number of JA3 hashes each thread keeps around.
+///
+/// Must be called before the packet threads start.
+#[no_mangle]
+pub unsafe extern "C" fn SCJA3SetCacheSize(size: u32) {
+    JA3_CACHE_SIZE = size as usize;
+}
+
+/// Write the hex MD5 of the JA3 string in `buf` to `out`. `out` is not
+/// NUL terminated.
+///
+/// # Safety
+///
+/// buf must be a valid buffer of at least buf_len bytes
+#[no_mangle]
+pub unsafe extern "C" fn SCJA3GetHash(buf: *const u8, buf_len: u32, out: &mut [u8; JA3_HEX_LEN]) {
+    let ja3 = std::slice::from_raw_parts(buf, buf_len as usize);
+    *out = ja3_hash(ja3);
+}
+
+#[no_mangle]
+pub extern "C" fn SCJA3CacheHits() -> u64 {
+    JA3_CACHE_HITS.load(Ordering::Relaxed)
+}
+
+#[no_mangle]
+pub extern "C" fn SCJA3CacheMisses() -> u64 {
+    JA3_CACHE_MISSES.load(Ordering::Relaxed)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_ja3_hash() {
+        let ja3 = b"771,4865-4866-4867,0-23-65281-10-11-35-16-5-13-18-51-45-43-27-21,29-23-24,0";
+        let expected = format!("{:x}", Md5::new().chain(ja3).finalize());
+        // miss, then hit
+        assert_eq!(&ja3_hash(ja3), expected.as_bytes());
+        assert_eq!(&ja3_hash(ja3), expected.as_bytes());
+        assert_eq!(
+            &ja3_hash(b""),
+            format!("{:x}", Md5::new().chain(b"").finalize()).as_bytes()
+        );
+    }
+}
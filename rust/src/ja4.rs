@@ -22,16 +22,35 @@ use crate::jsonbuilder::HEX;
 #[cfg(feature = "ja4")]
 use digest::Digest;
 #[cfg(feature = "ja4")]
+use lru::LruCache;
+#[cfg(feature = "ja4")]
 use sha2::Sha256;
 #[cfg(feature = "ja4")]
+use std::cell::RefCell;
+#[cfg(feature = "ja4")]
 use std::cmp::min;
 #[cfg(feature = "ja4")]
+use std::num::NonZeroUsize;
+use std::sync::atomic::{AtomicU64, Ordering};
+#[cfg(feature = "ja4")]
 use tls_parser::{TlsExtensionType, TlsVersion};
 
 use crate::handshake::HandshakeParams;
 
 pub const JA4_HEX_LEN: usize = 36;
 
+/// Number of JA4 fingerprints remembered per thread. 0 disables the cache.
+static mut JA4_CACHE_SIZE: usize = 64;
+
+static JA4_CACHE_HITS: AtomicU64 = AtomicU64::new(0);
+static JA4_CACHE_MISSES: AtomicU64 = AtomicU64::new(0);
+
+#[cfg(feature = "ja4")]
+thread_local! {
+    /// Recent fingerprints, keyed by the handshake values they are made of.
+    static JA4_CACHE: RefCell<Option<LruCache<Vec<u16>, String>>> = const { RefCell::new(None) };
+}
+
 pub(crate) trait JA4Impl {
     fn try_new(hs: &HandshakeParams) -> Option<JA4>;
 }
@@ -89,11 +108,31 @@ impl JA4 {
         }
         ret
     }
-}
 
-#[cfg(feature = "ja4")]
-impl JA4Impl for JA4 {
-    fn try_new(hs: &HandshakeParams) -> Option<Self> {
+    /// Build a cache key holding everything the fingerprint depends on.
+    /// It is much cheaper to build than the fingerprint itself, which needs
+    /// sorting, formatting and two SHA-256 digests.
+    fn cache_key(hs: &HandshakeParams) -> Vec<u16> {
+        let alpn = Self::format_alpn(hs.alpns.first());
+        let mut key = Vec::with_capacity(
+            7 + hs.ciphersuites.len() + hs.extensions.len() + hs.signature_algorithms.len(),
+        );
+        key.push(
+            (hs.quic as u16) | ((hs.domain as u16) << 1) | ((hs.tls_version.is_some() as u16) << 2),
+        );
+        key.push(hs.tls_version.map(u16::from).unwrap_or(0));
+        key.push(alpn[0] as u16);
+        key.push(alpn[1] as u16);
+        key.push(hs.ciphersuites.len() as u16);
+        key.extend(hs.ciphersuites.iter().map(|&v| u16::from(v)));
+        key.push(hs.extensions.len() as u16);
+        key.extend(hs.extensions.iter().map(|&v| u16::from(v)));
+        key.push(hs.signature_algorithms.len() as u16);
+        key.extend_from_slice(&hs.signature_algorithms);
+        key
+    }
+
+    fn compute(hs: &HandshakeParams) -> String {
         // All non-GREASE extensions are stored to produce a more verbose, complete output
         // of extensions but we need to omit ALPN & SNI extensions from the JA4_a hash.
         let mut exts = hs
@@ -150,9 +189,33 @@ impl JA4Impl for JA4 {
         let mut ja4_c = format!("{:x}", sha.finalize());
         ja4_c.truncate(12);
 
-        Some(Self {
-            hash: format!("{}_{}_{}", ja4_a, ja4_b, ja4_c),
-        })
+        format!("{}_{}_{}", ja4_a, ja4_b, ja4_c)
+    }
+}
+
+#[cfg(feature = "ja4")]
+impl JA4Impl for JA4 {
+    fn try_new(hs: &HandshakeParams) -> Option<Self> {
+        let size = unsafe { JA4_CACHE_SIZE };
+        let Some(size) = NonZeroUsize::new(size) else {
+            return Some(Self {
+                hash: Self::compute(hs),
+            });
+        };
+        let key = Self::cache_key(hs);
+        let hash = JA4_CACHE.with(|cache| {
+            let mut cache = cache.borrow_mut();
+            let cache = cache.get_or_insert_with(|| LruCache::new(size));
+            if let Some(hash) = cache.get(&key) {
+                JA4_CACHE_HITS.fetch_add(1, Ordering::Relaxed);
+                return hash.clone();
+            }
+            JA4_CACHE_MISSES.fetch_add(1, Ordering::Relaxed);
+            let hash = Self::compute(hs);
+            cache.put(key, hash.clone());
+            hash
+        });
+        Some(Self { hash })
     }
 }
 
@@ -172,6 +235,24 @@ pub unsafe extern "C" fn SCJA4GetHash(hs: &HandshakeParams, out: &mut [u8; JA4_H
     }
 }
 
+/// Set the number of JA4 fingerprints each thread keeps around.
+///
+/// Must be called before the packet threads start.
+#[no_mangle]
+pub unsafe extern "C" fn SCJA4SetCacheSize(size: u32) {
+    JA4_CACHE_SIZE = size as usize;
+}
+
+#[no_mangle]
+pub extern "C" fn SCJA4CacheHits() -> u64 {
+    JA4_CACHE_HITS.load(Ordering::Relaxed)
+}
+
+#[no_mangle]
+pub extern "C" fn SCJA4CacheMisses() -> u64 {
+    JA4_CACHE_MISSES.load(Ordering::Relaxed)
+}
+
 #[cfg(test)]
 #[cfg(feature = "ja4")]
 mod tests {
@@ -335,4 +416,28 @@ mod tests {
         let s = JA4::try_new(&hs).expect("JA4 create failure");
         assert_eq!(s.as_ref(), "q12d0305h6_f500716053f9_2debc8880bae");
     }
+
+    #[test]
+    fn test_cache() {
+        let mut hs = HandshakeParams::default();
+        hs.set_tls_version(TlsVersion::Tls13);
+        hs.add_cipher_suite(TlsCipherSuiteID(0x1301));
+        hs.add_extension(TlsExtensionType(0x0000));
+        hs.add_signature_algorithm(0x0403);
+        let first = JA4::try_new(&hs).expect("JA4 create failure");
+        let second = JA4::try_new(&hs).expect("JA4 create failure");
+        assert_eq!(first.as_ref(), JA4::compute(&hs));
+        assert_eq!(first, second);
+
+        // same values, different JA4: must not be served from the cache
+        hs.quic = true;
+        let s = JA4::try_new(&hs).expect("JA4 create failure");
+        assert_eq!(s.as_ref(), JA4::compute(&hs));
+        assert_ne!(s, first);
+
+        // the first ALPN is part of the fingerprint
+        hs.add_alpn(b"h3");
+        let s = JA4::try_new(&hs).expect("JA4 create failure");
+        assert_eq!(s.as_ref(), JA4::compute(&hs));
+    }
 }
@@ -86,6 +86,7 @@ pub mod utils;
 
 pub mod encryption;
 pub mod handshake;
+pub mod ja3;
 pub mod ja4;
 pub mod tls_version;
 
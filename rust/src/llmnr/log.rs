@@ -32,7 +32,7 @@ fn llmnr_log_json_answer_detail(answer: &DNSAnswerEntry) -> Result<JsonBuilder,
     }
     let rrtype = dns_rrtype_string(answer.rrtype).to_lowercase();
 
-    match &answer.data {
+    match answer.data() {
         DNSRData::A(addr) | DNSRData::AAAA(addr) => {
             jsa.set_string(&rrtype, &dns_print_addr(addr))?;
         }
@@ -142,7 +142,7 @@ fn log_json(tx: &DNSTransaction, jb: &mut JsonBuilder) -> Result<(), JsonError>
     if !message.additionals.is_empty() {
         let mut is_jb_open = false;
         for entry in &message.additionals {
-            if let DNSRData::OPT(rdata) = &entry.data {
+            if let DNSRData::OPT(rdata) = entry.data() {
                 if rdata.is_empty() {
                     continue;
                 }
@@ -21,6 +21,7 @@ use crate::utils::base64;
 use digest::Digest;
 use digest::Update;
 use md5::Md5;
+use memchr::memchr;
 use std::ffi::CStr;
 use suricata_sys::sys::{FileAppendData, FileContainer, SCBasicSearchNocaseIndex};
 
@@ -617,8 +618,10 @@ fn mime_smtp_parse_line(
                                 }
                                 c += 3;
                             } else {
-                                quoted_buffer.push(i[c]);
-                                c += 1;
+                                // copy the run of literal bytes up to the next escape
+                                let run = memchr(b'=', &i[c..]).unwrap_or(i.len() - c);
+                                quoted_buffer.extend_from_slice(&i[c..c + run]);
+                                c += run;
                             }
                         }
                         if i.is_empty() {
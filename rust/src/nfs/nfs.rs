@@ -53,6 +53,9 @@ pub const NFS_MIN_FRAME_LEN: u16 = 32;
 
 static mut NFS_MAX_TX: usize = 1024;
 
+/// memory used by the queued out of order READ/WRITE data of all files
+static NFS_FILE_CHUNKS: FileChunkMemcap = FileChunkMemcap::new(268435456);
+
 pub const RPC_TCP_PRE_CREDS: usize = 28;
 pub const RPC_UDP_PRE_CREDS: usize = 24;
 
@@ -160,7 +163,7 @@ pub struct NFSTransactionFile {
 impl NFSTransactionFile {
     pub fn new() -> Self {
         return Self {
-            file_tracker: FileTransferTracker::new(),
+            file_tracker: FileTransferTracker::with_memcap(&NFS_FILE_CHUNKS),
             ..Default::default()
         };
     }
@@ -2321,6 +2324,16 @@ unsafe extern "C" fn nfs_probe_udp_tc(
 // Parser name as a C style string.
 const PARSER_NAME: &[u8] = b"nfs\0";
 
+#[no_mangle]
+pub extern "C" fn SCNfsFileChunksMemuse() -> u64 {
+    NFS_FILE_CHUNKS.memuse()
+}
+
+#[no_mangle]
+pub extern "C" fn SCNfsFileChunksMemcap() -> u64 {
+    NFS_FILE_CHUNKS.memcap_reached()
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn SCRegisterNfsParser() {
     let default_port = CString::new("[2049]").unwrap();
@@ -2419,6 +2432,17 @@ pub unsafe extern "C" fn SCRegisterNfsParser() {
                 SCLogError!("Invalid max-requests value");
             }
         }
+        let retval = conf_get("app-layer.protocols.nfs.file-chunk-memcap");
+        if let Some(val) = retval {
+            match get_memval(val) {
+                Ok(v) => {
+                    NFS_FILE_CHUNKS.set_memcap(v);
+                }
+                Err(_) => {
+                    SCLogError!("Invalid file-chunk-memcap value");
+                }
+            }
+        }
         let retval = conf_get("app-layer.protocols.nfs.max-names");
         if let Some(val) = retval {
             if let Ok(v) = val.parse::<usize>() {
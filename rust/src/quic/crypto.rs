@@ -20,13 +20,26 @@ use aes::Aes128;
 use aes_gcm::aead::AeadInPlace;
 use aes_gcm::Aes128Gcm;
 use hkdf::Hkdf;
+use lru::LruCache;
 use sha2::Sha256;
+use std::cell::RefCell;
 use std::convert::TryInto;
+use std::num::NonZeroUsize;
+use std::sync::Arc;
 
 pub const AES128_KEY_LEN: usize = 16;
 pub const AES128_TAG_LEN: usize = 16;
 pub const AES128_IV_LEN: usize = 12;
 
+/// Number of Initial keys remembered per thread. 0 disables the cache.
+pub(super) static mut QUIC_KEYS_CACHE_SIZE: usize = 64;
+
+thread_local! {
+    /// Recently derived Initial keys, by version and client destination
+    /// connection id.
+    static QUIC_KEYS_CACHE: RefCell<Option<LruCache<(u32, Vec<u8>), Arc<QuicKeys>>>> = const { RefCell::new(None) };
+}
+
 pub struct HeaderProtectionKey(Aes128);
 
 impl HeaderProtectionKey {
@@ -196,3 +209,47 @@ pub fn quic_keys_initial(version: u32, client_dst_connection_id: &[u8]) -> Optio
         remote: DirectionalKeys::new(&client_secret, version),
     });
 }
+
+/// Get the Initial keys for a connection, from the per-thread cache if the
+/// same connection id was seen recently.
+///
+/// Clients reuse their destination connection id when they retransmit or
+/// resend their Initial packets from another port, which leads to new flows.
+/// The keys are shared through an Arc, as the flow may be freed by another
+/// thread.
+pub fn quic_keys_initial_cached(
+    version: u32, client_dst_connection_id: &[u8],
+) -> Option<Arc<QuicKeys>> {
+    let size = unsafe { QUIC_KEYS_CACHE_SIZE };
+    let Some(size) = NonZeroUsize::new(size) else {
+        return quic_keys_initial(version, client_dst_connection_id).map(Arc::new);
+    };
+    QUIC_KEYS_CACHE.with(|cache| {
+        let mut cache = cache.borrow_mut();
+        let cache = cache.get_or_insert_with(|| LruCache::new(size));
+        let key = (version, client_dst_connection_id.to_vec());
+        if let Some(keys) = cache.get(&key) {
+            return Some(keys.clone());
+        }
+        let keys = Arc::new(quic_keys_initial(version, client_dst_connection_id)?);
+        cache.put(key, keys.clone());
+        Some(keys)
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_quic_keys_initial_cached() {
+        // RFC 9001 A.1
+        let dcid = [0x83, 0x94, 0xc8, 0xf0, 0x3e, 0x51, 0x57, 0x08];
+        let k1 = quic_keys_initial_cached(1, &dcid).unwrap();
+        let k2 = quic_keys_initial_cached(1, &dcid).unwrap();
+        assert!(Arc::ptr_eq(&k1, &k2));
+        let k3 = quic_keys_initial_cached(0x6b3343cf, &dcid).unwrap();
+        assert!(!Arc::ptr_eq(&k1, &k3));
+        assert!(quic_keys_initial_cached(0x1234, &dcid).is_none());
+    }
+}
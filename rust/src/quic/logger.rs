@@ -17,10 +17,8 @@
 
 use super::parser::QuicType;
 use super::quic::QuicTransaction;
+use crate::ja3::ja3_hash;
 use crate::jsonbuilder::{JsonBuilder, JsonError};
-use digest::Digest;
-use digest::Update;
-use md5::Md5;
 
 fn quic_tls_extension_name(e: u16) -> Option<String> {
     match e {
@@ -117,8 +115,8 @@ fn log_quic(tx: &QuicTransaction, js: &mut JsonBuilder) -> Result<(), JsonError>
         } else {
             js.open_object("ja3s")?;
         }
-        let hash = format!("{:x}", Md5::new().chain(ja3).finalize());
-        js.set_string("hash", &hash)?;
+        let hash = ja3_hash(ja3.as_bytes());
+        js.set_string_from_bytes("hash", &hash)?;
         js.set_string("string", ja3)?;
         js.close()?;
     }
@@ -16,7 +16,7 @@
  */
 
 use super::{
-    crypto::{quic_keys_initial, QuicKeys, AES128_KEY_LEN},
+    crypto::{quic_keys_initial_cached, QuicKeys, AES128_KEY_LEN, QUIC_KEYS_CACHE_SIZE},
     cyu::Cyu,
     frames::{Frame, QuicTlsExtension, StreamTag},
     parser::{quic_pkt_num, QuicData, QuicHeader, QuicType},
@@ -36,6 +36,7 @@ use crate::{
 use std::collections::VecDeque;
 use std::ffi::CString;
 use std::str::FromStr;
+use std::sync::Arc;
 use suricata_sys::sys::{
     AppLayerParserState, AppProto, SCAppLayerParserConfParserEnabled,
     SCAppLayerParserRegisterLogger, SCAppLayerParserStateSetFlag,
@@ -123,7 +124,7 @@ impl QuicTransaction {
 pub struct QuicState {
     state_data: AppLayerStateData,
     max_tx_id: u64,
-    keys: Option<QuicKeys>,
+    keys: Option<Arc<QuicKeys>>,
     /// crypto fragment data already seen and reassembled to client
     crypto_frag_tc: Vec<u8>,
     /// number of bytes set in crypto fragment data to client
@@ -191,8 +192,8 @@ impl QuicState {
     }
 
     fn decrypt<'a>(
-        &mut self, to_server: bool, header: &QuicHeader, framebuf: &'a [u8], buf: &'a [u8],
-        hlen: usize, output: &'a mut Vec<u8>,
+        &mut self, to_server: bool, framebuf: &'a [u8], buf: &'a [u8], hlen: usize,
+        output: &'a mut Vec<u8>,
     ) -> Result<usize, ()> {
         if let Some(keys) = &self.keys {
             let hkey = if to_server {
@@ -203,35 +204,29 @@ impl QuicState {
             if framebuf.len() < PKT_NUM_BUF_MAX_LEN + AES128_KEY_LEN {
                 return Err(());
             }
-            let h2len = hlen + usize::from(header.length);
-            let mut h2 = Vec::with_capacity(h2len);
-            h2.extend_from_slice(&buf[..h2len]);
+            // only the header and the packet number get unprotected, so
+            // only copy those, the sample is read from the packet itself
+            let mut h2 = Vec::with_capacity(hlen + PKT_NUM_BUF_MAX_LEN);
+            h2.extend_from_slice(&buf[..hlen + PKT_NUM_BUF_MAX_LEN]);
             let mut h20 = h2[0];
-            let mut pktnum_buf = Vec::with_capacity(PKT_NUM_BUF_MAX_LEN);
-            pktnum_buf.extend_from_slice(&h2[hlen..hlen + PKT_NUM_BUF_MAX_LEN]);
             let r1 = hkey.decrypt_in_place(
-                &h2[hlen + PKT_NUM_BUF_MAX_LEN..hlen + PKT_NUM_BUF_MAX_LEN + AES128_KEY_LEN],
+                &framebuf[PKT_NUM_BUF_MAX_LEN..PKT_NUM_BUF_MAX_LEN + AES128_KEY_LEN],
                 &mut h20,
-                &mut pktnum_buf,
+                &mut h2[hlen..],
             );
             if r1.is_err() {
                 return Err(());
             }
-            // mutate one at a time
             h2[0] = h20;
-            let _ = &h2[hlen..hlen + 1 + ((h20 & 3) as usize)]
-                .copy_from_slice(&pktnum_buf[..1 + ((h20 & 3) as usize)]);
-            let pkt_num = quic_pkt_num(&h2[hlen..hlen + 1 + ((h20 & 3) as usize)]);
-            if framebuf.len() < 1 + ((h20 & 3) as usize) {
-                return Err(());
-            }
+            h2.truncate(hlen + 1 + ((h20 & 3) as usize));
+            let pkt_num = quic_pkt_num(&h2[hlen..]);
             output.extend_from_slice(&framebuf[1 + ((h20 & 3) as usize)..]);
             let pkey = if to_server {
                 &keys.remote.packet
             } else {
                 &keys.local.packet
             };
-            let r = pkey.decrypt_in_place(pkt_num, &h2[..hlen + 1 + ((h20 & 3) as usize)], output);
+            let r = pkey.decrypt_in_place(pkt_num, &h2, output);
             if let Ok(r2) = r {
                 return Ok(r2.len());
             }
@@ -307,6 +302,8 @@ impl QuicState {
                         self.hello_tc = true;
                     }
                     if self.hello_tc && self.hello_ts {
+                        // nothing left to decrypt in either direction
+                        self.keys = None;
                         let flags = match unsafe { ENCRYPTION_BYPASS_ENABLED } {
                             EncryptionHandling::ENCRYPTION_HANDLING_BYPASS => {
                                 APP_LAYER_PARSER_NO_INSPECTION | APP_LAYER_PARSER_BYPASS_READY
@@ -354,7 +351,8 @@ impl QuicState {
 
                     // unprotect/decrypt packet
                     if self.keys.is_none() && header.ty == QuicType::Initial {
-                        self.keys = quic_keys_initial(u32::from(header.version), &header.dcid);
+                        self.keys =
+                            quic_keys_initial_cached(u32::from(header.version), &header.dcid);
                     } else if !to_server
                         && self.keys.is_some()
                         && header.ty == QuicType::Retry
@@ -389,8 +387,7 @@ impl QuicState {
                     let mut output;
                     if self.keys.is_some() && !framebuf.is_empty() {
                         output = Vec::with_capacity(framebuf.len() + 4);
-                        if let Ok(dlen) =
-                            self.decrypt(to_server, &header, framebuf, buf, hlen, &mut output)
+                        if let Ok(dlen) = self.decrypt(to_server, framebuf, buf, hlen, &mut output)
                         {
                             output.resize(dlen, 0);
                         } else {
@@ -600,6 +597,13 @@ pub unsafe extern "C" fn SCRegisterQuicParser() {
                     SCFatalErrorOnInit!("Unknown value {} for quic.encryption-handling.", val);
                 }
             }
+            if let Some(val) = conf_get("app-layer.protocols.quic.keys-cache-size") {
+                if let Ok(v) = val.parse::<u16>() {
+                    QUIC_KEYS_CACHE_SIZE = v as usize;
+                } else {
+                    SCFatalErrorOnInit!("Invalid value {} for quic.keys-cache-size.", val);
+                }
+            }
         }
         SCLogDebug!("Rust quic parser registered.");
         SCAppLayerParserRegisterLogger(IPPROTO_UDP, ALPROTO_QUIC);
@@ -41,7 +41,7 @@ pub struct SMBTransactionFile {
 impl SMBTransactionFile {
     pub fn new() -> Self {
         return Self {
-            file_tracker: FileTransferTracker::new(),
+            file_tracker: FileTransferTracker::with_memcap(&SMB_FILE_CHUNKS),
             ..Default::default()
         };
     }
@@ -49,6 +49,7 @@ use crate::conf::*;
 use crate::core::*;
 use crate::direction::Direction;
 use crate::filecontainer::FileContainerWrapper;
+use crate::filetracker::FileChunkMemcap;
 use crate::flow::{flow_get_flags, flow_get_last_time, flow_get_ports, Flow, FLOW_DIR_REVERSED};
 use crate::frames::*;
 
@@ -90,6 +91,8 @@ pub static mut SMB_CFG_MAX_READ_QUEUE_CNT: u32 = 64;
 pub static mut SMB_CFG_MAX_WRITE_SIZE: u32 = 16777216;
 pub static mut SMB_CFG_MAX_WRITE_QUEUE_SIZE: u32 = 67108864;
 pub static mut SMB_CFG_MAX_WRITE_QUEUE_CNT: u32 = 64;
+/// memory used by the queued out of order READ/WRITE data of all files
+pub static SMB_FILE_CHUNKS: FileChunkMemcap = FileChunkMemcap::new(268435456);
 /// max size of the per state guid2name cache
 pub static mut SMB_CFG_MAX_GUID_CACHE_SIZE: usize = 1024;
 /// SMBState::read_offset_cache
@@ -2836,6 +2839,16 @@ fn register_pattern_probe() -> i8 {
     }
 }
 
+#[no_mangle]
+pub extern "C" fn SCSmbFileChunksMemuse() -> u64 {
+    SMB_FILE_CHUNKS.memuse()
+}
+
+#[no_mangle]
+pub extern "C" fn SCSmbFileChunksMemcap() -> u64 {
+    SMB_FILE_CHUNKS.memcap_reached()
+}
+
 // Parser name as a C style string.
 const PARSER_NAME: &[u8] = b"smb\0";
 
@@ -2981,6 +2994,17 @@ pub unsafe extern "C" fn SCRegisterSmbParser() {
                 }
             }
         }
+        let retval = conf_get("app-layer.protocols.smb.file-chunk-memcap");
+        if let Some(val) = retval {
+            match get_memval(val) {
+                Ok(retval) => {
+                    SMB_FILE_CHUNKS.set_memcap(retval);
+                }
+                Err(_) => {
+                    SCLogError!("Invalid file-chunk-memcap value");
+                }
+            }
+        }
         let retval = conf_get("app-layer.protocols.smb.max-read-queue-cnt");
         if let Some(val) = retval {
             match get_memval(val) {
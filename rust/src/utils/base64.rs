@@ -19,73 +19,238 @@
 
 use std::io::{Error, ErrorKind, Result};
 
+const BASE64_INVALID: u8 = 0xff;
+
+const fn base64_build_table() -> [u8; 256] {
+    let alphabet = b"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    let mut table = [BASE64_INVALID; 256];
+    let mut i = 0;
+    while i < alphabet.len() {
+        table[alphabet[i] as usize] = i as u8;
+        i += 1;
+    }
+    table
+}
+
+/// Maps an input byte to its 6 bit value, or BASE64_INVALID.
+static BASE64_TABLE: [u8; 256] = base64_build_table();
+
 fn base64_map(input: u8) -> Result<u8> {
-    match input {
-        43 => Ok(62),  // +
-        47 => Ok(63),  // /
-        48 => Ok(52),  // 0
-        49 => Ok(53),  // 1
-        50 => Ok(54),  // 2
-        51 => Ok(55),  // 3
-        52 => Ok(56),  // 4
-        53 => Ok(57),  // 5
-        54 => Ok(58),  // 6
-        55 => Ok(59),  // 7
-        56 => Ok(60),  // 8
-        57 => Ok(61),  // 9
-        65 => Ok(0),   // A
-        66 => Ok(1),   // B
-        67 => Ok(2),   // C
-        68 => Ok(3),   // D
-        69 => Ok(4),   // E
-        70 => Ok(5),   // F
-        71 => Ok(6),   // G
-        72 => Ok(7),   // H
-        73 => Ok(8),   // I
-        74 => Ok(9),   // J
-        75 => Ok(10),  // K
-        76 => Ok(11),  // L
-        77 => Ok(12),  // M
-        78 => Ok(13),  // N
-        79 => Ok(14),  // O
-        80 => Ok(15),  // P
-        81 => Ok(16),  // Q
-        82 => Ok(17),  // R
-        83 => Ok(18),  // S
-        84 => Ok(19),  // T
-        85 => Ok(20),  // U
-        86 => Ok(21),  // V
-        87 => Ok(22),  // W
-        88 => Ok(23),  // X
-        89 => Ok(24),  // Y
-        90 => Ok(25),  // Z
-        97 => Ok(26),  // a
-        98 => Ok(27),  // b
-        99 => Ok(28),  // c
-        100 => Ok(29), // d
-        101 => Ok(30), // e
-        102 => Ok(31), // f
-        103 => Ok(32), // g
-        104 => Ok(33), // h
-        105 => Ok(34), // i
-        106 => Ok(35), // j
-        107 => Ok(36), // k
-        108 => Ok(37), // l
-        109 => Ok(38), // m
-        110 => Ok(39), // n
-        111 => Ok(40), // o
-        112 => Ok(41), // p
-        113 => Ok(42), // q
-        114 => Ok(43), // r
-        115 => Ok(44), // s
-        116 => Ok(45), // t
-        117 => Ok(46), // u
-        118 => Ok(47), // v
-        119 => Ok(48), // w
-        120 => Ok(49), // x
-        121 => Ok(50), // y
-        122 => Ok(51), // z
-        _ => Err(Error::new(ErrorKind::InvalidData, "invalid base64")),
+    match BASE64_TABLE[input as usize] {
+        BASE64_INVALID => Err(Error::new(ErrorKind::InvalidData, "invalid base64")),
+        v => Ok(v),
+    }
+}
+
+/// Decode the complete quanta of alphabet characters at the start of input.
+///
+/// Stops at the first quantum holding padding or a character outside of the
+/// alphabet, so that the caller can handle it byte per byte. Returns the number
+/// of bytes consumed and produced.
+pub fn decode_quanta_scalar(input: &[u8], output: &mut [u8]) -> (usize, usize) {
+    let mut consumed = 0;
+    let mut produced = 0;
+    for q in input.chunks_exact(4) {
+        if output.len() - produced < 3 {
+            break;
+        }
+        let a = BASE64_TABLE[q[0] as usize];
+        let b = BASE64_TABLE[q[1] as usize];
+        let c = BASE64_TABLE[q[2] as usize];
+        let d = BASE64_TABLE[q[3] as usize];
+        if (a | b | c | d) == BASE64_INVALID {
+            break;
+        }
+        let v = (a as u32) << 18 | (b as u32) << 12 | (c as u32) << 6 | d as u32;
+        output[produced] = (v >> 16) as u8;
+        output[produced + 1] = (v >> 8) as u8;
+        output[produced + 2] = v as u8;
+        consumed += 4;
+        produced += 3;
+    }
+    (consumed, produced)
+}
+
+/// Decode the complete quanta of alphabet characters at the start of input,
+/// using the widest vector instructions the cpu supports.
+pub fn decode_quanta(input: &[u8], output: &mut [u8]) -> (usize, usize) {
+    let (consumed, produced) = simd::decode_quanta(input, output);
+    let (c, p) = decode_quanta_scalar(&input[consumed..], &mut output[produced..]);
+    (consumed + c, produced + p)
+}
+
+/// Vectorized decoding of 16 (or 32) characters at a time. Each block is
+/// validated against the alphabet first: a block with padding or another
+/// character falls back to the scalar code. Lookup tables and reshuffling
+/// follow the approach of Wojciech Mula and Alfred Klomp.
+#[cfg(target_arch = "x86_64")]
+mod simd {
+    use std::arch::x86_64::*;
+
+    pub fn decode_quanta(input: &[u8], output: &mut [u8]) -> (usize, usize) {
+        if is_x86_feature_detected!("avx2") {
+            return unsafe { decode_avx2(input, output) };
+        }
+        if is_x86_feature_detected!("ssse3") {
+            return unsafe { decode_ssse3(input, output) };
+        }
+        (0, 0)
+    }
+
+    #[target_feature(enable = "ssse3")]
+    unsafe fn decode_ssse3(input: &[u8], output: &mut [u8]) -> (usize, usize) {
+        let lut_lo = _mm_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b,
+            0x1b, 0x1a,
+        );
+        let lut_hi = _mm_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10,
+        );
+        let lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        let mask_2f = _mm_set1_epi8(0x2f);
+        let pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+        let mut consumed = 0;
+        let mut produced = 0;
+        while input.len() - consumed >= 16 && output.len() - produced >= 16 {
+            let src = _mm_loadu_si128(input.as_ptr().add(consumed) as *const __m128i);
+            let hi_nibbles = _mm_and_si128(_mm_srli_epi32(src, 4), mask_2f);
+            let lo_nibbles = _mm_and_si128(src, mask_2f);
+            let hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+            let lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+            if _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0 {
+                break;
+            }
+            let eq_2f = _mm_cmpeq_epi8(src, mask_2f);
+            let roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+            let values = _mm_add_epi8(src, roll);
+            let merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            let merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+            let out = _mm_shuffle_epi8(merged, pack);
+            _mm_storeu_si128(output.as_mut_ptr().add(produced) as *mut __m128i, out);
+            consumed += 16;
+            produced += 12;
+        }
+        (consumed, produced)
+    }
+
+    #[target_feature(enable = "avx2")]
+    unsafe fn decode_avx2(input: &[u8], output: &mut [u8]) -> (usize, usize) {
+        let lut_lo = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b,
+            0x1b, 0x1a,
+        ));
+        let lut_hi = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10,
+        ));
+        let lut_roll = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        ));
+        let mask_2f = _mm256_set1_epi8(0x2f);
+        let pack = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        ));
+        let compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+
+        let mut consumed = 0;
+        let mut produced = 0;
+        while input.len() - consumed >= 32 && output.len() - produced >= 32 {
+            let src = _mm256_loadu_si256(input.as_ptr().add(consumed) as *const __m256i);
+            let hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(src, 4), mask_2f);
+            let lo_nibbles = _mm256_and_si256(src, mask_2f);
+            let hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+            let lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+            if _mm256_movemask_epi8(_mm256_cmpgt_epi8(
+                _mm256_and_si256(lo, hi),
+                _mm256_setzero_si256(),
+            )) != 0
+            {
+                break;
+            }
+            let eq_2f = _mm256_cmpeq_epi8(src, mask_2f);
+            let roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+            let values = _mm256_add_epi8(src, roll);
+            let merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+            let merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+            let out = _mm256_shuffle_epi8(merged, pack);
+            let out = _mm256_permutevar8x32_epi32(out, compact);
+            _mm256_storeu_si256(output.as_mut_ptr().add(produced) as *mut __m256i, out);
+            consumed += 32;
+            produced += 24;
+        }
+        let (c, p) = decode_ssse3(&input[consumed..], &mut output[produced..]);
+        (consumed + c, produced + p)
+    }
+}
+
+#[cfg(all(target_arch = "aarch64", target_feature = "neon"))]
+mod simd {
+    use std::arch::aarch64::*;
+
+    pub fn decode_quanta(input: &[u8], output: &mut [u8]) -> (usize, usize) {
+        unsafe { decode_neon(input, output) }
+    }
+
+    #[target_feature(enable = "neon")]
+    unsafe fn decode_neon(input: &[u8], output: &mut [u8]) -> (usize, usize) {
+        const LUT_LO: [u8; 16] = [
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b,
+            0x1b, 0x1a,
+        ];
+        const LUT_HI: [u8; 16] = [
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10,
+        ];
+        const LUT_ROLL: [u8; 16] = [0, 16, 19, 4, 0xbf, 0xbf, 0xb9, 0xb9, 0, 0, 0, 0, 0, 0, 0, 0];
+        const PACK: [u8; 16] = [
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, 0xff, 0xff, 0xff, 0xff,
+        ];
+        let lut_lo = vld1q_u8(LUT_LO.as_ptr());
+        let lut_hi = vld1q_u8(LUT_HI.as_ptr());
+        let lut_roll = vld1q_u8(LUT_ROLL.as_ptr());
+        let pack = vld1q_u8(PACK.as_ptr());
+        let mask_0f = vdupq_n_u8(0x0f);
+        let slash = vdupq_n_u8(0x2f);
+        let mask_ff = vdupq_n_u32(0xff);
+
+        let mut consumed = 0;
+        let mut produced = 0;
+        while input.len() - consumed >= 16 && output.len() - produced >= 16 {
+            let src = vld1q_u8(input.as_ptr().add(consumed));
+            let hi_nibbles = vshrq_n_u8(src, 4);
+            let lo_nibbles = vandq_u8(src, mask_0f);
+            let hi = vqtbl1q_u8(lut_hi, hi_nibbles);
+            let lo = vqtbl1q_u8(lut_lo, lo_nibbles);
+            if vmaxvq_u8(vandq_u8(lo, hi)) != 0 {
+                break;
+            }
+            let eq_2f = vceqq_u8(src, slash);
+            let roll = vqtbl1q_u8(lut_roll, vaddq_u8(eq_2f, hi_nibbles));
+            let values = vreinterpretq_u32_u8(vaddq_u8(src, roll));
+            // each 32 bit lane holds 4 six bit values, first one in the low byte
+            let a = vshlq_n_u32(vandq_u32(values, mask_ff), 18);
+            let b = vshlq_n_u32(vandq_u32(vshrq_n_u32(values, 8), mask_ff), 12);
+            let c = vshlq_n_u32(vandq_u32(vshrq_n_u32(values, 16), mask_ff), 6);
+            let d = vshrq_n_u32(values, 24);
+            let merged = vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d));
+            let out = vqtbl1q_u8(vreinterpretq_u8_u32(merged), pack);
+            vst1q_u8(output.as_mut_ptr().add(produced), out);
+            consumed += 16;
+            produced += 12;
+        }
+        (consumed, produced)
+    }
+}
+
+#[cfg(not(any(
+    target_arch = "x86_64",
+    all(target_arch = "aarch64", target_feature = "neon")
+)))]
+mod simd {
+    pub fn decode_quanta(_input: &[u8], _output: &mut [u8]) -> (usize, usize) {
+        (0, 0)
     }
 }
 
@@ -118,6 +283,14 @@ pub fn decode_rfc4648(
     let mut offset = 0;
     let mut stop = false;
     while !i.is_empty() {
+        if decoder.nb == 0 {
+            let (consumed, produced) = decode_quanta(i, &mut output[offset..]);
+            i = &i[consumed..];
+            offset += produced;
+            if i.is_empty() {
+                break;
+            }
+        }
         while decoder.nb < 4 {
             if !i.is_empty() && (base64_map(i[0]).is_ok() || i[0] == b'=') {
                 decoder.tmp[decoder.nb as usize] = i[0];
@@ -171,6 +344,14 @@ pub fn decode_rfc2045(
     let mut offset = 0;
 
     while !i.is_empty() {
+        if decoder.nb == 0 {
+            let (consumed, produced) = decode_quanta(i, &mut output[offset..]);
+            i = &i[consumed..];
+            offset += produced;
+            if i.is_empty() {
+                break;
+            }
+        }
         while decoder.nb < 4 && !i.is_empty() {
             if base64_map(i[0]).is_ok() || i[0] == b'=' {
                 decoder.tmp[decoder.nb as usize] = i[0];
@@ -205,3 +386,99 @@ pub fn decode_rfc2045(
 
     return Ok(());
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn encode(input: &[u8]) -> Vec<u8> {
+        let alphabet = b"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        let mut out = Vec::new();
+        for c in input.chunks(3) {
+            let v = (c[0] as u32) << 16
+                | (*c.get(1).unwrap_or(&0) as u32) << 8
+                | *c.get(2).unwrap_or(&0) as u32;
+            out.push(alphabet[(v >> 18) as usize & 0x3f]);
+            out.push(alphabet[(v >> 12) as usize & 0x3f]);
+            out.push(if c.len() > 1 {
+                alphabet[(v >> 6) as usize & 0x3f]
+            } else {
+                b'='
+            });
+            out.push(if c.len() > 2 {
+                alphabet[v as usize & 0x3f]
+            } else {
+                b'='
+            });
+        }
+        out
+    }
+
+    fn data(len: usize) -> Vec<u8> {
+        (0..len).map(|i| (i * 7 + i / 256) as u8).collect()
+    }
+
+    #[test]
+    fn test_decode_quanta_vs_scalar() {
+        for len in 0..200 {
+            let plain = data(len);
+            let enc = encode(&plain);
+            let mut out = vec![0; enc.len()];
+            let mut out_scalar = vec![0; enc.len()];
+            let r = decode_quanta(&enc, &mut out);
+            let r_scalar = decode_quanta_scalar(&enc, &mut out_scalar);
+            assert_eq!(r, r_scalar);
+            assert_eq!(out[..r.1], out_scalar[..r_scalar.1]);
+            assert_eq!(out[..r.1], plain[..r.1]);
+        }
+    }
+
+    #[test]
+    fn test_decode_quanta_invalid() {
+        let plain = data(96);
+        let enc = encode(&plain);
+        for bad in [b'=', b' ', b'.', b'\n', 0x80, 0xff] {
+            for pos in [0, 5, 17, 40, 63, 127] {
+                let mut input = enc.clone();
+                input[pos] = bad;
+                let mut out = vec![0; input.len()];
+                let (consumed, produced) = decode_quanta(&input, &mut out);
+                assert_eq!(consumed, pos - pos % 4);
+                assert_eq!(produced, consumed / 4 * 3);
+                assert_eq!(out[..produced], plain[..produced]);
+            }
+        }
+    }
+
+    #[test]
+    fn test_decode_rfc2045_lines() {
+        let plain = data(4096);
+        let enc = encode(&plain);
+        let mut input = Vec::new();
+        for line in enc.chunks(76) {
+            input.extend_from_slice(line);
+            input.extend_from_slice(b"\r\n");
+        }
+        let mut decoder = Decoder::new();
+        let mut out = vec![0; get_decoded_buffer_size(input.len() as u32) as usize];
+        let mut decoded = 0;
+        assert!(decode_rfc2045(&mut decoder, &input, &mut out, &mut decoded).is_ok());
+        assert_eq!(decoded as usize, plain.len());
+        assert_eq!(out[..decoded as usize], plain[..]);
+    }
+
+    #[test]
+    fn test_decode_rfc4648_stop() {
+        let plain = data(100);
+        let mut input = encode(&plain);
+        input.truncate(64);
+        input.extend_from_slice(b"Zm 9v");
+        let mut decoder = Decoder::new();
+        let mut out = vec![0; input.len()];
+        let mut decoded = 0;
+        assert!(decode_rfc4648(&mut decoder, &input, &mut out, &mut decoded).is_ok());
+        assert_eq!(decoded, 49);
+        assert_eq!(out[..48], plain[..48]);
+        assert_eq!(out[48], b'f');
+    }
+}
@@ -20,9 +20,15 @@
 // written by Pierre Chifflier  <chifflier@wzdftpd.net>
 
 use crate::x509::GeneralName;
+use lru::LruCache;
 use nom7::Err;
 use std;
+use std::cell::RefCell;
+use std::collections::hash_map::DefaultHasher;
 use std::fmt;
+use std::hash::{Hash, Hasher};
+use std::num::NonZeroUsize;
+use std::sync::{Arc, OnceLock};
 use x509_parser::prelude::*;
 mod log;
 mod time;
@@ -44,7 +50,23 @@ pub enum X509DecodeError {
     InvalidDER,
 }
 
-pub struct X509(X509Certificate<'static>);
+/// A decoded certificate. It owns a copy of the DER encoding, so that it can
+/// outlive the input buffer and be shared through the cache.
+///
+/// Only the validity is extracted when decoding. The other fields are
+/// formatted on first access, which parses the encoding again: parsing
+/// borrows from the input and is cheap compared to formatting the names.
+struct X509Fields {
+    der: Box<[u8]>,
+    not_before: i64,
+    not_after: i64,
+    subject: OnceLock<Vec<u8>>,
+    issuer: OnceLock<Vec<u8>>,
+    serial: OnceLock<Vec<u8>>,
+    sans: OnceLock<Vec<Vec<u8>>>,
+}
+
+pub struct X509(Arc<X509Fields>);
 
 pub struct SCGeneralName<'a>(&'a GeneralName<'a>);
 
@@ -59,8 +81,134 @@ impl fmt::Display for SCGeneralName<'_> {
     }
 }
 
+impl X509Fields {
+    fn new(der: &[u8], cert: &X509Certificate) -> Self {
+        Self {
+            der: der.into(),
+            not_before: cert.validity().not_before.timestamp(),
+            not_after: cert.validity().not_after.timestamp(),
+            subject: OnceLock::new(),
+            issuer: OnceLock::new(),
+            serial: OnceLock::new(),
+            sans: OnceLock::new(),
+        }
+    }
+
+    /// Parse the encoding again and run `f` on the certificate. The
+    /// encoding was parsed successfully before, so this only fails if the
+    /// parser is not deterministic, in which case the field is left empty.
+    fn with_cert<T: Default>(&self, f: impl FnOnce(&X509Certificate) -> T) -> T {
+        match X509Certificate::from_der(&self.der) {
+            Ok((_rem, cert)) => f(&cert),
+            Err(_) => T::default(),
+        }
+    }
+
+    fn subject(&self) -> &[u8] {
+        self.subject.get_or_init(|| {
+            self.with_cert(|cert| cert.tbs_certificate.subject().to_string().into_bytes())
+        })
+    }
+
+    fn issuer(&self) -> &[u8] {
+        self.issuer.get_or_init(|| {
+            self.with_cert(|cert| cert.tbs_certificate.issuer.to_string().into_bytes())
+        })
+    }
+
+    fn serial(&self) -> &[u8] {
+        self.serial.get_or_init(|| {
+            self.with_cert(|cert| {
+                let v: Vec<_> = cert
+                    .tbs_certificate
+                    .raw_serial()
+                    .iter()
+                    .map(|x| format!("{:02X}", x))
+                    .collect();
+                v.join(":").into_bytes()
+            })
+        })
+    }
+
+    fn sans(&self) -> &[Vec<u8>] {
+        self.sans.get_or_init(|| {
+            self.with_cert(|cert| {
+                let mut sans = Vec::new();
+                if let Ok(Some(san_list)) = cert.tbs_certificate.subject_alternative_name() {
+                    // SAN length in a certificate is kept u16 following discussions at
+                    // https://community.letsencrypt.org/t/why-sans-are-limited-to-100-domains-only
+                    debug_validate_bug_on!(
+                        san_list.value.general_names.len() == usize::from(u16::MAX)
+                    );
+                    for general_name in san_list.value.general_names.iter().take(u16::MAX as usize)
+                    {
+                        sans.push(SCGeneralName(general_name).to_string().into_bytes());
+                    }
+                }
+                sans
+            })
+        })
+    }
+}
+
+/// Number of leaf certificates remembered per thread. 0 disables the cache.
+static mut X509_CACHE_SIZE: usize = 64;
+
+thread_local! {
+    /// Recently decoded certificates, keyed by a hash of the DER encoding.
+    ///
+    /// The decoded certificates are shared with the X509 objects handed out
+    /// to the TLS state, which may be freed by another thread than the one
+    /// owning the cache, so the reference count needs to be atomic.
+    static X509_CACHE: RefCell<Option<LruCache<u64, Arc<X509Fields>>>> = const { RefCell::new(None) };
+}
+
+/// The signature at the end of the certificate makes its tail unique enough
+/// for a cache key. Hits are confirmed by comparing the full encoding.
+fn x509_cache_key(der: &[u8]) -> u64 {
+    let mut hasher = DefaultHasher::new();
+    der.len().hash(&mut hasher);
+    der[der.len().saturating_sub(32)..].hash(&mut hasher);
+    hasher.finish()
+}
+
+fn x509_cache_get(key: u64, der: &[u8]) -> Option<Arc<X509Fields>> {
+    X509_CACHE.with(|cache| {
+        let mut cache = cache.borrow_mut();
+        let fields = cache.as_mut()?.get(&key)?;
+        if *fields.der == *der {
+            return Some(fields.clone());
+        }
+        None
+    })
+}
+
+fn x509_cache_put(key: u64, fields: &Arc<X509Fields>) {
+    let size = unsafe { X509_CACHE_SIZE };
+    let Some(size) = NonZeroUsize::new(size) else {
+        return;
+    };
+    X509_CACHE.with(|cache| {
+        let mut cache = cache.borrow_mut();
+        let cache = cache.get_or_insert_with(|| LruCache::new(size));
+        cache.put(key, fields.clone());
+    });
+}
+
+/// Set the number of decoded leaf certificates each thread keeps around.
+///
+/// Must be called before the packet threads start.
+#[no_mangle]
+pub unsafe extern "C" fn SCX509SetCacheSize(size: u32) {
+    X509_CACHE_SIZE = size as usize;
+}
+
 /// Attempt to parse a X.509 from input, and return a pointer to the parsed object if successful.
 ///
+/// Certificates that were recently decoded by the same thread are served from
+/// a small cache instead of being parsed again. Subject, issuer, serial and
+/// subject alternative names are only formatted when first asked for.
+///
 /// # Safety
 ///
 /// input must be a valid buffer of at least input_len bytes
@@ -69,9 +217,17 @@ pub unsafe extern "C" fn SCX509Decode(
     input: *const u8, input_len: u32, err_code: *mut u32,
 ) -> *mut X509 {
     let slice = std::slice::from_raw_parts(input, input_len as usize);
+    let key = x509_cache_key(slice);
+    if let Some(fields) = x509_cache_get(key, slice) {
+        return Box::into_raw(Box::new(X509(fields)));
+    }
     let res = X509Certificate::from_der(slice);
     match res {
-        Ok((_rem, cert)) => Box::into_raw(Box::new(X509(cert))),
+        Ok((_rem, cert)) => {
+            let fields = Arc::new(X509Fields::new(slice, &cert));
+            x509_cache_put(key, &fields);
+            Box::into_raw(Box::new(X509(fields)))
+        }
         Err(e) => {
             let error = x509_parse_error_to_errcode(&e);
             *err_code = error as u32;
@@ -80,6 +236,13 @@ pub unsafe extern "C" fn SCX509Decode(
     }
 }
 
+fn x509_array_export(v: &[u8], ptr: *mut *mut u8, len: *mut u32) {
+    unsafe {
+        *len = v.len() as u32;
+        *ptr = Box::into_raw(v.to_vec().into_boxed_slice()) as *mut u8;
+    }
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn SCX509GetSubject(
     ptr: *const X509, subject_name: *mut *mut u8, subject_len: *mut u32,
@@ -90,10 +253,7 @@ pub unsafe extern "C" fn SCX509GetSubject(
         return;
     }
     let x509 = cast_pointer! {ptr, X509};
-    let subject = x509.0.tbs_certificate.subject().to_string().into_bytes();
-
-    *subject_len = subject.len() as u32;
-    *subject_name = Box::into_raw(subject.into_boxed_slice()) as *mut u8;
+    x509_array_export(x509.0.subject(), subject_name, subject_len);
 }
 
 #[no_mangle]
@@ -102,14 +262,7 @@ pub unsafe extern "C" fn SCX509GetSubjectAltNameLen(ptr: *const X509) -> u16 {
         return 0;
     }
     let x509 = cast_pointer! {ptr, X509};
-    let san_list = x509.0.tbs_certificate.subject_alternative_name();
-    if let Ok(Some(sans)) = san_list {
-        // SAN length in a certificate is kept u16 following discussions at
-        // https://community.letsencrypt.org/t/why-sans-are-limited-to-100-domains-only
-        debug_validate_bug_on!(sans.value.general_names.len() == usize::from(u16::MAX));
-        return sans.value.general_names.len() as u16;
-    }
-    return 0;
+    return x509.0.sans().len() as u16;
 }
 
 #[no_mangle]
@@ -122,13 +275,8 @@ pub unsafe extern "C" fn SCX509GetSubjectAltNameAt(
         return;
     }
     let x509 = cast_pointer! {ptr, X509};
-    let san_list = x509.0.tbs_certificate.subject_alternative_name();
-    if let Ok(Some(sans)) = san_list {
-        let general_name = &sans.value.general_names[idx as usize];
-        let dns_name = SCGeneralName(general_name);
-        let dn = dns_name.to_string().into_bytes();
-        *san_len = dn.len() as u32;
-        *san = Box::into_raw(dn.into_boxed_slice()) as *mut u8;
+    if let Some(dn) = x509.0.sans().get(idx as usize) {
+        x509_array_export(dn, san, san_len);
     }
 }
 
@@ -142,10 +290,7 @@ pub unsafe extern "C" fn SCX509GetIssuer(
         return;
     }
     let x509 = cast_pointer! {ptr, X509};
-    let issuer = x509.0.tbs_certificate.issuer.to_string().into_bytes();
-
-    *issuer_len = issuer.len() as u32;
-    *issuer_name = Box::into_raw(issuer.into_boxed_slice()) as *mut u8;
+    x509_array_export(x509.0.issuer(), issuer_name, issuer_len);
 }
 
 #[no_mangle]
@@ -158,11 +303,7 @@ pub unsafe extern "C" fn SCX509GetSerial(
         return;
     }
     let x509 = cast_pointer! {ptr, X509};
-    let raw_serial = x509.0.tbs_certificate.raw_serial();
-    let v: Vec<_> = raw_serial.iter().map(|x| format!("{:02X}", x)).collect();
-    let serial = v.join(":");
-    *serial_len = serial.len() as u32;
-    *serial_num = Box::into_raw(serial.into_bytes().into_boxed_slice()) as *mut u8;
+    x509_array_export(x509.0.serial(), serial_num, serial_len);
 }
 
 /// Extract validity from input X.509 object
@@ -178,10 +319,8 @@ pub unsafe extern "C" fn SCX509GetValidity(
         return -1;
     }
     let x509 = &*ptr;
-    let n_b = x509.0.validity().not_before.timestamp();
-    let n_a = x509.0.validity().not_after.timestamp();
-    *not_before = n_b;
-    *not_after = n_a;
+    *not_before = x509.0.not_before;
+    *not_after = x509.0.not_after;
     0
 }
 
@@ -224,3 +363,103 @@ fn x509_parse_error_to_errcode(e: &Err<X509Error>) -> X509DecodeError {
         },
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Self-signed EC certificate, CN=lazy.example.com, O=Test, serial 0x1234,
+    /// SANs lazy.example.com and www.example.com
+    const CERT: &[u8] = &[
+        0x30, 0x82, 0x01, 0xc6, 0x30, 0x82, 0x01, 0x6c, 0xa0, 0x03, 0x02, 0x01, 0x02, 0x02, 0x02,
+        0x12, 0x34, 0x30, 0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x02, 0x30,
+        0x2a, 0x31, 0x19, 0x30, 0x17, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0c, 0x10, 0x6c, 0x61, 0x7a,
+        0x79, 0x2e, 0x65, 0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f, 0x6d, 0x31, 0x0d,
+        0x30, 0x0b, 0x06, 0x03, 0x55, 0x04, 0x0a, 0x0c, 0x04, 0x54, 0x65, 0x73, 0x74, 0x30, 0x1e,
+        0x17, 0x0d, 0x32, 0x36, 0x31, 0x30, 0x31, 0x37, 0x30, 0x35, 0x31, 0x39, 0x33, 0x37, 0x5a,
+        0x17, 0x0d, 0x32, 0x36, 0x31, 0x30, 0x31, 0x38, 0x30, 0x35, 0x31, 0x39, 0x33, 0x37, 0x5a,
+        0x30, 0x2a, 0x31, 0x19, 0x30, 0x17, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0c, 0x10, 0x6c, 0x61,
+        0x7a, 0x79, 0x2e, 0x65, 0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f, 0x6d, 0x31,
+        0x0d, 0x30, 0x0b, 0x06, 0x03, 0x55, 0x04, 0x0a, 0x0c, 0x04, 0x54, 0x65, 0x73, 0x74, 0x30,
+        0x59, 0x30, 0x13, 0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02, 0x01, 0x06, 0x08, 0x2a,
+        0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04, 0xc2, 0x6b, 0x13, 0x65,
+        0xea, 0x4d, 0x3c, 0x99, 0x38, 0x97, 0x38, 0x79, 0xac, 0x50, 0x54, 0x87, 0x29, 0x56, 0x61,
+        0x65, 0x91, 0x5e, 0x30, 0xf0, 0xa8, 0xcf, 0xd7, 0x45, 0x48, 0x0c, 0x1e, 0xe1, 0xed, 0x03,
+        0x3b, 0x50, 0x65, 0x98, 0xbe, 0x09, 0x02, 0x90, 0x83, 0x42, 0x43, 0xde, 0x0e, 0x1f, 0xb4,
+        0xef, 0x38, 0xc1, 0xca, 0x83, 0xfe, 0xe5, 0xd7, 0x40, 0xc5, 0xfb, 0x41, 0x4c, 0x69, 0xf8,
+        0xa3, 0x81, 0x81, 0x30, 0x7f, 0x30, 0x1d, 0x06, 0x03, 0x55, 0x1d, 0x0e, 0x04, 0x16, 0x04,
+        0x14, 0xaf, 0xc6, 0x7d, 0x60, 0x77, 0x9e, 0x8e, 0x1a, 0x06, 0xca, 0xbc, 0xed, 0xdf, 0x2a,
+        0xce, 0x19, 0x77, 0x77, 0x43, 0x9e, 0x30, 0x1f, 0x06, 0x03, 0x55, 0x1d, 0x23, 0x04, 0x18,
+        0x30, 0x16, 0x80, 0x14, 0xaf, 0xc6, 0x7d, 0x60, 0x77, 0x9e, 0x8e, 0x1a, 0x06, 0xca, 0xbc,
+        0xed, 0xdf, 0x2a, 0xce, 0x19, 0x77, 0x77, 0x43, 0x9e, 0x30, 0x0f, 0x06, 0x03, 0x55, 0x1d,
+        0x13, 0x01, 0x01, 0xff, 0x04, 0x05, 0x30, 0x03, 0x01, 0x01, 0xff, 0x30, 0x2c, 0x06, 0x03,
+        0x55, 0x1d, 0x11, 0x04, 0x25, 0x30, 0x23, 0x82, 0x10, 0x6c, 0x61, 0x7a, 0x79, 0x2e, 0x65,
+        0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f, 0x6d, 0x82, 0x0f, 0x77, 0x77, 0x77,
+        0x2e, 0x65, 0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f, 0x6d, 0x30, 0x0a, 0x06,
+        0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x02, 0x03, 0x48, 0x00, 0x30, 0x45, 0x02,
+        0x20, 0x6c, 0x5f, 0xa2, 0x6e, 0xc0, 0x1e, 0x23, 0xf0, 0x83, 0xb4, 0x6c, 0x38, 0xcc, 0x02,
+        0xae, 0xc0, 0xf7, 0x36, 0x45, 0xb9, 0x1d, 0x75, 0x98, 0x06, 0xdc, 0x16, 0xc0, 0xcb, 0x7a,
+        0x1b, 0x4a, 0x1e, 0x02, 0x21, 0x00, 0xe0, 0x4f, 0x71, 0x5e, 0x7d, 0x4b, 0x76, 0x2b, 0x52,
+        0x70, 0x28, 0xa0, 0x2a, 0xef, 0x9d, 0x85, 0x9d, 0x7f, 0x57, 0xc0, 0xdb, 0x27, 0xf8, 0xf1,
+        0x0c, 0xbf, 0x71, 0xaf, 0xbd, 0x8d, 0x24, 0x47,
+    ];
+
+    #[test]
+    fn test_x509_decode_lazy() {
+        let mut err_code = 0;
+        let ptr = unsafe { SCX509Decode(CERT.as_ptr(), CERT.len() as u32, &mut err_code) };
+        assert!(!ptr.is_null());
+        let x509 = unsafe { &*ptr };
+
+        // only the validity is extracted when decoding
+        assert!(x509.0.subject.get().is_none());
+        assert!(x509.0.issuer.get().is_none());
+        assert!(x509.0.serial.get().is_none());
+        assert!(x509.0.sans.get().is_none());
+        assert!(x509.0.not_after > x509.0.not_before);
+
+        assert_eq!(x509.0.serial(), b"12:34");
+        assert!(x509.0.subject.get().is_none());
+        assert!(x509.0.issuer.get().is_none());
+
+        let subject = String::from_utf8(x509.0.subject().to_vec()).unwrap();
+        assert!(subject.contains("CN=lazy.example.com"));
+        assert!(subject.contains("O=Test"));
+        assert!(x509.0.issuer.get().is_none());
+        assert!(x509.0.sans.get().is_none());
+
+        assert_eq!(unsafe { SCX509GetSubjectAltNameLen(ptr) }, 2);
+        assert_eq!(x509.0.sans()[0], b"lazy.example.com");
+        assert_eq!(x509.0.sans()[1], b"www.example.com");
+
+        unsafe { SCX509Free(ptr) };
+    }
+
+    #[test]
+    fn test_x509_decode_cache() {
+        let mut err_code = 0;
+        let ptr1 = unsafe { SCX509Decode(CERT.as_ptr(), CERT.len() as u32, &mut err_code) };
+        let ptr2 = unsafe { SCX509Decode(CERT.as_ptr(), CERT.len() as u32, &mut err_code) };
+        assert!(!ptr1.is_null() && !ptr2.is_null());
+        let (x1, x2) = unsafe { (&*ptr1, &*ptr2) };
+        assert!(Arc::ptr_eq(&x1.0, &x2.0));
+
+        // fields formatted through one object are available to the other
+        assert_eq!(x1.0.serial(), b"12:34");
+        assert!(x2.0.serial.get().is_some());
+
+        unsafe { SCX509Free(ptr1) };
+        unsafe { SCX509Free(ptr2) };
+    }
+
+    #[test]
+    fn test_x509_decode_invalid() {
+        let mut der = CERT.to_vec();
+        // break the outer SEQUENCE tag
+        der[0] = 0x31;
+        let mut err_code = 0;
+        let ptr = unsafe { SCX509Decode(der.as_ptr(), der.len() as u32, &mut err_code) };
+        assert!(ptr.is_null());
+        assert_ne!(err_code, 0);
+    }
+}
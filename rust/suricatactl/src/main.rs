@@ -11,6 +11,7 @@ use clap::Subcommand;
 use tracing::Level;
 
 mod filestore;
+mod stats;
 
 #[derive(Parser, Debug)]
 struct Cli {
@@ -33,6 +34,8 @@ struct Cli {
 enum Commands {
     /// Filestore management commands
     Filestore(FilestoreCommand),
+    /// Stats commands
+    Stats(StatsCommand),
 }
 
 #[derive(Parser, Debug)]
@@ -57,6 +60,35 @@ struct FilestorePruneArgs {
     age: String,
 }
 
+#[derive(Parser, Debug)]
+struct StatsCommand {
+    #[command(subcommand)]
+    command: StatsCommands,
+}
+
+#[derive(Subcommand, Debug)]
+enum StatsCommands {
+    /// Show the counters from the shared memory stats segment
+    Show(StatsShowArgs),
+}
+
+#[derive(Parser, Debug)]
+struct StatsShowArgs {
+    #[arg(
+        long,
+        short,
+        default_value = "/dev/shm/suricata-stats",
+        help = "stats segment, see stats.shm.filename"
+    )]
+    filename: String,
+    #[arg(long, short, help = "show the counters per thread")]
+    threads: bool,
+    #[arg(long, help = "only show counters with names containing this")]
+    filter: Option<String>,
+    #[arg(long, short, help = "also show counters that are 0")]
+    zeroes: bool,
+}
+
 fn main() -> Result<(), Box<dyn std::error::Error>> {
     let cli = Cli::parse();
 
@@ -73,5 +105,8 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
         Commands::Filestore(filestore) => match filestore.command {
             FilestoreCommands::Prune(args) => crate::filestore::prune::prune(args),
         },
+        Commands::Stats(stats) => match stats.command {
+            StatsCommands::Show(args) => crate::stats::show(args),
+        },
     }
 }
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: Copyright 2025 Open Information Security Foundation
+// SPDX-License-Identifier: GPL-2.0-only
+
+pub(crate) mod shm;
+
+use crate::StatsShowArgs;
+use shm::{CounterType, StatsShm};
+
+pub(crate) fn show(args: StatsShowArgs) -> Result<(), Box<dyn std::error::Error>> {
+    let shm = StatsShm::open(&args.filename)?;
+    let snapshot = shm.read()?;
+
+    let matches = |name: &str| args.filter.as_ref().map_or(true, |f| name.contains(f));
+    let print = |name: &str, value: i64| {
+        if (value != 0 || args.zeroes) && matches(name) {
+            println!("{:<60} | {}", name, value);
+        }
+    };
+
+    if args.threads {
+        for thread in &snapshot.threads {
+            println!("{}", thread.name);
+            for (id, values) in &thread.counters {
+                let counter = &snapshot.counters[*id as usize];
+                print(&counter.name, counter.kind.value(values));
+            }
+        }
+    } else {
+        let mut totals: Vec<Option<Vec<i64>>> = vec![None; snapshot.counters.len()];
+        for thread in &snapshot.threads {
+            for (id, values) in &thread.counters {
+                let kind = &snapshot.counters[*id as usize].kind;
+                let total = &mut totals[*id as usize];
+                *total = Some(match total.take() {
+                    None => values.clone(),
+                    Some(t) => kind.merge(&t, values),
+                });
+            }
+        }
+        for (counter, total) in snapshot.counters.iter().zip(totals) {
+            if let Some(total) = total {
+                print(&counter.name, counter.kind.value(&total));
+            }
+        }
+    }
+
+    Ok(())
+}
+
+impl CounterType {
+    /// Merge the values of a counter from 2 threads.
+    fn merge(&self, a: &[i64], b: &[i64]) -> Vec<i64> {
+        let sum = a.iter().zip(b).map(|(a, b)| a + b);
+        match self {
+            CounterType::Maximum => vec![a[0].max(b[0])],
+            // the max value followed by the buckets
+            CounterType::Histogram => std::iter::once(a[0].max(b[0])).chain(sum.skip(1)).collect(),
+            _ => sum.collect(),
+        }
+    }
+
+    /// The value as shown by the other stats outputs.
+    fn value(&self, values: &[i64]) -> i64 {
+        match self {
+            CounterType::Average if values.len() > 1 && values[1] > 0 => values[0] / values[1],
+            CounterType::Average => 0,
+            _ => values[0],
+        }
+    }
+}
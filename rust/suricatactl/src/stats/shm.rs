@@ -0,0 +1,259 @@
+// SPDX-FileCopyrightText: Copyright 2025 Open Information Security Foundation
+// SPDX-License-Identifier: GPL-2.0-only
+
+//! Reader for the shared memory stats segment written by Suricata when
+//! `stats.shm` is enabled. The layout is described in `src/counters-shm.h`.
+//!
+//! The segment is read with regular file reads, so no memory mapping is
+//! needed. Each thread publishes its counters with a seqlock, which is
+//! checked to get a consistent copy of the values of each thread.
+
+use std::fs::File;
+use std::io::{Read, Seek, SeekFrom};
+use std::path::Path;
+
+const MAGIC: u32 = 0x54534353;
+const VERSION: u32 = 1;
+
+const HEADER_LEN: usize = 48;
+const NAME_LEN: usize = 128;
+const COUNTER_LEN: usize = NAME_LEN + 8;
+const THREAD_NAME_LEN: usize = 64;
+const THREAD_LEN: usize = THREAD_NAME_LEN + 24;
+const NO_ID: u32 = u32::MAX;
+
+/// How often to retry reading the values of a thread that is updating them.
+const SEQ_RETRIES: usize = 1000;
+
+type Error = Box<dyn std::error::Error>;
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) enum CounterType {
+    Normal,
+    /// Sum and number of updates.
+    Average,
+    Maximum,
+    /// Max value followed by the buckets.
+    Histogram,
+    Unknown(u32),
+}
+
+impl From<u32> for CounterType {
+    fn from(v: u32) -> Self {
+        match v {
+            1 => CounterType::Normal,
+            2 => CounterType::Average,
+            3 => CounterType::Maximum,
+            6 => CounterType::Histogram,
+            _ => CounterType::Unknown(v),
+        }
+    }
+}
+
+#[derive(Debug)]
+pub(crate) struct Counter {
+    pub name: String,
+    pub kind: CounterType,
+}
+
+#[derive(Debug)]
+pub(crate) struct Thread {
+    pub name: String,
+    /// Counter id and the values of the counter.
+    pub counters: Vec<(u32, Vec<i64>)>,
+}
+
+#[derive(Debug)]
+pub(crate) struct Snapshot {
+    /// Engine start time, seconds since the epoch.
+    #[allow(dead_code)]
+    pub start_time: i64,
+    /// Counters, indexed by id.
+    pub counters: Vec<Counter>,
+    pub threads: Vec<Thread>,
+}
+
+struct Header {
+    start_time: i64,
+    ncounters: usize,
+    nthreads: usize,
+    counters_offset: u64,
+    threads_offset: u64,
+}
+
+pub(crate) struct StatsShm {
+    file: File,
+}
+
+fn u32_at(buf: &[u8], offset: usize) -> u32 {
+    u32::from_ne_bytes(buf[offset..offset + 4].try_into().unwrap())
+}
+
+fn u64_at(buf: &[u8], offset: usize) -> u64 {
+    u64::from_ne_bytes(buf[offset..offset + 8].try_into().unwrap())
+}
+
+fn str_at(buf: &[u8], offset: usize, len: usize) -> String {
+    let s = &buf[offset..offset + len];
+    let end = s.iter().position(|&c| c == 0).unwrap_or(len);
+    String::from_utf8_lossy(&s[..end]).into_owned()
+}
+
+impl StatsShm {
+    pub(crate) fn open<P: AsRef<Path>>(path: P) -> Result<Self, Error> {
+        let file = File::open(path)?;
+        Ok(Self { file })
+    }
+
+    fn read_at(&mut self, offset: u64, len: usize) -> Result<Vec<u8>, Error> {
+        let mut buf = vec![0; len];
+        self.file.seek(SeekFrom::Start(offset))?;
+        self.file.read_exact(&mut buf)?;
+        Ok(buf)
+    }
+
+    fn header(&mut self) -> Result<Header, Error> {
+        let buf = self.read_at(0, HEADER_LEN)?;
+        if u32_at(&buf, 0) != MAGIC {
+            return Err("not a stats segment, or not ready yet".into());
+        }
+        let version = u32_at(&buf, 4);
+        if version != VERSION {
+            return Err(format!("unsupported stats segment version {}", version).into());
+        }
+        Ok(Header {
+            start_time: u64_at(&buf, 16) as i64,
+            ncounters: u32_at(&buf, 24) as usize,
+            nthreads: u32_at(&buf, 28) as usize,
+            counters_offset: u64_at(&buf, 32),
+            threads_offset: u64_at(&buf, 40),
+        })
+    }
+
+    /// Read the values of a thread, consistent with the seqlock.
+    fn values(&mut self, seq_offset: u64, offset: u64, n: usize) -> Result<Vec<i64>, Error> {
+        for _ in 0..SEQ_RETRIES {
+            let seq = u32_at(&self.read_at(seq_offset, 4)?, 0);
+            if seq % 2 == 1 {
+                std::thread::yield_now();
+                continue;
+            }
+            let buf = self.read_at(offset, n * 8)?;
+            if u32_at(&self.read_at(seq_offset, 4)?, 0) == seq {
+                return Ok((0..n).map(|i| u64_at(&buf, i * 8) as i64).collect());
+            }
+        }
+        Err("thread values kept changing while reading".into())
+    }
+
+    /// Take a snapshot of all counters.
+    pub(crate) fn read(mut self) -> Result<Snapshot, Error> {
+        let hdr = self.header()?;
+
+        let buf = self.read_at(hdr.counters_offset, hdr.ncounters * COUNTER_LEN)?;
+        let counters = (0..hdr.ncounters)
+            .map(|i| {
+                let o = i * COUNTER_LEN;
+                Counter {
+                    name: str_at(&buf, o, NAME_LEN),
+                    kind: CounterType::from(u32_at(&buf, o + NAME_LEN)),
+                }
+            })
+            .collect();
+
+        let buf = self.read_at(hdr.threads_offset, hdr.nthreads * THREAD_LEN)?;
+        let mut threads = Vec::with_capacity(hdr.nthreads);
+        for i in 0..hdr.nthreads {
+            let o = i * THREAD_LEN;
+            let name = str_at(&buf, o, THREAD_NAME_LEN);
+            let seq_offset = hdr.threads_offset + (o + THREAD_NAME_LEN) as u64;
+            let nvalues = u32_at(&buf, o + THREAD_NAME_LEN + 4) as usize;
+            let ids_offset = u64_at(&buf, o + THREAD_NAME_LEN + 8);
+            let values_offset = u64_at(&buf, o + THREAD_NAME_LEN + 16);
+
+            let ids = self.read_at(ids_offset, nvalues * 4)?;
+            let ids: Vec<u32> = (0..nvalues).map(|i| u32_at(&ids, i * 4)).collect();
+            let values = self.values(seq_offset, values_offset, nvalues)?;
+
+            // group the values by counter: a counter owns the values up
+            // to the next counter
+            let mut counters: Vec<(u32, Vec<i64>)> = Vec::new();
+            for (id, value) in ids.iter().zip(values) {
+                if *id != NO_ID && (*id as usize) < hdr.ncounters {
+                    counters.push((*id, vec![value]));
+                } else if let Some((_, v)) = counters.last_mut() {
+                    v.push(value);
+                }
+            }
+            threads.push(Thread { name, counters });
+        }
+
+        Ok(Snapshot {
+            start_time: hdr.start_time,
+            counters,
+            threads,
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Write;
+
+    fn counter(name: &str, kind: u32) -> Vec<u8> {
+        let mut v = name.as_bytes().to_vec();
+        v.resize(NAME_LEN, 0);
+        v.extend_from_slice(&kind.to_ne_bytes());
+        v.extend_from_slice(&0u32.to_ne_bytes());
+        v
+    }
+
+    #[test]
+    fn test_stats_shm_read() {
+        // 2 counters, 1 thread with 3 values: unused slot 0, an average
+        // counter using 2 slots
+        let threads_offset = (HEADER_LEN + 2 * COUNTER_LEN) as u64;
+        let ids_offset = threads_offset + THREAD_LEN as u64;
+        let values_offset = ids_offset + 16;
+        let size = values_offset + 3 * 8;
+
+        let mut seg = Vec::new();
+        seg.extend_from_slice(&MAGIC.to_ne_bytes());
+        seg.extend_from_slice(&VERSION.to_ne_bytes());
+        seg.extend_from_slice(&size.to_ne_bytes());
+        seg.extend_from_slice(&1700000000i64.to_ne_bytes());
+        seg.extend_from_slice(&2u32.to_ne_bytes());
+        seg.extend_from_slice(&1u32.to_ne_bytes());
+        seg.extend_from_slice(&(HEADER_LEN as u64).to_ne_bytes());
+        seg.extend_from_slice(&threads_offset.to_ne_bytes());
+        seg.extend(counter("decoder.pkts", 1));
+        seg.extend(counter("decoder.avg_pkt_size", 2));
+        let mut name = b"W#01".to_vec();
+        name.resize(THREAD_NAME_LEN, 0);
+        seg.extend(name);
+        seg.extend_from_slice(&2u32.to_ne_bytes());
+        seg.extend_from_slice(&3u32.to_ne_bytes());
+        seg.extend_from_slice(&ids_offset.to_ne_bytes());
+        seg.extend_from_slice(&values_offset.to_ne_bytes());
+        for id in [NO_ID, 1, NO_ID, 0] {
+            seg.extend_from_slice(&id.to_ne_bytes());
+        }
+        for v in [0i64, 3000, 4] {
+            seg.extend_from_slice(&v.to_ne_bytes());
+        }
+        assert_eq!(seg.len() as u64, size);
+
+        let path = std::env::temp_dir().join(format!("suricatactl-shm-{}", std::process::id()));
+        File::create(&path).unwrap().write_all(&seg).unwrap();
+        let snapshot = StatsShm::open(&path).unwrap().read().unwrap();
+        std::fs::remove_file(&path).unwrap();
+
+        assert_eq!(snapshot.counters.len(), 2);
+        assert_eq!(snapshot.counters[1].name, "decoder.avg_pkt_size");
+        assert_eq!(snapshot.counters[1].kind, CounterType::Average);
+        assert_eq!(snapshot.threads.len(), 1);
+        assert_eq!(snapshot.threads[0].name, "W#01");
+        assert_eq!(snapshot.threads[0].counters, vec![(1, vec![3000, 4])]);
+    }
+}
@@ -1526,6 +1526,9 @@ extern "C" {
         f: *mut Flow, direction: ::std::os::raw::c_int,
     );
 }
+extern "C" {
+    pub fn SCAppLayerParserTxReady(pstate: *mut AppLayerParserState, tx_id: u64);
+}
 extern "C" {
     pub fn SCAppLayerParserSetStreamDepth(ipproto: u8, alproto: AppProto, stream_depth: u32);
 }
@@ -76,17 +76,17 @@ typedef struct AlertDebugLogThread_ {
  */
 static void AlertDebugLogFlowVars(AlertDebugLogThread *aft, const Packet *p)
 {
+    for (uint32_t idx = FlowBitNext(p->flow, 0); idx != 0; idx = FlowBitNext(p->flow, idx)) {
+        const char *fbname = VarNameStoreLookupById(idx, VAR_TYPE_FLOW_BIT);
+        if (fbname) {
+            MemBufferWriteString(aft->buffer, "FLOWBIT:           %s\n", fbname);
+        }
+    }
+
     const GenericVar *gv = p->flow->flowvar;
     uint16_t i;
     while (gv != NULL) {
-        if (gv->type == DETECT_FLOWBITS) {
-            FlowBit *fb = (FlowBit *)gv;
-            const char *fbname = VarNameStoreLookupById(fb->idx, VAR_TYPE_FLOW_BIT);
-            if (fbname) {
-                MemBufferWriteString(aft->buffer, "FLOWBIT:           %s\n",
-                        fbname);
-            }
-        } else if (gv->type == DETECT_FLOWVAR || gv->type == DETECT_FLOWINT) {
+        if (gv->type == DETECT_FLOWVAR || gv->type == DETECT_FLOWINT) {
             FlowVar *fv = (FlowVar *) gv;
 
             if (fv->datatype == FLOWVAR_TYPE_STR) {
@@ -570,6 +570,19 @@ void AppLayerHtpEnableResponseBodyCallback(void)
     SCReturn;
 }
 
+/**
+ * \brief Sets a flag that informs the HTP app layer that an output logs the
+ *        http response body of all flows.
+ * \initonly
+ */
+void AppLayerHtpEnableResponseBodyLogging(void)
+{
+    SCEnter();
+
+    SC_ATOMIC_OR(htp_config_flags, HTP_REQUIRE_RESPONSE_BODY | HTP_REQUIRE_RESPONSE_BODY_LOG);
+    SCReturn;
+}
+
 /**
  * \brief Sets a flag that informs the HTP app layer that some module in the
  *        engine needs the http request file.
@@ -843,6 +856,35 @@ static AppLayerResult HTPHandleRequestData(Flow *f, void *htp_state, AppLayerPar
     SCReturnStruct(APP_LAYER_OK);
 }
 
+/* set by the file and filedata output registration */
+extern bool g_file_logger_enabled;
+extern bool g_filedata_logger_enabled;
+
+/**
+ *  \internal
+ *  \brief check if the response bodies of a flow need to be decompressed
+ *
+ *  Outputs logging bodies or files need them for all flows. Otherwise the
+ *  rules of the flow's to client rule group decide, or a filestore rule
+ *  that matched. As long as the rule group is not known, decompress.
+ */
+static bool HTPNeedResponseDecompression(const Flow *f)
+{
+    const uint32_t flags = SC_ATOMIC_GET(htp_config_flags);
+    if (!(flags & HTP_REQUIRE_RESPONSE_BODY))
+        return false;
+    if (flags & HTP_REQUIRE_RESPONSE_BODY_LOG)
+        return true;
+    if (g_file_logger_enabled || g_filedata_logger_enabled)
+        return true;
+    if (f->file_flags & FLOWFILE_STORE_TC)
+        return true;
+    if (!(f->flags & FLOW_SGH_TOCLIENT))
+        return true;
+    return f->sgh_toclient != NULL &&
+           (f->sgh_toclient->flags & SIG_GROUP_HEAD_HAVEHTTPRESPBODY);
+}
+
 /**
  *  \brief  Function to handle the reassembled data from server and feed it to
  *          the HTP library to process it.
@@ -881,6 +923,11 @@ static AppLayerResult HTPHandleResponseData(Flow *f, void *htp_state, AppLayerPa
     struct timeval ts = { SCTIME_SECS(f->startts), SCTIME_USECS(f->startts) };
     const htp_tx_t *tx = NULL;
     uint32_t consumed = 0;
+    if (hstate->cfg != NULL && hstate->cfg->lazy_decompression) {
+        /* applies to the responses starting in this data */
+        htp_connp_set_response_decompression(
+                hstate->connp, HTPNeedResponseDecompression(f) ? 1 : 0);
+    }
     if (input_len > 0) {
         const int r = htp_connp_response_data(hstate->connp, &ts, input, input_len);
         switch (r) {
@@ -2252,6 +2299,8 @@ static void HTPConfigParseParameters(HTPCfgRec *cfg_prec, SCConfNode *s, struct
             }
             SCLogConfig("Setting HTTP decompression time limit to %" PRIu32 " usec", limit);
             htp_config_set_compression_time_limit(cfg_prec->cfg, limit);
+        } else if (strcasecmp("lazy-decompression", p->name) == 0) {
+            cfg_prec->lazy_decompression = SCConfValIsTrue(p->val);
         } else if (strcasecmp("max-tx", p->name) == 0) {
             uint32_t limit = 0;
             if (ParseSizeStringU32(p->val, &limit) < 0) {
@@ -5672,6 +5721,92 @@ static int HTPParserTest27(void)
     PASS;
 }
 
+/** \test lazy decompression: response bodies are only decompressed once
+ *        something in the flow consumes them */
+static int HTPParserLazyDecompressionTest01(void)
+{
+    /* gzip of "lazy decompression test body" */
+    static const uint8_t gz[] = { 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xcb,
+        0x49, 0xac, 0xaa, 0x54, 0x48, 0x49, 0x4d, 0xce, 0xcf, 0x2d, 0x28, 0x4a, 0x2d, 0x2e, 0xce,
+        0xcc, 0xcf, 0x53, 0x28, 0x49, 0x2d, 0x2e, 0x51, 0x48, 0xca, 0x4f, 0xa9, 0x04, 0x00, 0x1a,
+        0x7d, 0x80, 0x5a, 0x1c, 0x00, 0x00, 0x00 };
+    static const char plain[] = "lazy decompression test body";
+    uint8_t request[] = "GET /a HTTP/1.1\r\nHost: example.com\r\n\r\n";
+    const char hdr[] = "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: 48\r\n\r\n";
+    uint8_t response[sizeof(hdr) - 1 + sizeof(gz)];
+    memcpy(response, hdr, sizeof(hdr) - 1);
+    memcpy(response + sizeof(hdr) - 1, gz, sizeof(gz));
+
+    const bool lazy = cfglist.lazy_decompression;
+    cfglist.lazy_decompression = true;
+    AppLayerHtpEnableResponseBodyCallback();
+
+    TcpSession ssn;
+    memset(&ssn, 0, sizeof(ssn));
+    AppLayerParserThreadCtx *alp_tctx = AppLayerParserThreadCtxAlloc();
+    FAIL_IF_NULL(alp_tctx);
+    Flow *f = UTHBuildFlow(AF_INET, "1.2.3.4", "1.2.3.5", 1024, 80);
+    FAIL_IF_NULL(f);
+    f->protoctx = &ssn;
+    f->proto = IPPROTO_TCP;
+    f->alproto = ALPROTO_HTTP1;
+    StreamTcpInitConfig(true);
+
+    /* rule group without response body rules */
+    f->flags |= FLOW_SGH_TOCLIENT;
+    f->sgh_toclient = NULL;
+
+    int r = AppLayerParserParse(NULL, alp_tctx, f, ALPROTO_HTTP1,
+            STREAM_TOSERVER | STREAM_START, request, sizeof(request) - 1);
+    FAIL_IF(r != 0);
+    r = AppLayerParserParse(NULL, alp_tctx, f, ALPROTO_HTTP1, STREAM_TOCLIENT | STREAM_START,
+            response, sizeof(response));
+    FAIL_IF(r != 0);
+
+    /* a filestore rule matched: the next response is decompressed */
+    f->file_flags |= FLOWFILE_STORE_TC;
+    r = AppLayerParserParse(
+            NULL, alp_tctx, f, ALPROTO_HTTP1, STREAM_TOSERVER, request, sizeof(request) - 1);
+    FAIL_IF(r != 0);
+    r = AppLayerParserParse(
+            NULL, alp_tctx, f, ALPROTO_HTTP1, STREAM_TOCLIENT, response, sizeof(response));
+    FAIL_IF(r != 0);
+
+    HtpState *htp_state = f->alstate;
+    FAIL_IF_NULL(htp_state);
+
+    htp_tx_t *tx = HTPStateGetTx(htp_state, 0);
+    FAIL_IF_NULL(tx);
+    HtpTxUserData *tx_ud = htp_tx_get_user_data(tx);
+    FAIL_IF_NULL(tx_ud);
+    FAIL_IF_NULL(tx_ud->response_body.first);
+    const uint8_t *data = NULL;
+    uint32_t data_len = 0;
+    StreamingBufferSegmentGetData(
+            tx_ud->response_body.sb, &tx_ud->response_body.first->sbseg, &data, &data_len);
+    FAIL_IF_NOT(data_len == sizeof(gz));
+    FAIL_IF(memcmp(data, gz, sizeof(gz)) != 0);
+    /* logged length is the same either way */
+    FAIL_IF_NOT(htp_tx_response_message_len(tx) == sizeof(gz));
+
+    tx = HTPStateGetTx(htp_state, 1);
+    FAIL_IF_NULL(tx);
+    tx_ud = htp_tx_get_user_data(tx);
+    FAIL_IF_NULL(tx_ud);
+    FAIL_IF_NULL(tx_ud->response_body.first);
+    StreamingBufferSegmentGetData(
+            tx_ud->response_body.sb, &tx_ud->response_body.first->sbseg, &data, &data_len);
+    FAIL_IF_NOT(data_len == sizeof(plain) - 1);
+    FAIL_IF(memcmp(data, plain, sizeof(plain) - 1) != 0);
+    FAIL_IF_NOT(htp_tx_response_message_len(tx) == sizeof(gz));
+
+    UTHFreeFlow(f);
+    AppLayerParserThreadCtxFree(alp_tctx);
+    StreamTcpFreeConfig(true);
+    cfglist.lazy_decompression = lazy;
+    PASS;
+}
+
 /**
  *  \brief  Register the Unit tests for the HTTP protocol
  */
@@ -5723,6 +5858,7 @@ static void HTPParserRegisterTests(void)
     UtRegisterTest("HTPParserTest25", HTPParserTest25);
     UtRegisterTest("HTPParserTest26", HTPParserTest26);
     UtRegisterTest("HTPParserTest27", HTPParserTest27);
+    UtRegisterTest("HTPParserLazyDecompressionTest01", HTPParserLazyDecompressionTest01);
 
     HTPFileParserRegisterTests();
     HTPXFFParserRegisterTests();
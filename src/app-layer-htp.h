@@ -117,6 +117,9 @@ typedef struct HTPCfgRec_ {
     HTPCfgDir response;
 
     bool uri_include_all; /**< use all info in uri (bool) */
+    /** only decompress response bodies if the body is inspected, logged
+     *  or extracted (bool) */
+    bool lazy_decompression;
 } HTPCfgRec;
 
 /** Struct used to hold chunks of a body on a request */
@@ -206,6 +209,8 @@ typedef struct HtpState_ {
 #define HTP_REQUIRE_REQUEST_FILE        (1 << 2)
 /** part of the engine needs the request body (e.g. file_data keyword) */
 #define HTP_REQUIRE_RESPONSE_BODY       (1 << 3)
+/** an output logs the response body, for all flows */
+#define HTP_REQUIRE_RESPONSE_BODY_LOG   (1 << 4)
 
 SC_ATOMIC_EXTERN(uint32_t, htp_config_flags);
 
@@ -217,6 +222,7 @@ void HTPFreeConfig(void);
 void HTPStateFree(void *);
 void AppLayerHtpEnableRequestBodyCallback(void);
 void AppLayerHtpEnableResponseBodyCallback(void);
+void AppLayerHtpEnableResponseBodyLogging(void);
 void AppLayerHtpNeedFileInspection(void);
 void AppLayerHtpPrintStats(void);
 
@@ -37,6 +37,7 @@
 
 #include "util-validate.h"
 #include "util-config.h"
+#include "conf.h"
 
 #include "app-layer.h"
 #include "app-layer-detect-proto.h"
@@ -132,6 +133,23 @@ typedef struct AppLayerParserCtx_ {
     size_t ctxs_len;
 } AppLayerParserCtx;
 
+/** initial number of txs the tx ready queue can hold */
+#define APP_LAYER_TX_READY_QUEUE_SIZE 8
+/** max number of txs tracked by the tx ready queue between cleanup runs.
+ *  Beyond this iterating all txs is as cheap as using the queue. */
+#define APP_LAYER_TX_READY_QUEUE_MAX 256
+
+/** tx ready queue: ids of the txs that the parser updated since the last
+ *  cleanup run, plus the complete txs that still wait for detection,
+ *  logging or file handling. Grows on demand up to
+ *  APP_LAYER_TX_READY_QUEUE_MAX. */
+typedef struct AppLayerTxReadyQueue_ {
+    uint16_t cnt;
+    uint16_t size;
+    bool overflow;
+    uint64_t *ids;
+} AppLayerTxReadyQueue;
+
 struct AppLayerParserState_ {
     /* coccinelle: AppLayerParserState:flags:APP_LAYER_PARSER_ */
     uint16_t flags;
@@ -146,6 +164,10 @@ struct AppLayerParserState_ {
 
     uint64_t min_id;
 
+    /* tx ready queue, allocated on first use by parsers that register
+     * APP_LAYER_PARSER_OPT_TX_READY_QUEUE */
+    AppLayerTxReadyQueue *tx_ready;
+
     /* Used to store decoder events. */
     AppLayerDecoderEvents *decoder_events;
 
@@ -153,10 +175,21 @@ struct AppLayerParserState_ {
 };
 
 enum ExceptionPolicy g_applayerparser_error_policy = EXCEPTION_POLICY_NOT_SET;
+/** use the tx ready queue for parsers that support it */
+static bool g_applayerparser_tx_ready_queue = true;
+/** number of times a tx ready queue overflowed and the engine fell back to
+ *  iterating all txs of the flow */
+SC_ATOMIC_DECLARE(uint64_t, tx_ready_queue_overflow);
 
 static void AppLayerConfig(void)
 {
     g_applayerparser_error_policy = ExceptionPolicyParse("app-layer.error-policy", true);
+
+    int tx_ready_queue = 1;
+    if (SCConfGetBool("app-layer.tx-ready-queue", &tx_ready_queue) == 1 && !tx_ready_queue) {
+        SCLogConfig("app-layer: tx ready queue disabled");
+        g_applayerparser_tx_ready_queue = false;
+    }
 }
 
 enum ExceptionPolicy AppLayerErrorGetExceptionPolicy(void)
@@ -251,6 +284,10 @@ void AppLayerParserStateFree(AppLayerParserState *pstate)
     if (pstate->decoder_events != NULL)
         SCAppLayerDecoderEventsFreeEvents(&pstate->decoder_events);
     AppLayerParserFramesFreeContainer(pstate->frames);
+    if (pstate->tx_ready != NULL) {
+        SCFree(pstate->tx_ready->ids);
+        SCFree(pstate->tx_ready);
+    }
     SCFree(pstate);
 
     SCReturn;
@@ -259,6 +296,7 @@ void AppLayerParserStateFree(AppLayerParserState *pstate)
 int AppLayerParserSetup(void)
 {
     SCEnter();
+    SC_ATOMIC_INIT(tx_ready_queue_overflow);
     // initial allocation that will later be grown using realloc,
     // when new protocols register themselves and make g_alproto_max grow
     alp_ctx.ctxs = SCCalloc(g_alproto_max, sizeof(AppLayerParserProtoCtx[FLOW_PROTO_MAX]));
@@ -921,6 +959,248 @@ extern int g_detect_disabled;
 extern bool g_file_logger_enabled;
 extern bool g_filedata_logger_enabled;
 
+/** per call constants for AppLayerParserTransactionsCleanup */
+typedef struct AppLayerTxCleanupCtx_ {
+    AppLayerParserProtoCtx *p;
+    void *alstate;
+    uint8_t ipproto;
+    AppProto alproto;
+    uint8_t pkt_dir;
+    bool has_tx_detect_flags;
+    LoggerId logger_expectation;
+    int tx_end_state_ts;
+    int tx_end_state_tc;
+    uint8_t ts_disrupt_flags;
+    uint8_t tc_disrupt_flags;
+    int pkt_dir_trunc;
+} AppLayerTxCleanupCtx;
+
+enum AppLayerTxCleanupResult {
+    /** tx was freed */
+    TX_CLEANUP_FREED = 0,
+    /** tx is not complete yet: the parser will update it again */
+    TX_CLEANUP_SKIP_PROGRESS,
+    /** tx is complete, but detection, logging or file handling is pending */
+    TX_CLEANUP_SKIP_PENDING,
+};
+
+/**
+ * \internal
+ * \brief free a single tx if it has been inspected and logged
+ */
+static enum AppLayerTxCleanupResult AppLayerParserTxCleanup(
+        const Flow *f, AppLayerTxCleanupCtx *c, void *tx, const uint64_t i)
+{
+    SCLogDebug("%p/%"PRIu64" checking", tx, i);
+    AppLayerTxData *txd = AppLayerParserGetTxData(c->ipproto, c->alproto, tx);
+    if (AppLayerParserHasFilesInDir(txd, c->pkt_dir)) {
+        if (c->pkt_dir_trunc == -1)
+            c->pkt_dir_trunc = IS_DISRUPTED((c->pkt_dir == STREAM_TOSERVER) ? c->ts_disrupt_flags
+                                                                              : c->tc_disrupt_flags);
+        AppLayerParserFileTxHousekeeping(f, tx, c->pkt_dir, (bool)c->pkt_dir_trunc);
+    }
+    // should be reset by parser next time it updates the tx
+    if (c->pkt_dir & STREAM_TOSERVER) {
+        txd->updated_ts = false;
+    } else {
+        txd->updated_tc = false;
+    }
+    const int tx_progress_tc =
+            AppLayerParserGetStateProgress(c->ipproto, c->alproto, tx, c->tc_disrupt_flags);
+    if (tx_progress_tc < c->tx_end_state_tc) {
+        SCLogDebug("%p/%"PRIu64" skipping: tc parser not done", tx, i);
+        return TX_CLEANUP_SKIP_PROGRESS;
+    }
+    const int tx_progress_ts =
+            AppLayerParserGetStateProgress(c->ipproto, c->alproto, tx, c->ts_disrupt_flags);
+    if (tx_progress_ts < c->tx_end_state_ts) {
+        SCLogDebug("%p/%"PRIu64" skipping: ts parser not done", tx, i);
+        return TX_CLEANUP_SKIP_PROGRESS;
+    }
+
+    if (c->has_tx_detect_flags) {
+        bool tx_skipped = false;
+        if (!IS_DISRUPTED(c->ts_disrupt_flags) &&
+                (f->sgh_toserver != NULL || (f->flags & FLOW_SGH_TOSERVER) == 0)) {
+            if ((txd->flags & (APP_LAYER_TX_INSPECTED_TS | APP_LAYER_TX_SKIP_INSPECT_TS)) == 0) {
+                SCLogDebug("%p/%" PRIu64 " skipping: TS inspect not done: ts:%02x", tx, i,
+                        txd->flags);
+                tx_skipped = true;
+            }
+        }
+        if (!IS_DISRUPTED(c->tc_disrupt_flags) &&
+                (f->sgh_toclient != NULL || (f->flags & FLOW_SGH_TOCLIENT) == 0)) {
+            if ((txd->flags & (APP_LAYER_TX_INSPECTED_TC | APP_LAYER_TX_SKIP_INSPECT_TC)) == 0) {
+                SCLogDebug("%p/%" PRIu64 " skipping: TC inspect not done: ts:%02x", tx, i,
+                        txd->flags);
+                tx_skipped = true;
+            }
+        }
+        if (tx_skipped) {
+            SCLogDebug("%p/%" PRIu64 " tx_skipped", tx, i);
+            return TX_CLEANUP_SKIP_PENDING;
+        }
+    }
+
+    if (c->logger_expectation != 0) {
+        LoggerId tx_logged = GetTxLogged(txd);
+        if (tx_logged != c->logger_expectation) {
+            SCLogDebug("%p/%"PRIu64" skipping: logging not done: want:%"PRIx32", have:%"PRIx32,
+                    tx, i, c->logger_expectation, tx_logged);
+            return TX_CLEANUP_SKIP_PENDING;
+        }
+    }
+
+    /* if file logging is enabled, we keep a tx active while some of the files aren't
+     * logged yet. */
+    SCLogDebug("files_opened %u files_logged %u files_stored %u", txd->files_opened,
+            txd->files_logged, txd->files_stored);
+
+    if (txd->files_opened) {
+        if (g_file_logger_enabled && txd->files_opened != txd->files_logged) {
+            return TX_CLEANUP_SKIP_PENDING;
+        }
+        if (g_filedata_logger_enabled && txd->files_opened != txd->files_stored) {
+            return TX_CLEANUP_SKIP_PENDING;
+        }
+    }
+
+    /* if we are here, the tx can be freed. */
+    c->p->StateTransactionFree(c->alstate, i);
+    SCLogDebug("%p/%"PRIu64" freed", tx, i);
+    return TX_CLEANUP_FREED;
+}
+
+static inline bool AppLayerParserTxReadyQueueEnabled(const AppLayerParserProtoCtx *p)
+{
+    return g_applayerparser_tx_ready_queue &&
+           (p->option_flags & APP_LAYER_PARSER_OPT_TX_READY_QUEUE) != 0;
+}
+
+/**
+ * \brief add a tx to the flow's tx ready queue
+ *
+ * To be called by parsers that registered APP_LAYER_PARSER_OPT_TX_READY_QUEUE
+ * each time they update a tx. Logging and cleanup will then only consider
+ * the txs in the queue. The queue grows up to APP_LAYER_TX_READY_QUEUE_MAX
+ * entries. If it can't grow further, it is marked as overflowed and the
+ * engine falls back to iterating all txs until the next cleanup run.
+ *
+ * The queue is allocated on the first call. If that fails, the engine
+ * keeps iterating all txs.
+ */
+void SCAppLayerParserTxReady(AppLayerParserState *pstate, uint64_t tx_id)
+{
+    if (pstate == NULL)
+        return;
+    AppLayerTxReadyQueue *q = pstate->tx_ready;
+    if (q == NULL) {
+        q = pstate->tx_ready = SCCalloc(1, sizeof(*q));
+        if (q == NULL)
+            return;
+    }
+    if (q->overflow)
+        return;
+    for (uint16_t i = 0; i < q->cnt; i++) {
+        if (q->ids[i] == tx_id)
+            return;
+    }
+    if (q->cnt == q->size) {
+        const uint16_t new_size = q->size ? q->size * 2 : APP_LAYER_TX_READY_QUEUE_SIZE;
+        uint64_t *ids = NULL;
+        if (new_size <= APP_LAYER_TX_READY_QUEUE_MAX)
+            ids = SCRealloc(q->ids, new_size * sizeof(uint64_t));
+        if (ids == NULL) {
+            SCLogDebug("tx ready queue overflow at tx_id %" PRIu64, tx_id);
+            q->overflow = true;
+            (void)SC_ATOMIC_ADD(tx_ready_queue_overflow, 1);
+            return;
+        }
+        q->ids = ids;
+        q->size = new_size;
+    }
+    q->ids[q->cnt++] = tx_id;
+}
+
+uint64_t AppLayerParserTxReadyOverflowCounter(void)
+{
+    return SC_ATOMIC_GET(tx_ready_queue_overflow);
+}
+
+/**
+ * \brief get the tx ready queue of a flow
+ *
+ * The queue can only be used if the parser supports it, it was allocated,
+ * it didn't overflow and the flow is not at EOF or disrupted. In the latter
+ * cases txs can progress without the parser updating them.
+ *
+ * \retval true queue is usable, \a ids and \a cnt are set
+ * \retval false caller has to iterate all txs
+ */
+bool AppLayerParserGetTxReadyQueue(const Flow *f, const uint64_t **ids, uint16_t *cnt)
+{
+    const AppLayerParserState *pstate = f->alparser;
+    if (pstate == NULL || pstate->tx_ready == NULL || pstate->tx_ready->overflow)
+        return false;
+    if (!AppLayerParserTxReadyQueueEnabled(&alp_ctx.ctxs[f->alproto][f->protomap]))
+        return false;
+    if (pstate->flags & (APP_LAYER_PARSER_EOF_TS | APP_LAYER_PARSER_EOF_TC))
+        return false;
+    if (IS_DISRUPTED(FlowGetDisruptionFlags(f, STREAM_TOSERVER)) ||
+            IS_DISRUPTED(FlowGetDisruptionFlags(f, STREAM_TOCLIENT)))
+        return false;
+
+    *ids = pstate->tx_ready->ids;
+    *cnt = pstate->tx_ready->cnt;
+    return true;
+}
+
+/**
+ * \internal
+ * \brief cleanup only the txs in the tx ready queue
+ *
+ * Txs that are complete but still pending stay in the queue, the others
+ * are removed from it.
+ */
+static void AppLayerParserTransactionsCleanupReady(
+        const Flow *f, AppLayerTxCleanupCtx *c, AppLayerParserState *alparser)
+{
+    AppLayerTxReadyQueue *q = alparser->tx_ready;
+    uint16_t keep = 0;
+    bool freed_min = false;
+
+    for (uint16_t idx = 0; idx < q->cnt; idx++) {
+        const uint64_t i = q->ids[idx];
+        void *tx = AppLayerParserGetTx(c->ipproto, c->alproto, c->alstate, i);
+        if (tx == NULL)
+            continue;
+
+        const enum AppLayerTxCleanupResult r = AppLayerParserTxCleanup(f, c, tx, i);
+        if (r == TX_CLEANUP_SKIP_PENDING) {
+            q->ids[keep++] = i;
+        } else if (r == TX_CLEANUP_FREED && i == alparser->min_id) {
+            freed_min = true;
+        }
+    }
+    q->cnt = keep;
+
+    /* the lowest tx was freed, so move the minimum up to the next tx
+     * that still exists. */
+    if (freed_min) {
+        const uint64_t total_txs = AppLayerParserGetTxCnt(f, c->alstate);
+        uint64_t new_min = alparser->min_id + 1;
+        while (new_min < total_txs &&
+                AppLayerParserGetTx(c->ipproto, c->alproto, c->alstate, new_min) == NULL) {
+            new_min++;
+        }
+        alparser->min_id = new_min;
+        alparser->inspect_id[0] = MAX(alparser->inspect_id[0], new_min);
+        alparser->inspect_id[1] = MAX(alparser->inspect_id[1], new_min);
+        alparser->log_id = MAX(alparser->log_id, new_min);
+        SCLogDebug("updated f->alparser->min_id %" PRIu64, alparser->min_id);
+    }
+}
+
 /**
  * \brief remove obsolete (inspected and logged) transactions
  */
@@ -933,7 +1213,6 @@ void AppLayerParserTransactionsCleanup(Flow *f, const uint8_t pkt_dir)
     if (unlikely(p->StateTransactionFree == NULL))
         SCReturn;
 
-    const bool has_tx_detect_flags = !g_detect_disabled;
     const uint8_t ipproto = f->proto;
     const AppProto alproto = f->alproto;
     void * const alstate = f->alstate;
@@ -942,15 +1221,41 @@ void AppLayerParserTransactionsCleanup(Flow *f, const uint8_t pkt_dir)
     if (alstate == NULL || alparser == NULL)
         SCReturn;
 
+    AppLayerTxCleanupCtx c = {
+        .p = p,
+        .alstate = alstate,
+        .ipproto = ipproto,
+        .alproto = alproto,
+        .pkt_dir = pkt_dir,
+        .has_tx_detect_flags = !g_detect_disabled,
+        .logger_expectation = AppLayerParserProtocolGetLoggerBits(ipproto, alproto),
+        .tx_end_state_ts =
+                AppLayerParserGetStateProgressCompletionStatus(alproto, STREAM_TOSERVER),
+        .tx_end_state_tc =
+                AppLayerParserGetStateProgressCompletionStatus(alproto, STREAM_TOCLIENT),
+        .ts_disrupt_flags = FlowGetDisruptionFlags(f, STREAM_TOSERVER),
+        .tc_disrupt_flags = FlowGetDisruptionFlags(f, STREAM_TOCLIENT),
+        .pkt_dir_trunc = -1,
+    };
+
+    const uint64_t *ready_ids = NULL;
+    uint16_t ready_cnt = 0;
+    if (AppLayerParserGetTxReadyQueue(f, &ready_ids, &ready_cnt)) {
+        SCLogDebug("tx ready queue: %u txs", ready_cnt);
+        AppLayerParserTransactionsCleanupReady(f, &c, alparser);
+        SCReturn;
+    }
+
+    /* iterate all txs. If the parser supports the tx ready queue, it is
+     * rebuilt from the txs that remain pending. */
+    const bool rebuild_queue = AppLayerParserTxReadyQueueEnabled(p);
+    if (rebuild_queue && alparser->tx_ready != NULL) {
+        alparser->tx_ready->cnt = 0;
+        alparser->tx_ready->overflow = false;
+    }
+
     const uint64_t min = alparser->min_id;
     const uint64_t total_txs = AppLayerParserGetTxCnt(f, alstate);
-    const LoggerId logger_expectation = AppLayerParserProtocolGetLoggerBits(ipproto, alproto);
-    const int tx_end_state_ts = AppLayerParserGetStateProgressCompletionStatus(alproto, STREAM_TOSERVER);
-    const int tx_end_state_tc = AppLayerParserGetStateProgressCompletionStatus(alproto, STREAM_TOCLIENT);
-    const uint8_t ts_disrupt_flags = FlowGetDisruptionFlags(f, STREAM_TOSERVER);
-    const uint8_t tc_disrupt_flags = FlowGetDisruptionFlags(f, STREAM_TOCLIENT);
-
-    int pkt_dir_trunc = -1;
 
     AppLayerGetTxIteratorFunc IterFunc = AppLayerGetTxIterator(ipproto, alproto);
     AppLayerGetTxIterState state;
@@ -966,96 +1271,17 @@ void AppLayerParserTransactionsCleanup(Flow *f, const uint8_t pkt_dir)
         if (ires.tx_ptr == NULL)
             break;
 
-        bool tx_skipped = false;
         void *tx = ires.tx_ptr;
         i = ires.tx_id; // actual tx id for the tx the IterFunc returned
 
-        SCLogDebug("%p/%"PRIu64" checking", tx, i);
-        AppLayerTxData *txd = AppLayerParserGetTxData(ipproto, alproto, tx);
-        if (AppLayerParserHasFilesInDir(txd, pkt_dir)) {
-            if (pkt_dir_trunc == -1)
-                pkt_dir_trunc = IS_DISRUPTED(
-                        (pkt_dir == STREAM_TOSERVER) ? ts_disrupt_flags : tc_disrupt_flags);
-            AppLayerParserFileTxHousekeeping(f, tx, pkt_dir, (bool)pkt_dir_trunc);
-        }
-        // should be reset by parser next time it updates the tx
-        if (pkt_dir & STREAM_TOSERVER) {
-            txd->updated_ts = false;
-        } else {
-            txd->updated_tc = false;
-        }
-        const int tx_progress_tc =
-                AppLayerParserGetStateProgress(ipproto, alproto, tx, tc_disrupt_flags);
-        if (tx_progress_tc < tx_end_state_tc) {
-            SCLogDebug("%p/%"PRIu64" skipping: tc parser not done", tx, i);
-            skipped = true;
-            goto next;
-        }
-        const int tx_progress_ts =
-                AppLayerParserGetStateProgress(ipproto, alproto, tx, ts_disrupt_flags);
-        if (tx_progress_ts < tx_end_state_ts) {
-            SCLogDebug("%p/%"PRIu64" skipping: ts parser not done", tx, i);
-            skipped = true;
-            goto next;
-        }
-
-        if (has_tx_detect_flags) {
-            if (!IS_DISRUPTED(ts_disrupt_flags) &&
-                    (f->sgh_toserver != NULL || (f->flags & FLOW_SGH_TOSERVER) == 0)) {
-                if ((txd->flags & (APP_LAYER_TX_INSPECTED_TS | APP_LAYER_TX_SKIP_INSPECT_TS)) ==
-                        0) {
-                    SCLogDebug("%p/%" PRIu64 " skipping: TS inspect not done: ts:%02x", tx, i,
-                            txd->flags);
-                    tx_skipped = true;
-                }
-            }
-            if (!IS_DISRUPTED(tc_disrupt_flags) &&
-                    (f->sgh_toclient != NULL || (f->flags & FLOW_SGH_TOCLIENT) == 0)) {
-                if ((txd->flags & (APP_LAYER_TX_INSPECTED_TC | APP_LAYER_TX_SKIP_INSPECT_TC)) ==
-                        0) {
-                    SCLogDebug("%p/%" PRIu64 " skipping: TC inspect not done: ts:%02x", tx, i,
-                            txd->flags);
-                    tx_skipped = true;
-                }
-            }
-        }
-
-        if (tx_skipped) {
-            SCLogDebug("%p/%" PRIu64 " tx_skipped", tx, i);
+        const enum AppLayerTxCleanupResult r = AppLayerParserTxCleanup(f, &c, tx, i);
+        if (r != TX_CLEANUP_FREED) {
             skipped = true;
+            if (rebuild_queue && r == TX_CLEANUP_SKIP_PENDING)
+                SCAppLayerParserTxReady(alparser, i);
             goto next;
         }
 
-        if (logger_expectation != 0) {
-            LoggerId tx_logged = GetTxLogged(txd);
-            if (tx_logged != logger_expectation) {
-                SCLogDebug("%p/%"PRIu64" skipping: logging not done: want:%"PRIx32", have:%"PRIx32,
-                        tx, i, logger_expectation, tx_logged);
-                skipped = true;
-                goto next;
-            }
-        }
-
-        /* if file logging is enabled, we keep a tx active while some of the files aren't
-         * logged yet. */
-        SCLogDebug("files_opened %u files_logged %u files_stored %u", txd->files_opened,
-                txd->files_logged, txd->files_stored);
-
-        if (txd->files_opened) {
-            if (g_file_logger_enabled && txd->files_opened != txd->files_logged) {
-                skipped = true;
-                goto next;
-            }
-            if (g_filedata_logger_enabled && txd->files_opened != txd->files_stored) {
-                skipped = true;
-                goto next;
-            }
-        }
-
-        /* if we are here, the tx can be freed. */
-        p->StateTransactionFree(alstate, i);
-        SCLogDebug("%p/%"PRIu64" freed", tx, i);
-
         /* if we didn't skip any tx so far, up the minimum */
         SCLogDebug("skipped? %s i %"PRIu64", new_min %"PRIu64, skipped ? "true" : "false", i, new_min);
         if (!skipped)
@@ -1879,6 +2105,7 @@ uint16_t SCAppLayerParserStateIssetFlag(AppLayerParserState *pstate, uint16_t fl
 /***** Unittests *****/
 
 #ifdef UNITTESTS
+#include "util-unittest.h"
 #include "util-unittest-helper.h"
 
 void AppLayerParserRegisterProtocolUnittests(uint8_t ipproto, AppProto alproto,
@@ -1889,6 +2116,222 @@ void AppLayerParserRegisterProtocolUnittests(uint8_t ipproto, AppProto alproto,
     SCReturn;
 }
 
+/* mock protocol for the tx ready queue tests, with a fixed set of txs */
+#define TEST_TX_READY_TXS 4
+
+typedef struct TestTxReadyTx_ {
+    AppLayerTxData txd;
+    int progress;
+    bool freed;
+} TestTxReadyTx;
+
+typedef struct TestTxReadyState_ {
+    TestTxReadyTx txs[TEST_TX_READY_TXS];
+} TestTxReadyState;
+
+typedef struct TestTxReadyCtx_ {
+    AppLayerParserProtoCtx saved;
+    int saved_complete_ts;
+    int saved_complete_tc;
+    bool saved_enabled;
+    TestTxReadyState state;
+    Flow f;
+} TestTxReadyCtx;
+
+static void TestTxReadyTxFree(void *state, uint64_t tx_id)
+{
+    TestTxReadyState *s = state;
+    s->txs[tx_id].freed = true;
+}
+
+static uint64_t TestTxReadyGetTxCnt(void *state)
+{
+    return TEST_TX_READY_TXS;
+}
+
+static void *TestTxReadyGetTx(void *state, uint64_t tx_id)
+{
+    TestTxReadyState *s = state;
+    if (tx_id >= TEST_TX_READY_TXS || s->txs[tx_id].freed)
+        return NULL;
+    return &s->txs[tx_id];
+}
+
+static int TestTxReadyGetProgress(void *tx, uint8_t direction)
+{
+    return ((TestTxReadyTx *)tx)->progress;
+}
+
+static AppLayerTxData *TestTxReadyGetTxData(void *tx)
+{
+    return &((TestTxReadyTx *)tx)->txd;
+}
+
+/** \internal
+ *  \brief take over the udp/http2 parser slot for the mock protocol
+ *
+ *  All txs start complete and inspected. */
+static void TestTxReadySetup(TestTxReadyCtx *t, const LoggerId logger_bits)
+{
+    memset(t, 0, sizeof(*t));
+    const uint8_t map = FlowGetProtoMapping(IPPROTO_UDP);
+    AppLayerParserProtoCtx *ctx = &alp_ctx.ctxs[ALPROTO_HTTP2][map];
+    AppLayerParserProtoCtx *dctx = &alp_ctx.ctxs[ALPROTO_HTTP2][FLOW_PROTO_DEFAULT];
+    t->saved = *ctx;
+    t->saved_complete_ts = dctx->complete_ts;
+    t->saved_complete_tc = dctx->complete_tc;
+    t->saved_enabled = g_applayerparser_tx_ready_queue;
+    g_applayerparser_tx_ready_queue = true;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->StateTransactionFree = TestTxReadyTxFree;
+    ctx->StateGetTxCnt = TestTxReadyGetTxCnt;
+    ctx->StateGetTx = TestTxReadyGetTx;
+    ctx->StateGetProgress = TestTxReadyGetProgress;
+    ctx->GetTxData = TestTxReadyGetTxData;
+    ctx->option_flags = APP_LAYER_PARSER_OPT_TX_READY_QUEUE;
+    ctx->logger_bits = logger_bits;
+    dctx->complete_ts = 1;
+    dctx->complete_tc = 1;
+
+    for (int i = 0; i < TEST_TX_READY_TXS; i++) {
+        t->state.txs[i].progress = 1;
+        t->state.txs[i].txd.flags = APP_LAYER_TX_INSPECTED_TS | APP_LAYER_TX_INSPECTED_TC;
+    }
+
+    FLOWLOCK_INIT(&t->f);
+    FLOWLOCK_WRLOCK(&t->f);
+    t->f.proto = IPPROTO_UDP;
+    t->f.protomap = map;
+    t->f.alproto = ALPROTO_HTTP2;
+    t->f.alstate = &t->state;
+    t->f.alparser = AppLayerParserStateAlloc();
+}
+
+static void TestTxReadyTeardown(TestTxReadyCtx *t)
+{
+    const uint8_t map = FlowGetProtoMapping(IPPROTO_UDP);
+    alp_ctx.ctxs[ALPROTO_HTTP2][map] = t->saved;
+    alp_ctx.ctxs[ALPROTO_HTTP2][FLOW_PROTO_DEFAULT].complete_ts = t->saved_complete_ts;
+    alp_ctx.ctxs[ALPROTO_HTTP2][FLOW_PROTO_DEFAULT].complete_tc = t->saved_complete_tc;
+    g_applayerparser_tx_ready_queue = t->saved_enabled;
+
+    AppLayerParserStateFree(t->f.alparser);
+    FLOWLOCK_UNLOCK(&t->f);
+    FLOWLOCK_DESTROY(&t->f);
+}
+
+/** \test queue keeps insertion order, deduplicates, grows and falls back
+ *        to iteration on overflow */
+static int AppLayerParserTxReadyTest01(void)
+{
+    TestTxReadyCtx t;
+    TestTxReadySetup(&t, 0);
+    const uint64_t *ids = NULL;
+    uint16_t cnt = 0;
+
+    /* not allocated until the parser uses it */
+    FAIL_IF(AppLayerParserGetTxReadyQueue(&t.f, &ids, &cnt));
+    FAIL_IF_NOT_NULL(t.f.alparser->tx_ready);
+
+    SCAppLayerParserTxReady(t.f.alparser, 2);
+    SCAppLayerParserTxReady(t.f.alparser, 0);
+    SCAppLayerParserTxReady(t.f.alparser, 2);
+    FAIL_IF_NOT(AppLayerParserGetTxReadyQueue(&t.f, &ids, &cnt));
+    FAIL_IF_NOT(cnt == 2);
+    FAIL_IF_NOT(ids[0] == 2);
+    FAIL_IF_NOT(ids[1] == 0);
+
+    /* grows past the initial size */
+    for (uint64_t i = 10; i < 10 + APP_LAYER_TX_READY_QUEUE_SIZE; i++) {
+        SCAppLayerParserTxReady(t.f.alparser, i);
+    }
+    FAIL_IF_NOT(AppLayerParserGetTxReadyQueue(&t.f, &ids, &cnt));
+    FAIL_IF_NOT(cnt == 2 + APP_LAYER_TX_READY_QUEUE_SIZE);
+    FAIL_IF_NOT(ids[0] == 2);
+    FAIL_IF_NOT(ids[cnt - 1] == 10 + APP_LAYER_TX_READY_QUEUE_SIZE - 1);
+
+    /* overflows at the max size */
+    const uint64_t overflows = AppLayerParserTxReadyOverflowCounter();
+    for (uint64_t i = 100; i < 100 + APP_LAYER_TX_READY_QUEUE_MAX; i++) {
+        SCAppLayerParserTxReady(t.f.alparser, i);
+    }
+    FAIL_IF(AppLayerParserGetTxReadyQueue(&t.f, &ids, &cnt));
+    FAIL_IF_NOT(t.f.alparser->tx_ready->cnt == APP_LAYER_TX_READY_QUEUE_MAX);
+    FAIL_IF_NOT(AppLayerParserTxReadyOverflowCounter() == overflows + 1);
+
+    /* a full cleanup run rebuilds the queue: all txs were freed */
+    AppLayerParserTransactionsCleanup(&t.f, STREAM_TOSERVER);
+    FAIL_IF_NOT(AppLayerParserGetTxReadyQueue(&t.f, &ids, &cnt));
+    FAIL_IF_NOT(cnt == 0);
+    FAIL_IF_NOT(t.f.alparser->min_id == TEST_TX_READY_TXS);
+
+    TestTxReadyTeardown(&t);
+    PASS;
+}
+
+/** \test txs completing out of order */
+static int AppLayerParserTxReadyTest02(void)
+{
+    TestTxReadyCtx t;
+    TestTxReadySetup(&t, 0);
+    const uint64_t *ids = NULL;
+    uint16_t cnt = 0;
+
+    /* tx 0 is still in progress, tx 1 completes first */
+    t.state.txs[0].progress = 0;
+    SCAppLayerParserTxReady(t.f.alparser, 0);
+    SCAppLayerParserTxReady(t.f.alparser, 1);
+    AppLayerParserTransactionsCleanup(&t.f, STREAM_TOSERVER);
+    FAIL_IF_NOT(t.state.txs[1].freed);
+    FAIL_IF(t.state.txs[0].freed);
+    /* in progress txs are re-added by the parser on their next update */
+    FAIL_IF_NOT(AppLayerParserGetTxReadyQueue(&t.f, &ids, &cnt));
+    FAIL_IF_NOT(cnt == 0);
+    FAIL_IF_NOT(t.f.alparser->min_id == 0);
+
+    /* tx 0 completes: min moves past the freed tx 1 */
+    t.state.txs[0].progress = 1;
+    SCAppLayerParserTxReady(t.f.alparser, 0);
+    AppLayerParserTransactionsCleanup(&t.f, STREAM_TOSERVER);
+    FAIL_IF_NOT(t.state.txs[0].freed);
+    FAIL_IF_NOT(t.f.alparser->min_id == 2);
+    FAIL_IF_NOT(t.f.alparser->log_id == 2);
+
+    TestTxReadyTeardown(&t);
+    PASS;
+}
+
+/** \test txs waiting for logging stay queued, txs freed before they were
+ *        logged are dropped from the queue */
+static int AppLayerParserTxReadyTest03(void)
+{
+    TestTxReadyCtx t;
+    TestTxReadySetup(&t, BIT_U32(LOGGER_JSON_TX));
+    const uint64_t *ids = NULL;
+    uint16_t cnt = 0;
+
+    SCAppLayerParserTxReady(t.f.alparser, 0);
+    SCAppLayerParserTxReady(t.f.alparser, 1);
+    AppLayerParserTransactionsCleanup(&t.f, STREAM_TOSERVER);
+    FAIL_IF(t.state.txs[0].freed);
+    FAIL_IF(t.state.txs[1].freed);
+    FAIL_IF_NOT(AppLayerParserGetTxReadyQueue(&t.f, &ids, &cnt));
+    FAIL_IF_NOT(cnt == 2);
+
+    /* the parser frees tx 1 before it was logged, tx 0 gets logged */
+    t.state.txs[1].freed = true;
+    t.state.txs[0].txd.logged = BIT_U32(LOGGER_JSON_TX);
+    AppLayerParserTransactionsCleanup(&t.f, STREAM_TOSERVER);
+    FAIL_IF_NOT(t.state.txs[0].freed);
+    FAIL_IF_NOT(AppLayerParserGetTxReadyQueue(&t.f, &ids, &cnt));
+    FAIL_IF_NOT(cnt == 0);
+    FAIL_IF_NOT(t.f.alparser->min_id == 2);
+
+    TestTxReadyTeardown(&t);
+    PASS;
+}
+
 void AppLayerParserRegisterUnittests(void)
 {
     SCEnter();
@@ -1906,6 +2349,10 @@ void AppLayerParserRegisterUnittests(void)
         }
     }
 
+    UtRegisterTest("AppLayerParserTxReadyTest01", AppLayerParserTxReadyTest01);
+    UtRegisterTest("AppLayerParserTxReadyTest02", AppLayerParserTxReadyTest02);
+    UtRegisterTest("AppLayerParserTxReadyTest03", AppLayerParserTxReadyTest03);
+
     SCReturn;
 }
 
@@ -345,6 +345,9 @@ bool AppLayerParserHasDecoderEvents(AppLayerParserState *pstate);
 int AppLayerParserProtocolHasLogger(uint8_t ipproto, AppProto alproto);
 LoggerId AppLayerParserProtocolGetLoggerBits(uint8_t ipproto, AppProto alproto);
 void SCAppLayerParserTriggerRawStreamInspection(Flow *f, int direction);
+void SCAppLayerParserTxReady(AppLayerParserState *pstate, uint64_t tx_id);
+bool AppLayerParserGetTxReadyQueue(const Flow *f, const uint64_t **ids, uint16_t *cnt);
+uint64_t AppLayerParserTxReadyOverflowCounter(void);
 void SCAppLayerParserSetStreamDepth(uint8_t ipproto, AppProto alproto, uint32_t stream_depth);
 uint32_t AppLayerParserGetStreamDepth(const Flow *f);
 void AppLayerParserSetStreamDepthFlag(uint8_t ipproto, AppProto alproto, void *state, uint64_t tx_id, uint8_t flags);
@@ -205,6 +205,8 @@ typedef struct SslConfig_ {
     bool disable_ja3; /**< ja3 explicitly disabled. Don't enable on demand. */
     SC_ATOMIC_DECLARE(int, enable_ja4);
     bool disable_ja4; /**< ja4 explicitly disabled. Don't enable on demand. */
+    /** decode the first certificate only when a rule or logger needs it */
+    bool lazy_cert_decoding;
 } SslConfig;
 
 SslConfig ssl_config;
@@ -464,12 +466,75 @@ static inline int TlsDecodeHSCertificateAddCertToChain(
     return 0;
 }
 
+/** \internal
+ * \brief extract subject, issuer, SANs, serial and validity of a decoded
+ *        certificate
+ *
+ * \retval 0 ok
+ * \retval -1 error, err_code is set if a field could not be extracted
+ */
+static int TlsCertificateExtractFields(SSLStateConnp *connp, const X509 *x509, uint32_t *err_code)
+{
+    SCX509GetSubject(x509, &connp->cert0_subject, &connp->cert0_subject_len);
+    if (connp->cert0_subject == NULL) {
+        *err_code = ERR_EXTRACT_SUBJECT;
+        return -1;
+    }
+
+    SCX509GetIssuer(x509, &connp->cert0_issuerdn, &connp->cert0_issuerdn_len);
+    if (connp->cert0_issuerdn == NULL) {
+        *err_code = ERR_EXTRACT_ISSUER;
+        return -1;
+    }
+
+    connp->cert0_sans_num = SCX509GetSubjectAltNameLen(x509);
+    connp->cert0_sans = SCCalloc(connp->cert0_sans_num, sizeof(SSLSubjectAltName));
+    if (connp->cert0_sans == NULL) {
+        return -1;
+    }
+    for (uint16_t i = 0; i < connp->cert0_sans_num; i++) {
+        SCX509GetSubjectAltNameAt(
+                x509, i, &connp->cert0_sans[i].san, &connp->cert0_sans[i].san_len);
+    }
+
+    SCX509GetSerial(x509, &connp->cert0_serial, &connp->cert0_serial_len);
+    if (connp->cert0_serial == NULL) {
+        *err_code = ERR_INVALID_SERIAL;
+        return -1;
+    }
+
+    if (SCX509GetValidity(x509, &connp->cert0_not_before, &connp->cert0_not_after) != 0) {
+        *err_code = ERR_EXTRACT_VALIDITY;
+        return -1;
+    }
+    return 0;
+}
+
+/** \internal
+ * \brief decode subject, issuer, SANs, serial and validity of a certificate
+ *
+ * \retval 0 ok
+ * \retval 1 certificate could not be decoded, err_code is set
+ * \retval -1 error, err_code is set if a field could not be extracted
+ */
+static int TlsDecodeHSCertificateFields(
+        SSLStateConnp *connp, const uint8_t *input, uint32_t cert_len, uint32_t *err_code)
+{
+    X509 *x509 = SCX509Decode(input, cert_len, err_code);
+    if (x509 == NULL) {
+        return 1;
+    }
+
+    int r = TlsCertificateExtractFields(connp, x509, err_code);
+    SCX509Free(x509);
+    return r;
+}
+
 static int TlsDecodeHSCertificate(SSLState *ssl_state, SSLStateConnp *connp,
         const uint8_t *const initial_input, const uint32_t input_len, const int certn)
 {
     const uint8_t *input = (uint8_t *)initial_input;
     uint32_t err_code = 0;
-    X509 *x509 = NULL;
     int rc = 0;
 
     if (!(HAS_SPACE(3)))
@@ -481,52 +546,31 @@ static int TlsDecodeHSCertificate(SSLState *ssl_state, SSLStateConnp *connp,
     if (!(HAS_SPACE(cert_len)))
         goto invalid_cert;
 
-    /* only store fields from the first certificate in the chain */
-    if (certn == 0 && connp->cert0_subject == NULL && connp->cert0_issuerdn == NULL &&
-            connp->cert0_serial == NULL) {
-        x509 = SCX509Decode(input, cert_len, &err_code);
-        if (x509 == NULL) {
+    /* in lazy mode, only check that the first certificate decodes, so that
+     * invalid certificates are flagged while parsing. Its fields are
+     * extracted by SSLStateCertDecodeLazy when they are needed. */
+    if (certn == 0 && ssl_config.lazy_cert_decoding && connp->cert0_flags == 0 &&
+            connp->cert0_x509 == NULL) {
+        connp->cert0_x509 = SCX509Decode(input, cert_len, &err_code);
+        if (connp->cert0_x509 == NULL) {
+            connp->cert0_flags = SSL_CERT0_ALL;
             TlsDecodeHSCertificateErrSetEvent(ssl_state, err_code);
             goto next;
         }
+    }
 
-        SCX509GetSubject(x509, &connp->cert0_subject, &connp->cert0_subject_len);
-        if (connp->cert0_subject == NULL) {
-            err_code = ERR_EXTRACT_SUBJECT;
-            goto error;
-        }
-
-        SCX509GetIssuer(x509, &connp->cert0_issuerdn, &connp->cert0_issuerdn_len);
-        if (connp->cert0_issuerdn == NULL) {
-            err_code = ERR_EXTRACT_ISSUER;
-            goto error;
-        }
-
-        connp->cert0_sans_num = SCX509GetSubjectAltNameLen(x509);
-        connp->cert0_sans = SCCalloc(connp->cert0_sans_num, sizeof(SSLSubjectAltName));
-        if (connp->cert0_sans == NULL) {
-            goto error;
-        }
-        for (uint16_t i = 0; i < connp->cert0_sans_num; i++) {
-            SCX509GetSubjectAltNameAt(
-                    x509, i, &connp->cert0_sans[i].san, &connp->cert0_sans[i].san_len);
-        }
-
-        SCX509GetSerial(x509, &connp->cert0_serial, &connp->cert0_serial_len);
-        if (connp->cert0_serial == NULL) {
-            err_code = ERR_INVALID_SERIAL;
-            goto error;
-        }
+    /* only store fields from the first certificate in the chain */
+    if (certn == 0 && !ssl_config.lazy_cert_decoding && connp->cert0_flags == 0) {
+        connp->cert0_flags = SSL_CERT0_ALL;
 
-        rc = SCX509GetValidity(x509, &connp->cert0_not_before, &connp->cert0_not_after);
-        if (rc != 0) {
-            err_code = ERR_EXTRACT_VALIDITY;
+        rc = TlsDecodeHSCertificateFields(connp, input, cert_len, &err_code);
+        if (rc == 1) {
+            TlsDecodeHSCertificateErrSetEvent(ssl_state, err_code);
+            goto next;
+        } else if (rc != 0) {
             goto error;
         }
 
-        SCX509Free(x509);
-        x509 = NULL;
-
         rc = TlsDecodeHSCertificateFingerprint(connp, input, cert_len);
         if (rc != 0) {
             SCLogDebug("TlsDecodeHSCertificateFingerprint failed with %d", rc);
@@ -547,8 +591,6 @@ next:
 error:
     if (err_code != 0)
         TlsDecodeHSCertificateErrSetEvent(ssl_state, err_code);
-    if (x509 != NULL)
-        SCX509Free(x509);
 
     return -1;
 
@@ -558,6 +600,36 @@ invalid_cert:
     return -1;
 }
 
+/**
+ * \brief extract fields of the first certificate of the chain on demand
+ *
+ * The parser decoded the certificate and set the events if it is invalid,
+ * so this only formats the fields that are asked for. Each group of fields
+ * is extracted at most once per direction. The extracted fields are a cache
+ * of the certificate in the connp, filled under the flow lock.
+ *
+ * \param fields SSL_CERT0_* flags
+ */
+void SSLStateCertDecodeLazy(const SSLStateConnp *const_connp, uint8_t fields)
+{
+    SSLStateConnp *connp = (SSLStateConnp *)const_connp;
+
+    const SSLCertsChain *cert = TAILQ_FIRST(&connp->certs);
+    if (cert == NULL || connp->cert0_x509 == NULL)
+        return;
+
+    fields &= ~connp->cert0_flags;
+    connp->cert0_flags |= fields;
+
+    if (fields & SSL_CERT0_FIELDS) {
+        uint32_t err_code = 0;
+        (void)TlsCertificateExtractFields(connp, connp->cert0_x509, &err_code);
+    }
+    if (fields & SSL_CERT0_FINGERPRINT) {
+        (void)TlsDecodeHSCertificateFingerprint(connp, cert->cert_data, cert->cert_len);
+    }
+}
+
 /** \internal
  * \brief parse cert data in a certificate handshake message
  *        will be called with all data.
@@ -2637,6 +2709,13 @@ static struct SSLDecoderResult SSLv3Decode(uint8_t direction, SSLState *ssl_stat
     }
 }
 
+static inline bool SSLStateHasCert0(const SSLStateConnp *connp)
+{
+    if (ssl_config.lazy_cert_decoding)
+        return connp->cert0_x509 != NULL;
+    return connp->cert0_subject != NULL && connp->cert0_issuerdn != NULL;
+}
+
 /**
  * \internal
  * \brief SSLv2, SSLv23, SSLv3, TLSv1.1, TLSv1.2, TLSv1.3 parser.
@@ -2780,14 +2859,15 @@ static AppLayerResult SSLDecode(Flow *f, uint8_t direction, void *alstate,
         counter++;
     } /* while (input_len) */
 
-    /* mark handshake as done if we have subject and issuer */
+    /* mark handshake as done if we have subject and issuer, or in lazy
+     * mode, the certificate to get them from */
     if ((ssl_state->flags & SSL_AL_FLAG_NEED_CLIENT_CERT) &&
-            ssl_state->client_connp.cert0_subject && ssl_state->client_connp.cert0_issuerdn) {
+            SSLStateHasCert0(&ssl_state->client_connp)) {
         /* update both sides to keep existing behavior */
         UpdateClientState(ssl_state, TLS_STATE_CLIENT_HANDSHAKE_DONE);
         UpdateServerState(ssl_state, TLS_STATE_SERVER_HANDSHAKE_DONE);
     } else if ((ssl_state->flags & SSL_AL_FLAG_NEED_CLIENT_CERT) == 0 &&
-               ssl_state->server_connp.cert0_subject && ssl_state->server_connp.cert0_issuerdn) {
+               SSLStateHasCert0(&ssl_state->server_connp)) {
         /* update both sides to keep existing behavior */
         UpdateClientState(ssl_state, TLS_STATE_CLIENT_HANDSHAKE_DONE);
         UpdateServerState(ssl_state, TLS_STATE_SERVER_HANDSHAKE_DONE);
@@ -2861,6 +2941,8 @@ static void SSLStateFree(void *p)
                 ssl_state->client_connp.cert0_serial, ssl_state->client_connp.cert0_serial_len);
     if (ssl_state->client_connp.cert0_fingerprint)
         SCFree(ssl_state->client_connp.cert0_fingerprint);
+    if (ssl_state->client_connp.cert0_x509)
+        SCX509Free(ssl_state->client_connp.cert0_x509);
     if (ssl_state->client_connp.sni)
         SCFree(ssl_state->client_connp.sni);
     if (ssl_state->client_connp.session_id)
@@ -2879,6 +2961,8 @@ static void SSLStateFree(void *p)
                 ssl_state->server_connp.cert0_serial, ssl_state->server_connp.cert0_serial_len);
     if (ssl_state->server_connp.cert0_fingerprint)
         SCFree(ssl_state->server_connp.cert0_fingerprint);
+    if (ssl_state->server_connp.cert0_x509)
+        SCX509Free(ssl_state->server_connp.cert0_x509);
     if (ssl_state->server_connp.sni)
         SCFree(ssl_state->server_connp.sni);
     if (ssl_state->server_connp.session_id)
@@ -3278,6 +3362,34 @@ void RegisterSSLParsers(void)
         }
         SCLogDebug("ssl_config.encrypt_mode %u", ssl_config.encrypt_mode);
 
+        int lazy = 0;
+        if (SCConfGetBool("app-layer.protocols.tls.lazy-certificate-decoding", &lazy) == 1 &&
+                lazy == 1) {
+            ssl_config.lazy_cert_decoding = true;
+            SCLogConfig("tls: decoding certificates only when needed");
+        }
+
+        intmax_t cache_size = 0;
+        if (SCConfGetInt("app-layer.protocols.tls.certificate-cache-size", &cache_size) == 1) {
+            if (cache_size < 0 || cache_size > UINT16_MAX) {
+                FatalError("invalid value for app-layer.protocols.tls.certificate-cache-size: "
+                           "%" PRIdMAX,
+                        cache_size);
+            }
+            SCX509SetCacheSize((uint32_t)cache_size);
+        }
+
+        cache_size = 0;
+        if (SCConfGetInt("app-layer.protocols.tls.fingerprint-cache-size", &cache_size) == 1) {
+            if (cache_size < 0 || cache_size > UINT16_MAX) {
+                FatalError("invalid value for app-layer.protocols.tls.fingerprint-cache-size: "
+                           "%" PRIdMAX,
+                        cache_size);
+            }
+            SCJA3SetCacheSize((uint32_t)cache_size);
+            SCJA4SetCacheSize((uint32_t)cache_size);
+        }
+
 #ifdef HAVE_JA3
         CheckJA3Enabled();
 #endif /* HAVE_JA3 */
@@ -3369,3 +3481,17 @@ bool SSLJA4IsEnabled(void)
 {
     return SC_ATOMIC_GET(ssl_config.enable_ja4);
 }
+
+#ifdef UNITTESTS
+/**
+ * \brief set lazy certificate decoding mode, for unittests
+ *
+ * \retval old setting
+ */
+bool SSLConfigSetLazyCertDecoding(bool lazy)
+{
+    bool old = ssl_config.lazy_cert_decoding;
+    ssl_config.lazy_cert_decoding = lazy;
+    return old;
+}
+#endif
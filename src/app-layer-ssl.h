@@ -143,6 +143,11 @@ enum TlsStateServer {
 /* config flags */
 #define SSL_TLS_LOG_PEM                         (1 << 0)
 
+/* first certificate of the chain: fields that have been decoded */
+#define SSL_CERT0_FIELDS      BIT_U8(0) /**< subject, issuer, SANs, serial, validity */
+#define SSL_CERT0_FINGERPRINT BIT_U8(1)
+#define SSL_CERT0_ALL         (SSL_CERT0_FIELDS | SSL_CERT0_FINGERPRINT)
+
 /* extensions */
 #define SSL_EXTENSION_SNI                       0x0000
 #define SSL_EXTENSION_ELLIPTIC_CURVES           0x000a
@@ -202,6 +207,11 @@ typedef struct SSLStateConnp_ {
 
     SSLSubjectAltName *cert0_sans;
     uint16_t cert0_sans_num;
+    /* SSL_CERT0_* fields that have been decoded, or failed to */
+    uint8_t cert0_flags;
+    /* lazy mode: first certificate, decoded by the parser. Its fields are
+     * extracted on demand. */
+    X509 *cert0_x509;
     /* ssl server name indication extension */
     uint8_t *sni;
     uint16_t sni_len;
@@ -260,9 +270,30 @@ typedef struct SSLState_ {
 } SSLState;
 
 void RegisterSSLParsers(void);
+void SSLStateCertDecodeLazy(const SSLStateConnp *connp, uint8_t fields);
+
+/**
+ * \brief Make sure the requested fields of the first certificate of the
+ *        chain are available.
+ *
+ * In lazy certificate decoding mode the parser only decodes the certificate,
+ * and its fields are formatted when a rule or logger asks for them. In the
+ * default mode this is a no-op, as the fields are extracted by the parser.
+ *
+ * \param fields SSL_CERT0_* flags
+ */
+static inline void SSLStateCertDecode(const SSLStateConnp *connp, const uint8_t fields)
+{
+    if ((connp->cert0_flags & fields) != fields)
+        SSLStateCertDecodeLazy(connp, fields);
+}
+
 void SSLEnableJA3(void);
 bool SSLJA3IsEnabled(void);
 void SSLEnableJA4(void);
 bool SSLJA4IsEnabled(void);
+#ifdef UNITTESTS
+bool SSLConfigSetLazyCertDecoding(bool lazy);
+#endif
 
 #endif /* SURICATA_APP_LAYER_SSL_H */
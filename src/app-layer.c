@@ -1169,12 +1169,22 @@ void AppLayerRegisterGlobalCounters(void)
     StatsRegisterGlobalCounter("ftp.memuse", FTPMemuseGlobalCounter);
     StatsRegisterGlobalCounter("ftp.memcap", FTPMemcapGlobalCounter);
     StatsRegisterGlobalCounter("app_layer.expectations", ExpectationGetCounter);
+    StatsRegisterGlobalCounter(
+            "app_layer.tx_ready_queue_overflow", AppLayerParserTxReadyOverflowCounter);
     StatsRegisterGlobalCounter("http.byterange.memuse", HTPByteRangeMemuseGlobalCounter);
     StatsRegisterGlobalCounter("http.byterange.memcap", HTPByteRangeMemcapGlobalCounter);
     StatsRegisterGlobalCounter("ippair.memuse", IPPairGetMemuse);
     StatsRegisterGlobalCounter("ippair.memcap", IPPairGetMemcap);
     StatsRegisterGlobalCounter("host.memuse", HostGetMemuse);
     StatsRegisterGlobalCounter("host.memcap", HostGetMemcap);
+    StatsRegisterGlobalCounter("tls.ja3_cache_hits", SCJA3CacheHits);
+    StatsRegisterGlobalCounter("tls.ja3_cache_misses", SCJA3CacheMisses);
+    StatsRegisterGlobalCounter("tls.ja4_cache_hits", SCJA4CacheHits);
+    StatsRegisterGlobalCounter("tls.ja4_cache_misses", SCJA4CacheMisses);
+    StatsRegisterGlobalCounter("smb.file_chunks.memuse", SCSmbFileChunksMemuse);
+    StatsRegisterGlobalCounter("smb.file_chunks.memcap", SCSmbFileChunksMemcap);
+    StatsRegisterGlobalCounter("nfs.file_chunks.memuse", SCNfsFileChunksMemuse);
+    StatsRegisterGlobalCounter("nfs.file_chunks.memcap", SCNfsFileChunksMemcap);
 }
 
 static bool IsAppLayerErrorExceptionPolicyStatsValid(enum ExceptionPolicy policy)
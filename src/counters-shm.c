@@ -0,0 +1,124 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Shared memory stats segment. See counters-shm.h for the layout.
+ */
+
+#include "suricata-common.h"
+#include "counters.h"
+#include "counters-shm.h"
+
+static void *stats_shm_map = NULL;
+static uint64_t stats_shm_size = 0;
+static char *stats_shm_filename = NULL;
+
+/**
+ * \brief create and map the stats segment
+ *
+ * \param filename file to create, replacing an existing file
+ * \param size size of the segment
+ * \param header set to the start of the zeroed segment
+ *
+ * \retval 0 on success, -1 on error
+ */
+int StatsShmCreate(const char *filename, uint64_t size, StatsShmHeader **header)
+{
+#if HAVE_SYS_MMAN_H
+    BUG_ON(stats_shm_map != NULL);
+
+    /* don't let readers map a stale, partially written segment */
+    (void)unlink(filename);
+    int fd = open(filename, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        SCLogError("stats shm: failed to create %s: %s", filename, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        SCLogError("stats shm: failed to size %s: %s", filename, strerror(errno));
+        goto error;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        SCLogError("stats shm: failed to map %s: %s", filename, strerror(errno));
+        goto error;
+    }
+    close(fd);
+
+    stats_shm_filename = SCStrdup(filename);
+    if (stats_shm_filename == NULL) {
+        munmap(map, size);
+        (void)unlink(filename);
+        return -1;
+    }
+    stats_shm_map = map;
+    stats_shm_size = size;
+    *header = map;
+    SCLogConfig("stats shm: %s (%" PRIu64 " bytes)", filename, size);
+    return 0;
+
+error:
+    close(fd);
+    (void)unlink(filename);
+    return -1;
+#else
+    SCLogError("stats shm: not supported on this platform");
+    return -1;
+#endif
+}
+
+/**
+ * \brief publish a thread's counter values to the segment
+ *
+ * Called by the thread owning `t` only.
+ */
+void StatsShmThreadPublish(StatsShmThread *t, const StatsLocalCounter *values, uint32_t nvalues)
+{
+    int64_t *dst = (int64_t *)((uint8_t *)stats_shm_map + t->values_offset);
+    const uint32_t n = MIN(nvalues, t->nvalues);
+
+    const uint32_t seq = t->seq;
+    __atomic_store_n(&t->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (uint32_t i = 0; i < n; i++) {
+        __atomic_store_n(&dst[i], values[i].v, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&t->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief unmap and remove the segment
+ *
+ * Must only be called after the threads stopped publishing.
+ */
+void StatsShmDestroy(void)
+{
+#if HAVE_SYS_MMAN_H
+    if (stats_shm_map != NULL) {
+        munmap(stats_shm_map, stats_shm_size);
+        stats_shm_map = NULL;
+        stats_shm_size = 0;
+    }
+#endif
+    if (stats_shm_filename != NULL) {
+        (void)unlink(stats_shm_filename);
+        SCFree(stats_shm_filename);
+        stats_shm_filename = NULL;
+    }
+}
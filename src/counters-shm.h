@@ -0,0 +1,96 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Layout of the shared memory stats segment.
+ *
+ * The segment is a file that is mmap'ed by Suricata and can be mapped or
+ * read by other processes. All integers are in host byte order and all
+ * offsets are from the start of the segment.
+ *
+ *   StatsShmHeader
+ *   StatsShmCounter[ncounters]      names, indexed by the counter id
+ *   StatsShmThread[nthreads]
+ *   per thread: uint32_t ids[nvalues], int64_t values[nvalues]
+ *
+ * The header is written last: a reader should only use the segment once
+ * `magic` is set. The threads publish their values with a seqlock: `seq`
+ * is odd while the values are being updated. A reader copies the values
+ * and retries if `seq` was odd or changed during the copy.
+ *
+ * `ids` maps the values of a thread to counters. Counters of type
+ * AVERAGE use 2 values: the sum and the number of updates. HISTOGRAM
+ * counters use the max value followed by the buckets. Values that are
+ * not the first value of a counter have the id STATS_SHM_NO_ID.
+ */
+
+#ifndef SURICATA_COUNTERS_SHM_H
+#define SURICATA_COUNTERS_SHM_H
+
+#define STATS_SHM_MAGIC   0x54534353 /* "SCST" */
+#define STATS_SHM_VERSION 1
+
+#define STATS_SHM_NAME_LEN        128
+#define STATS_SHM_THREAD_NAME_LEN 64
+#define STATS_SHM_NO_ID           UINT32_MAX
+
+/** the ids and values arrays start on 8 byte boundaries */
+#define STATS_SHM_ALIGN(x) (((x) + 7) & ~(uint64_t)7)
+
+/* counter types, same values as enum StatsType */
+#define STATS_SHM_TYPE_NORMAL    1
+#define STATS_SHM_TYPE_AVERAGE   2
+#define STATS_SHM_TYPE_MAXIMUM   3
+#define STATS_SHM_TYPE_HISTOGRAM 6
+
+typedef struct StatsShmHeader_ {
+    uint32_t magic;
+    uint32_t version;
+    /** size of the segment in bytes */
+    uint64_t size;
+    /** engine start time, seconds since the epoch */
+    int64_t start_time;
+    uint32_t ncounters;
+    uint32_t nthreads;
+    uint64_t counters_offset;
+    uint64_t threads_offset;
+} StatsShmHeader;
+
+typedef struct StatsShmCounter_ {
+    char name[STATS_SHM_NAME_LEN];
+    uint32_t type;
+    uint32_t pad;
+} StatsShmCounter;
+
+typedef struct StatsShmThread_ {
+    char name[STATS_SHM_THREAD_NAME_LEN];
+    /** seqlock, odd while the values are updated */
+    uint32_t seq;
+    uint32_t nvalues;
+    uint64_t ids_offset;
+    uint64_t values_offset;
+} StatsShmThread;
+
+int StatsShmCreate(const char *filename, uint64_t size, StatsShmHeader **header);
+struct StatsLocalCounter_;
+void StatsShmThreadPublish(
+        StatsShmThread *t, const struct StatsLocalCounter_ *values, uint32_t nvalues);
+void StatsShmDestroy(void);
+
+#endif /* SURICATA_COUNTERS_SHM_H */
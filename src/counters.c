@@ -26,6 +26,7 @@
 
 #include "suricata-common.h"
 #include "counters.h"
+#include "counters-shm.h"
 
 #include "suricata.h"
 #include "threadvars.h"
@@ -57,6 +58,29 @@ enum StatsType {
     STATS_TYPE_MAXIMUM = 3,
     STATS_TYPE_FUNC = 4,
     STATS_TYPE_DERIVE_DIV = 5,
+    STATS_TYPE_HISTOGRAM = 6,
+    STATS_TYPE_PERCENTILE = 7,
+};
+
+/* Histogram counters use log-linear buckets: values below
+ * STATS_HISTOGRAM_SUB get a bucket each, above that every power of 2 is
+ * split into STATS_HISTOGRAM_SUB buckets. This keeps the error of the
+ * reported percentiles under 12.5%. Values of 2^STATS_HISTOGRAM_MAX_BITS
+ * and up all end up in the last bucket. */
+#define STATS_HISTOGRAM_SUB_BITS 3
+#define STATS_HISTOGRAM_SUB      (1 << STATS_HISTOGRAM_SUB_BITS)
+#define STATS_HISTOGRAM_MAX_BITS 32
+#define STATS_HISTOGRAM_BUCKETS                                                                    \
+    ((STATS_HISTOGRAM_MAX_BITS - STATS_HISTOGRAM_SUB_BITS + 1) * STATS_HISTOGRAM_SUB)
+
+/** percentiles exported for each histogram, in permille */
+static const struct {
+    const char *suffix;
+    uint16_t permille;
+} stats_percentiles[] = {
+    { "p50", 500 },
+    { "p90", 900 },
+    { "p99", 990 },
 };
 
 /**
@@ -98,6 +122,20 @@ bool stats_decoder_events = true;
 const char *stats_decoder_events_prefix = "decoder.event";
 /**< add stream events as stats? disabled by default */
 bool stats_stream_events = false;
+/**< sample packet latency? disabled by default */
+uint32_t stats_latency_sample_rate = 0;
+/**< file for the shared memory stats segment. NULL if disabled */
+static const char *stats_shm_path = NULL;
+
+/** names of the counters generated by histogram registration. The
+ *  counters and the stats table only point to their names, so they are
+ *  kept here until the stats are released. */
+typedef struct StatsHistogramName_ {
+    char *name;
+    struct StatsHistogramName_ *next;
+} StatsHistogramName;
+static StatsHistogramName *stats_histogram_names = NULL;
+static SCMutex stats_histogram_names_mutex = SCMUTEX_INITIALIZER;
 
 static int StatsOutput(ThreadVars *tv);
 static int StatsThreadRegister(const char *thread_name, StatsPublicThreadContext *);
@@ -251,6 +289,84 @@ void StatsCounterAvgAddI64(StatsThreadContext *stats, StatsCounterAvgId id, int6
     pca->head[id.id + 1].v++;
 }
 
+static inline uint32_t StatsHistogramBucket(uint64_t x)
+{
+    if (x < STATS_HISTOGRAM_SUB)
+        return (uint32_t)x;
+    if (x >> STATS_HISTOGRAM_MAX_BITS)
+        return STATS_HISTOGRAM_BUCKETS - 1;
+    const uint32_t msb = 63 - __builtin_clzll(x);
+    const uint32_t shift = msb - STATS_HISTOGRAM_SUB_BITS;
+    return (shift + 1) * STATS_HISTOGRAM_SUB + (uint32_t)((x >> shift) & (STATS_HISTOGRAM_SUB - 1));
+}
+
+/** \internal
+ *  \brief highest value that ends up in bucket `b` */
+static uint64_t StatsHistogramBucketMax(uint32_t b)
+{
+    if (b < STATS_HISTOGRAM_SUB)
+        return b;
+    const uint32_t shift = b / STATS_HISTOGRAM_SUB - 1;
+    const uint64_t low = (uint64_t)(STATS_HISTOGRAM_SUB + b % STATS_HISTOGRAM_SUB) << shift;
+    return low + (1ULL << shift) - 1;
+}
+
+/**
+ * \brief Adds a value to a histogram counter
+ *
+ * \param id  Index of the histogram counter in the counter array
+ * \param x   Value to record
+ */
+void StatsCounterHistogramRecord(StatsThreadContext *stats, StatsCounterHistId id, uint64_t x)
+{
+    StatsPrivateThreadContext *pca = &stats->priv;
+#if defined(UNITTESTS) || defined(FUZZ)
+    if (pca->initialized == 0)
+        return;
+#endif
+#ifdef DEBUG
+    BUG_ON((id.id < 1) || (id.id + STATS_HISTOGRAM_BUCKETS >= pca->size));
+#endif
+
+    StatsLocalCounter *h = &pca->head[id.id];
+    if ((int64_t)x > h[0].v) {
+        h[0].v = (int64_t)x;
+    }
+    h[1 + StatsHistogramBucket(x)].v++;
+}
+
+/** \internal
+ *  \brief get a percentile from a histogram
+ *
+ *  \param h the max value followed by the buckets
+ *  \param permille percentile * 10
+ *
+ *  \retval value the highest value of the bucket the percentile falls in,
+ *          capped at the max value seen.
+ */
+static uint64_t StatsHistogramPercentile(const StatsLocalCounter *h, uint16_t permille)
+{
+    uint64_t total = 0;
+    for (uint32_t b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+        total += (uint64_t)h[1 + b].v;
+    }
+    if (total == 0)
+        return 0;
+
+    const uint64_t rank = MAX(1, (total * permille + 999) / 1000);
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+        seen += (uint64_t)h[1 + b].v;
+        if (seen >= rank) {
+            /* the last bucket has no upper bound */
+            if (b == STATS_HISTOGRAM_BUCKETS - 1)
+                return (uint64_t)h[0].v;
+            return MIN(StatsHistogramBucketMax(b), (uint64_t)h[0].v);
+        }
+    }
+    return (uint64_t)h[0].v;
+}
+
 static SCConfNode *GetConfig(void)
 {
     SCConfNode *stats = SCConfGetNode("stats");
@@ -316,6 +432,22 @@ static void StatsInitCtxPreOutput(void)
             prefix = "decoder.event";
         }
         stats_decoder_events_prefix = prefix;
+
+        const char *rate = SCConfNodeLookupChildValue(stats, "latency-sample-rate");
+        if (rate != NULL) {
+            if (StringParseUint32(&stats_latency_sample_rate, 10, 0, rate) < 0) {
+                SCLogWarning("Invalid value for latency-sample-rate: \"%s\". "
+                             "Disabling latency sampling.",
+                        rate);
+                stats_latency_sample_rate = 0;
+            }
+        }
+
+        SCConfNode *shm = SCConfNodeLookupChild(stats, "shm");
+        if (shm != NULL && SCConfNodeChildValueIsTrue(shm, "enabled")) {
+            const char *filename = SCConfNodeLookupChildValue(shm, "filename");
+            stats_shm_path = filename != NULL ? filename : "/dev/shm/suricata-stats";
+        }
     }
     SCReturn;
 }
@@ -335,8 +467,9 @@ static void StatsInitCtxPostOutput(void)
         stats_loggers_active = 0;
 
         /* if the unix command socket is enabled we do the background
-         * stats sync just in case someone runs 'dump-counters' */
-        if (!ConfUnixSocketIsEnable()) {
+         * stats sync just in case someone runs 'dump-counters'. Same
+         * for the shared memory segment. */
+        if (!ConfUnixSocketIsEnable() && stats_shm_path == NULL) {
             SCLogWarning("stats are enabled but no loggers are active");
             stats_enabled = false;
             SCReturn;
@@ -346,6 +479,125 @@ static void StatsInitCtxPostOutput(void)
     SCReturn;
 }
 
+/** \internal
+ *  \brief get the name "<name>.<suffix>", owned by the stats API */
+static const char *StatsHistogramGetName(const char *name, const char *suffix)
+{
+    char buf[256];
+    if (snprintf(buf, sizeof(buf), "%s.%s", name, suffix) >= (int)sizeof(buf))
+        return NULL;
+
+    const char *r = NULL;
+    SCMutexLock(&stats_histogram_names_mutex);
+    for (StatsHistogramName *n = stats_histogram_names; n != NULL; n = n->next) {
+        if (strcmp(n->name, buf) == 0) {
+            r = n->name;
+            goto end;
+        }
+    }
+    StatsHistogramName *n = SCCalloc(1, sizeof(*n));
+    if (n == NULL)
+        goto end;
+    n->name = SCStrdup(buf);
+    if (n->name == NULL) {
+        SCFree(n);
+        goto end;
+    }
+    n->next = stats_histogram_names;
+    stats_histogram_names = n;
+    r = n->name;
+end:
+    SCMutexUnlock(&stats_histogram_names_mutex);
+    return r;
+}
+
+static void StatsHistogramNamesFree(void)
+{
+    SCMutexLock(&stats_histogram_names_mutex);
+    StatsHistogramName *n = stats_histogram_names;
+    while (n != NULL) {
+        StatsHistogramName *next = n->next;
+        SCFree(n->name);
+        SCFree(n);
+        n = next;
+    }
+    stats_histogram_names = NULL;
+    SCMutexUnlock(&stats_histogram_names_mutex);
+}
+
+/** \internal
+ *  \brief create the shared memory stats segment
+ *
+ *  Called by the stats thread after all threads have registered their
+ *  counters. Threads registering later are not part of the segment.
+ */
+static void StatsShmSetup(void)
+{
+    SCMutexLock(&stats_ctx->sts_lock);
+    const uint32_t ncounters = counters_global_id;
+    uint32_t nthreads = 0;
+    uint64_t size = sizeof(StatsShmHeader) + ncounters * sizeof(StatsShmCounter);
+    for (const StatsThreadStore *sts = stats_ctx->sts; sts != NULL; sts = sts->next) {
+        const uint32_t nvalues = sts->ctx->curr_id + 1;
+        size += sizeof(StatsShmThread);
+        size += STATS_SHM_ALIGN(nvalues * sizeof(uint32_t)) + nvalues * sizeof(int64_t);
+        nthreads++;
+    }
+
+    StatsShmHeader *hdr = NULL;
+    if (StatsShmCreate(stats_shm_path, size, &hdr) != 0) {
+        SCMutexUnlock(&stats_ctx->sts_lock);
+        return;
+    }
+    uint8_t *base = (uint8_t *)hdr;
+    hdr->version = STATS_SHM_VERSION;
+    hdr->size = size;
+    hdr->start_time = (int64_t)stats_start_time;
+    hdr->ncounters = ncounters;
+    hdr->nthreads = nthreads;
+    hdr->counters_offset = sizeof(StatsShmHeader);
+    hdr->threads_offset = hdr->counters_offset + ncounters * sizeof(StatsShmCounter);
+
+    StatsShmCounter *counters = (StatsShmCounter *)(base + hdr->counters_offset);
+    StatsShmThread *threads = (StatsShmThread *)(base + hdr->threads_offset);
+    uint64_t offset = hdr->threads_offset + nthreads * sizeof(StatsShmThread);
+    uint32_t t = 0;
+    for (const StatsThreadStore *sts = stats_ctx->sts; sts != NULL; sts = sts->next, t++) {
+        const StatsPublicThreadContext *pctx = sts->ctx;
+        const uint32_t nvalues = pctx->curr_id + 1;
+        StatsShmThread *st = &threads[t];
+        strlcpy(st->name, sts->name, sizeof(st->name));
+        st->nvalues = nvalues;
+        st->ids_offset = offset;
+        offset += STATS_SHM_ALIGN(nvalues * sizeof(uint32_t));
+        st->values_offset = offset;
+        offset += nvalues * sizeof(int64_t);
+
+        uint32_t *ids = (uint32_t *)(base + st->ids_offset);
+        for (uint32_t i = 0; i < nvalues; i++) {
+            const StatsCounter *pc = pctx->pc_array[i];
+            if (pc == NULL || pc->id != i) {
+                ids[i] = STATS_SHM_NO_ID;
+                continue;
+            }
+            ids[i] = pc->gid;
+            if (pc->gid < ncounters && counters[pc->gid].type == 0) {
+                strlcpy(counters[pc->gid].name, pc->name, sizeof(counters[pc->gid].name));
+                counters[pc->gid].type = (uint32_t)pc->type;
+            }
+        }
+    }
+    DEBUG_VALIDATE_BUG_ON(offset != size);
+
+    /* the segment is complete: let readers in and threads publish */
+    __atomic_store_n(&hdr->magic, STATS_SHM_MAGIC, __ATOMIC_RELEASE);
+    t = 0;
+    for (StatsThreadStore *sts = stats_ctx->sts; sts != NULL; sts = sts->next, t++) {
+        SC_ATOMIC_SET(sts->ctx->shm, &threads[t]);
+    }
+    SCMutexUnlock(&stats_ctx->sts_lock);
+}
+
 /**
  * \brief Releases the resources allotted to the output context of the
  *        Stats API
@@ -390,6 +642,9 @@ static void StatsReleaseCtx(void)
     }
     memset(&stats_table, 0, sizeof(stats_table));
     SCMutexUnlock(&stats_table_mutex);
+
+    StatsShmDestroy();
+    StatsHistogramNamesFree();
 }
 
 /**
@@ -432,6 +687,10 @@ static void *StatsMgmtThread(void *arg)
 
     TmThreadsSetFlag(tv_local, THV_INIT_DONE | THV_RUNNING);
     bool run = TmThreadsWaitForUnpause(tv_local);
+    /* all threads are set up once we're unpaused */
+    if (run && stats_shm_path != NULL) {
+        StatsShmSetup();
+    }
     while (run) {
         struct timeval cur_timev;
         gettimeofday(&cur_timev, NULL);
@@ -594,6 +853,14 @@ static void StatsReleaseCounter(StatsCounter *pc)
     }
 }
 
+/** \internal
+ *  \brief derived counters are not updated by the threads, but calculated
+ *         from other counters at output time. */
+static inline bool StatsTypeIsDerived(const int type)
+{
+    return type == STATS_TYPE_DERIVE_DIV || type == STATS_TYPE_PERCENTILE;
+}
+
 /** \internal
  *  \brief Get ID for counters referenced in a derive counter
  *  \retval id (>=1) or 0 on error
@@ -655,6 +922,13 @@ static uint16_t StatsRegisterQualifiedCounter(const char *name, StatsPublicThrea
         if (did1 == 0 || did2 == 0) {
             return 0;
         }
+    } else if (type_q == STATS_TYPE_PERCENTILE) {
+        /* did1 is the histogram, did2 is set by the caller to the
+         * percentile in permille */
+        did1 = GetIdByName(pctx, dname1);
+        if (did1 == 0) {
+            return 0;
+        }
     }
 
     /* if we reach this point we don't have a counter registered by this name */
@@ -663,7 +937,7 @@ static uint16_t StatsRegisterQualifiedCounter(const char *name, StatsPublicThrea
 
     /* assign a unique id to this StatsCounter.  The id is local to this
      * thread context.  Please note that the id start from 1, and not 0 */
-    if (type_q == STATS_TYPE_DERIVE_DIV) {
+    if (StatsTypeIsDerived(type_q)) {
         pc->id = ++pctx->derive_id;
     } else {
         pc->id = ++(pctx->curr_id);
@@ -672,6 +946,10 @@ static uint16_t StatsRegisterQualifiedCounter(const char *name, StatsPublicThrea
      * the other to track updates. */
     if (type_q == STATS_TYPE_AVERAGE)
         ++(pctx->curr_id);
+    /* HISTOGRAM counters use the first index for the max value, followed
+     * by the buckets. */
+    if (type_q == STATS_TYPE_HISTOGRAM)
+        pctx->curr_id += STATS_HISTOGRAM_BUCKETS;
     pc->name = name;
 
     /* Precalculate the short name */
@@ -693,6 +971,50 @@ static uint16_t StatsRegisterQualifiedCounter(const char *name, StatsPublicThrea
     return pc->id;
 }
 
+/** histograms merged over all threads during output */
+typedef struct StatsHistogramMerge_ {
+    struct StatsHistogramMergeEntry {
+        uint16_t gid;
+        /** max value followed by the buckets */
+        StatsLocalCounter h[1 + STATS_HISTOGRAM_BUCKETS];
+    } *h;
+    uint16_t cnt;
+} StatsHistogramMerge;
+
+static const StatsLocalCounter *StatsHistogramMergeGet(const StatsHistogramMerge *m, uint16_t gid)
+{
+    for (uint16_t i = 0; i < m->cnt; i++) {
+        if (m->h[i].gid == gid)
+            return m->h[i].h;
+    }
+    return NULL;
+}
+
+static void StatsHistogramMergeAdd(StatsHistogramMerge *m, uint16_t gid, const StatsLocalCounter *h)
+{
+    struct StatsHistogramMergeEntry *e = NULL;
+    for (uint16_t i = 0; i < m->cnt; i++) {
+        if (m->h[i].gid == gid) {
+            e = &m->h[i];
+            break;
+        }
+    }
+    if (e == NULL) {
+        void *ptr = SCRealloc(m->h, (m->cnt + 1) * sizeof(*m->h));
+        if (ptr == NULL)
+            return;
+        m->h = ptr;
+        e = &m->h[m->cnt++];
+        memset(e, 0, sizeof(*e));
+        e->gid = gid;
+    }
+    if (h[0].v > e->h[0].v)
+        e->h[0].v = h[0].v;
+    for (uint32_t b = 1; b <= STATS_HISTOGRAM_BUCKETS; b++) {
+        e->h[b].v += h[b].v;
+    }
+}
+
 /**
  * \brief The output interface for the Stats API
  */
@@ -739,10 +1061,17 @@ static int StatsOutput(ThreadVars *tv)
         enum StatsType type;
         int64_t value;
         uint64_t updates;
+        /* percentiles: gid of the histogram and the percentile */
+        uint16_t hist_gid;
+        uint16_t permille;
     } merge_table[max_id];
     memset(&merge_table, 0x00,
            max_id * sizeof(struct CountersMergeTable));
 
+    /* histogram buckets summed over all threads, needed to calculate
+     * the percentiles for the totals */
+    StatsHistogramMerge hist = { NULL, 0 };
+
     int thread = stats_ctx->sts_cnt - 1;
     StatsRecord *table = stats_table.stats;
 
@@ -762,13 +1091,14 @@ static int StatsOutput(ThreadVars *tv)
         memset(&thread_table, 0x00,
                 max_id * sizeof(struct CountersMergeTable));
 
-        StatsLocalCounter thread_table_from_private[max_id];
-        memset(&thread_table_from_private, 0x00, max_id * sizeof(StatsLocalCounter));
+        /* ids are fixed once the thread is registered */
+        const uint16_t table_size = sts->ctx->curr_id + sts->ctx->derive_id + 1;
+        StatsLocalCounter thread_table_from_private[table_size];
+        memset(&thread_table_from_private, 0x00, table_size * sizeof(StatsLocalCounter));
 
         /* copy private table to a local variable to loop it w/o lock */
         bool skip = false;
         SCSpinLock(&sts->ctx->lock);
-        const uint16_t table_size = sts->ctx->curr_id + sts->ctx->derive_id + 1;
         if (sts->ctx->copy_of_private == NULL) {
             skip = true;
         } else {
@@ -782,7 +1112,6 @@ static int StatsOutput(ThreadVars *tv)
         /* loop counters and handle them. This includes the global counters, which
          * access the StatsCounters but don't modify them. */
         for (uint16_t i = 1; i < table_size; i++) {
-            DEBUG_VALIDATE_BUG_ON(i >= max_id); // help scan-build
             const StatsCounter *pc = sts->ctx->pc_array[i];
             thread_table[pc->gid].type = pc->type;
 
@@ -795,7 +1124,7 @@ static int StatsOutput(ThreadVars *tv)
                         thread_table[pc->gid].value = pc->Func();
                     break;
                 case STATS_TYPE_AVERAGE:
-                    DEBUG_VALIDATE_BUG_ON(i + 1 >= max_id); // help scan-build
+                    DEBUG_VALIDATE_BUG_ON(i + 1 >= table_size); // help scan-build
                     thread_table[pc->gid].value = thread_table_from_private[i].v;
                     thread_table[pc->gid].updates = thread_table_from_private[i + 1].v;
                     /* skip updates row */
@@ -807,6 +1136,19 @@ static int StatsOutput(ThreadVars *tv)
                     thread_table[pc->gid].value = thread_table_from_private[pc->did1].v;
                     thread_table[pc->gid].updates = thread_table_from_private[pc->did2].v;
                     break;
+                case STATS_TYPE_HISTOGRAM:
+                    DEBUG_VALIDATE_BUG_ON(i + STATS_HISTOGRAM_BUCKETS >= table_size);
+                    thread_table[pc->gid].value = thread_table_from_private[i].v;
+                    StatsHistogramMergeAdd(&hist, pc->gid, &thread_table_from_private[i]);
+                    /* skip bucket rows */
+                    i += STATS_HISTOGRAM_BUCKETS;
+                    break;
+                case STATS_TYPE_PERCENTILE:
+                    thread_table[pc->gid].value = StatsHistogramPercentile(
+                            &thread_table_from_private[pc->did1], pc->did2);
+                    thread_table[pc->gid].hist_gid = sts->ctx->pc_array[pc->did1]->gid;
+                    thread_table[pc->gid].permille = pc->did2;
+                    break;
                 default:
                     SCLogDebug("Counter %s (%u:%u) value %" PRIu64, pc->name, pc->id, pc->gid,
                             thread_table_from_private[i].v);
@@ -826,12 +1168,18 @@ static int StatsOutput(ThreadVars *tv)
 
             switch (e->type) {
                 case STATS_TYPE_MAXIMUM:
+                case STATS_TYPE_HISTOGRAM:
                     if (e->value > merge_table[c].value)
                         merge_table[c].value = e->value;
                     break;
                 case STATS_TYPE_FUNC:
                     merge_table[c].value = e->value;
                     break;
+                case STATS_TYPE_PERCENTILE:
+                    /* calculated from the merged histogram below */
+                    merge_table[c].hist_gid = e->hist_gid;
+                    merge_table[c].permille = e->permille;
+                    break;
                 case STATS_TYPE_AVERAGE:
                 default:
                     merge_table[c].value += e->value;
@@ -886,9 +1234,17 @@ static int StatsOutput(ThreadVars *tv)
         const struct CountersMergeTable *m = &merge_table[x];
         switch (m->type) {
             case STATS_TYPE_MAXIMUM:
+            case STATS_TYPE_HISTOGRAM:
                 if (m->value > table[x].value)
                     table[x].value = m->value;
                 break;
+            case STATS_TYPE_PERCENTILE: {
+                const StatsLocalCounter *h = StatsHistogramMergeGet(&hist, m->hist_gid);
+                if (h != NULL) {
+                    table[x].value = StatsHistogramPercentile(h, m->permille);
+                }
+                break;
+            }
             case STATS_TYPE_AVERAGE:
             case STATS_TYPE_DERIVE_DIV:
                 if (m->value > 0 && m->updates > 0) {
@@ -901,6 +1257,8 @@ static int StatsOutput(ThreadVars *tv)
         }
     }
 
+    SCFree(hist.h);
+
     /* invoke logger(s) */
     if (stats_loggers_active) {
         OutputStatsLog(tv, td, &stats_table);
@@ -1106,6 +1464,47 @@ StatsCounterGlobalId StatsRegisterGlobalCounter(const char *name, uint64_t (*Fun
     return s;
 }
 
+/**
+ * \brief Registers a histogram counter, tracking the distribution of the
+ *        values recorded into it.
+ *
+ * Registers "<name>.max" holding the highest value recorded, and a
+ * "<name>.pXX" counter for each exported percentile.
+ *
+ * \param name Name of the counter, to be registered
+ * \param stats Stats context of the thread to register the counter for
+ *
+ * \retval id Counter id for the newly registered counter, or the already
+ *            present counter
+ */
+StatsCounterHistId StatsRegisterHistogramCounter(const char *name, StatsThreadContext *stats)
+{
+    StatsCounterHistId s = { .id = 0 };
+    const char *max_name = StatsHistogramGetName(name, "max");
+    if (max_name == NULL)
+        return s;
+    uint16_t id = StatsRegisterQualifiedCounter(
+            max_name, &stats->pub, STATS_TYPE_HISTOGRAM, NULL, NULL, NULL);
+    if (id == 0)
+        return s;
+
+    for (size_t i = 0; i < ARRAY_SIZE(stats_percentiles); i++) {
+        const char *pname = StatsHistogramGetName(name, stats_percentiles[i].suffix);
+        if (pname == NULL || StatsRegisterQualifiedCounter(pname, &stats->pub,
+                                     STATS_TYPE_PERCENTILE, NULL, max_name, NULL) == 0) {
+            return s;
+        }
+        for (StatsCounter *pc = stats->pub.head; pc != NULL; pc = pc->next) {
+            if (pc->name == pname) {
+                pc->did2 = stats_percentiles[i].permille;
+                break;
+            }
+        }
+    }
+    s.id = id;
+    return s;
+}
+
 /**
  * \brief Registers a counter which tracks the result of the calculating the value
  * of counter dname1 divided by the value of the counter dname2
@@ -1182,7 +1581,7 @@ static int StatsThreadSetupPublic(StatsPublicThreadContext *pctx)
     }
     /* regular counters that get direct updates by their id as idx */
     for (StatsCounter *pc = pctx->head; pc != NULL; pc = pc->next) {
-        if (pc->type != STATS_TYPE_DERIVE_DIV) {
+        if (!StatsTypeIsDerived(pc->type)) {
             SCLogDebug("pc %s gid %u id %u", pc->name, pc->gid, pc->id);
             BUG_ON(pctx->pc_array[pc->id] != NULL);
             pctx->pc_array[pc->id] = pc;
@@ -1191,9 +1590,9 @@ static int StatsThreadSetupPublic(StatsPublicThreadContext *pctx)
     /* derive counters are not updated by the thread itself and will be put
      * at the end of the array */
     for (StatsCounter *pc = pctx->head; pc != NULL; pc = pc->next) {
-        if (pc->type == STATS_TYPE_DERIVE_DIV) {
+        if (StatsTypeIsDerived(pc->type)) {
             uint16_t id = pctx->curr_id + pc->id;
-            SCLogDebug("STATS_TYPE_DERIVE_DIV: pc %s gid %u pc->id %u id %u", pc->name, pc->gid,
+            SCLogDebug("derived: pc %s gid %u pc->id %u id %u", pc->name, pc->gid,
                     pc->id, id);
             BUG_ON(pctx->pc_array[id] != NULL);
             pctx->pc_array[id] = pc;
@@ -1359,6 +1758,11 @@ static int StatsUpdateCounterArray(StatsPrivateThreadContext *pca, StatsPublicTh
         SCSpinLock(&pctx->lock);
         memcpy(pctx->copy_of_private, pca->head, pca->size * sizeof(StatsLocalCounter));
         SCSpinUnlock(&pctx->lock);
+
+        StatsShmThread *shm = SC_ATOMIC_GET(pctx->shm);
+        if (shm != NULL) {
+            StatsShmThreadPublish(shm, pca->head, pca->size);
+        }
     }
     SC_ATOMIC_SET(pctx->sync_now, false);
     return 1;
@@ -1648,6 +2052,51 @@ static int StatsTestCounterValues11(void)
     PASS;
 }
 
+static int StatsTestHistogram12(void)
+{
+    /* every bucket holds its own max value, and the buckets are ordered */
+    for (uint32_t b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+        FAIL_IF_NOT(StatsHistogramBucket(StatsHistogramBucketMax(b)) == b);
+        if (b > 0) {
+            FAIL_IF_NOT(StatsHistogramBucketMax(b) > StatsHistogramBucketMax(b - 1));
+        }
+    }
+    FAIL_IF_NOT(StatsHistogramBucket(UINT64_MAX) == STATS_HISTOGRAM_BUCKETS - 1);
+
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(ThreadVars));
+    StatsThreadInit(&tv.stats);
+
+    StatsCounterId c1 = RegisterCounter("t1", "c1", &tv.stats.pub);
+    StatsCounterHistId h1 = StatsRegisterHistogramCounter("h1", &tv.stats);
+    FAIL_IF_NOT(h1.id == 2);
+    StatsCounterId c2 = RegisterCounter("t2", "c2", &tv.stats.pub);
+    FAIL_IF_NOT(c2.id == h1.id + STATS_HISTOGRAM_BUCKETS + 1);
+    /* registering again gives the same counter */
+    FAIL_IF_NOT(StatsRegisterHistogramCounter("h1", &tv.stats).id == h1.id);
+
+    StatsThreadSetupPublic(&tv.stats.pub);
+    StatsGetAllCountersArray(&tv.stats.pub, &tv.stats.priv);
+    StatsPrivateThreadContext *pca = &tv.stats.priv;
+
+    for (uint64_t x = 1; x <= 1000; x++) {
+        StatsCounterHistogramRecord(&tv.stats, h1, x);
+    }
+    StatsCounterIncr(&tv.stats, c2);
+
+    const StatsLocalCounter *h = &pca->head[h1.id];
+    FAIL_IF_NOT(h[0].v == 1000);
+    FAIL_IF_NOT(StatsHistogramPercentile(h, 500) == 511);
+    FAIL_IF_NOT(StatsHistogramPercentile(h, 900) == 959);
+    FAIL_IF_NOT(StatsHistogramPercentile(h, 990) == 1000);
+    FAIL_IF_NOT(pca->head[c1.id].v == 0);
+    FAIL_IF_NOT(pca->head[c2.id].v == 1);
+
+    StatsThreadCleanup(&tv.stats);
+    StatsHistogramNamesFree();
+    PASS;
+}
+
 #endif
 
 void StatsRegisterTests(void)
@@ -1664,5 +2113,6 @@ void StatsRegisterTests(void)
     UtRegisterTest("StatsTestUpdateGlobalCounter10",
                    StatsTestUpdateGlobalCounter10);
     UtRegisterTest("StatsTestCounterValues11", StatsTestCounterValues11);
+    UtRegisterTest("StatsTestHistogram12", StatsTestHistogram12);
 #endif
 }
@@ -39,6 +39,12 @@ typedef struct StatsCounterMaxId {
     uint16_t id;
 } StatsCounterMaxId;
 
+/* histogram counters track a distribution of values, exported as
+ * percentiles. */
+typedef struct StatsCounterHistId {
+    uint16_t id;
+} StatsCounterHistId;
+
 typedef struct StatsCounterGlobalId {
     uint16_t id;
 } StatsCounterGlobalId;
@@ -80,12 +86,16 @@ typedef struct StatsCounter_ {
 
 /**
  * \brief counter type for local (private) increments.
- * For AVG counters we use 2 to track values and updates.
+ * For AVG counters we use 2 to track values and updates. HISTOGRAM
+ * counters use 1 for the max value and one per bucket.
  */
 typedef struct StatsLocalCounter_ {
     int64_t v;
 } StatsLocalCounter;
 
+struct StatsShmThread_;
+typedef struct StatsShmThread_ *StatsShmThreadPtr;
+
 /**
  * \brief Stats Context for a ThreadVars instance
  */
@@ -111,6 +121,10 @@ typedef struct StatsPublicThreadContext_ {
 
     StatsLocalCounter *copy_of_private;
 
+    /* part of the shared memory stats segment for this thread, if enabled.
+     * Set by the stats thread once the segment is created. */
+    SC_ATOMIC_DECLARE(StatsShmThreadPtr, shm);
+
     /* lock to prevent simultaneous access during update_counter/output_stat */
     SCSpinlock lock;
 } StatsPublicThreadContext;
@@ -149,6 +163,7 @@ StatsCounterId StatsRegisterCounter(const char *, StatsThreadContext *);
 StatsCounterAvgId StatsRegisterAvgCounter(const char *, StatsThreadContext *);
 StatsCounterMaxId StatsRegisterMaxCounter(const char *, StatsThreadContext *);
 StatsCounterGlobalId StatsRegisterGlobalCounter(const char *cname, uint64_t (*Func)(void));
+StatsCounterHistId StatsRegisterHistogramCounter(const char *, StatsThreadContext *);
 
 StatsCounterDeriveId StatsRegisterDeriveDivCounter(
         const char *cname, const char *dname1, const char *dname2, StatsThreadContext *);
@@ -161,6 +176,33 @@ void StatsCounterDecr(StatsThreadContext *, StatsCounterId);
 
 void StatsCounterMaxUpdateI64(StatsThreadContext *, StatsCounterMaxId id, int64_t x);
 void StatsCounterAvgAddI64(StatsThreadContext *, StatsCounterAvgId id, int64_t x);
+void StatsCounterHistogramRecord(StatsThreadContext *, StatsCounterHistId id, uint64_t x);
+
+/** sample 1 in every N packets for the latency histograms. 0: disabled */
+extern uint32_t stats_latency_sample_rate;
+
+/**
+ * \brief check if the next packet should be sampled for latency
+ *
+ * \param cnt per thread packet count since the last sample
+ */
+static inline bool StatsLatencySample(uint32_t *cnt)
+{
+    if (likely(stats_latency_sample_rate == 0))
+        return false;
+    if (++(*cnt) < stats_latency_sample_rate)
+        return false;
+    *cnt = 0;
+    return true;
+}
+
+/** \brief monotonic time in nanoseconds, for the latency histograms */
+static inline uint64_t StatsLatencyNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
 
 /* utility functions */
 int64_t StatsCounterGetLocalValue(StatsThreadContext *, StatsCounterId);
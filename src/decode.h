@@ -68,6 +68,7 @@ enum PktSrcEnum {
 #include "source-nfq.h"
 #include "source-ipfw.h"
 #include "source-pcap.h"
+#include "source-lib.h"
 #include "source-af-packet.h"
 #include "source-netmap.h"
 #include "source-windivert.h"
@@ -599,6 +600,9 @@ typedef struct Packet_
 
         /** libpcap vars: shared by Pcap Live mode and Pcap File mode */
         PcapPacketVars pcap_v;
+
+        /** library mode packet injection */
+        LibPacketVars lib_v;
     };
 
     /** The release function for packet structure and data */
@@ -47,6 +47,7 @@
 #include "detect-ipopts.h"
 #include "detect-tcp-seq.h"
 #include "feature.h"
+#include "app-layer-htp.h"
 #include "util-print.h"
 #include "util-time.h"
 #include "util-validate.h"
@@ -2383,3 +2384,283 @@ int FirewallAnalyzer(const DetectEngineCtx *de_ctx)
     SCJbFree(ctx.js);
     return 0;
 }
+
+/** trim engine features not needed by the ruleset or the outputs */
+static bool g_detect_trim_features = false;
+
+/* set by the file and filedata output registration */
+extern bool g_file_logger_enabled;
+extern bool g_filedata_logger_enabled;
+
+/**
+ * \internal
+ * \brief decide if http file tracking is needed
+ *
+ * Without trimming files are always tracked. Otherwise only if a file or
+ * filedata logger is enabled. Rules enable file tracking when they are
+ * parsed.
+ */
+static bool DetectEngineTrimNeedFiles(
+        const bool trim, const bool file_logger, const bool filedata_logger)
+{
+    if (!trim)
+        return true;
+    return file_logger || filedata_logger;
+}
+
+/**
+ * \brief read the detect.trim-features setting
+ *
+ * Needs to run before the outputs and the rules are set up.
+ */
+void DetectEngineTrimFeaturesSetup(void)
+{
+    int trim = 0;
+    g_detect_trim_features = false;
+    if (SCConfGetBool("detect.trim-features", &trim) == 1 && trim) {
+        SCLogConfig("detect: trimming engine features not used by rules or outputs");
+        g_detect_trim_features = true;
+    }
+    /* when trimming, the rules and outputs that need http bodies or
+     * files enable them on their own */
+    if (DetectEngineTrimNeedFiles(g_detect_trim_features, false, false))
+        AppLayerHtpNeedFileInspection();
+}
+
+/**
+ * \brief enable http file tracking for the file loggers
+ *
+ * Needs to run after the outputs are set up.
+ */
+void DetectEngineTrimFeaturesPostOutputs(void)
+{
+    if (g_detect_trim_features &&
+            DetectEngineTrimNeedFiles(
+                    g_detect_trim_features, g_file_logger_enabled, g_filedata_logger_enabled)) {
+        AppLayerHtpNeedFileInspection();
+    }
+}
+
+bool DetectEngineTrimFeaturesEnabled(void)
+{
+    return g_detect_trim_features;
+}
+
+/**
+ * \brief log the features trimmed after the rules were loaded
+ */
+void DetectEngineTrimFeaturesReport(void)
+{
+    if (!g_detect_trim_features)
+        return;
+
+    const uint32_t htp_flags = SC_ATOMIC_GET(htp_config_flags);
+    if (!(htp_flags & HTP_REQUIRE_REQUEST_BODY))
+        SCLogConfig("detect: http request body tracking trimmed: not used by rules or outputs");
+    if (!(htp_flags & HTP_REQUIRE_RESPONSE_BODY))
+        SCLogConfig("detect: http response body tracking trimmed: not used by rules or outputs");
+}
+
+static const char *FeatureState(const uint32_t flags, const uint32_t flag)
+{
+    return (flags & flag) ? "enabled" : "trimmed";
+}
+
+/**
+ * \brief report the app-layer features used by the ruleset
+ *
+ * Lists per app-layer protocol the buffers inspected by the rules, the
+ * number of raw stream rules and the state of the HTTP body and file
+ * tracking. The HTTP features are only enabled by the rule keywords and
+ * outputs that need them when detect.trim-features is set. The report is
+ * written to features.json in the log directory when running engine
+ * analysis.
+ */
+int FeatureAnalyzer(const DetectEngineCtx *de_ctx)
+{
+    const uint32_t nbufs = de_ctx->buffer_type_id;
+    uint32_t *rules = SCCalloc(g_alproto_max, sizeof(uint32_t));
+    uint8_t *used = SCCalloc((size_t)g_alproto_max * nbufs, sizeof(uint8_t));
+    if (rules == NULL || used == NULL) {
+        SCFree(rules);
+        SCFree(used);
+        return -1;
+    }
+
+    uint32_t raw_stream_rules = 0;
+    uint32_t last_sid = 0;
+    for (const Signature *s = de_ctx->sig_list; s != NULL; s = s->next) {
+        /* don't double count <> sigs */
+        if (last_sid == s->id)
+            continue;
+        last_sid = s->id;
+
+        if (s->flags & SIG_FLAG_REQUIRE_STREAM)
+            raw_stream_rules++;
+        if (s->alproto != ALPROTO_UNKNOWN && s->alproto < g_alproto_max)
+            rules[s->alproto]++;
+        for (const DetectEngineAppInspectionEngine *e = s->app_inspect; e != NULL; e = e->next) {
+            if (e->alproto < g_alproto_max && e->sm_list_base < nbufs)
+                used[(size_t)e->alproto * nbufs + e->sm_list_base] = 1;
+        }
+    }
+
+    SCJsonBuilder *js = SCJbNewObject();
+    if (js == NULL) {
+        SCFree(rules);
+        SCFree(used);
+        return -1;
+    }
+    SCJbSetBool(js, "trim_enabled", g_detect_trim_features);
+    SCJbSetUint(js, "raw_stream_rules", raw_stream_rules);
+
+    SCJbOpenObject(js, "app_layer");
+    for (AppProto a = 0; a < g_alproto_max; a++) {
+        if (!AppProtoIsValid(a))
+            continue;
+
+        uint32_t buffers = 0;
+        for (uint32_t b = 0; b < nbufs; b++)
+            buffers += used[(size_t)a * nbufs + b];
+        if (rules[a] == 0 && buffers == 0)
+            continue;
+
+        SCJbOpenObject(js, AppProtoToString(a));
+        SCJbSetUint(js, "rules", rules[a]);
+        SCJbOpenArray(js, "buffers");
+        for (uint32_t b = 0; b < nbufs; b++) {
+            if (used[(size_t)a * nbufs + b]) {
+                const char *name = DetectEngineBufferTypeGetNameById(de_ctx, b);
+                if (name != NULL)
+                    SCJbAppendString(js, name);
+            }
+        }
+        SCJbClose(js); // buffers
+        SCJbClose(js); // app proto
+    }
+    SCJbClose(js); // app_layer
+
+    const uint32_t htp_flags = SC_ATOMIC_GET(htp_config_flags);
+    SCJbOpenObject(js, "http");
+    SCJbSetString(js, "request_body", FeatureState(htp_flags, HTP_REQUIRE_REQUEST_BODY));
+    SCJbSetString(js, "response_body", FeatureState(htp_flags, HTP_REQUIRE_RESPONSE_BODY));
+    SCJbSetString(js, "files", FeatureState(htp_flags, HTP_REQUIRE_REQUEST_FILE));
+    SCJbClose(js); // http
+
+    SCJbClose(js); // top level object
+
+    const char *filename = "features.json";
+    const char *log_dir = SCConfigGetLogDirectory();
+    char json_path[PATH_MAX] = "";
+    snprintf(json_path, sizeof(json_path), "%s/%s", log_dir, filename);
+
+    SCMutexLock(&g_rules_analyzer_write_m);
+    FILE *fp = fopen(json_path, "w");
+    if (fp != NULL) {
+        fwrite(SCJbPtr(js), SCJbLen(js), 1, fp);
+        fprintf(fp, "\n");
+        fclose(fp);
+    }
+    SCMutexUnlock(&g_rules_analyzer_write_m);
+    SCJbFree(js);
+    SCFree(rules);
+    SCFree(used);
+    return 0;
+}
+
+#ifdef UNITTESTS
+#include "util-unittest.h"
+#include "conf-yaml-loader.h"
+
+static int DetectEngineTrimFeaturesTest01(void)
+{
+    /* no trimming: files are always tracked */
+    FAIL_IF_NOT(DetectEngineTrimNeedFiles(false, false, false));
+    FAIL_IF_NOT(DetectEngineTrimNeedFiles(false, true, false));
+    /* trimming: only for the file loggers */
+    FAIL_IF(DetectEngineTrimNeedFiles(true, false, false));
+    FAIL_IF_NOT(DetectEngineTrimNeedFiles(true, true, false));
+    FAIL_IF_NOT(DetectEngineTrimNeedFiles(true, false, true));
+    FAIL_IF_NOT(DetectEngineTrimNeedFiles(true, true, true));
+    PASS;
+}
+
+static int DetectEngineTrimFeaturesTest02(void)
+{
+    const bool saved = g_detect_trim_features;
+    const char *conf = "%YAML 1.1\n"
+                       "---\n"
+                       "detect:\n"
+                       "  trim-features: yes\n";
+
+    SCConfCreateContextBackup();
+    SCConfInit();
+    FAIL_IF(SCConfYamlLoadString(conf, strlen(conf)) != 0);
+    DetectEngineTrimFeaturesSetup();
+    FAIL_IF_NOT(DetectEngineTrimFeaturesEnabled());
+    SCConfDeInit();
+    SCConfRestoreContextBackup();
+
+    /* not set means no trimming */
+    SCConfCreateContextBackup();
+    SCConfInit();
+    DetectEngineTrimFeaturesSetup();
+    FAIL_IF(DetectEngineTrimFeaturesEnabled());
+    SCConfDeInit();
+    SCConfRestoreContextBackup();
+
+    g_detect_trim_features = saved;
+    PASS;
+}
+
+/** \test the http body and file features enabled by the rules */
+static int DetectEngineTrimFeaturesTest03(void)
+{
+    const uint32_t saved = SC_ATOMIC_GET(htp_config_flags);
+    SC_ATOMIC_SET(htp_config_flags, 0);
+
+    DetectEngineCtx *de_ctx = DetectEngineCtxInit();
+    FAIL_IF_NULL(de_ctx);
+    de_ctx->flags |= DE_QUIET;
+
+    /* raw content rules need no http features */
+    FAIL_IF_NULL(DetectEngineAppendSig(
+            de_ctx, "alert tcp any any -> any any (content:\"abc\"; sid:1;)"));
+    FAIL_IF_NOT(SC_ATOMIC_GET(htp_config_flags) == 0);
+    FAIL_IF_NULL(DetectEngineAppendSig(
+            de_ctx, "alert http any any -> any any (http.uri; content:\"abc\"; sid:2;)"));
+    FAIL_IF_NOT(SC_ATOMIC_GET(htp_config_flags) == 0);
+
+    /* request body only */
+    FAIL_IF_NULL(DetectEngineAppendSig(de_ctx,
+            "alert http any any -> any any (http.request_body; content:\"abc\"; sid:3;)"));
+    FAIL_IF_NOT(SC_ATOMIC_GET(htp_config_flags) == HTP_REQUIRE_REQUEST_BODY);
+
+    /* file keywords enable both bodies and file tracking */
+    const uint32_t files =
+            HTP_REQUIRE_REQUEST_BODY | HTP_REQUIRE_RESPONSE_BODY | HTP_REQUIRE_REQUEST_FILE;
+    SC_ATOMIC_SET(htp_config_flags, 0);
+    FAIL_IF_NULL(DetectEngineAppendSig(
+            de_ctx, "alert http any any -> any any (filename:\"abc\"; sid:4;)"));
+    FAIL_IF_NOT(SC_ATOMIC_GET(htp_config_flags) == files);
+
+    SC_ATOMIC_SET(htp_config_flags, 0);
+    FAIL_IF_NULL(DetectEngineAppendSig(de_ctx,
+            "alert http any any -> any any (flow:to_client; file.data; content:\"abc\"; "
+            "sid:5;)"));
+    FAIL_IF_NOT(SC_ATOMIC_GET(htp_config_flags) == files);
+    /* only outputs log all response bodies */
+    FAIL_IF(SC_ATOMIC_GET(htp_config_flags) & HTP_REQUIRE_RESPONSE_BODY_LOG);
+
+    DetectEngineCtxFree(de_ctx);
+    SC_ATOMIC_SET(htp_config_flags, saved);
+    PASS;
+}
+
+void DetectEngineAnalyzerRegisterTests(void)
+{
+    UtRegisterTest("DetectEngineTrimFeaturesTest01", DetectEngineTrimFeaturesTest01);
+    UtRegisterTest("DetectEngineTrimFeaturesTest02", DetectEngineTrimFeaturesTest02);
+    UtRegisterTest("DetectEngineTrimFeaturesTest03", DetectEngineTrimFeaturesTest03);
+}
+#endif
@@ -41,4 +41,14 @@ void EngineAnalysisRules2(const struct DetectEngineCtx_ *de_ctx, const Signature
 
 int FirewallAnalyzer(const struct DetectEngineCtx_ *de_ctx);
 
+void DetectEngineTrimFeaturesSetup(void);
+void DetectEngineTrimFeaturesPostOutputs(void);
+void DetectEngineTrimFeaturesReport(void);
+bool DetectEngineTrimFeaturesEnabled(void);
+int FeatureAnalyzer(const struct DetectEngineCtx_ *de_ctx);
+
+#ifdef UNITTESTS
+void DetectEngineAnalyzerRegisterTests(void);
+#endif
+
 #endif /* SURICATA_DETECT_ENGINE_ANALYZER_H */
@@ -176,6 +176,32 @@ int SignatureIsFileSha256Inspecting(const Signature *s)
     return 0;
 }
 
+/** \brief Test if a rule needs the decompressed http response body
+ *
+ *  Rules inspecting file.data or files on http responses and lua scripts
+ *  on http, which can access the body through the http lua lib.
+ */
+bool SignatureIsHttpResponseBodyInspecting(const Signature *s)
+{
+    if (s->alproto != ALPROTO_UNKNOWN && !AppProtoEquals(s->alproto, ALPROTO_HTTP1))
+        return false;
+
+    const int file_data_id = DetectBufferTypeGetByName("file_data");
+    for (const DetectEngineAppInspectionEngine *e = s->app_inspect; e != NULL; e = e->next) {
+        if (e->alproto != ALPROTO_HTTP1 || e->dir != 1)
+            continue;
+        if (e->sm_list_base == file_data_id || (s->file_flags & FILE_SIG_NEED_FILE))
+            return true;
+        for (const SigMatchData *smd = e->smd; smd != NULL; smd++) {
+            if (smd->type == DETECT_LUA)
+                return true;
+            if (smd->is_last)
+                break;
+        }
+    }
+    return false;
+}
+
 static bool SignatureInspectsBuffers(const Signature *s)
 {
     return (s->init_data->buffer_index > 0);
@@ -1769,6 +1795,108 @@ void SignatureSetType(DetectEngineCtx *de_ctx, Signature *s)
     }
 }
 
+/** \internal
+ *  \brief get the single range of a port list
+ *  \retval bool true if the list is a single range */
+static bool SigHeaderPortRange(const DetectPort *dp, uint16_t range[2])
+{
+    if (dp == NULL || dp->next != NULL)
+        return false;
+    range[0] = dp->port;
+    range[1] = dp->port2;
+    return true;
+}
+
+/** \internal
+ *  \brief get the single range of an IPv4 match array
+ *
+ *  An empty array can't match any IPv4 packet, so it's stored as an
+ *  empty range.
+ *
+ *  \retval bool true if the array has at most one range */
+static bool SigHeaderAddressRange(
+        const DetectMatchAddressIPv4 *addrs, const uint16_t cnt, uint32_t range[2])
+{
+    if (cnt > 1)
+        return false;
+    if (cnt == 0 || addrs == NULL) {
+        range[0] = 1;
+        range[1] = 0;
+    } else {
+        range[0] = addrs[0].ip;
+        range[1] = addrs[0].ip2;
+    }
+    return true;
+}
+
+void SigHeaderSummaryFree(SigHeaderSummary *hdr)
+{
+    SCFree(hdr->src4);
+    SCFree(hdr->dst4);
+    SCFree(hdr->sp);
+    SCFree(hdr->dp);
+    SCFree(hdr->flags);
+    memset(hdr, 0, sizeof(*hdr));
+}
+
+/** \internal
+ *  \brief build the rule header summary for the sigs in sig_array
+ *
+ *  Summarizes the checks of DetectRunInspectRuleHeader() that are cheap to
+ *  do on the candidate list after prefilter. Anything that can't be
+ *  summarized is left to the full header inspection. */
+static int SigHeaderSummaryBuild(DetectEngineCtx *de_ctx)
+{
+    SigHeaderSummary *hdr = &de_ctx->sig_hdr;
+    const uint32_t len = de_ctx->sig_array_len;
+
+    SigHeaderSummaryFree(hdr);
+    if (len == 0)
+        return 0;
+
+    hdr->src4 = SCCalloc(len, sizeof(hdr->src4[0]));
+    hdr->dst4 = SCCalloc(len, sizeof(hdr->dst4[0]));
+    hdr->sp = SCCalloc(len, sizeof(hdr->sp[0]));
+    hdr->dp = SCCalloc(len, sizeof(hdr->dp[0]));
+    hdr->flags = SCCalloc(len, sizeof(hdr->flags[0]));
+    if (hdr->src4 == NULL || hdr->dst4 == NULL || hdr->sp == NULL || hdr->dp == NULL ||
+            hdr->flags == NULL) {
+        SigHeaderSummaryFree(hdr);
+        return -1;
+    }
+
+    for (const Signature *s = de_ctx->sig_list; s != NULL; s = s->next) {
+        const SigIntId id = s->iid;
+        uint8_t flags = 0;
+
+        if (s->proto != NULL) {
+            if (s->proto->flags & DETECT_PROTO_IPV4)
+                flags |= SIG_HDR_IPV4;
+            if (s->proto->flags & DETECT_PROTO_IPV6)
+                flags |= SIG_HDR_IPV6;
+        }
+        if (!(s->flags & SIG_FLAG_SP_ANY)) {
+            flags |= SIG_HDR_PORTS;
+            if (SigHeaderPortRange(s->sp, hdr->sp[id]))
+                flags |= SIG_HDR_SP;
+        }
+        if (!(s->flags & SIG_FLAG_DP_ANY)) {
+            flags |= SIG_HDR_PORTS;
+            if (SigHeaderPortRange(s->dp, hdr->dp[id]))
+                flags |= SIG_HDR_DP;
+        }
+        if (!(s->flags & SIG_FLAG_SRC_ANY) &&
+                SigHeaderAddressRange(s->addr_src_match4, s->addr_src_match4_cnt, hdr->src4[id]))
+            flags |= SIG_HDR_SRC4;
+        if (!(s->flags & SIG_FLAG_DST_ANY) &&
+                SigHeaderAddressRange(s->addr_dst_match4, s->addr_dst_match4_cnt, hdr->dst4[id]))
+            flags |= SIG_HDR_DST4;
+
+        hdr->flags[id] = flags;
+    }
+    return 0;
+}
+
 /**
  * \brief Preprocess signature, classify ip-only, etc, build sig array
  *
@@ -1898,6 +2026,9 @@ int SigPrepareStage1(DetectEngineCtx *de_ctx)
     if (DetectFlowbitsAnalyze(de_ctx) != 0)
         goto error;
 
+    if (SigHeaderSummaryBuild(de_ctx) != 0)
+        goto error;
+
     return 0;
 
 error:
@@ -1962,6 +2093,13 @@ int SigPrepareStage2(DetectEngineCtx *de_ctx)
     de_ctx->flow_gh[1].udp = RulesGroupByPorts(de_ctx, IPPROTO_UDP, SIG_FLAG_TOSERVER);
     de_ctx->flow_gh[0].udp = RulesGroupByPorts(de_ctx, IPPROTO_UDP, SIG_FLAG_TOCLIENT);
 
+    /* direct lookup tables for the port groups. On failure the lookup
+     * falls back to the lists. */
+    for (int f = 0; f < FLOW_STATES; f++) {
+        de_ctx->flow_gh[f].tcp_table = DetectPortTableBuild(de_ctx->flow_gh[f].tcp);
+        de_ctx->flow_gh[f].udp_table = DetectPortTableBuild(de_ctx->flow_gh[f].udp);
+    }
+
     /* Setup the other IP Protocols (so not TCP/UDP) */
     RulesGroupByIPProto(de_ctx);
 
@@ -2087,7 +2225,11 @@ int SigAddressCleanupStage1(DetectEngineCtx *de_ctx)
             de_ctx->flow_gh[f].sgh[p] = NULL;
         }
 
-        /* free lookup lists */
+        /* free lookup tables and lists */
+        DetectPortTableFree(de_ctx->flow_gh[f].tcp_table);
+        de_ctx->flow_gh[f].tcp_table = NULL;
+        DetectPortTableFree(de_ctx->flow_gh[f].udp_table);
+        de_ctx->flow_gh[f].udp_table = NULL;
         DetectPortCleanupList(de_ctx, de_ctx->flow_gh[f].tcp);
         de_ctx->flow_gh[f].tcp = NULL;
         DetectPortCleanupList(de_ctx, de_ctx->flow_gh[f].udp);
@@ -2162,6 +2304,9 @@ int SigPrepareStage4(DetectEngineCtx *de_ctx)
 
         SigGroupHeadSetupFiles(de_ctx, sgh);
         SCLogDebug("filestore count %u", sgh->filestore_cnt);
+        if (de_ctx->auto_bypass) {
+            SigGroupHeadSetupAutoBypass(de_ctx, sgh);
+        }
 
         PrefilterSetupRuleGroup(de_ctx, sgh);
 
@@ -2360,6 +2505,10 @@ int SigGroupBuild(DetectEngineCtx *de_ctx)
     if (EngineModeIsFirewall()) {
         FirewallAnalyzer(de_ctx);
     }
+    DetectEngineTrimFeaturesReport();
+    if (de_ctx->ea != NULL) {
+        FeatureAnalyzer(de_ctx);
+    }
     return 0;
 }
 
@@ -26,9 +26,11 @@ int SignatureIsFilemagicInspecting(const Signature *);
 int SignatureIsFileMd5Inspecting(const Signature *);
 int SignatureIsFileSha1Inspecting(const Signature *s);
 int SignatureIsFileSha256Inspecting(const Signature *s);
+bool SignatureIsHttpResponseBodyInspecting(const Signature *s);
 void SignatureSetType(DetectEngineCtx *de_ctx, Signature *s);
 
 int SigPrepareStage1(DetectEngineCtx *de_ctx);
+void SigHeaderSummaryFree(SigHeaderSummary *hdr);
 int SigPrepareStage2(DetectEngineCtx *de_ctx);
 int SigPrepareStage3(DetectEngineCtx *de_ctx);
 int SigPrepareStage4(DetectEngineCtx *de_ctx);
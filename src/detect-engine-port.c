@@ -598,6 +598,104 @@ DetectPort *DetectPortLookupGroup(DetectPort *dp, uint16_t port)
     return NULL;
 }
 
+/**
+ * \brief Build a lookup table for a port group list
+ *
+ * The table gives the same result as DetectPortLookupGroup() on the list.
+ *
+ * \param list port group list, sorted and non-overlapping
+ *
+ * \retval table or NULL on error
+ */
+DetectPortTable *DetectPortTableBuild(const DetectPort *list)
+{
+    uint16_t *ids = NULL;
+    uint16_t *blocks = NULL;
+    DetectPortTable *t = SCCalloc(1, sizeof(*t));
+    if (t == NULL)
+        goto error;
+
+    /* rule group index per port. Index 0 is no rule group. */
+    ids = SCCalloc(65536, sizeof(uint16_t));
+    if (ids == NULL)
+        goto error;
+    uint32_t sghs_cnt = 1;
+    for (const DetectPort *dp = list; dp != NULL; dp = dp->next) {
+        if (dp->sh == NULL)
+            continue;
+        uint32_t id = 0;
+        for (uint32_t i = 1; i < sghs_cnt; i++) {
+            if (t->sghs[i] == dp->sh) {
+                id = i;
+                break;
+            }
+        }
+        if (id == 0) {
+            if (sghs_cnt > UINT16_MAX)
+                goto error;
+            void *ptmp = SCRealloc(t->sghs, (sghs_cnt + 1) * sizeof(struct SigGroupHead_ *));
+            if (ptmp == NULL)
+                goto error;
+            t->sghs = ptmp;
+            t->sghs[0] = NULL;
+            id = sghs_cnt++;
+            t->sghs[id] = dp->sh;
+        }
+        /* first match wins, like in DetectPortLookupGroup() */
+        for (uint32_t port = dp->port; port <= dp->port2; port++) {
+            if (ids[port] == 0)
+                ids[port] = (uint16_t)id;
+        }
+    }
+    if (t->sghs == NULL) {
+        t->sghs = SCCalloc(1, sizeof(struct SigGroupHead_ *));
+        if (t->sghs == NULL)
+            goto error;
+    }
+
+    /* store each distinct block once */
+    blocks = SCMalloc(65536 * sizeof(uint16_t));
+    if (blocks == NULL)
+        goto error;
+    uint32_t nblocks = 0;
+    for (uint32_t b = 0; b < 256; b++) {
+        const uint16_t *block = &ids[b << 8];
+        uint32_t i = 0;
+        for (; i < nblocks; i++) {
+            if (memcmp(&blocks[i << 8], block, 256 * sizeof(uint16_t)) == 0)
+                break;
+        }
+        if (i == nblocks) {
+            memcpy(&blocks[i << 8], block, 256 * sizeof(uint16_t));
+            nblocks++;
+        }
+        t->l1[b] = (uint16_t)i;
+    }
+    SCFree(ids);
+    ids = NULL;
+
+    t->blocks = SCRealloc(blocks, (size_t)nblocks * 256 * sizeof(uint16_t));
+    if (t->blocks == NULL)
+        goto error;
+    SCLogDebug("port table: %u rule groups, %u blocks", sghs_cnt - 1, nblocks);
+    return t;
+
+error:
+    SCFree(ids);
+    SCFree(blocks);
+    DetectPortTableFree(t);
+    return NULL;
+}
+
+void DetectPortTableFree(DetectPortTable *t)
+{
+    if (t == NULL)
+        return;
+    SCFree(t->blocks);
+    SCFree(t->sghs);
+    SCFree(t);
+}
+
 /**
  * \brief Checks if two port group lists are equal.
  *
@@ -1793,6 +1891,36 @@ static int PortTestFunctions07(void)
     PASS;
 }
 
+/**
+ * \test Test the port lookup table against the list lookup
+ */
+static int PortTestFunctions08(void)
+{
+    DetectPort *dd = NULL;
+    FAIL_IF_NOT(DetectPortParse(NULL, &dd, "[1:80,![2,4],443,1024:65535,!8080]") == 0);
+
+    /* fake rule groups, shared by some of the ranges */
+    SigGroupHead sghs[2];
+    int i = 0;
+    for (DetectPort *p = dd; p != NULL; p = p->next) {
+        p->sh = &sghs[i++ % 2];
+        p->flags |= PORT_SIGGROUPHEAD_COPY;
+    }
+
+    DetectPortTable *t = DetectPortTableBuild(dd);
+    FAIL_IF_NULL(t);
+    for (uint32_t port = 0; port <= UINT16_MAX; port++) {
+        DetectPort *p = DetectPortLookupGroup(dd, (uint16_t)port);
+        FAIL_IF_NOT(DetectPortTableLookup(t, (uint16_t)port) == (p ? p->sh : NULL));
+    }
+    FAIL_IF_NOT_NULL(DetectPortTableLookup(t, 0));
+    FAIL_IF_NOT_NULL(DetectPortTableLookup(t, 8080));
+
+    DetectPortTableFree(t);
+    DetectPortCleanupList(NULL, dd);
+    PASS;
+}
+
 /**
  * \test Test packet Matches
  * \param raw_eth_pkt pointer to the ethernet packet
@@ -2182,6 +2310,7 @@ void DetectPortTests(void)
     UtRegisterTest("PortTestFunctions03", PortTestFunctions03);
     UtRegisterTest("PortTestFunctions04", PortTestFunctions04);
     UtRegisterTest("PortTestFunctions07", PortTestFunctions07);
+    UtRegisterTest("PortTestFunctions08", PortTestFunctions08);
     UtRegisterTest("PortTestMatchReal01", PortTestMatchReal01);
     UtRegisterTest("PortTestMatchReal02", PortTestMatchReal02);
     UtRegisterTest("PortTestMatchReal03", PortTestMatchReal03);
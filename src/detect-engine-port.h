@@ -50,6 +50,17 @@ void DetectPortCleanupList (const DetectEngineCtx *de_ctx, DetectPort *head);
 
 DetectPort *DetectPortLookupGroup(DetectPort *dp, uint16_t port);
 
+DetectPortTable *DetectPortTableBuild(const DetectPort *list);
+void DetectPortTableFree(DetectPortTable *t);
+
+/** \brief get the rule group of a port from a table
+ *  \retval sgh or NULL if the port has no rule group */
+static inline struct SigGroupHead_ *DetectPortTableLookup(
+        const DetectPortTable *t, const uint16_t port)
+{
+    return t->sghs[t->blocks[((uint32_t)t->l1[port >> 8] << 8) | (port & 0xff)]];
+}
+
 bool DetectPortListsAreEqual(DetectPort *list1, DetectPort *list2);
 
 void DetectPortPrint(DetectPort *);
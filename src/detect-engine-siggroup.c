@@ -173,6 +173,8 @@ void SigGroupHeadFree(const DetectEngineCtx *de_ctx, SigGroupHead *sgh)
     }
 
     PrefilterCleanupRuleGroup(de_ctx, sgh);
+    if (sgh->alprotos != NULL)
+        SCFree(sgh->alprotos);
     SCFree(sgh);
 }
 
@@ -589,6 +591,10 @@ void SigGroupHeadSetupFiles(const DetectEngineCtx *de_ctx, SigGroupHead *sgh)
             sgh->flags |= SIG_GROUP_HEAD_HAVEFILESHA256;
             SCLogDebug("sgh %p has filesha256", sgh);
         }
+        if (SignatureIsHttpResponseBodyInspecting(s)) {
+            sgh->flags |= SIG_GROUP_HEAD_HAVEHTTPRESPBODY;
+            SCLogDebug("sgh %p has http response body", sgh);
+        }
 #ifdef HAVE_MAGIC
         if (SignatureIsFilemagicInspecting(s)) {
             sgh->flags |= SIG_GROUP_HEAD_HAVEFILEMAGIC;
@@ -602,6 +608,61 @@ void SigGroupHeadSetupFiles(const DetectEngineCtx *de_ctx, SigGroupHead *sgh)
     }
 }
 
+static int SigGroupHeadAddAppProto(SigGroupHead *sgh, AppProto alproto)
+{
+    for (uint16_t i = 0; i < sgh->alprotos_cnt; i++) {
+        if (sgh->alprotos[i] == alproto)
+            return 0;
+    }
+    AppProto *ptr = SCRealloc(sgh->alprotos, (sgh->alprotos_cnt + 1) * sizeof(AppProto));
+    if (ptr == NULL)
+        return -1;
+    sgh->alprotos = ptr;
+    sgh->alprotos[sgh->alprotos_cnt++] = alproto;
+    return 0;
+}
+
+/**
+ *  \brief Record which flows the rules of a sgh can still match.
+ *
+ *  Rules without an app-layer protocol can match any flow, for the others
+ *  the protocols are stored so that detect can tell if a flow with a known
+ *  protocol has any rules left.
+ *
+ *  \param de_ctx detection engine ctx for the signatures
+ *  \param sgh sig group head to update
+ */
+void SigGroupHeadSetupAutoBypass(const DetectEngineCtx *de_ctx, SigGroupHead *sgh)
+{
+    if (sgh == NULL)
+        return;
+
+    for (uint32_t sig = 0; sig < sgh->init->sig_cnt; sig++) {
+        const Signature *s = sgh->init->match_array[sig];
+        if (s == NULL)
+            continue;
+
+        if (s->alproto != ALPROTO_UNKNOWN) {
+            if (SigGroupHeadAddAppProto(sgh, s->alproto) < 0)
+                goto error;
+        } else if (s->init_data->alprotos[0] != ALPROTO_UNKNOWN) {
+            for (AppProto i = 0; i < SIG_ALPROTO_MAX; i++) {
+                if (s->init_data->alprotos[i] == ALPROTO_UNKNOWN)
+                    break;
+                if (SigGroupHeadAddAppProto(sgh, s->init_data->alprotos[i]) < 0)
+                    goto error;
+            }
+        } else {
+            sgh->flags |= SIG_GROUP_HEAD_HAVEPKTRULES;
+            SCLogDebug("sgh %p has rules for any app-layer protocol", sgh);
+        }
+    }
+    return;
+error:
+    /* without the list we have to assume any flow can match */
+    sgh->flags |= SIG_GROUP_HEAD_HAVEPKTRULES;
+}
+
 /**
  * \brief Check if a SigGroupHead contains a Signature, whose sid is sent as an
  *        argument.
@@ -987,6 +1048,43 @@ static int SigGroupHeadTest06(void)
     StatsThreadCleanup(&th_v.stats);
     PASS;
 }
+
+/**
+ * \test auto bypass info of the rule groups.
+ */
+static int SigGroupHeadTest07(void)
+{
+    DetectEngineCtx *de_ctx = DetectEngineCtxInit();
+    FAIL_IF_NULL(de_ctx);
+    de_ctx->auto_bypass = true;
+
+    Signature *s = DetectEngineAppendSig(de_ctx,
+            "alert http any any -> any any (http.uri; content:\"/x\"; sid:1; rev:1;)");
+    FAIL_IF_NULL(s);
+    s = DetectEngineAppendSig(
+            de_ctx, "alert tcp any any -> any 80 (content:\"y\"; sid:2; rev:1;)");
+    FAIL_IF_NULL(s);
+    SigGroupBuild(de_ctx);
+
+    Packet *p = UTHBuildPacketReal(NULL, 0, IPPROTO_TCP, "1.2.3.4", "5.6.7.8", 41424, 873);
+    FAIL_IF_NULL(p);
+    p->flowflags |= FLOW_PKT_TOSERVER;
+    const SigGroupHead *sgh = SigMatchSignaturesGetSgh(de_ctx, p);
+    FAIL_IF_NULL(sgh);
+    FAIL_IF(sgh->flags & SIG_GROUP_HEAD_HAVEPKTRULES);
+    FAIL_IF_NOT(sgh->alprotos_cnt == 1);
+    FAIL_IF_NOT(AppProtoEquals(sgh->alprotos[0], ALPROTO_HTTP1));
+    FAIL_IF(AppProtoEquals(sgh->alprotos[0], ALPROTO_FAILED));
+
+    p->dp = 80;
+    sgh = SigMatchSignaturesGetSgh(de_ctx, p);
+    FAIL_IF_NULL(sgh);
+    FAIL_IF_NOT(sgh->flags & SIG_GROUP_HEAD_HAVEPKTRULES);
+
+    UTHFreePackets(&p, 1);
+    DetectEngineCtxFree(de_ctx);
+    PASS;
+}
 #endif
 
 void SigGroupHeadRegisterTests(void)
@@ -998,5 +1096,6 @@ void SigGroupHeadRegisterTests(void)
     UtRegisterTest("SigGroupHeadTest04", SigGroupHeadTest04);
     UtRegisterTest("SigGroupHeadTest05", SigGroupHeadTest05);
     UtRegisterTest("SigGroupHeadTest06", SigGroupHeadTest06);
+    UtRegisterTest("SigGroupHeadTest07", SigGroupHeadTest07);
 #endif
 }
@@ -2792,6 +2792,7 @@ void DetectEngineCtxFree(DetectEngineCtx *de_ctx)
     SigCleanSignatures(de_ctx);
     if (de_ctx->sig_array)
         SCFree(de_ctx->sig_array);
+    SigHeaderSummaryFree(&de_ctx->sig_hdr);
 
     if (de_ctx->filedata_config)
         SCFree(de_ctx->filedata_config);
@@ -3094,6 +3095,15 @@ static int DetectEngineCtxLoadConf(DetectEngineCtx *de_ctx)
         }
     }
 
+    int auto_bypass = 0;
+    if ((SCConfGetBool("detect.auto-bypass", &auto_bypass)) == 1 && auto_bypass == 1) {
+        if (EngineModeIsFirewall()) {
+            SCLogWarning("detect.auto-bypass is not supported in firewall mode, disabling");
+        } else {
+            de_ctx->auto_bypass = true;
+        }
+    }
+
     /* parse port grouping priority settings */
 
     const char *ports = NULL;
@@ -3543,6 +3553,12 @@ TmEcode DetectEngineThreadCtxInit(ThreadVars *tv, void *initdata, void **data)
     }
     det_ctx->counter_alerts_suppressed =
             StatsRegisterCounter("detect.alerts_suppressed", &tv->stats);
+    if (det_ctx->de_ctx->auto_bypass) {
+        det_ctx->counter_auto_bypass_no_rules =
+                StatsRegisterCounter("detect.auto_bypass.no_rules", &tv->stats);
+        det_ctx->counter_auto_bypass_no_app_proto_rules =
+                StatsRegisterCounter("detect.auto_bypass.no_app_proto_rules", &tv->stats);
+    }
 
     /* Register counter for Lua rule errors. */
     det_ctx->lua_rule_errors = StatsRegisterCounter("detect.lua.errors", &tv->stats);
@@ -3630,6 +3646,12 @@ DetectEngineThreadCtx *DetectEngineThreadCtxInitForReload(
     }
     det_ctx->counter_alerts_suppressed =
             StatsRegisterCounter("detect.alerts_suppressed", &tv->stats);
+    if (det_ctx->de_ctx->auto_bypass) {
+        det_ctx->counter_auto_bypass_no_rules =
+                StatsRegisterCounter("detect.auto_bypass.no_rules", &tv->stats);
+        det_ctx->counter_auto_bypass_no_app_proto_rules =
+                StatsRegisterCounter("detect.auto_bypass.no_app_proto_rules", &tv->stats);
+    }
 #ifdef PROFILING
     det_ctx->counter_mpm_list = StatsRegisterAvgCounter("detect.mpm_list", &tv->stats);
     det_ctx->counter_match_list = StatsRegisterAvgCounter("detect.match_list", &tv->stats);
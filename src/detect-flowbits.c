@@ -1037,14 +1037,11 @@ static void PrefilterFlowbitMatch(DetectEngineThreadCtx *det_ctx, Packet *p, con
         SCReturn;
     }
 
-    for (GenericVar *gv = p->flow->flowvar; gv != NULL; gv = gv->next) {
-        if (gv->type != DETECT_FLOWBITS)
-            continue;
-
+    for (uint32_t idx = FlowBitNext(p->flow, 0); idx != 0; idx = FlowBitNext(p->flow, idx)) {
         PrefilterFlowbit lookup;
         memset(&lookup, 0, sizeof(lookup));
-        lookup.id = gv->idx;
-        SCLogDebug("flowbit %u", gv->idx);
+        lookup.id = idx;
+        SCLogDebug("flowbit %u", idx);
 
         PrefilterFlowbit *b = PFB_RB_FIND(&ctx->fb_tree, &lookup);
         if (b == NULL) {
@@ -1056,7 +1053,7 @@ static void PrefilterFlowbitMatch(DetectEngineThreadCtx *det_ctx, Packet *p, con
 #ifdef DEBUG
             for (uint32_t x = 0; x < b->rule_id_cnt; x++) {
                 const Signature *s = det_ctx->de_ctx->sig_array[b->rule_id[x]];
-                SCLogDebug("flowbit %u -> sig %u", gv->idx, s->id);
+                SCLogDebug("flowbit %u -> sig %u", idx, s->id);
             }
 #endif
         }
@@ -1635,18 +1632,14 @@ static int FlowBitsTestSig06(void)
     DetectEngineThreadCtx *det_ctx = NULL;
     DetectEngineCtx *de_ctx = NULL;
     Flow f;
-    GenericVar flowvar, *gv = NULL;
-    int result = 0;
     uint32_t idx = 0;
 
     memset(&th_v, 0, sizeof(th_v));
     StatsThreadInit(&th_v.stats);
     memset(&f, 0, sizeof(Flow));
-    memset(&flowvar, 0, sizeof(GenericVar));
 
     FLOW_INITIALIZE(&f);
     p->flow = &f;
-    p->flow->flowvar = &flowvar;
 
     p->src.family = AF_INET;
     p->dst.family = AF_INET;
@@ -1671,14 +1664,7 @@ static int FlowBitsTestSig06(void)
 
     SigMatchSignatures(&th_v, de_ctx, det_ctx, p);
 
-    gv = p->flow->flowvar;
-    FAIL_IF_NULL(gv);
-    for ( ; gv != NULL; gv = gv->next) {
-        if (gv->type == DETECT_FLOWBITS && gv->idx == idx) {
-                result = 1;
-        }
-    }
-    FAIL_IF_NOT(result);
+    FAIL_IF_NOT(FlowBitIsset(p->flow, idx));
 
     PacketFree(p);
     FLOW_DESTROY(&f);
@@ -1710,18 +1696,14 @@ static int FlowBitsTestSig07(void)
     DetectEngineThreadCtx *det_ctx = NULL;
     DetectEngineCtx *de_ctx = NULL;
     Flow f;
-    GenericVar flowvar, *gv = NULL;
-    int result = 0;
     uint32_t idx = 0;
 
     memset(&th_v, 0, sizeof(th_v));
     StatsThreadInit(&th_v.stats);
     memset(&f, 0, sizeof(Flow));
-    memset(&flowvar, 0, sizeof(GenericVar));
 
     FLOW_INITIALIZE(&f);
     p->flow = &f;
-    p->flow->flowvar = &flowvar;
 
     p->src.family = AF_INET;
     p->dst.family = AF_INET;
@@ -1747,15 +1729,7 @@ static int FlowBitsTestSig07(void)
 
     SigMatchSignatures(&th_v, de_ctx, det_ctx, p);
 
-    gv = p->flow->flowvar;
-    FAIL_IF_NULL(gv);
-
-    for ( ; gv != NULL; gv = gv->next) {
-        if (gv->type == DETECT_FLOWBITS && gv->idx == idx) {
-                result = 1;
-        }
-    }
-    FAIL_IF(result);
+    FAIL_IF(FlowBitIsset(p->flow, idx));
 
     PacketFree(p);
     FLOW_DESTROY(&f);
@@ -776,6 +776,12 @@ static int DetectLuaSetup (DetectEngineCtx *de_ctx, Signature *s, const char *st
         goto error;
     }
 
+    /* scripts on http txs can access the bodies through the http lib */
+    if (s->alproto == ALPROTO_HTTP1 || s->alproto == ALPROTO_HTTP) {
+        AppLayerHtpEnableRequestBodyCallback();
+        AppLayerHtpEnableResponseBodyCallback();
+    }
+
     return 0;
 
 error:
@@ -142,6 +142,8 @@ static InspectionBuffer *GetData(DetectEngineThreadCtx *det_ctx,
             connp = &ssl_state->server_connp;
         }
 
+        SSLStateCertDecode(connp, SSL_CERT0_FINGERPRINT);
+
         if (connp->cert0_fingerprint == NULL) {
             return NULL;
         }
@@ -144,6 +144,8 @@ static InspectionBuffer *GetData(DetectEngineThreadCtx *det_ctx,
             connp = &ssl_state->server_connp;
         }
 
+        SSLStateCertDecode(connp, SSL_CERT0_FIELDS);
+
         if (connp->cert0_serial == NULL) {
             return NULL;
         }
@@ -134,6 +134,8 @@ static InspectionBuffer *GetData(DetectEngineThreadCtx *det_ctx,
             connp = &ssl_state->server_connp;
         }
 
+        SSLStateCertDecode(connp, SSL_CERT0_FIELDS);
+
         if (connp->cert0_subject == NULL) {
             return NULL;
         }
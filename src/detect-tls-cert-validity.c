@@ -164,6 +164,8 @@ static int DetectTlsValidityMatch (DetectEngineThreadCtx *det_ctx,
     else
         connp = &ssl_state->server_connp;
 
+    SSLStateCertDecode(connp, SSL_CERT0_FIELDS);
+
     const DetectTlsValidityData *dd = (const DetectTlsValidityData *)ctx;
 
     time_t cert_epoch = 0;
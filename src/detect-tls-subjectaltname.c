@@ -62,6 +62,7 @@ static bool TlsSubjectAltNameGetData(DetectEngineThreadCtx *det_ctx, const void
     const SSLStateConnp *connp;
 
     connp = &ssl_state->server_connp;
+    SSLStateCertDecode(connp, SSL_CERT0_FIELDS);
 
     if (idx >= connp->cert0_sans_num) {
         return false;
@@ -183,6 +183,8 @@ static int DetectTlsSubjectMatch (DetectEngineThreadCtx *det_ctx,
         connp = &ssl_state->server_connp;
     }
 
+    SSLStateCertDecode(connp, SSL_CERT0_FIELDS);
+
     if (connp->cert0_subject != NULL) {
         SCLogDebug("TLS: Subject is [%s], looking for [%s]\n",
                    connp->cert0_subject, tls_data->subject);
@@ -374,6 +376,8 @@ static int DetectTlsIssuerDNMatch (DetectEngineThreadCtx *det_ctx,
         connp = &ssl_state->server_connp;
     }
 
+    SSLStateCertDecode(connp, SSL_CERT0_FIELDS);
+
     if (connp->cert0_issuerdn != NULL) {
         SCLogDebug("TLS: IssuerDN is [%s], looking for [%s]\n",
                    connp->cert0_issuerdn, tls_data->issuerdn);
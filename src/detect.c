@@ -25,10 +25,12 @@
 
 #include "suricata-common.h"
 #include "suricata.h"
+#include "conf.h"
 
 #include "decode.h"
 #include "packet.h"
 #include "flow.h"
+#include "flow-bit.h"
 #include "flow-bindgen.h"
 #include "stream-tcp.h"
 #include "app-layer.h"
@@ -88,7 +90,7 @@ static inline void DetectRunPrefilterPkt(ThreadVars *tv, const DetectEngineCtx *
         DetectEngineThreadCtx *det_ctx, Packet *p, DetectRunScratchpad *scratch);
 static inline uint8_t DetectRulePacketRules(ThreadVars *const tv,
         const DetectEngineCtx *const de_ctx, DetectEngineThreadCtx *const det_ctx, Packet *const p,
-        Flow *const pflow, const DetectRunScratchpad *scratch);
+        Flow *const pflow, const DetectRunScratchpad *scratch, const bool fw);
 static void DetectRunTx(ThreadVars *tv, DetectEngineCtx *de_ctx,
         DetectEngineThreadCtx *det_ctx, Packet *p,
         Flow *f, DetectRunScratchpad *scratch);
@@ -96,16 +98,19 @@ static void DetectRunFrames(ThreadVars *tv, DetectEngineCtx *de_ctx, DetectEngin
         Packet *p, Flow *f, DetectRunScratchpad *scratch);
 static inline void DetectRunPostRules(ThreadVars *tv, const DetectEngineCtx *de_ctx,
         DetectEngineThreadCtx *det_ctx, Packet *const p, Flow *const pflow,
-        DetectRunScratchpad *scratch);
+        DetectRunScratchpad *scratch, const bool fw);
 static void DetectRunCleanup(DetectEngineThreadCtx *det_ctx,
         Packet *p, Flow * const pflow);
+static void DetectRunAutoBypass(
+        ThreadVars *tv, DetectEngineThreadCtx *det_ctx, Packet *p, Flow *f);
 static inline void DetectRunAppendDefaultAccept(DetectEngineThreadCtx *det_ctx, Packet *p);
 
 /** \internal
+ *  \param fw firewall mode. Only called through DetectRunIDS() and
+ *         DetectRunFirewall(), which pass it as a constant.
  */
-static void DetectRun(ThreadVars *th_v,
-        DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx,
-        Packet *p)
+static inline void DetectRun(ThreadVars *th_v, DetectEngineCtx *de_ctx,
+        DetectEngineThreadCtx *det_ctx, Packet *p, const bool fw)
 {
     SCEnter();
     SCLogDebug("pcap_cnt %" PRIu64 " direction %s pkt_src %s", PcapPacketCntGet(p),
@@ -128,7 +133,7 @@ static void DetectRun(ThreadVars *th_v,
     /* if we didn't get a sig group head, we
      * have nothing to do.... */
     if (scratch.sgh == NULL) {
-        if (!EngineModeIsFirewall()) {
+        if (!fw) {
             SCLogDebug("no sgh for this packet, nothing to match against");
             goto end;
         }
@@ -140,7 +145,7 @@ static void DetectRun(ThreadVars *th_v,
     }
     PACKET_PROFILING_DETECT_START(p, PROF_DETECT_RULES);
     /* inspect the rules against the packet */
-    const uint8_t pkt_policy = DetectRulePacketRules(th_v, de_ctx, det_ctx, p, pflow, &scratch);
+    const uint8_t pkt_policy = DetectRulePacketRules(th_v, de_ctx, det_ctx, p, pflow, &scratch, fw);
     PACKET_PROFILING_DETECT_END(p, PROF_DETECT_RULES);
     SCLogDebug("packet %" PRIu64 ": pkt_policy %02x (p->action %02x)", PcapPacketCntGet(p),
             pkt_policy, p->action);
@@ -161,7 +166,7 @@ static void DetectRun(ThreadVars *th_v,
         if (p->proto == IPPROTO_TCP) {
             if ((p->flags & PKT_STREAM_EST) == 0) {
                 SCLogDebug("packet %" PRIu64 ": skip tcp non-established", PcapPacketCntGet(p));
-                if (EngineModeIsFirewall()) {
+                if (fw) {
                     SCLogDebug("default accept: no PKT_STREAM_EST");
                     DetectRunAppendDefaultAccept(det_ctx, p);
                 }
@@ -184,7 +189,7 @@ static void DetectRun(ThreadVars *th_v,
                     ((PKT_IS_TOSERVER(p) && (p->flow->flags & FLOW_TS_APP_UPDATED) == 0) ||
                             (PKT_IS_TOCLIENT(p) && (p->flow->flags & FLOW_TC_APP_UPDATED) == 0))) {
                 SCLogDebug("packet %" PRIu64 ": no app-layer update", PcapPacketCntGet(p));
-                if (EngineModeIsFirewall()) {
+                if (fw) {
                     SCLogDebug("default accept: no app update");
                     DetectRunAppendDefaultAccept(det_ctx, p);
                 }
@@ -204,19 +209,42 @@ static void DetectRun(ThreadVars *th_v,
         PACKET_PROFILING_DETECT_END(p, PROF_DETECT_TX_UPDATE);
     } else {
         SCLogDebug("packet %" PRIu64 ": no flow / app-layer", PcapPacketCntGet(p));
-        if (EngineModeIsFirewall()) {
+        if (fw) {
             SCLogDebug("default accept: no flow/app");
             DetectRunAppendDefaultAccept(det_ctx, p);
         }
     }
 
 end:
-    DetectRunPostRules(th_v, de_ctx, det_ctx, p, pflow, &scratch);
+    DetectRunPostRules(th_v, de_ctx, det_ctx, p, pflow, &scratch, fw);
+
+    if (de_ctx->auto_bypass && pflow != NULL && !(pflow->flags & FLOW_AUTO_BYPASS_CHECKED)) {
+        DetectRunAutoBypass(th_v, det_ctx, p, pflow);
+    }
 
     DetectRunCleanup(det_ctx, p, pflow);
     SCReturn;
 }
 
+/** \internal
+ *  \brief per packet detection for IDS/IPS mode
+ *
+ *  Kept out of line, together with DetectRunFirewall(), so there is one
+ *  copy of the detection path per engine mode. */
+static NOINLINE void DetectRunIDS(
+        ThreadVars *th_v, DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx, Packet *p)
+{
+    DetectRun(th_v, de_ctx, det_ctx, p, false);
+}
+
+/** \internal
+ *  \brief per packet detection for firewall mode */
+static NOINLINE void DetectRunFirewall(
+        ThreadVars *th_v, DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx, Packet *p)
+{
+    DetectRun(th_v, de_ctx, det_ctx, p, true);
+}
+
 /** \internal
  */
 static void DetectRunPacketHook(ThreadVars *th_v, const DetectEngineCtx *de_ctx,
@@ -248,14 +276,15 @@ static void DetectRunPacketHook(ThreadVars *th_v, const DetectEngineCtx *de_ctx,
 
     //    PACKET_PROFILING_DETECT_START(p, PROF_DETECT_RULES); // TODO
     /* inspect the rules against the packet */
-    const uint8_t pkt_policy = DetectRulePacketRules(th_v, de_ctx, det_ctx, p, pflow, &scratch);
+    const uint8_t pkt_policy = DetectRulePacketRules(
+            th_v, de_ctx, det_ctx, p, pflow, &scratch, EngineModeIsFirewall());
     //    PACKET_PROFILING_DETECT_END(p, PROF_DETECT_RULES);
     if (pkt_policy & (ACTION_DROP | ACTION_ACCEPT)) {
         goto end;
     }
 
 end:
-    DetectRunPostRules(th_v, de_ctx, det_ctx, p, pflow, &scratch);
+    DetectRunPostRules(th_v, de_ctx, det_ctx, p, pflow, &scratch, EngineModeIsFirewall());
 
     DetectRunCleanup(det_ctx, p, pflow);
     SCReturn;
@@ -324,19 +353,27 @@ const SigGroupHead *SigMatchSignaturesGetSgh(const DetectEngineCtx *de_ctx,
                 de_ctx->flow_gh[0].tcp, de_ctx->flow_gh[dir].tcp);
         const uint16_t port = dir ? p->dp : p->sp;
         SCLogDebug("tcp port %u -> %u:%u", port, p->sp, p->dp);
-        DetectPort *sghport = DetectPortLookupGroup(list, port);
-        if (sghport != NULL)
-            sgh = sghport->sh;
-        SCLogDebug("TCP list %p, port %u, direction %s, sghport %p, sgh %p", list, port,
-                dir ? "toserver" : "toclient", sghport, sgh);
+        if (likely(de_ctx->flow_gh[dir].tcp_table != NULL)) {
+            sgh = DetectPortTableLookup(de_ctx->flow_gh[dir].tcp_table, port);
+        } else {
+            DetectPort *sghport = DetectPortLookupGroup(list, port);
+            if (sghport != NULL)
+                sgh = sghport->sh;
+        }
+        SCLogDebug("TCP list %p, port %u, direction %s, sgh %p", list, port,
+                dir ? "toserver" : "toclient", sgh);
     } else if (proto == IPPROTO_UDP) {
         DetectPort *list = de_ctx->flow_gh[dir].udp;
         uint16_t port = dir ? p->dp : p->sp;
-        DetectPort *sghport = DetectPortLookupGroup(list, port);
-        if (sghport != NULL)
-            sgh = sghport->sh;
-        SCLogDebug("UDP list %p, port %u, direction %s, sghport %p, sgh %p", list, port,
-                dir ? "toserver" : "toclient", sghport, sgh);
+        if (likely(de_ctx->flow_gh[dir].udp_table != NULL)) {
+            sgh = DetectPortTableLookup(de_ctx->flow_gh[dir].udp_table, port);
+        } else {
+            DetectPort *sghport = DetectPortLookupGroup(list, port);
+            if (sghport != NULL)
+                sgh = sghport->sh;
+        }
+        SCLogDebug("UDP list %p, port %u, direction %s, sgh %p", list, port,
+                dir ? "toserver" : "toclient", sgh);
     } else {
         sgh = de_ctx->flow_gh[dir].sgh[proto];
     }
@@ -344,21 +381,75 @@ const SigGroupHead *SigMatchSignaturesGetSgh(const DetectEngineCtx *de_ctx,
     SCReturnPtr(sgh, "SigGroupHead");
 }
 
+static inline int SigHeaderOutOfRange(const uint16_t v, const uint16_t range[2])
+{
+    return (v < range[0]) | (v > range[1]);
+}
+
+static inline int SigHeaderOutOfRange4(const uint32_t v, const uint32_t range[2])
+{
+    return (v < range[0]) | (v > range[1]);
+}
+
+/** \internal
+ *  \brief copy the prefilter candidates to the match array
+ *
+ *  Candidates are deduplicated and filtered using the rule header
+ *  summary, so rules that can't match the packet header are dropped
+ *  without touching their Signature. The checks are a subset of
+ *  DetectRunInspectRuleHeader(), which is still run for the survivors. */
 static inline void DetectPrefilterCopyDeDup(
-        const DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx)
+        const DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx, const Packet *p)
 {
     SigIntId *pf_ptr = det_ctx->pmq.rule_id_array;
     uint32_t final_cnt = det_ctx->pmq.rule_id_array_cnt;
     Signature **sig_array = de_ctx->sig_array;
     Signature **match_array = det_ctx->match_array;
     SigIntId previous_id = (SigIntId)-1;
+
+    /* summary flags that fail for this packet, and those that need
+     * their range checked against it */
+    const SigHeaderSummary *hdr = &de_ctx->sig_hdr;
+    uint8_t fail = 0;
+    uint8_t check = 0;
+    uint32_t src4 = 0, dst4 = 0;
+    uint16_t sp = 0, dp = 0;
+    if (PacketIsIPv4(p)) {
+        check |= SIG_HDR_SRC4 | SIG_HDR_DST4;
+        src4 = SCNtohl(p->src.addr_data32[0]);
+        dst4 = SCNtohl(p->dst.addr_data32[0]);
+    } else {
+        fail |= SIG_HDR_IPV4;
+    }
+    if (!PacketIsIPv6(p)) {
+        fail |= SIG_HDR_IPV6;
+    }
+    if ((p->proto == IPPROTO_TCP || p->proto == IPPROTO_UDP || p->proto == IPPROTO_SCTP) &&
+            !(p->flags & PKT_IS_FRAGMENT)) {
+        check |= SIG_HDR_SP | SIG_HDR_DP;
+        sp = p->sp;
+        dp = p->dp;
+    } else {
+        fail |= SIG_HDR_PORTS;
+    }
+
     while (final_cnt-- > 0) {
         SigIntId id = *pf_ptr++;
-        Signature *s = sig_array[id];
 
         /* As the prefilter list can contain duplicates, check for that here. */
         if (likely(id != previous_id)) {
-            *match_array++ = s;
+            /* evaluate all checks without branching, most candidates
+             * of broad fast patterns fail one of them */
+            const uint8_t flags = hdr->flags[id];
+            const uint8_t c = flags & check;
+            const int skip =
+                    ((flags & fail) != 0) |
+                    (((c & SIG_HDR_SP) != 0) & SigHeaderOutOfRange(sp, hdr->sp[id])) |
+                    (((c & SIG_HDR_DP) != 0) & SigHeaderOutOfRange(dp, hdr->dp[id])) |
+                    (((c & SIG_HDR_SRC4) != 0) & SigHeaderOutOfRange4(src4, hdr->src4[id])) |
+                    (((c & SIG_HDR_DST4) != 0) & SigHeaderOutOfRange4(dst4, hdr->dst4[id]));
+            *match_array = sig_array[id];
+            match_array += !skip;
             previous_id = id;
         }
     }
@@ -498,6 +589,85 @@ static inline void DetectRunGetRuleGroup(
     scratch->sgh = sgh;
 }
 
+/** \internal
+ *  \brief check if the parser of a protocol can hand the flow over to
+ *         another protocol, e.g. STARTTLS or HTTP CONNECT. */
+static bool DetectAutoBypassAppProtoMayChange(const AppProto alproto)
+{
+    switch (alproto) {
+        case ALPROTO_HTTP1:
+        case ALPROTO_HTTP2:
+        case ALPROTO_SMTP:
+        case ALPROTO_FTP:
+        case ALPROTO_POP3:
+        case ALPROTO_LDAP:
+        case ALPROTO_PGSQL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** \internal
+ *  \brief bypass the flow if no rule of its rule groups can match it
+ *
+ *  Checked once per flow: when the rule group of both directions is known
+ *  and protocol detection has finished. The flow is bypassed if:
+ *  - none of the rules is a packet or stream rule, so all rules are tied
+ *    to an app-layer protocol
+ *  - none of those protocols is the protocol of the flow
+ *  - no transaction, file or streaming logger needs the flow's data
+ */
+static void DetectRunAutoBypass(
+        ThreadVars *tv, DetectEngineThreadCtx *det_ctx, Packet *p, Flow *f)
+{
+    if ((f->flags & (FLOW_SGH_TOSERVER | FLOW_SGH_TOCLIENT)) !=
+            (FLOW_SGH_TOSERVER | FLOW_SGH_TOCLIENT))
+        return;
+    if (PKT_IS_PSEUDOPKT(p) || PacketGetIPProto(p) != f->proto)
+        return;
+    const AppProto alproto = f->alproto;
+    if (alproto == ALPROTO_UNKNOWN || (f->flags & FLOW_CHANGE_PROTO))
+        return;
+
+    /* from here on the outcome won't change until the next rule reload */
+    f->flags |= FLOW_AUTO_BYPASS_CHECKED;
+
+    if (f->flags & (FLOW_ACTION_DROP | FLOW_ACTION_PASS))
+        return;
+    if (f->proto == IPPROTO_TCP && stream_config.streaming_log_api)
+        return;
+    if (alproto != ALPROTO_FAILED && AppLayerParserProtocolGetLoggerBits(f->proto, alproto) != 0)
+        return;
+
+    bool have_rules = false;
+    const SigGroupHead *sghs[2] = { f->sgh_toserver, f->sgh_toclient };
+    for (int i = 0; i < 2; i++) {
+        const SigGroupHead *sgh = sghs[i];
+        if (sgh == NULL)
+            continue;
+        if (sgh->flags & SIG_GROUP_HEAD_HAVEPKTRULES)
+            return;
+        for (uint16_t j = 0; j < sgh->alprotos_cnt; j++) {
+            if (AppProtoEquals(sgh->alprotos[j], alproto))
+                return;
+        }
+        if (sgh->alprotos_cnt > 0)
+            have_rules = true;
+    }
+    /* rules for another protocol could still match after an upgrade */
+    if (have_rules && DetectAutoBypassAppProtoMayChange(alproto))
+        return;
+
+    SCLogDebug("flow %p: no rules left for alproto %s, bypassing", f, AppProtoToString(alproto));
+    if (have_rules) {
+        StatsCounterIncr(&tv->stats, det_ctx->counter_auto_bypass_no_app_proto_rules);
+    } else {
+        StatsCounterIncr(&tv->stats, det_ctx->counter_auto_bypass_no_rules);
+    }
+    PacketBypassCallback(p);
+}
+
 static void DetectRunInspectIPOnly(ThreadVars *tv, const DetectEngineCtx *de_ctx,
         DetectEngineThreadCtx *det_ctx,
         Flow * const pflow, Packet * const p)
@@ -533,7 +703,7 @@ static inline bool DetectRunInspectRuleHeader(
         DEBUG_VALIDATE_BUG_ON(f == NULL);
 
         /* no flowvars? skip this sig */
-        const bool fv = f->flowvar != NULL;
+        const bool fv = f->flowvar != NULL || FlowBitAnySet(f);
         if (!fv) {
             SCLogDebug("skipping sig as the flow has no flowvars and sig "
                     "has SIG_FLAG_REQUIRE_FLOWVAR flag set.");
@@ -635,7 +805,7 @@ static inline void DetectRunPrefilterPkt(ThreadVars *tv, const DetectEngineCtx *
         }
 #endif
         PACKET_PROFILING_DETECT_START(p, PROF_DETECT_PF_SORT2);
-        DetectPrefilterCopyDeDup(de_ctx, det_ctx);
+        DetectPrefilterCopyDeDup(de_ctx, det_ctx, p);
         PACKET_PROFILING_DETECT_END(p, PROF_DETECT_PF_SORT2);
     }
 }
@@ -746,11 +916,11 @@ static uint8_t DetectRunApplyPacketPolicy(const DetectEngineCtx *de_ctx,
 
 static inline uint8_t DetectRulePacketRules(ThreadVars *const tv,
         const DetectEngineCtx *const de_ctx, DetectEngineThreadCtx *const det_ctx, Packet *const p,
-        Flow *const pflow, const DetectRunScratchpad *scratch)
+        Flow *const pflow, const DetectRunScratchpad *scratch, const bool fw)
 {
     uint8_t action = 0;
     bool fw_verdict = false;
-    const bool have_fw_rules = EngineModeIsFirewall();
+    const bool have_fw_rules = fw;
     const Signature *next_s = NULL;
 
     /* inspect the sigs against the packet */
@@ -769,7 +939,7 @@ static inline uint8_t DetectRulePacketRules(ThreadVars *const tv,
         RulesDumpMatchArray(det_ctx, scratch->sgh, p);
 #endif
 
-    bool skip_fw = SkipFwRules(p);
+    bool skip_fw = fw && SkipFwRules(p);
     uint32_t sflags, next_sflags = 0;
     if (match_cnt) {
         next_s = *match_array++;
@@ -1067,12 +1237,14 @@ static DetectRunScratchpad DetectRunSetup(const DetectEngineCtx *de_ctx,
             /* first time we inspect flow with this de_ctx, reset */
             pflow->flags &= ~FLOW_SGH_TOSERVER;
             pflow->flags &= ~FLOW_SGH_TOCLIENT;
+            pflow->flags &= ~FLOW_AUTO_BYPASS_CHECKED;
             pflow->sgh_toserver = NULL;
             pflow->sgh_toclient = NULL;
 
             pflow->de_ctx_version = de_ctx->version;
             SCGenericVarFree(pflow->flowvar);
             pflow->flowvar = NULL;
+            FlowBitsFree(pflow);
 
             DetectEngineStateResetTxs(pflow);
         }
@@ -1105,7 +1277,7 @@ static DetectRunScratchpad DetectRunSetup(const DetectEngineCtx *de_ctx,
 
 static inline void DetectRunPostRules(ThreadVars *tv, const DetectEngineCtx *de_ctx,
         DetectEngineThreadCtx *det_ctx, Packet *const p, Flow *const pflow,
-        DetectRunScratchpad *scratch)
+        DetectRunScratchpad *scratch, const bool fw)
 {
     /* so now let's iterate the alerts and remove the ones after a pass rule
      * matched (if any). This is done inside PacketAlertFinalize() */
@@ -1133,8 +1305,7 @@ static inline void DetectRunPostRules(ThreadVars *tv, const DetectEngineCtx *de_
     /* firewall: "fail" closed if we don't have an ACCEPT. This can happen
      * if there was no rule group. */
     // TODO review packet src types here
-    if (EngineModeIsFirewall() && ((p->action & (ACTION_ACCEPT | ACTION_DROP)) == 0) &&
-            p->pkt_src == PKT_SRC_WIRE) {
+    if (fw && ((p->action & (ACTION_ACCEPT | ACTION_DROP)) == 0) && p->pkt_src == PKT_SRC_WIRE) {
         SCLogDebug("packet %" PRIu64 ": default action as no verdict set %02x (pkt %s)",
                 PcapPacketCntGet(p), p->action, PktSrcToString(p->pkt_src));
         (void)DetectRunApplyPacketPolicy(de_ctx, det_ctx, scratch->fw_pkt_policy, p, true);
@@ -2801,9 +2972,8 @@ static DetectEngineThreadCtx *GetTenantById(HashTable *h, uint32_t id)
     return HashTableLookup(h, &id, 0);
 }
 
-static void DetectFlow(ThreadVars *tv,
-                       DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx,
-                       Packet *p)
+static ALWAYS_INLINE void DetectFlow(ThreadVars *tv, DetectEngineCtx *de_ctx,
+        DetectEngineThreadCtx *det_ctx, Packet *p, const bool fw)
 {
     Flow *const f = p->flow;
 
@@ -2817,7 +2987,7 @@ static void DetectFlow(ThreadVars *tv,
 
     /* in firewall mode, we still need to run the fw rulesets even for exception policy pass */
     bool skip = (p->flags & PKT_NOPACKET_INSPECTION || f->flags & (FLOW_ACTION_PASS));
-    if (EngineModeIsFirewall() && (f->flags & FLOW_ACTION_ACCEPT) == 0) {
+    if (fw && (f->flags & FLOW_ACTION_ACCEPT) == 0) {
         skip = false;
     }
     if (skip) {
@@ -2843,13 +3013,15 @@ static void DetectFlow(ThreadVars *tv,
     }
 
     /* see if the packet matches one or more of the sigs */
-    DetectRun(tv, de_ctx, det_ctx, p);
+    if (fw) {
+        DetectRunFirewall(tv, de_ctx, det_ctx, p);
+    } else {
+        DetectRunIDS(tv, de_ctx, det_ctx, p);
+    }
 }
 
-
-static void DetectNoFlow(ThreadVars *tv,
-                         DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx,
-                         Packet *p)
+static ALWAYS_INLINE void DetectNoFlow(ThreadVars *tv, DetectEngineCtx *de_ctx,
+        DetectEngineThreadCtx *det_ctx, Packet *p, const bool fw)
 {
     /* No need to perform any detection on this packet, if the given flag is set.*/
     if ((p->flags & PKT_NOPACKET_INSPECTION) || (PacketCheckAction(p, ACTION_DROP))) {
@@ -2857,7 +3029,74 @@ static void DetectNoFlow(ThreadVars *tv,
     }
 
     /* see if the packet matches one or more of the sigs */
-    DetectRun(tv, de_ctx, det_ctx, p);
+    if (fw) {
+        DetectRunFirewall(tv, de_ctx, det_ctx, p);
+    } else {
+        DetectRunIDS(tv, de_ctx, det_ctx, p);
+    }
+}
+
+/* Variants of the per packet detection for the engine modes. The engine
+ * mode doesn't change at runtime, so the variant is selected once. */
+typedef void (*DetectPacketFunc)(
+        ThreadVars *tv, DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx, Packet *p);
+
+static void DetectPacketIDS(
+        ThreadVars *tv, DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx, Packet *p)
+{
+    if (p->flow) {
+        DetectFlow(tv, de_ctx, det_ctx, p, false);
+    } else {
+        DetectNoFlow(tv, de_ctx, det_ctx, p, false);
+    }
+}
+
+static void DetectPacketFirewall(
+        ThreadVars *tv, DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx, Packet *p)
+{
+    if (p->flow) {
+        DetectFlow(tv, de_ctx, det_ctx, p, true);
+    } else {
+        DetectNoFlow(tv, de_ctx, det_ctx, p, true);
+    }
+}
+
+/** \internal
+ *  \brief used until DetectRunSelectProfile() is called, e.g. in unittests */
+static void DetectPacketGeneric(
+        ThreadVars *tv, DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx, Packet *p)
+{
+    if (EngineModeIsFirewall()) {
+        DetectPacketFirewall(tv, de_ctx, det_ctx, p);
+    } else {
+        DetectPacketIDS(tv, de_ctx, det_ctx, p);
+    }
+}
+
+static DetectPacketFunc DetectPacket = DetectPacketGeneric;
+
+/** multi-detect is enabled. Tenants can only be registered if it is, so
+ *  without it Detect() skips the tenant lookup. */
+static bool detect_multi_tenant = true;
+
+/** \brief select the detection variant for the engine mode
+ *
+ *  Must be called after the engine mode is set and before the packet
+ *  threads start. */
+void DetectRunSelectProfile(void)
+{
+    if (EngineModeIsFirewall()) {
+        DetectPacket = DetectPacketFirewall;
+    } else {
+        DetectPacket = DetectPacketIDS;
+    }
+
+    int mt_enabled = 0;
+    (void)SCConfGetBool("multi-detect.enabled", &mt_enabled);
+    detect_multi_tenant = mt_enabled != 0;
+
+    SCLogConfig("detect: using %s variant, multi-tenant %s",
+            EngineModeIsFirewall() ? "firewall" : "IDS/IPS", BOOL2STR(detect_multi_tenant));
 }
 
 uint8_t DetectPreFlow(ThreadVars *tv, DetectEngineThreadCtx *det_ctx, Packet *p)
@@ -2908,8 +3147,7 @@ TmEcode Detect(ThreadVars *tv, Packet *p, void *data)
 
     /* if in MT mode _and_ we have tenants registered, use
      * MT logic. */
-    if (det_ctx->mt_det_ctxs_cnt > 0 && det_ctx->TenantGetId != NULL)
-    {
+    if (detect_multi_tenant && det_ctx->mt_det_ctxs_cnt > 0 && det_ctx->TenantGetId != NULL) {
         uint32_t tenant_id = p->tenant_id;
         if (tenant_id == 0)
             tenant_id = det_ctx->TenantGetId(det_ctx, p);
@@ -2934,11 +3172,7 @@ TmEcode Detect(ThreadVars *tv, Packet *p, void *data)
         de_ctx = det_ctx->de_ctx;
     }
 
-    if (p->flow) {
-        DetectFlow(tv, de_ctx, det_ctx, p);
-    } else {
-        DetectNoFlow(tv, de_ctx, det_ctx, p);
-    }
+    DetectPacket(tv, de_ctx, det_ctx, p);
 
 #ifdef PROFILE_RULES
     /* aggregate statistics */
@@ -2971,11 +3205,7 @@ void DisableDetectFlowFileFlags(Flow *f)
 void SigMatchSignatures(
         ThreadVars *tv, DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx, Packet *p)
 {
-    if (p->flow) {
-        DetectFlow(tv, de_ctx, det_ctx, p);
-    } else {
-        DetectNoFlow(tv, de_ctx, det_ctx, p);
-    }
+    DetectPacketGeneric(tv, de_ctx, det_ctx, p);
 }
 #endif
 
@@ -866,9 +866,25 @@ typedef struct DetectEngineIPOnlyCtx_ {
     uint32_t sig_mapping_size;
 } DetectEngineIPOnlyCtx;
 
+/** \brief two level port to rule group lookup table
+ *
+ *  Built from a port group list. The high byte of the port selects a
+ *  block of 256 entries, the low byte the entry in it. Blocks with the
+ *  same content are stored once. Entries are indexes in sghs, where 0 is
+ *  no rule group. */
+typedef struct DetectPortTable_ {
+    uint16_t l1[256];
+    uint16_t *blocks;
+    struct SigGroupHead_ **sghs;
+} DetectPortTable;
+
 typedef struct DetectEngineLookupFlow_ {
     DetectPort *tcp;
     DetectPort *udp;
+    /* lookup tables for the tcp and udp lists. NULL if they couldn't be
+     * built, in which case the lists are used. */
+    DetectPortTable *tcp_table;
+    DetectPortTable *udp_table;
     struct SigGroupHead_ *sgh[256];
 } DetectEngineLookupFlow;
 
@@ -969,6 +985,31 @@ typedef uint8_t (*DetectPacketHookFunc)(ThreadVars *tv, DetectEngineThreadCtx *d
 typedef uint8_t (*SCDetectRateFilterFunc)(const Packet *p, uint32_t sid, uint32_t gid, uint32_t rev,
         uint8_t original_action, uint8_t new_action, void *arg);
 
+/* rule header summary flags */
+#define SIG_HDR_IPV4  BIT_U8(0) /**< needs an IPv4 packet */
+#define SIG_HDR_IPV6  BIT_U8(1) /**< needs an IPv6 packet */
+#define SIG_HDR_PORTS BIT_U8(2) /**< sp and/or dp is not 'any' */
+#define SIG_HDR_SP    BIT_U8(3) /**< sp is the single range sp[] */
+#define SIG_HDR_DP    BIT_U8(4) /**< dp is the single range dp[] */
+#define SIG_HDR_SRC4  BIT_U8(5) /**< IPv4 src is the single range src4[] */
+#define SIG_HDR_DST4  BIT_U8(6) /**< IPv4 dst is the single range dst4[] */
+
+/** \brief summary of the rule headers as a structure of arrays, indexed
+ *         by Signature::iid
+ *
+ *  Holds the subset of the DetectRunInspectRuleHeader() checks that can be
+ *  done with a few compares, so prefilter candidates can be dropped without
+ *  touching the Signature. Rules with lists of ports or addresses only get
+ *  the flags, and are fully checked later. The flowvar requirement is not
+ *  part of it, as rules matching earlier on the same packet can set them. */
+typedef struct SigHeaderSummary_ {
+    uint32_t (*src4)[2]; /**< host order lo, hi */
+    uint32_t (*dst4)[2];
+    uint16_t (*sp)[2];
+    uint16_t (*dp)[2];
+    uint8_t *flags;
+} SigHeaderSummary;
+
 /** \brief main detection engine ctx */
 typedef struct DetectEngineCtx_ {
     bool failure_fatal;
@@ -990,6 +1031,8 @@ typedef struct DetectEngineCtx_ {
 
     Signature **sig_array;
     uint32_t sig_array_len;  /* size in array members */
+    /* header summary of the sigs in sig_array */
+    SigHeaderSummary sig_hdr;
 
     uint32_t signum;
 
@@ -1022,6 +1065,9 @@ typedef struct DetectEngineCtx_ {
     /* force app-layer tx finding for alerts with signatures not having app-layer keywords */
     bool guess_applayer;
 
+    /* bypass flows that no rule in their rule groups can match */
+    bool auto_bypass;
+
     /* registration id for per thread ctx for the filemagic/file.magic keywords */
     int filemagic_thread_ctx_id;
 
@@ -1340,6 +1386,9 @@ typedef struct DetectEngineThreadCtx_ {
     StatsCounterId counter_firewall_discarded_alerts;
     /** id for suppressed alerts counter */
     StatsCounterId counter_alerts_suppressed;
+    /** ids for the auto bypass counters, per reason */
+    StatsCounterId counter_auto_bypass_no_rules;
+    StatsCounterId counter_auto_bypass_no_app_proto_rules;
 #ifdef PROFILING
     StatsCounterAvgId counter_mpm_list;
     StatsCounterAvgId counter_match_list;
@@ -1543,6 +1592,10 @@ enum {
 // vacancy
 #define SIG_GROUP_HEAD_HAVEFILESHA1   BIT_U16(4)
 #define SIG_GROUP_HEAD_HAVEFILESHA256 BIT_U16(5)
+/** group has rules that are not tied to an app-layer protocol */
+#define SIG_GROUP_HEAD_HAVEPKTRULES BIT_U16(6)
+/** group has rules that need the decompressed http response body */
+#define SIG_GROUP_HEAD_HAVEHTTPRESPBODY BIT_U16(7)
 
 enum MpmBuiltinBuffers {
     MPMB_TCP_PKT_TS,
@@ -1692,6 +1745,11 @@ typedef struct SigGroupHead_ {
     PrefilterEngine *frame_engines;
     PrefilterEngine *post_rule_match_engines; /**< engines to run after rules modified a state */
 
+    /** app-layer protocols of the app-layer rules in this group. Only set
+     *  if detect.auto-bypass is enabled. */
+    AppProto *alprotos;
+    uint16_t alprotos_cnt;
+
     /* ptr to our init data we only use at... init :) */
     SigGroupHeadInitData *init;
 
@@ -1755,6 +1813,7 @@ extern SigTableElmt *sigmatch_table;
 
 /* detection api */
 TmEcode Detect(ThreadVars *tv, Packet *p, void *data);
+void DetectRunSelectProfile(void);
 uint8_t DetectPreFlow(ThreadVars *tv, DetectEngineThreadCtx *det_ctx, Packet *p);
 uint8_t DetectPreStream(ThreadVars *tv, DetectEngineThreadCtx *det_ctx, Packet *p);
 
@@ -24,7 +24,11 @@
  * but called that way because of Snort's flowbits.
  * It's a binary storage.
  *
- * \todo move away from a linked list implementation
+ * The bits are stored in a bitset in the flow, indexed by the flowbit id.
+ * Flowbit ids are numbered densely by the variable name store, so the
+ * bitset stays small. Ids below 64 are stored inline in the flow, higher
+ * ids in an array that is grown on demand.
+ *
  * \todo use different datatypes, such as string, int, etc.
  * \todo have more than one instance of the same var, and be able to match on a
  *       specific one, or one all at a time. So if a certain capture matches
@@ -42,49 +46,42 @@
 #include "util-debug.h"
 #include "util-unittest.h"
 
-/* get the flowbit with idx from the flow */
-static FlowBit *FlowBitGet(Flow *f, uint32_t idx)
-{
-    GenericVar *gv = f->flowvar;
-    for ( ; gv != NULL; gv = gv->next) {
-        if (gv->type == DETECT_FLOWBITS && gv->idx == idx) {
-            return (FlowBit *)gv;
-        }
-    }
+#define FLOWBIT_WORD_BITS 64
 
-    return NULL;
+/* get the word for the flowbit with idx, NULL if not allocated */
+static uint64_t *FlowBitGetWord(Flow *f, uint32_t idx)
+{
+    FlowBitStore *fbs = &f->flowbits;
+    const uint32_t w = idx / FLOWBIT_WORD_BITS;
+    if (w == 0)
+        return &fbs->bits;
+    if (fbs->ext == NULL || w >= fbs->ext[0])
+        return NULL;
+    return &fbs->ext[w];
 }
 
-/** \brief add a flowbit to the flow
- *  \retval -1 error
- *  \retval 0 not added, already set before
- *  \retval 1 added */
-static int FlowBitAdd(Flow *f, uint32_t idx)
+/* get the word for the flowbit with idx, growing the bitset if needed */
+static uint64_t *FlowBitGetWordAlloc(Flow *f, uint32_t idx)
 {
-    FlowBit *fb = FlowBitGet(f, idx);
-    if (fb == NULL) {
-        fb = SCMalloc(sizeof(FlowBit));
-        if (unlikely(fb == NULL))
-            return -1;
-
-        fb->type = DETECT_FLOWBITS;
-        fb->idx = idx;
-        fb->next = NULL;
-        GenericVarAppend(&f->flowvar, (GenericVar *)fb);
-        return 1;
-    } else {
-        return 0;
-    }
+    uint64_t *word = FlowBitGetWord(f, idx);
+    if (word != NULL)
+        return word;
+
+    FlowBitStore *fbs = &f->flowbits;
+    const uint32_t size = idx / FLOWBIT_WORD_BITS + 1;
+    const uint32_t old_size = fbs->ext ? (uint32_t)fbs->ext[0] : 1;
+    uint64_t *ext = SCRealloc(fbs->ext, size * sizeof(uint64_t));
+    if (unlikely(ext == NULL))
+        return NULL;
+    memset(ext + old_size, 0, (size - old_size) * sizeof(uint64_t));
+    ext[0] = size;
+    fbs->ext = ext;
+    return &ext[size - 1];
 }
 
-static void FlowBitRemove(Flow *f, uint32_t idx)
+static inline uint64_t FlowBitMask(uint32_t idx)
 {
-    FlowBit *fb = FlowBitGet(f, idx);
-    if (fb == NULL)
-        return;
-
-    GenericVarRemove(&f->flowvar, (GenericVar *)fb);
-    FlowBitFree(fb);
+    return 1ULL << (idx % FLOWBIT_WORD_BITS);
 }
 
 /** \brief add a flowbit to the flow
@@ -93,47 +90,65 @@ static void FlowBitRemove(Flow *f, uint32_t idx)
  *  \retval 1 added */
 int FlowBitSet(Flow *f, uint32_t idx)
 {
-    return FlowBitAdd(f, idx);
+    uint64_t *word = FlowBitGetWordAlloc(f, idx);
+    if (unlikely(word == NULL))
+        return -1;
+    if (*word & FlowBitMask(idx))
+        return 0;
+    *word |= FlowBitMask(idx);
+    return 1;
 }
 
 void FlowBitUnset(Flow *f, uint32_t idx)
 {
-    FlowBitRemove(f, idx);
+    uint64_t *word = FlowBitGetWord(f, idx);
+    if (word != NULL)
+        *word &= ~FlowBitMask(idx);
 }
 
 int FlowBitIsset(Flow *f, uint32_t idx)
 {
-    int r = 0;
-
-    FlowBit *fb = FlowBitGet(f, idx);
-    if (fb != NULL) {
-        r = 1;
-    }
-
-    return r;
+    const uint64_t *word = FlowBitGetWord(f, idx);
+    return (word != NULL && (*word & FlowBitMask(idx)) != 0);
 }
 
 int FlowBitIsnotset(Flow *f, uint32_t idx)
 {
-    int r = 0;
+    return !FlowBitIsset(f, idx);
+}
 
-    FlowBit *fb = FlowBitGet(f, idx);
-    if (fb == NULL) {
-        r = 1;
+/** \brief get the next flowbit that is set
+ *
+ *  Used to walk all set flowbits, starting with idx 0:
+ *  for (uint32_t idx = FlowBitNext(f, 0); idx != 0; idx = FlowBitNext(f, idx))
+ *
+ *  \param idx flowbit to start after. As 0 is not a valid flowbit id, 0
+ *             starts at the first bit.
+ *  \retval idx of the next set flowbit or 0 if there are none */
+uint32_t FlowBitNext(const Flow *f, uint32_t idx)
+{
+    const FlowBitStore *fbs = &f->flowbits;
+    const uint32_t words = fbs->ext ? (uint32_t)fbs->ext[0] : 1;
+    uint32_t i = idx + 1;
+    while (i / FLOWBIT_WORD_BITS < words) {
+        const uint32_t w = i / FLOWBIT_WORD_BITS;
+        uint64_t word = (w == 0) ? fbs->bits : fbs->ext[w];
+        word &= UINT64_MAX << (i % FLOWBIT_WORD_BITS);
+        if (word != 0)
+            return w * FLOWBIT_WORD_BITS + (uint32_t)__builtin_ctzll(word);
+        i = (w + 1) * FLOWBIT_WORD_BITS;
     }
-
-    return r;
+    return 0;
 }
 
-void FlowBitFree(FlowBit *fb)
+/** \brief clear all flowbits and free the out of line storage */
+void FlowBitsFree(Flow *f)
 {
-    if (fb == NULL)
-        return;
-
-    SCFree(fb);
+    SCFree(f->flowbits.ext);
+    f->flowbits.ext = NULL;
+    f->flowbits.bits = 0;
 }
 
-
 /* TESTS */
 #ifdef UNITTESTS
 static int FlowBitTest01 (void)
@@ -141,12 +156,10 @@ static int FlowBitTest01 (void)
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBitAdd(&f, 0);
-
-    FlowBit *fb = FlowBitGet(&f, 0);
-    FAIL_IF_NULL(fb);
+    FAIL_IF_NOT(FlowBitSet(&f, 1) == 1);
+    FAIL_IF_NOT(FlowBitIsset(&f, 1));
 
-    SCGenericVarFree(f.flowvar);
+    FlowBitsFree(&f);
     PASS;
 }
 
@@ -155,10 +168,11 @@ static int FlowBitTest02 (void)
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBit *fb = FlowBitGet(&f, 0);
-    FAIL_IF_NOT_NULL(fb);
+    FAIL_IF(FlowBitIsset(&f, 1));
+    FAIL_IF_NOT(FlowBitIsnotset(&f, 1));
+    FAIL_IF(FlowBitAnySet(&f));
 
-    SCGenericVarFree(f.flowvar);
+    FlowBitsFree(&f);
     PASS;
 }
 
@@ -167,17 +181,14 @@ static int FlowBitTest03 (void)
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBitAdd(&f, 0);
+    FlowBitSet(&f, 1);
+    FAIL_IF_NOT(FlowBitIsset(&f, 1));
 
-    FlowBit *fb = FlowBitGet(&f,0);
-    FAIL_IF_NULL(fb);
+    FlowBitUnset(&f, 1);
+    FAIL_IF(FlowBitIsset(&f, 1));
+    FAIL_IF(FlowBitAnySet(&f));
 
-    FlowBitRemove(&f, 0);
-
-    fb = FlowBitGet(&f, 0);
-    FAIL_IF_NOT_NULL(fb);
-
-    SCGenericVarFree(f.flowvar);
+    FlowBitsFree(&f);
     PASS;
 }
 
@@ -186,88 +197,108 @@ static int FlowBitTest04 (void)
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBitAdd(&f, 0);
-    FlowBitAdd(&f, 1);
-    FlowBitAdd(&f, 2);
-    FlowBitAdd(&f, 3);
+    FlowBitSet(&f, 1);
+    FlowBitSet(&f, 2);
+    FlowBitSet(&f, 3);
+    FlowBitSet(&f, 4);
 
-    FlowBit *fb = FlowBitGet(&f, 0);
-    FAIL_IF_NULL(fb);
+    for (uint32_t i = 1; i <= 4; i++) {
+        FAIL_IF_NOT(FlowBitIsset(&f, i));
+    }
+    FAIL_IF(FlowBitIsset(&f, 5));
 
-    SCGenericVarFree(f.flowvar);
+    FlowBitsFree(&f);
     PASS;
 }
 
+/** \test setting a bit twice */
 static int FlowBitTest05 (void)
 {
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBitAdd(&f, 0);
-    FlowBitAdd(&f, 1);
-    FlowBitAdd(&f, 2);
-    FlowBitAdd(&f, 3);
-
-    FlowBit *fb = FlowBitGet(&f, 1);
-    FAIL_IF_NULL(fb);
+    FAIL_IF_NOT(FlowBitSet(&f, 2) == 1);
+    FAIL_IF_NOT(FlowBitSet(&f, 2) == 0);
+    FAIL_IF_NOT(FlowBitIsset(&f, 2));
 
-    SCGenericVarFree(f.flowvar);
+    FlowBitsFree(&f);
     PASS;
 }
 
+/** \test unset of one bit leaves the others */
 static int FlowBitTest06 (void)
 {
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBitAdd(&f, 0);
-    FlowBitAdd(&f, 1);
-    FlowBitAdd(&f, 2);
-    FlowBitAdd(&f, 3);
-
-    FlowBit *fb = FlowBitGet(&f, 2);
-    FAIL_IF_NULL(fb);
+    for (uint32_t i = 1; i <= 4; i++) {
+        FlowBitSet(&f, i);
+    }
+    for (uint32_t i = 1; i <= 4; i++) {
+        FlowBitUnset(&f, i);
+        FAIL_IF(FlowBitIsset(&f, i));
+        for (uint32_t j = i + 1; j <= 4; j++) {
+            FAIL_IF_NOT(FlowBitIsset(&f, j));
+        }
+    }
 
-    SCGenericVarFree(f.flowvar);
+    FlowBitsFree(&f);
     PASS;
 }
 
+/** \test ids that don't fit the inline word */
 static int FlowBitTest07 (void)
 {
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBitAdd(&f, 0);
-    FlowBitAdd(&f, 1);
-    FlowBitAdd(&f, 2);
-    FlowBitAdd(&f, 3);
-
-    FlowBit *fb = FlowBitGet(&f, 3);
-    FAIL_IF_NULL(fb);
-
-    SCGenericVarFree(f.flowvar);
+    FAIL_IF(FlowBitIsset(&f, 64));
+    FlowBitUnset(&f, 1000);
+    FAIL_IF_NOT_NULL(f.flowbits.ext);
+
+    FAIL_IF_NOT(FlowBitSet(&f, 63) == 1);
+    FAIL_IF_NOT_NULL(f.flowbits.ext);
+    FAIL_IF_NOT(FlowBitSet(&f, 64) == 1);
+    FAIL_IF_NULL(f.flowbits.ext);
+    FAIL_IF_NOT(FlowBitSet(&f, 1000) == 1);
+    FAIL_IF_NOT(FlowBitIsset(&f, 63));
+    FAIL_IF_NOT(FlowBitIsset(&f, 64));
+    FAIL_IF_NOT(FlowBitIsset(&f, 1000));
+    FAIL_IF(FlowBitIsset(&f, 999));
+    FAIL_IF(FlowBitIsset(&f, 1001));
+    FAIL_IF(FlowBitIsset(&f, 100000));
+
+    FlowBitUnset(&f, 64);
+    FAIL_IF(FlowBitIsset(&f, 64));
+    FAIL_IF_NOT(FlowBitIsset(&f, 1000));
+
+    FlowBitsFree(&f);
+    FAIL_IF(FlowBitAnySet(&f));
     PASS;
 }
 
+/** \test walking the set bits */
 static int FlowBitTest08 (void)
 {
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBitAdd(&f, 0);
-    FlowBitAdd(&f, 1);
-    FlowBitAdd(&f, 2);
-    FlowBitAdd(&f, 3);
-
-    FlowBit *fb = FlowBitGet(&f,0);
-    FAIL_IF_NULL(fb);
+    FAIL_IF_NOT(FlowBitNext(&f, 0) == 0);
 
-    FlowBitRemove(&f,0);
+    static const uint32_t ids[] = { 1, 5, 63, 64, 127, 128, 700 };
+    for (size_t i = 0; i < ARRAY_SIZE(ids); i++) {
+        FlowBitSet(&f, ids[i]);
+    }
 
-    fb = FlowBitGet(&f, 0);
-    FAIL_IF_NOT_NULL(fb);
+    size_t n = 0;
+    for (uint32_t idx = FlowBitNext(&f, 0); idx != 0; idx = FlowBitNext(&f, idx)) {
+        FAIL_IF(n >= ARRAY_SIZE(ids));
+        FAIL_IF_NOT(idx == ids[n]);
+        n++;
+    }
+    FAIL_IF_NOT(n == ARRAY_SIZE(ids));
 
-    SCGenericVarFree(f.flowvar);
+    FlowBitsFree(&f);
     PASS;
 }
 
@@ -276,20 +307,21 @@ static int FlowBitTest09 (void)
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBitAdd(&f, 0);
-    FlowBitAdd(&f, 1);
-    FlowBitAdd(&f, 2);
-    FlowBitAdd(&f, 3);
+    FlowBitSet(&f, 0);
+    FlowBitSet(&f, 1);
+    FlowBitSet(&f, 2);
+    FlowBitSet(&f, 3);
 
-    FlowBit *fb = FlowBitGet(&f,1);
-    FAIL_IF_NULL(fb);
+    FAIL_IF_NOT(FlowBitIsset(&f, 1));
 
-    FlowBitRemove(&f,1);
+    FlowBitUnset(&f, 1);
 
-    fb = FlowBitGet(&f, 1);
-    FAIL_IF_NOT_NULL(fb);
+    FAIL_IF(FlowBitIsset(&f, 1));
+    FAIL_IF_NOT(FlowBitIsset(&f, 0));
+    FAIL_IF_NOT(FlowBitIsset(&f, 2));
+    FAIL_IF_NOT(FlowBitIsset(&f, 3));
 
-    SCGenericVarFree(f.flowvar);
+    FlowBitsFree(&f);
     PASS;
 }
 
@@ -298,20 +330,21 @@ static int FlowBitTest10 (void)
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBitAdd(&f, 0);
-    FlowBitAdd(&f, 1);
-    FlowBitAdd(&f, 2);
-    FlowBitAdd(&f, 3);
+    FlowBitSet(&f, 0);
+    FlowBitSet(&f, 1);
+    FlowBitSet(&f, 2);
+    FlowBitSet(&f, 3);
 
-    FlowBit *fb = FlowBitGet(&f,2);
-    FAIL_IF_NULL(fb);
+    FAIL_IF_NOT(FlowBitIsset(&f, 2));
 
-    FlowBitRemove(&f,2);
+    FlowBitUnset(&f, 2);
 
-    fb = FlowBitGet(&f, 2);
-    FAIL_IF_NOT_NULL(fb);
+    FAIL_IF(FlowBitIsset(&f, 2));
+    FAIL_IF_NOT(FlowBitIsset(&f, 0));
+    FAIL_IF_NOT(FlowBitIsset(&f, 1));
+    FAIL_IF_NOT(FlowBitIsset(&f, 3));
 
-    SCGenericVarFree(f.flowvar);
+    FlowBitsFree(&f);
     PASS;
 }
 
@@ -320,20 +353,21 @@ static int FlowBitTest11 (void)
     Flow f;
     memset(&f, 0, sizeof(Flow));
 
-    FlowBitAdd(&f, 0);
-    FlowBitAdd(&f, 1);
-    FlowBitAdd(&f, 2);
-    FlowBitAdd(&f, 3);
+    FlowBitSet(&f, 0);
+    FlowBitSet(&f, 1);
+    FlowBitSet(&f, 2);
+    FlowBitSet(&f, 3);
 
-    FlowBit *fb = FlowBitGet(&f,3);
-    FAIL_IF_NULL(fb);
+    FAIL_IF_NOT(FlowBitIsset(&f, 3));
 
-    FlowBitRemove(&f,3);
+    FlowBitUnset(&f, 3);
 
-    fb = FlowBitGet(&f, 3);
-    FAIL_IF_NOT_NULL(fb);
+    FAIL_IF(FlowBitIsset(&f, 3));
+    FAIL_IF_NOT(FlowBitIsset(&f, 0));
+    FAIL_IF_NOT(FlowBitIsset(&f, 1));
+    FAIL_IF_NOT(FlowBitIsset(&f, 2));
 
-    SCGenericVarFree(f.flowvar);
+    FlowBitsFree(&f);
     PASS;
 }
 
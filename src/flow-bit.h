@@ -27,20 +27,22 @@
 #include "flow.h"
 #include "util-var.h"
 
-typedef struct FlowBit_ {
-    uint16_t type; /* type, DETECT_FLOWBITS in this case */
-    uint8_t pad[2];
-    uint32_t idx; /* name idx */
-    GenericVar *next; /* right now just implement this as a list,
-                       * in the long run we have think of something
-                       * faster. */
-} FlowBit;
-
-void FlowBitFree(FlowBit *);
 void FlowBitRegisterTests(void);
 
 int FlowBitSet(Flow *, uint32_t);
 void FlowBitUnset(Flow *, uint32_t);
 int FlowBitIsset(Flow *, uint32_t);
 int FlowBitIsnotset(Flow *, uint32_t);
+uint32_t FlowBitNext(const Flow *, uint32_t);
+void FlowBitsFree(Flow *);
+
+/** \brief check if any flowbit is set */
+static inline bool FlowBitAnySet(const Flow *f)
+{
+    if (f->flowbits.bits != 0)
+        return true;
+    if (f->flowbits.ext == NULL)
+        return false;
+    return FlowBitNext(f, 0) != 0;
+}
 #endif /* SURICATA_FLOW_BIT_H */
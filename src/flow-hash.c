@@ -1047,7 +1047,7 @@ Flow *FlowGetExistingFlowFromFlowId(uint64_t flow_id)
  *  \param hash Value of the flow hash
  *  \retval f *LOCKED* flow or NULL
  */
-static Flow *FlowGetExistingFlowFromHash(FlowKey *key, const uint32_t hash)
+Flow *FlowGetExistingFlowFromFlowKey(FlowKey *key, const uint32_t hash)
 {
     /* get our hash bucket and lock it */
     FlowBucket *fb = &flow_hash[hash % flow_config.hash_size];
@@ -1084,7 +1084,7 @@ static Flow *FlowGetExistingFlowFromHash(FlowKey *key, const uint32_t hash)
 
 Flow *FlowGetFromFlowKey(FlowKey *key, struct timespec *ttime, const uint32_t hash)
 {
-    Flow *f = FlowGetExistingFlowFromHash(key, hash);
+    Flow *f = FlowGetExistingFlowFromFlowKey(key, hash);
 
     if (f != NULL) {
         return f;
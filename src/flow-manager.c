@@ -63,7 +63,21 @@
 #include "runmode-unix-socket.h"
 
 /** queue to pass flows to cleanup/log thread(s) */
-FlowQueue flow_recycle_q;
+typedef struct FlowRecycleQueue_ {
+    FlowQueue q;
+    /** time the oldest flow in the queue was added, in ns, see StatsLatencyNow() */
+    uint64_t since;
+} FlowRecycleQueue;
+
+/** one recycle queue per flow manager, so managers don't contend on a
+ *  single lock. Recyclers take from their own queue first and then steal
+ *  from the others. */
+static FlowRecycleQueue *flow_recycle_qs = NULL;
+static uint32_t flow_recycle_qs_cnt = 0;
+
+/** hand timed out flows to the worker thread that owns them instead of
+ *  the recyclers, see flow.recycle-in-workers */
+static bool flow_recycle_in_workers = false;
 
 /* multi flow manager support */
 static uint32_t flowmgr_number = 1;
@@ -96,6 +110,96 @@ void FlowWakeupFlowRecyclerThread(void)
     SCCtrlMutexUnlock(&flow_recycler_ctrl_mutex);
 }
 
+/** \brief set up the recycle queues, one per flow manager
+ *  \warning Not thread safe */
+void FlowRecycleQueuesInit(void)
+{
+    intmax_t setting = 1;
+    (void)SCConfGetInt("flow.managers", &setting);
+    if (setting < 1 || setting > 1024) {
+        FatalError("invalid flow.managers setting %" PRIdMAX, setting);
+    }
+
+    flow_recycle_qs = SCCalloc((size_t)setting, sizeof(FlowRecycleQueue));
+    if (flow_recycle_qs == NULL) {
+        FatalError("failed to allocate flow recycle queues");
+    }
+    flow_recycle_qs_cnt = (uint32_t)setting;
+    for (uint32_t u = 0; u < flow_recycle_qs_cnt; u++) {
+        FlowQueueInit(&flow_recycle_qs[u].q);
+    }
+}
+
+/** \brief free the flows left in the recycle queues and the queues
+ *  \warning Not thread safe */
+void FlowRecycleQueuesDestroy(void)
+{
+    for (uint32_t u = 0; u < flow_recycle_qs_cnt; u++) {
+        Flow *f;
+        while ((f = FlowDequeue(&flow_recycle_qs[u].q))) {
+            FlowFree(f);
+        }
+        FlowQueueDestroy(&flow_recycle_qs[u].q);
+    }
+    SCFree(flow_recycle_qs);
+    flow_recycle_qs = NULL;
+    flow_recycle_qs_cnt = 0;
+}
+
+static void FlowRecycleQueueAppend(FlowRecycleQueue *rq, FlowQueuePrivate *fqp)
+{
+    if (fqp->len == 0)
+        return;
+
+    const uint64_t now = StatsLatencyNow();
+    FQLOCK_LOCK(&rq->q);
+    if (rq->q.qlen == 0) {
+        rq->since = now;
+    }
+    FlowQueuePrivateAppendPrivate(&rq->q.priv, fqp);
+    SC_ATOMIC_SET(rq->q.non_empty, true);
+    FQLOCK_UNLOCK(&rq->q);
+    FlowWakeupFlowRecyclerThread();
+}
+
+/** \param since set to the time the oldest extracted flow was queued */
+static FlowQueuePrivate FlowRecycleQueueExtract(FlowRecycleQueue *rq, uint64_t *since)
+{
+    FlowQueuePrivate list = { NULL, NULL, 0 };
+    if (!SC_ATOMIC_GET(rq->q.non_empty))
+        return list;
+
+    FQLOCK_LOCK(&rq->q);
+    list = rq->q.priv;
+    rq->q.qtop = rq->q.qbot = NULL;
+    rq->q.qlen = 0;
+    SC_ATOMIC_SET(rq->q.non_empty, false);
+    *since = rq->since;
+    FQLOCK_UNLOCK(&rq->q);
+    return list;
+}
+
+/** \brief number of flows waiting in the recycle queues, for the stats */
+static uint64_t FlowRecycleQueuesGetDepth(void)
+{
+    uint64_t depth = 0;
+    for (uint32_t u = 0; u < flow_recycle_qs_cnt; u++) {
+        FQLOCK_LOCK(&flow_recycle_qs[u].q);
+        depth += flow_recycle_qs[u].q.qlen;
+        FQLOCK_UNLOCK(&flow_recycle_qs[u].q);
+    }
+    return depth;
+}
+
+static bool FlowRecycleQueuesNonEmpty(void)
+{
+    for (uint32_t u = 0; u < flow_recycle_qs_cnt; u++) {
+        if (SC_ATOMIC_GET(flow_recycle_qs[u].q.non_empty))
+            return true;
+    }
+    return false;
+}
+
 void FlowTimeoutsInit(void)
 {
     SC_ATOMIC_SET(flow_timeouts, flow_timeouts_normal);
@@ -118,6 +222,7 @@ typedef struct FlowTimeoutCounters_ {
     uint32_t flows_removed;
     uint32_t flows_aside;
     uint32_t flows_aside_needs_work;
+    uint32_t flows_aside_to_worker;
 
     uint32_t bypassed_count;
     uint64_t bypassed_pkts;
@@ -278,6 +383,8 @@ typedef struct FlowManagerTimeoutThread {
     /* used to temporarily store flows that have timed out and are
      * removed from the hash to reduce locking contention */
     FlowQueuePrivate aside_queue;
+    /* recycle queue of this flow manager */
+    FlowRecycleQueue *recycle_q;
 } FlowManagerTimeoutThread;
 
 /**
@@ -314,19 +421,24 @@ static uint32_t ProcessAsideQueue(FlowManagerTimeoutThread *td, FlowTimeoutCount
             counters->flows_aside_needs_work++;
             continue;
         }
+        if (flow_recycle_in_workers && FlowHasLocalThread(f)) {
+            /* the worker logs and clears the flow between packets */
+            FlowSendToLocalThread(f);
+            FLOWLOCK_UNLOCK(f);
+
+            counters->flows_aside_to_worker++;
+            cnt++;
+            continue;
+        }
         FLOWLOCK_UNLOCK(f);
 
         FlowQueuePrivateAppendFlow(&recycle, f);
         if (recycle.len == 100) {
-            FlowQueueAppendPrivate(&flow_recycle_q, &recycle);
-            FlowWakeupFlowRecyclerThread();
+            FlowRecycleQueueAppend(td->recycle_q, &recycle);
         }
         cnt++;
     }
-    if (recycle.len) {
-        FlowQueueAppendPrivate(&flow_recycle_q, &recycle);
-        FlowWakeupFlowRecyclerThread();
-    }
+    FlowRecycleQueueAppend(td->recycle_q, &recycle);
     return cnt;
 }
 
@@ -613,6 +725,7 @@ static uint32_t FlowCleanupHash(void)
 {
     FlowQueuePrivate local_queue = { NULL, NULL, 0 };
     uint32_t cnt = 0;
+    uint32_t q = 0;
 
     for (uint32_t idx = 0; idx < flow_config.hash_size; idx++) {
         FlowBucket *fb = &flow_hash[idx];
@@ -630,12 +743,12 @@ static uint32_t FlowCleanupHash(void)
 
         FBLOCK_UNLOCK(fb);
         if (local_queue.len >= RECYCLE_MAX_QUEUE_ITEMS) {
-            FlowQueueAppendPrivate(&flow_recycle_q, &local_queue);
-            FlowWakeupFlowRecyclerThread();
+            /* spread the work over the queues of all the recyclers */
+            FlowRecycleQueueAppend(&flow_recycle_qs[q++ % flow_recycle_qs_cnt], &local_queue);
         }
     }
     DEBUG_VALIDATE_BUG_ON(local_queue.len >= RECYCLE_MAX_QUEUE_ITEMS);
-    FlowQueueAppendPrivate(&flow_recycle_q, &local_queue);
+    FlowRecycleQueueAppend(&flow_recycle_qs[q % flow_recycle_qs_cnt], &local_queue);
     FlowWakeupFlowRecyclerThread();
 
     return cnt;
@@ -654,6 +767,7 @@ typedef struct FlowCounters_ {
     StatsCounterId flow_mgr_flows_timeout;
     StatsCounterId flow_mgr_flows_aside;
     StatsCounterId flow_mgr_flows_aside_needs_work;
+    StatsCounterId flow_mgr_flows_aside_to_worker;
 
     StatsCounterMaxId flow_mgr_rows_maxlen;
 
@@ -693,6 +807,8 @@ static void FlowCountersInit(ThreadVars *t, FlowCounters *fc)
     fc->flow_mgr_flows_aside = StatsRegisterCounter("flow.mgr.flows_evicted", &t->stats);
     fc->flow_mgr_flows_aside_needs_work =
             StatsRegisterCounter("flow.mgr.flows_evicted_needs_work", &t->stats);
+    fc->flow_mgr_flows_aside_to_worker =
+            StatsRegisterCounter("flow.mgr.flows_evicted_to_worker", &t->stats);
 
     fc->flow_bypassed_cnt_clo = StatsRegisterCounter("flow_bypassed.closed", &t->stats);
     fc->flow_bypassed_pkts = StatsRegisterCounter("flow_bypassed.pkts", &t->stats);
@@ -715,6 +831,8 @@ static void FlowCountersUpdate(
     StatsCounterAddI64(&th_v->stats, ftd->cnt.flow_mgr_flows_aside, (int64_t)counters->flows_aside);
     StatsCounterAddI64(&th_v->stats, ftd->cnt.flow_mgr_flows_aside_needs_work,
             (int64_t)counters->flows_aside_needs_work);
+    StatsCounterAddI64(&th_v->stats, ftd->cnt.flow_mgr_flows_aside_to_worker,
+            (int64_t)counters->flows_aside_to_worker);
 
     StatsCounterAddI64(
             &th_v->stats, ftd->cnt.flow_bypassed_cnt_clo, (int64_t)counters->bypassed_count);
@@ -749,6 +867,7 @@ static TmEcode FlowManagerThreadInit(ThreadVars *t, const void *initdata, void *
     BUG_ON(ftd->min > flow_config.hash_size || ftd->max > flow_config.hash_size);
 
     SCLogDebug("instance %u hash range %u %u", ftd->instance, ftd->min, ftd->max);
+    ftd->timeout.recycle_q = &flow_recycle_qs[ftd->instance % flow_recycle_qs_cnt];
 
     /* pass thread data back to caller */
     *data = ftd;
@@ -1018,6 +1137,14 @@ void FlowManagerThreadSpawn(void)
     flowmgr_number = (uint32_t)setting;
 
     SCLogConfig("using %u flow manager threads", flowmgr_number);
+
+    int recycle_in_workers = 0;
+    if (SCConfGetBool("flow.recycle-in-workers", &recycle_in_workers) == 1) {
+        flow_recycle_in_workers = recycle_in_workers != 0;
+    }
+    if (flow_recycle_in_workers) {
+        SCLogConfig("timed out flows are logged and cleared by the worker threads");
+    }
     StatsRegisterGlobalCounter("flow.memuse", FlowGetMemuse);
 
     for (uint32_t u = 0; u < flowmgr_number; u++) {
@@ -1039,10 +1166,14 @@ void FlowManagerThreadSpawn(void)
 
 typedef struct FlowRecyclerThreadData_ {
     void *output_thread_data;
+    /** recycle queue this recycler takes from first */
+    uint32_t home;
 
     StatsCounterId counter_flows;
+    StatsCounterId counter_flows_stolen;
     StatsCounterAvgId counter_queue_avg;
     StatsCounterMaxId counter_queue_max;
+    StatsCounterHistId counter_queue_latency;
 
     StatsCounterId counter_flow_active;
     StatsCounterId counter_tcp_active_sessions;
@@ -1061,9 +1192,14 @@ static TmEcode FlowRecyclerThreadInit(ThreadVars *t, const void *initdata, void
     }
     SCLogDebug("output_thread_data %p", ftd->output_thread_data);
 
+    ftd->home = SC_ATOMIC_ADD(flowrec_cnt, 1) % flow_recycle_qs_cnt;
+
     ftd->counter_flows = StatsRegisterCounter("flow.recycler.recycled", &t->stats);
+    ftd->counter_flows_stolen = StatsRegisterCounter("flow.recycler.stolen", &t->stats);
     ftd->counter_queue_avg = StatsRegisterAvgCounter("flow.recycler.queue_avg", &t->stats);
     ftd->counter_queue_max = StatsRegisterMaxCounter("flow.recycler.queue_max", &t->stats);
+    ftd->counter_queue_latency =
+            StatsRegisterHistogramCounter("flow.recycler.queue_latency", &t->stats);
 
     ftd->counter_flow_active = StatsRegisterCounter("flow.active", &t->stats);
     ftd->counter_tcp_active_sessions = StatsRegisterCounter("tcp.active_sessions", &t->stats);
@@ -1102,32 +1238,33 @@ static void Recycler(ThreadVars *tv, FlowRecyclerThreadData *ftd, Flow *f)
     FLOWLOCK_UNLOCK(f);
 }
 
-/** \brief Thread that manages timed out flows.
+/** \internal
+ *  \brief recycle the flows of all recycle queues
  *
- *  \param td ThreadVars cast to void ptr
- */
-static TmEcode FlowRecycler(ThreadVars *th_v, void *thread_data)
+ *  Our own queue first, then help the other recyclers.
+ *
+ *  \retval number of flows recycled */
+static uint64_t FlowRecyclerProcessQueues(ThreadVars *th_v, FlowRecyclerThreadData *ftd)
 {
-    FlowRecyclerThreadData *ftd = (FlowRecyclerThreadData *)thread_data;
-    BUG_ON(ftd == NULL);
-    const bool time_is_live = TimeModeIsLive();
     uint64_t recycled_cnt = 0;
     FlowQueuePrivate ret_queue = { NULL, NULL, 0 };
 
-    TmThreadsSetFlag(th_v, THV_RUNNING);
-    bool run = TmThreadsWaitForUnpause(th_v);
-
-    while (run) {
-        SC_ATOMIC_ADD(flowrec_busy,1);
-        FlowQueuePrivate list = FlowQueueExtractPrivate(&flow_recycle_q);
-
-        StatsCounterAvgAddI64(&th_v->stats, ftd->counter_queue_avg, (int64_t)list.len);
-        StatsCounterMaxUpdateI64(&th_v->stats, ftd->counter_queue_max, (int64_t)list.len);
-
-        const int bail = (TmThreadsCheckFlag(th_v, THV_KILL));
+    for (uint32_t u = 0; u < flow_recycle_qs_cnt; u++) {
+        FlowRecycleQueue *rq = &flow_recycle_qs[(ftd->home + u) % flow_recycle_qs_cnt];
+        uint64_t since = 0;
+        FlowQueuePrivate list = FlowRecycleQueueExtract(rq, &since);
+        if (u == 0) {
+            StatsCounterAvgAddI64(&th_v->stats, ftd->counter_queue_avg, (int64_t)list.len);
+            StatsCounterMaxUpdateI64(&th_v->stats, ftd->counter_queue_max, (int64_t)list.len);
+        }
+        if (list.len == 0)
+            continue;
 
-        /* Get the time */
-        SCLogDebug("ts %" PRIdMAX "", (intmax_t)SCTIME_SECS(TimeGet()));
+        StatsCounterHistogramRecord(
+                &th_v->stats, ftd->counter_queue_latency, StatsLatencyNow() - since);
+        if (u != 0) {
+            StatsCounterAddI64(&th_v->stats, ftd->counter_flows_stolen, (int64_t)list.len);
+        }
 
         int64_t cnt = 0;
         Flow *f;
@@ -1144,12 +1281,39 @@ static TmEcode FlowRecycler(ThreadVars *th_v, void *thread_data)
         if (ret_queue.len > 0) {
             FlowSparePoolReturnFlows(&ret_queue);
         }
-        if (cnt > 0) {
-            recycled_cnt += cnt;
-            StatsCounterAddI64(&th_v->stats, ftd->counter_flows, cnt);
-        }
+        recycled_cnt += cnt;
+        StatsCounterAddI64(&th_v->stats, ftd->counter_flows, cnt);
+    }
+    return recycled_cnt;
+}
+
+/** \brief Thread that manages timed out flows.
+ *
+ *  \param td ThreadVars cast to void ptr
+ */
+static TmEcode FlowRecycler(ThreadVars *th_v, void *thread_data)
+{
+    FlowRecyclerThreadData *ftd = (FlowRecyclerThreadData *)thread_data;
+    BUG_ON(ftd == NULL);
+    const bool time_is_live = TimeModeIsLive();
+    uint64_t recycled_cnt = 0;
+
+    TmThreadsSetFlag(th_v, THV_RUNNING);
+    bool run = TmThreadsWaitForUnpause(th_v);
+
+    while (run) {
+        SC_ATOMIC_ADD(flowrec_busy,1);
+        const int bail = (TmThreadsCheckFlag(th_v, THV_KILL));
+
+        /* Get the time */
+        SCLogDebug("ts %" PRIdMAX "", (intmax_t)SCTIME_SECS(TimeGet()));
+
+        recycled_cnt += FlowRecyclerProcessQueues(th_v, ftd);
         SC_ATOMIC_SUB(flowrec_busy,1);
 
+        /* write out buffered flow records that are due */
+        (void)OutputFlowLogFlush(th_v, ftd->output_thread_data);
+
         if (bail) {
             break;
         }
@@ -1167,7 +1331,7 @@ static TmEcode FlowRecycler(ThreadVars *th_v, void *thread_data)
                 if (SC_ATOMIC_GET(flow_flags) & FLOW_EMERGENCY) {
                     break;
                 }
-                if (SC_ATOMIC_GET(flow_recycle_q.non_empty)) {
+                if (FlowRecycleQueuesNonEmpty()) {
                     break;
                 }
                 int rc = SCCtrlCondTimedwait(
@@ -1193,12 +1357,14 @@ static bool FlowRecyclerReadyToShutdown(void)
     if (SC_ATOMIC_GET(flowrec_busy) != 0) {
         return false;
     }
-    uint32_t len = 0;
-    FQLOCK_LOCK(&flow_recycle_q);
-    len = flow_recycle_q.qlen;
-    FQLOCK_UNLOCK(&flow_recycle_q);
-
-    return ((len == 0));
+    for (uint32_t u = 0; u < flow_recycle_qs_cnt; u++) {
+        FQLOCK_LOCK(&flow_recycle_qs[u].q);
+        const uint32_t len = flow_recycle_qs[u].q.qlen;
+        FQLOCK_UNLOCK(&flow_recycle_qs[u].q);
+        if (len != 0)
+            return false;
+    }
+    return true;
 }
 
 /** \brief spawn the flow recycler thread */
@@ -1213,6 +1379,7 @@ void FlowRecyclerThreadSpawn(void)
     flowrec_number = (uint32_t)setting;
 
     SCLogConfig("using %u flow recycler threads", flowrec_number);
+    StatsRegisterGlobalCounter("flow.recycler.queue_depth", FlowRecycleQueuesGetDepth);
 
     for (uint32_t u = 0; u < flowrec_number; u++) {
         char name[TM_THREAD_NAME_MAX];
@@ -1323,3 +1490,185 @@ void TmModuleFlowRecyclerRegister (void)
     SC_ATOMIC_INIT(flowrec_cnt);
     SC_ATOMIC_INIT(flowrec_busy);
 }
+
+#ifdef UNITTESTS
+#include "util-unittest.h"
+
+static void FlowMgrTestSetup(void)
+{
+    SCConfCreateContextBackup();
+    SCConfInit();
+    SCConfSet("flow.managers", "2");
+    FlowInitConfig(FLOW_QUIET);
+}
+
+static void FlowMgrTestTeardown(void)
+{
+    FlowShutdown();
+    SCConfDeInit();
+    SCConfRestoreContextBackup();
+}
+
+/** \test append to and extract from the per manager recycle queues */
+static int FlowMgrRecycleQueueTest01(void)
+{
+    FlowMgrTestSetup();
+    FAIL_IF_NOT(flow_recycle_qs_cnt == 2);
+
+    /* appending an empty list is a no-op */
+    FlowQueuePrivate fqp = { NULL, NULL, 0 };
+    FlowRecycleQueueAppend(&flow_recycle_qs[0], &fqp);
+    FAIL_IF(FlowRecycleQueuesNonEmpty());
+
+    Flow *f1 = FlowAlloc();
+    FAIL_IF_NULL(f1);
+    Flow *f2 = FlowAlloc();
+    FAIL_IF_NULL(f2);
+    FlowQueuePrivateAppendFlow(&fqp, f1);
+    FlowQueuePrivateAppendFlow(&fqp, f2);
+    FlowRecycleQueueAppend(&flow_recycle_qs[0], &fqp);
+    FAIL_IF_NOT(fqp.len == 0);
+    FAIL_IF_NOT(flow_recycle_qs[0].q.qlen == 2);
+    FAIL_IF_NOT(SC_ATOMIC_GET(flow_recycle_qs[0].q.non_empty));
+    FAIL_IF(SC_ATOMIC_GET(flow_recycle_qs[1].q.non_empty));
+    FAIL_IF_NOT(FlowRecycleQueuesNonEmpty());
+    FAIL_IF_NOT(FlowRecycleQueuesGetDepth() == 2);
+    const uint64_t queued = flow_recycle_qs[0].since;
+    FAIL_IF(queued == 0);
+
+    /* the other queue is untouched */
+    uint64_t since = 0;
+    FlowQueuePrivate list = FlowRecycleQueueExtract(&flow_recycle_qs[1], &since);
+    FAIL_IF_NOT(list.len == 0);
+    FAIL_IF_NOT(since == 0);
+
+    list = FlowRecycleQueueExtract(&flow_recycle_qs[0], &since);
+    FAIL_IF_NOT(list.len == 2);
+    FAIL_IF_NOT(since == queued);
+    FAIL_IF_NOT(FlowQueuePrivateGetFromTop(&list) == f1);
+    FAIL_IF_NOT(FlowQueuePrivateGetFromTop(&list) == f2);
+    FAIL_IF_NOT(flow_recycle_qs[0].q.qlen == 0);
+    FAIL_IF(FlowRecycleQueuesNonEmpty());
+    FAIL_IF_NOT(FlowRecycleQueuesGetDepth() == 0);
+
+    FlowFree(f1);
+    FlowFree(f2);
+    FlowMgrTestTeardown();
+    PASS;
+}
+
+/** \test a recycler takes the flows of another manager's queue */
+static int FlowMgrRecycleQueueTest02(void)
+{
+    FlowMgrTestSetup();
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(tv));
+    FlowRecyclerThreadData ftd;
+    memset(&ftd, 0, sizeof(ftd));
+    ftd.home = 0;
+    FAIL_IF(OutputFlowLogThreadInit(&tv, &ftd.output_thread_data) != TM_ECODE_OK);
+
+    /* nothing to do */
+    FAIL_IF_NOT(FlowRecyclerProcessQueues(&tv, &ftd) == 0);
+
+    FlowQueuePrivate fqp = { NULL, NULL, 0 };
+    for (int i = 0; i < 3; i++) {
+        Flow *f = FlowAlloc();
+        FAIL_IF_NULL(f);
+        f->proto = IPPROTO_UDP;
+        f->protomap = FlowGetProtoMapping(IPPROTO_UDP);
+        FlowQueuePrivateAppendFlow(&fqp, f);
+    }
+    FlowRecycleQueueAppend(&flow_recycle_qs[1], &fqp);
+    FAIL_IF(SC_ATOMIC_GET(flow_recycle_qs[0].q.non_empty));
+
+    const uint32_t spare = FlowSpareGetPoolSize();
+    FAIL_IF_NOT(FlowRecyclerProcessQueues(&tv, &ftd) == 3);
+    FAIL_IF(FlowRecycleQueuesNonEmpty());
+    /* recycled flows are returned to the spare pool */
+    FAIL_IF_NOT(FlowSpareGetPoolSize() == spare + 3);
+
+    OutputFlowLogThreadDeinit(&tv, ftd.output_thread_data);
+    FlowMgrTestTeardown();
+    PASS;
+}
+
+/** \test with flow.recycle-in-workers timed out flows go to the worker
+ *        that owns them, flows without a worker to the recycle queue */
+static int FlowMgrRecycleQueueTest03(void)
+{
+    FlowMgrTestSetup();
+    const bool saved = flow_recycle_in_workers;
+
+    ThreadVars wtv;
+    memset(&wtv, 0, sizeof(wtv));
+    strlcpy(wtv.name, "W#01", sizeof(wtv.name));
+    wtv.flow_queue = FlowQueueNew();
+    FAIL_IF_NULL(wtv.flow_queue);
+    const int id = TmThreadsRegisterThread(&wtv, TVT_PPT);
+    FAIL_IF_NOT(id > 0);
+
+    FlowManagerTimeoutThread td;
+    memset(&td, 0, sizeof(td));
+    td.recycle_q = &flow_recycle_qs[0];
+    FlowTimeoutCounters counters;
+
+    for (int run = 0; run < 2; run++) {
+        flow_recycle_in_workers = run == 1;
+        memset(&counters, 0, sizeof(counters));
+
+        Flow *fw = FlowAlloc();
+        FAIL_IF_NULL(fw);
+        fw->proto = IPPROTO_UDP;
+        fw->thread_id[0] = (FlowThreadId)id;
+        /* e.g. a flow created for a bypass table has no worker */
+        Flow *fn = FlowAlloc();
+        FAIL_IF_NULL(fn);
+        fn->proto = IPPROTO_UDP;
+
+        FLOWLOCK_WRLOCK(fw);
+        FLOWLOCK_WRLOCK(fn);
+        FlowQueuePrivateAppendFlow(&td.aside_queue, fw);
+        FlowQueuePrivateAppendFlow(&td.aside_queue, fn);
+        FAIL_IF_NOT(ProcessAsideQueue(&td, &counters) == 2);
+        FAIL_IF_NOT(counters.flows_aside == 2);
+
+        uint64_t since = 0;
+        FlowQueuePrivate list = FlowRecycleQueueExtract(&flow_recycle_qs[0], &since);
+        if (flow_recycle_in_workers) {
+            FAIL_IF_NOT(counters.flows_aside_to_worker == 1);
+            FAIL_IF_NOT(wtv.flow_queue->qlen == 1);
+            FAIL_IF_NOT(FlowDequeue(wtv.flow_queue) == fw);
+            FAIL_IF_NOT(list.len == 1);
+            FAIL_IF_NOT(FlowQueuePrivateGetFromTop(&list) == fn);
+        } else {
+            FAIL_IF_NOT(counters.flows_aside_to_worker == 0);
+            FAIL_IF_NOT(wtv.flow_queue->qlen == 0);
+            FAIL_IF_NOT(list.len == 2);
+            FAIL_IF_NOT(FlowQueuePrivateGetFromTop(&list) == fw);
+            FAIL_IF_NOT(FlowQueuePrivateGetFromTop(&list) == fn);
+        }
+        FlowFree(fw);
+        FlowFree(fn);
+    }
+
+    flow_recycle_in_workers = saved;
+    TmThreadsUnregisterThread(id);
+    FlowQueueDestroy(wtv.flow_queue);
+    SCFree(wtv.flow_queue);
+    FlowMgrTestTeardown();
+    PASS;
+}
+#endif /* UNITTESTS */
+
+/**
+ *  \brief Function to register the Flow Manager unit tests.
+ */
+void FlowMgrRegisterTests(void)
+{
+#ifdef UNITTESTS
+    UtRegisterTest("FlowMgrRecycleQueueTest01", FlowMgrRecycleQueueTest01);
+    UtRegisterTest("FlowMgrRecycleQueueTest02", FlowMgrRecycleQueueTest02);
+    UtRegisterTest("FlowMgrRecycleQueueTest03", FlowMgrRecycleQueueTest03);
+#endif /* UNITTESTS */
+}
@@ -30,11 +30,14 @@ void FlowWakeupFlowRecyclerThread(void);
 #define FlowTimeoutsReset() FlowTimeoutsInit()
 void FlowTimeoutsInit(void);
 void FlowTimeoutsEmergency(void);
+void FlowRecycleQueuesInit(void);
+void FlowRecycleQueuesDestroy(void);
 void FlowManagerThreadSpawn(void);
 void FlowDisableFlowManagerThread(void);
 void FlowRecyclerThreadSpawn(void);
 void FlowDisableFlowRecyclerThread(void);
 void TmModuleFlowManagerRegister (void);
 void TmModuleFlowRecyclerRegister (void);
+void FlowMgrRegisterTests(void);
 
 #endif /* SURICATA_FLOW_MANAGER_H */
@@ -87,9 +87,6 @@ extern FlowProtoFreeFunc flow_freefuncs[FLOW_PROTO_MAX];
 /** spare/unused/prealloced flows live here */
 //extern FlowQueue flow_spare_q;
 
-/** queue to pass flows to cleanup/log thread(s) */
-extern FlowQueue flow_recycle_q;
-
 extern FlowBucket *flow_hash;
 extern FlowConfig flow_config;
 
@@ -348,6 +348,17 @@ bool FlowNeedsReassembly(Flow *f)
  *
  * \param f Pointer to the flow.
  */
+/** \brief check if the flow can be sent to the thread that handles it
+ *
+ *  Flows not created by a packet thread, like the ones created for the
+ *  bypass tables, have no thread.
+ */
+bool FlowHasLocalThread(const Flow *f)
+{
+    int idx = f->flags & FLOW_DIR_REVERSED ? 1 : 0;
+    return f->thread_id[idx] != 0;
+}
+
 void FlowSendToLocalThread(Flow *f)
 {
     // Choose the thread_id based on whether the flow has been
@@ -26,6 +26,7 @@
 
 #include "stream-tcp-private.h"
 
+bool FlowHasLocalThread(const Flow *f);
 void FlowSendToLocalThread(Flow *f);
 bool FlowNeedsReassembly(Flow *f);
 void FlowWorkToDoCleanup(void);
@@ -26,6 +26,7 @@
 
 #include "flow.h"
 #include "stream-tcp-private.h"
+#include "flow-bit.h"
 
 #define RESET_COUNTERS(f)                                                                          \
     do {                                                                                           \
@@ -69,6 +70,8 @@
         (f)->sgh_toserver = NULL;                                                                  \
         (f)->sgh_toclient = NULL;                                                                  \
         (f)->flowvar = NULL;                                                                       \
+        (f)->flowbits.bits = 0;                                                                    \
+        (f)->flowbits.ext = NULL;                                                                  \
         RESET_COUNTERS((f));                                                                       \
     } while (0)
 
@@ -113,6 +116,7 @@
         (f)->sgh_toclient = NULL;                                                                  \
         SCGenericVarFree((f)->flowvar);                                                            \
         (f)->flowvar = NULL;                                                                       \
+        FlowBitsFree((f));                                                                         \
         RESET_COUNTERS((f));                                                                       \
     } while (0)
 
@@ -122,6 +126,7 @@
                                                                                                    \
         FLOWLOCK_DESTROY((f));                                                                     \
         SCGenericVarFree((f)->flowvar);                                                            \
+        FlowBitsFree((f));                                                                         \
     } while (0)
 
 /** \brief check if a memory alloc would fit in the memcap
@@ -49,11 +49,13 @@
 #include "util-validate.h"
 #include "util-time.h"
 #include "tmqh-packetpool.h"
+#include "tm-threads.h"
 
 #include "flow-util.h"
 #include "flow-manager.h"
 #include "flow-timeout.h"
 #include "flow-spare-pool.h"
+#include "flow-callbacks.h"
 #include "flow-worker.h"
 
 typedef DetectEngineThreadCtx *DetectEngineThreadCtxPtr;
@@ -75,6 +77,8 @@ typedef struct FlowWorkerThreadData_ {
 
     void *output_thread; /* Output thread data. */
     void *output_thread_flow; /* Output thread data. */
+    /** packet time in seconds of the last flow logger flush */
+    uint64_t output_flow_flush_secs;
 
     StatsCounterId local_bypass_pkts;
     StatsCounterId local_bypass_bytes;
@@ -94,8 +98,31 @@ typedef struct FlowWorkerThreadData_ {
     } cnt;
     FlowEndCounters fec;
 
+    /** sampled per stage latency, see stats.latency-sample-rate */
+    struct {
+        /** current packet is sampled, follows ThreadVars::latency */
+        bool sample;
+        StatsCounterHistId flow;
+        StatsCounterHistId stream;
+        StatsCounterHistId app_layer;
+        StatsCounterHistId detect;
+        StatsCounterHistId output;
+    } latency;
 } FlowWorkerThreadData;
 
+static inline uint64_t FlowWorkerLatencyStart(const FlowWorkerThreadData *fw)
+{
+    return fw->latency.sample ? StatsLatencyNow() : 0;
+}
+
+static inline void FlowWorkerLatencyEnd(
+        ThreadVars *tv, const FlowWorkerThreadData *fw, StatsCounterHistId id, const uint64_t start)
+{
+    if (fw->latency.sample) {
+        StatsCounterHistogramRecord(&tv->stats, id, StatsLatencyNow() - start);
+    }
+}
+
 static void FlowWorkerFlowTimeout(
         ThreadVars *tv, Packet *p, FlowWorkerThreadData *fw, DetectEngineThreadCtx *det_ctx);
 
@@ -185,6 +212,7 @@ static void CheckWorkQueue(ThreadVars *tv, FlowWorkerThreadData *fw, FlowTimeout
         }
         StatsCounterDecr(&tv->stats, fw->dtv->counter_flow_active);
 
+        SCFlowRunFinishCallbacks(tv, f);
         FlowClearMemory (f, f->protomap);
         FLOWLOCK_UNLOCK(f);
 
@@ -264,6 +292,14 @@ static TmEcode FlowWorkerThreadInit(ThreadVars *tv, const void *initdata, void *
     fw->cnt.flows_injected = StatsRegisterCounter("flow.wrk.flows_injected", &tv->stats);
     fw->cnt.flows_injected_max = StatsRegisterMaxCounter("flow.wrk.flows_injected_max", &tv->stats);
 
+    if (stats_latency_sample_rate > 0) {
+        fw->latency.flow = StatsRegisterHistogramCounter("latency.flow", &tv->stats);
+        fw->latency.stream = StatsRegisterHistogramCounter("latency.stream", &tv->stats);
+        fw->latency.app_layer = StatsRegisterHistogramCounter("latency.app_layer", &tv->stats);
+        fw->latency.detect = StatsRegisterHistogramCounter("latency.detect", &tv->stats);
+        fw->latency.output = StatsRegisterHistogramCounter("latency.output", &tv->stats);
+    }
+
     fw->fls.dtv = fw->dtv = DecodeThreadVarsAlloc(tv);
     if (fw->dtv == NULL) {
         FlowWorkerThreadDeinit(tv, fw);
@@ -374,9 +410,11 @@ static inline void FlowWorkerStreamTCPUpdate(ThreadVars *tv, FlowWorkerThreadDat
         }
     }
 
+    const uint64_t start = FlowWorkerLatencyStart(fw);
     FLOWWORKER_PROFILING_START(p, PROFILE_FLOWWORKER_STREAM);
     StreamTcp(tv, p, fw->stream_thread, &fw->pq);
     FLOWWORKER_PROFILING_END(p, PROFILE_FLOWWORKER_STREAM);
+    FlowWorkerLatencyEnd(tv, fw, fw->latency.stream, start);
 
     // this is the first packet that sets no payload inspection
     bool setting_nopayload =
@@ -516,6 +554,30 @@ static inline void FlowWorkerProcessLocalFlows(ThreadVars *tv, FlowWorkerThreadD
     FLOWWORKER_PROFILING_END(p, PROFILE_FLOWWORKER_FLOW_EVICTED);
 }
 
+/** \internal
+ *  \brief let the flow loggers write out buffered records that are due
+ *
+ *  Runs once per second of packet time and on capture timeouts, so the
+ *  records of a worker that stops ending flows are still written. While
+ *  records are buffered, THV_OUTPUT_FLUSH keeps the capture timeouts of
+ *  an idle worker injecting packets to get here.
+ */
+static inline void FlowWorkerFlushFlowLoggers(ThreadVars *tv, FlowWorkerThreadData *fw, Packet *p)
+{
+    const uint64_t secs = SCTIME_SECS(p->ts);
+    if (p->pkt_src != PKT_SRC_CAPTURE_TIMEOUT && secs == fw->output_flow_flush_secs)
+        return;
+    fw->output_flow_flush_secs = secs;
+
+    bool pending = false;
+    if (fw->output_thread_flow != NULL)
+        pending |= OutputFlowLogFlush(tv, fw->output_thread_flow);
+    if (fw->dtv->output_flow_thread_data != NULL)
+        pending |= OutputFlowLogFlush(tv, fw->dtv->output_flow_thread_data);
+    if (!pending && TmThreadsCheckFlag(tv, THV_OUTPUT_FLUSH))
+        TmThreadsUnsetFlag(tv, THV_OUTPUT_FLUSH);
+}
+
 /** \internal
  *  \brief apply Packet::app_update_direction to the flow flags
  */
@@ -569,6 +631,9 @@ static TmEcode FlowWorker(ThreadVars *tv, Packet *p, void *data)
 
     SCLogDebug("packet %" PRIu64, PcapPacketCntGet(p));
 
+    fw->latency.sample = tv->latency.sample;
+    uint64_t start;
+
     /* handle Flow */
     if (det_ctx != NULL && det_ctx->de_ctx->PreFlowHook != NULL) {
         const uint8_t action = det_ctx->de_ctx->PreFlowHook(tv, det_ctx, p);
@@ -579,6 +644,7 @@ static TmEcode FlowWorker(ThreadVars *tv, Packet *p, void *data)
     }
 
     if (p->flags & PKT_WANTS_FLOW) {
+        start = FlowWorkerLatencyStart(fw);
         FLOWWORKER_PROFILING_START(p, PROFILE_FLOWWORKER_FLOW);
 
         FlowHandlePacket(tv, &fw->fls, p);
@@ -595,6 +661,7 @@ static TmEcode FlowWorker(ThreadVars *tv, Packet *p, void *data)
         /* Flow is now LOCKED */
 
         FLOWWORKER_PROFILING_END(p, PROFILE_FLOWWORKER_FLOW);
+        FlowWorkerLatencyEnd(tv, fw, fw->latency.flow, start);
 
     /* if PKT_WANTS_FLOW is not set, but PKT_HAS_FLOW is, then this is a
      * pseudo packet created by the flow manager. */
@@ -646,9 +713,11 @@ static TmEcode FlowWorker(ThreadVars *tv, Packet *p, void *data)
 
             /* handle the app layer part of the UDP packet payload */
         } else if (p->proto == IPPROTO_UDP && !PacketCheckAction(p, ACTION_DROP)) {
+            start = FlowWorkerLatencyStart(fw);
             FLOWWORKER_PROFILING_START(p, PROFILE_FLOWWORKER_APPLAYERUDP);
             AppLayerHandleUdp(tv, fw->stream_thread->ra_ctx->app_tctx, p, p->flow);
             FLOWWORKER_PROFILING_END(p, PROFILE_FLOWWORKER_APPLAYERUDP);
+            FlowWorkerLatencyEnd(tv, fw, fw->latency.app_layer, start);
             PacketAppUpdate2FlowFlags(p);
         }
     }
@@ -659,14 +728,18 @@ static TmEcode FlowWorker(ThreadVars *tv, Packet *p, void *data)
     DEBUG_ASSERT_FLOW_LOCKED(p->flow);
     SCLogDebug("packet %" PRIu64 " calling Detect", PcapPacketCntGet(p));
     if (det_ctx != NULL) {
+        start = FlowWorkerLatencyStart(fw);
         FLOWWORKER_PROFILING_START(p, PROFILE_FLOWWORKER_DETECT);
         Detect(tv, p, det_ctx);
         FLOWWORKER_PROFILING_END(p, PROFILE_FLOWWORKER_DETECT);
+        FlowWorkerLatencyEnd(tv, fw, fw->latency.detect, start);
     }
 
 pre_flow_drop:
     // Outputs.
+    start = FlowWorkerLatencyStart(fw);
     OutputLoggerLog(tv, p, fw->output_thread);
+    FlowWorkerLatencyEnd(tv, fw, fw->latency.output, start);
 
     /*  Release tcp segments. Done here after alerting can use them. */
     if (p->flow != NULL) {
@@ -723,6 +796,8 @@ pre_flow_drop:
     }
 
 housekeeping:
+    /* flow timeouts handled below are not part of this packet */
+    fw->latency.sample = false;
 
     /* take injected flows and add them to our local queue */
     FlowWorkerProcessInjectedFlows(tv, fw, p);
@@ -730,6 +805,8 @@ housekeeping:
     /* process local work queue */
     FlowWorkerProcessLocalFlows(tv, fw, p);
 
+    FlowWorkerFlushFlowLoggers(tv, fw, p);
+
     return TM_ECODE_OK;
 }
 
@@ -583,7 +583,7 @@ void FlowInitConfig(bool quiet)
     SC_ATOMIC_INIT(flow_memuse);
     SC_ATOMIC_INIT(flow_prune_idx);
     SC_ATOMIC_INIT(flow_config.memcap);
-    FlowQueueInit(&flow_recycle_q);
+    FlowRecycleQueuesInit();
 
     /* set defaults */
     flow_config.hash_rand   = (uint32_t)RandomGet();
@@ -721,9 +721,7 @@ void FlowReset(void)
 void FlowShutdown(void)
 {
     Flow *f;
-    while ((f = FlowDequeue(&flow_recycle_q))) {
-        FlowFree(f);
-    }
+    FlowRecycleQueuesDestroy();
 
     /* clear and free the hash */
     if (flow_hash != NULL) {
@@ -752,7 +750,6 @@ void FlowShutdown(void)
         flow_hash = NULL;
     }
     (void) SC_ATOMIC_SUB(flow_memuse, flow_config.hash_size * sizeof(FlowBucket));
-    FlowQueueDestroy(&flow_recycle_q);
     FlowSparePoolDestroy();
     DEBUG_VALIDATE_BUG_ON(SC_ATOMIC_GET(flow_memuse) != 0);
 }
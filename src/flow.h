@@ -125,6 +125,8 @@ typedef struct AppLayerParserState_ AppLayerParserState;
 #define FLOW_ACTION_BY_FIREWALL BIT_U64(32)
 /** Flow action issued by exception policy */
 #define FLOW_ACTION_BY_EXCEPTION_POLICY BIT_U64(33)
+/** detect checked if the flow can be bypassed as no rule can match it */
+#define FLOW_AUTO_BYPASS_CHECKED BIT_U64(34)
 
 /* File flags */
 
@@ -332,6 +334,18 @@ typedef uint16_t FlowThreadId;
 
 #include "util-storage.h"
 
+/**
+ *  \brief Flowbits of a flow.
+ *
+ *  Bit 'n' is the flowbit with id 'n'. Ids below 64 are stored in 'bits',
+ *  higher ids in 'ext', which is allocated on demand. ext[0] holds the
+ *  number of words in 'ext', so the word for id 'n' is ext[n / 64].
+ */
+typedef struct FlowBitStore_ {
+    uint64_t bits;
+    uint64_t *ext;
+} FlowBitStore;
+
 /**
  *  \brief Flow data structure.
  *
@@ -487,6 +501,8 @@ typedef struct Flow_
 
     /* pointer to the var list */
     GenericVar *flowvar;
+    /** flowbits, indexed by flowbit id */
+    FlowBitStore flowbits;
 
     struct FlowBucket_ *fb;
 
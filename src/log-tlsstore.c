@@ -308,6 +308,8 @@ static bool LogTlsStoreCondition(
         goto dontlog;
     }
 
+    SSLStateCertDecode(&ssl_state->server_connp, SSL_CERT0_ALL);
+
     if (ssl_state->server_connp.cert0_issuerdn == NULL ||
             ssl_state->server_connp.cert0_subject == NULL) {
         goto dontlog;
@@ -339,6 +341,8 @@ static bool LogTlsStoreConditionClient(
         goto dontlog;
     }
 
+    SSLStateCertDecode(&ssl_state->client_connp, SSL_CERT0_ALL);
+
     if ((ssl_state->client_connp.cert0_issuerdn == NULL ||
                 ssl_state->client_connp.cert0_subject == NULL)) {
         goto dontlog;
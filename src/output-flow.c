@@ -40,6 +40,7 @@ typedef struct OutputFlowLoggerThreadData_ {
  * log module (e.g. fast.log) with different output ctx'. */
 typedef struct OutputFlowLogger_ {
     FlowLogger LogFunc;
+    FlowLoggerFlush FlushFunc;
 
     /** Data that will be passed to the ThreadInit callback. */
     void *initdata;
@@ -57,12 +58,21 @@ static OutputFlowLogger *list = NULL;
 
 int SCOutputRegisterFlowLogger(const char *name, FlowLogger LogFunc, void *initdata,
         ThreadInitFunc ThreadInit, ThreadDeinitFunc ThreadDeinit)
+{
+    return SCOutputRegisterFlowLoggerWithFlush(
+            name, LogFunc, NULL, initdata, ThreadInit, ThreadDeinit);
+}
+
+int SCOutputRegisterFlowLoggerWithFlush(const char *name, FlowLogger LogFunc,
+        FlowLoggerFlush FlushFunc, void *initdata, ThreadInitFunc ThreadInit,
+        ThreadDeinitFunc ThreadDeinit)
 {
     OutputFlowLogger *op = SCCalloc(1, sizeof(*op));
     if (op == NULL)
         return -1;
 
     op->LogFunc = LogFunc;
+    op->FlushFunc = FlushFunc;
     op->initdata = initdata;
     op->name = name;
     op->ThreadInit = ThreadInit;
@@ -115,6 +125,30 @@ TmEcode OutputFlowLog(ThreadVars *tv, void *thread_data, Flow *f)
     return TM_ECODE_OK;
 }
 
+/** \brief Run the flush function of the flow logger(s)
+ *
+ *  Called periodically by the threads running the flow loggers.
+ *
+ *  \retval true if any of the loggers still has records buffered */
+bool OutputFlowLogFlush(ThreadVars *tv, void *thread_data)
+{
+    DEBUG_VALIDATE_BUG_ON(thread_data == NULL);
+
+    OutputFlowLoggerThreadData *op_thread_data = (OutputFlowLoggerThreadData *)thread_data;
+    OutputFlowLogger *logger = list;
+    OutputLoggerThreadStore *store = op_thread_data->store;
+    bool pending = false;
+
+    while (logger && store) {
+        if (logger->FlushFunc) {
+            pending |= logger->FlushFunc(tv, store->thread_data);
+        }
+        logger = logger->next;
+        store = store->next;
+    }
+    return pending;
+}
+
 /** \brief thread init for the flow logger
  *  This will run the thread init functions for the individual registered
  *  loggers */
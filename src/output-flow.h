@@ -35,6 +35,18 @@
  */
 typedef int (*FlowLogger)(ThreadVars *, void *thread_data, Flow *f);
 
+/**
+ * \brief Flow logger flush function pointer type.
+ *
+ * Called periodically from the threads that run the flow loggers, so
+ * loggers that buffer records can write out the ones that are due.
+ * Loggers that buffer records should also set THV_OUTPUT_FLUSH on the
+ * thread, so an idle thread still gets to flush them.
+ *
+ * \retval true if records are still buffered
+ */
+typedef bool (*FlowLoggerFlush)(ThreadVars *, void *thread_data);
+
 /** \brief Register a flow logger.
  *
  * \param name An informational name for this logger. Used only for
@@ -50,12 +62,27 @@ typedef int (*FlowLogger)(ThreadVars *, void *thread_data, Flow *f);
 int SCOutputRegisterFlowLogger(const char *name, FlowLogger LogFunc, void *initdata,
         ThreadInitFunc ThreadInit, ThreadDeinitFunc ThreadDeinit);
 
+/** \brief Register a flow logger with a flush callback.
+ *
+ * Like SCOutputRegisterFlowLogger().
+ *
+ * \param FlushFunc Periodic flush callback, may be NULL.
+ *
+ * \retval 0 on success, -1 on failure.
+ */
+int SCOutputRegisterFlowLoggerWithFlush(const char *name, FlowLogger LogFunc,
+        FlowLoggerFlush FlushFunc, void *initdata, ThreadInitFunc ThreadInit,
+        ThreadDeinitFunc ThreadDeinit);
+
 /** Internal function: private API. */
 void OutputFlowShutdown(void);
 
 /** Internal function: private API. */
 TmEcode OutputFlowLog(ThreadVars *tv, void *thread_data, Flow *f);
 
+/** Internal function: private API. */
+bool OutputFlowLogFlush(ThreadVars *tv, void *thread_data);
+
 /** Internal function: private API. */
 TmEcode OutputFlowLogThreadInit(ThreadVars *tv, void **data);
 
@@ -44,6 +44,7 @@
 #include "detect-engine.h"
 #include "detect-metadata.h"
 #include "app-layer-parser.h"
+#include "app-layer-htp.h"
 #include "app-layer-htp-xff.h"
 #include "app-layer-ftp.h"
 #include "app-layer-frames.h"
@@ -1086,6 +1087,10 @@ static void JsonAlertLogSetupMetadata(AlertJsonOutputCtx *json_output_ctx, SCCon
     if (flags & LOG_JSON_RULE_METADATA) {
         DetectEngineSetParseMetadata();
     }
+    if (flags & JSON_BODY_LOGGING) {
+        AppLayerHtpEnableRequestBodyCallback();
+        AppLayerHtpEnableResponseBodyLogging();
+    }
 
     json_output_ctx->payload_buffer_size = payload_buffer_size;
     json_output_ctx->flags |= flags;
@@ -60,6 +60,10 @@ void FreeEveThreadCtx(OutputJsonThreadCtx *ctx)
     if (ctx != NULL && ctx->buffer != NULL) {
         MemBufferFree(ctx->buffer);
     }
+    if (ctx != NULL && ctx->batch != NULL) {
+        MemBufferFree(ctx->batch->buffer);
+        SCFree(ctx->batch);
+    }
     if (ctx != NULL) {
         SCFree(ctx);
     }
@@ -120,9 +124,63 @@ error_exit:
     return TM_ECODE_FAILED;
 }
 
+/**
+ * \brief Thread init for the flow loggers, which can batch their records
+ */
+TmEcode JsonFlowLogThreadInit(ThreadVars *t, const void *initdata, void **data)
+{
+    if (JsonLogThreadInit(t, initdata, data) != TM_ECODE_OK) {
+        return TM_ECODE_FAILED;
+    }
+
+    OutputJsonThreadCtx *thread = *data;
+    const OutputJsonFlowBatchCfg *cfg = &thread->ctx->flow_batch;
+    if (cfg->size == 0) {
+        return TM_ECODE_OK;
+    }
+
+    OutputJsonBatch *batch = SCCalloc(1, sizeof(*batch));
+    if (unlikely(batch == NULL)) {
+        goto error;
+    }
+    batch->buffer = MemBufferCreateNew(cfg->size);
+    if (unlikely(batch->buffer == NULL)) {
+        SCFree(batch);
+        goto error;
+    }
+    batch->timeout = cfg->timeout;
+    batch->records = StatsRegisterCounter("eve.flow_batch.records", &t->stats);
+    batch->flushes = StatsRegisterCounter("eve.flow_batch.flushes", &t->stats);
+    batch->bytes = StatsRegisterCounter("eve.flow_batch.bytes", &t->stats);
+    thread->batch = batch;
+    return TM_ECODE_OK;
+
+error:
+    FreeEveThreadCtx(thread);
+    *data = NULL;
+    return TM_ECODE_FAILED;
+}
+
+/**
+ * \brief Periodic flush for the flow loggers, writes out a batch that is due
+ *
+ * \retval true if records are still batched
+ */
+bool JsonFlowLogFlush(ThreadVars *t, void *data)
+{
+    OutputJsonThreadCtx *thread = (OutputJsonThreadCtx *)data;
+    if (thread == NULL)
+        return false;
+    return OutputJsonBatchFlushExpired(t, thread);
+}
+
 TmEcode JsonLogThreadDeinit(ThreadVars *t, void *data)
 {
     OutputJsonThreadCtx *thread = (OutputJsonThreadCtx *)data;
+    if (thread != NULL) {
+        /* write out what is left in the batch on shutdown */
+        OutputJsonBatchFlush(t, thread);
+    }
     FreeEveThreadCtx(thread);
     return TM_ECODE_OK;
 }
@@ -453,6 +453,7 @@ static int JsonFlowLogger(ThreadVars *tv, void *thread_data, Flow *f)
 void JsonFlowLogRegister (void)
 {
     /* register as child of eve-log */
-    OutputRegisterFlowSubModule(LOGGER_JSON_FLOW, "eve-log", "JsonFlowLog", "eve-log.flow",
-            OutputJsonLogInitSub, JsonFlowLogger, JsonLogThreadInit, JsonLogThreadDeinit);
+    OutputRegisterFlowSubModuleWithFlush(LOGGER_JSON_FLOW, "eve-log", "JsonFlowLog",
+            "eve-log.flow", OutputJsonLogInitSub, JsonFlowLogger, JsonFlowLogFlush,
+            JsonFlowLogThreadInit, JsonLogThreadDeinit);
 }
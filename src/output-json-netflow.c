@@ -314,6 +314,7 @@ static int JsonNetFlowLogger(ThreadVars *tv, void *thread_data, Flow *f)
 void JsonNetFlowLogRegister(void)
 {
     /* register as child of eve-log */
-    OutputRegisterFlowSubModule(LOGGER_JSON_NETFLOW, "eve-log", "JsonNetFlowLog", "eve-log.netflow",
-            OutputJsonLogInitSub, JsonNetFlowLogger, JsonLogThreadInit, JsonLogThreadDeinit);
+    OutputRegisterFlowSubModuleWithFlush(LOGGER_JSON_NETFLOW, "eve-log", "JsonNetFlowLog",
+            "eve-log.netflow", OutputJsonLogInitSub, JsonNetFlowLogger, JsonFlowLogFlush,
+            JsonFlowLogThreadInit, JsonLogThreadDeinit);
 }
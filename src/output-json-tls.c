@@ -432,6 +432,16 @@ static void JsonTlsLogServerHandshake(SCJsonBuilder *js, SSLState *ssl_state)
 
 static void JsonTlsLogFields(SCJsonBuilder *js, SSLState *ssl_state, uint64_t fields)
 {
+    /* decode the certificate fields we log, if the parser didn't */
+    uint8_t cert0_fields = 0;
+    if (fields & (LOG_TLS_FIELD_SUBJECT | LOG_TLS_FIELD_ISSUER | LOG_TLS_FIELD_SUBJECTALTNAME |
+                         LOG_TLS_FIELD_SESSION_RESUMED | LOG_TLS_FIELD_SERIAL |
+                         LOG_TLS_FIELD_NOTBEFORE | LOG_TLS_FIELD_NOTAFTER))
+        cert0_fields |= SSL_CERT0_FIELDS;
+    if (fields & LOG_TLS_FIELD_FINGERPRINT)
+        cert0_fields |= SSL_CERT0_FINGERPRINT;
+    SSLStateCertDecode(&ssl_state->server_connp, cert0_fields);
+
     /* tls subject */
     if (fields & LOG_TLS_FIELD_SUBJECT)
         JsonTlsLogSubject(js, ssl_state);
@@ -512,6 +522,7 @@ static void JsonTlsLogFields(SCJsonBuilder *js, SSLState *ssl_state, uint64_t fi
     if (fields & LOG_TLS_FIELD_CLIENT) {
         const bool log_cert = (fields & LOG_TLS_FIELD_CLIENT_CERT) != 0;
         const bool log_chain = (fields & LOG_TLS_FIELD_CLIENT_CHAIN) != 0;
+        SSLStateCertDecode(&ssl_state->client_connp, SSL_CERT0_ALL);
         if (HasClientCert(&ssl_state->client_connp)) {
             SCJbOpenObject(js, "client");
             JsonTlsLogClientCert(js, &ssl_state->client_connp, log_cert, log_chain);
@@ -539,6 +550,7 @@ static int JsonTlsLogger(ThreadVars *tv, void *thread_data, const Packet *p,
         return 0;
     }
 
+    SSLStateCertDecode(&ssl_state->server_connp, SSL_CERT0_FIELDS);
     if ((ssl_state->server_connp.cert0_issuerdn == NULL ||
                 ssl_state->server_connp.cert0_subject == NULL) &&
             ((ssl_state->flags & SSL_AL_FLAG_SESSION_RESUMED) == 0 ||
@@ -48,6 +48,7 @@
 #include "output-json.h"
 
 #include "util-byte.h"
+#include "util-misc.h"
 #include "util-print.h"
 #include "util-proto-name.h"
 #include "util-optimize.h"
@@ -60,6 +61,10 @@
 #include "flow-var.h"
 #include "flow-bit.h"
 #include "flow-storage.h"
+#include "flow-util.h"
+#include "flow-private.h"
+
+#include "tm-threads.h"
 
 #include "source-pcap-file-helper.h"
 
@@ -73,6 +78,56 @@ static void CreateEveCommunityFlowId(SCJsonBuilder *js, const Flow *f, const uin
 static int CreateJSONEther(
         SCJsonBuilder *parent, const Packet *p, const Flow *f, enum SCOutputJsonLogDirection dir);
 
+#define COMMUNITY_ID_BUF_SIZE 64
+
+/** cached 5-tuple and ip version fragment, valid for the key fields */
+typedef struct EveTupleCache_ {
+    Address src;
+    Address dst;
+    Port sp;
+    Port dp;
+    uint8_t proto;
+    uint8_t ipproto;
+    bool compress_ipv6;
+    char *json;
+} EveTupleCache;
+
+/** cached ether object, valid for the ether type and mac addresses in key */
+typedef struct EveEtherCache_ {
+    uint8_t key[14];
+    char *json;
+} EveEtherCache;
+
+/**
+ * \brief per flow cache of the eve header fields that are (mostly) invariant
+ *        over the lifetime of a flow
+ *
+ * The cache is set up on the second event of a flow, so flows with a single
+ * event don't pay for it. The fragments are serialized by the regular header
+ * code and spliced into the records of the flow's later events. Each fragment
+ * is stored with the values it was created from and is recreated when these
+ * no longer match, e.g. when the mac addresses change or when the flow is
+ * swapped.
+ *
+ * The cache and its fragments are accounted in the flow memuse.
+ */
+typedef struct EveFlowHeaderCache_ {
+    /** [0] flow src is the src in the record, [1] flow dst is the src */
+    EveTupleCache tuple[2];
+    /** [0] toserver packets, [1] toclient packets */
+    EveEtherCache ether[2];
+    uint16_t community_id_seed;
+    char community_id[COMMUNITY_ID_BUF_SIZE];
+    /** bytes accounted in flow_memuse, cache and fragments */
+    uint32_t memuse;
+} EveFlowHeaderCache;
+
+static SCFlowStorageId g_eve_header_storage_id = { .id = -1 };
+
+/** storage value of a flow that had its first event logged */
+static char eve_header_cache_seen;
+#define EVE_HEADER_CACHE_SEEN ((void *)&eve_header_cache_seen)
+
 static const char *TRAFFIC_ID_PREFIX = "traffic/id/";
 static const char *TRAFFIC_LABEL_PREFIX = "traffic/label/";
 static size_t traffic_id_prefix_len = 0;
@@ -230,7 +285,7 @@ static bool SCStringHasPrefix(const char *s, const char *prefix)
 
 static void EveAddFlowVars(const Flow *f, SCJsonBuilder *js_root, SCJsonBuilder **js_traffic)
 {
-    if (f == NULL || f->flowvar == NULL) {
+    if (f == NULL || (f->flowvar == NULL && !FlowBitAnySet(f))) {
         return;
     }
     SCJsonBuilder *js_flowvars = NULL;
@@ -297,38 +352,37 @@ static void EveAddFlowVars(const Flow *f, SCJsonBuilder *js_root, SCJsonBuilder
                     SCJbSetUint(js_flowints, varname, fv->data.fv_int.value);
                 }
             }
-        } else if (gv->type == DETECT_FLOWBITS) {
-            FlowBit *fb = (FlowBit *)gv;
-            const char *varname = VarNameStoreLookupById(fb->idx,
-                    VAR_TYPE_FLOW_BIT);
-            if (varname) {
-                if (SCStringHasPrefix(varname, TRAFFIC_ID_PREFIX)) {
-                    if (js_traffic_id == NULL) {
-                        js_traffic_id = SCJbNewArray();
-                        if (unlikely(js_traffic_id == NULL)) {
-                            break;
-                        }
-                    }
-                    SCJbAppendString(js_traffic_id, &varname[traffic_id_prefix_len]);
-                } else if (SCStringHasPrefix(varname, TRAFFIC_LABEL_PREFIX)) {
-                    if (js_traffic_label == NULL) {
-                        js_traffic_label = SCJbNewArray();
-                        if (unlikely(js_traffic_label == NULL)) {
-                            break;
-                        }
+        }
+        gv = gv->next;
+    }
+    for (uint32_t idx = FlowBitNext(f, 0); idx != 0; idx = FlowBitNext(f, idx)) {
+        const char *varname = VarNameStoreLookupById(idx, VAR_TYPE_FLOW_BIT);
+        if (varname) {
+            if (SCStringHasPrefix(varname, TRAFFIC_ID_PREFIX)) {
+                if (js_traffic_id == NULL) {
+                    js_traffic_id = SCJbNewArray();
+                    if (unlikely(js_traffic_id == NULL)) {
+                        break;
                     }
-                    SCJbAppendString(js_traffic_label, &varname[traffic_label_prefix_len]);
-                } else {
-                    if (js_flowbits == NULL) {
-                        js_flowbits = SCJbNewArray();
-                        if (unlikely(js_flowbits == NULL))
-                            break;
+                }
+                SCJbAppendString(js_traffic_id, &varname[traffic_id_prefix_len]);
+            } else if (SCStringHasPrefix(varname, TRAFFIC_LABEL_PREFIX)) {
+                if (js_traffic_label == NULL) {
+                    js_traffic_label = SCJbNewArray();
+                    if (unlikely(js_traffic_label == NULL)) {
+                        break;
                     }
-                    SCJbAppendString(js_flowbits, varname);
                 }
+                SCJbAppendString(js_traffic_label, &varname[traffic_label_prefix_len]);
+            } else {
+                if (js_flowbits == NULL) {
+                    js_flowbits = SCJbNewArray();
+                    if (unlikely(js_flowbits == NULL))
+                        break;
+                }
+                SCJbAppendString(js_flowbits, varname);
             }
         }
-        gv = gv->next;
     }
     if (js_flowbits) {
         SCJbClose(js_flowbits);
@@ -371,10 +425,11 @@ static void EveAddFlowVars(const Flow *f, SCJsonBuilder *js_root, SCJsonBuilder
 
 void EveAddMetadata(const Packet *p, const Flow *f, SCJsonBuilder *js)
 {
-    if ((p && p->pktvar) || (f && f->flowvar)) {
+    const bool fv = f && (f->flowvar || FlowBitAnySet(f));
+    if ((p && p->pktvar) || fv) {
         SCJsonBuilder *js_vars = SCJbNewObject();
         if (js_vars) {
-            if (f && f->flowvar) {
+            if (fv) {
                 SCJsonBuilder *js_traffic = NULL;
                 EveAddFlowVars(f, js_vars, &js_traffic);
                 if (js_traffic != NULL) {
@@ -567,7 +622,123 @@ void JsonAddrInfoInit(const Packet *p, enum SCOutputJsonLogDirection dir, JsonAd
     }
 }
 
-#define COMMUNITY_ID_BUF_SIZE 64
+static void EveFlowHeaderCacheFree(void *data)
+{
+    if (data == EVE_HEADER_CACHE_SEEN)
+        return;
+
+    EveFlowHeaderCache *c = data;
+    for (int i = 0; i < 2; i++) {
+        if (c->tuple[i].json != NULL)
+            SCFree(c->tuple[i].json);
+        if (c->ether[i].json != NULL)
+            SCFree(c->ether[i].json);
+    }
+    (void)SC_ATOMIC_SUB(flow_memuse, c->memuse);
+    SCFree(c);
+}
+
+/**
+ * \brief register the flow storage for the eve header cache
+ *
+ * Only registered if at least one eve-log output is enabled.
+ */
+void OutputJsonRegisterFlowStorage(void)
+{
+    SCConfNode *root = SCConfGetNode("outputs");
+    SCConfNode *node = NULL;
+    if (root == NULL)
+        return;
+    TAILQ_FOREACH (node, &root->head, next) {
+        if (node->val && strcmp(node->val, "eve-log") == 0) {
+            const char *enabled = SCConfNodeLookupChildValue(node->head.tqh_first, "enabled");
+            if (enabled != NULL && SCConfValIsTrue(enabled)) {
+                g_eve_header_storage_id =
+                        SCFlowStorageRegister("eve-header", EveFlowHeaderCacheFree);
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * \brief set up the header cache for a packet's event
+ *
+ * The first event of a flow only marks the flow, the cache is allocated
+ * on the second one. Pseudo packets are not considered: they are created
+ * when the flow ends, so there would be no later events to use the cache.
+ *
+ * The flow is locked by the caller, so updating the storage through the
+ * const flow pointer of the loggers is safe.
+ */
+static void EveFlowHeaderCacheSetup(const Packet *p, const Flow *f)
+{
+    if (g_eve_header_storage_id.id == -1 || f == NULL || PKT_IS_PSEUDOPKT(p))
+        return;
+
+    void *data = SCFlowGetStorageById(f, g_eve_header_storage_id);
+    if (data == NULL) {
+        SCFlowSetStorageById((Flow *)f, g_eve_header_storage_id, EVE_HEADER_CACHE_SEEN);
+    } else if (data == EVE_HEADER_CACHE_SEEN) {
+        EveFlowHeaderCache *c;
+        if (!FLOW_CHECK_MEMCAP(sizeof(*c)))
+            return;
+        c = SCCalloc(1, sizeof(*c));
+        if (unlikely(c == NULL))
+            return;
+        c->memuse = sizeof(*c);
+        (void)SC_ATOMIC_ADD(flow_memuse, c->memuse);
+        SCFlowSetStorageById((Flow *)f, g_eve_header_storage_id, c);
+    }
+}
+
+/**
+ * \brief get the header cache of a flow
+ *
+ * \retval c cache or NULL if disabled or not set up (yet)
+ */
+static EveFlowHeaderCache *EveFlowHeaderCacheGet(const Flow *f)
+{
+    if (g_eve_header_storage_id.id == -1)
+        return NULL;
+
+    void *data = SCFlowGetStorageById(f, g_eve_header_storage_id);
+    if (data == EVE_HEADER_CACHE_SEEN)
+        return NULL;
+    return data;
+}
+
+/**
+ * \brief store the fields of an unclosed scratch object, without the '{'
+ *
+ * Replaces the fragment in \a json, keeping the flow memuse up to date.
+ *
+ * \retval true fragment stored
+ * \retval false empty object, memcap reached or out of memory
+ */
+static bool EveFlowHeaderCacheSetFragment(EveFlowHeaderCache *c, char **json, SCJsonBuilder *jb)
+{
+    if (*json != NULL) {
+        const uint32_t old_len = (uint32_t)strlen(*json) + 1;
+        (void)SC_ATOMIC_SUB(flow_memuse, old_len);
+        c->memuse -= old_len;
+        SCFree(*json);
+        *json = NULL;
+    }
+
+    const size_t len = SCJbLen(jb);
+    if (len < 2 || !FLOW_CHECK_MEMCAP(len))
+        return false;
+    char *fragment = SCMalloc(len);
+    if (unlikely(fragment == NULL))
+        return false;
+    memcpy(fragment, SCJbPtr(jb) + 1, len - 1);
+    fragment[len - 1] = '\0';
+    (void)SC_ATOMIC_ADD(flow_memuse, len);
+    c->memuse += (uint32_t)len;
+    *json = fragment;
+    return true;
+}
 
 static bool CalculateCommunityFlowIdv4(const Flow *f,
         const uint16_t seed, unsigned char *base64buf)
@@ -670,14 +841,26 @@ static bool CalculateCommunityFlowIdv6(const Flow *f,
 
 static void CreateEveCommunityFlowId(SCJsonBuilder *js, const Flow *f, const uint16_t seed)
 {
+    /* the id only depends on the flow tuple and the seed, which may differ
+     * per eve output */
+    EveFlowHeaderCache *c = EveFlowHeaderCacheGet(f);
+    if (c != NULL && c->community_id[0] != '\0' && c->community_id_seed == seed) {
+        SCJbSetString(js, "community_id", c->community_id);
+        return;
+    }
+
     unsigned char buf[COMMUNITY_ID_BUF_SIZE];
+    bool ok = false;
     if (f->flags & FLOW_IPV4) {
-        if (CalculateCommunityFlowIdv4(f, seed, buf)) {
-            SCJbSetString(js, "community_id", (const char *)buf);
-        }
+        ok = CalculateCommunityFlowIdv4(f, seed, buf);
     } else if (f->flags & FLOW_IPV6) {
-        if (CalculateCommunityFlowIdv6(f, seed, buf)) {
-            SCJbSetString(js, "community_id", (const char *)buf);
+        ok = CalculateCommunityFlowIdv6(f, seed, buf);
+    }
+    if (ok) {
+        SCJbSetString(js, "community_id", (const char *)buf);
+        if (c != NULL) {
+            strlcpy(c->community_id, (const char *)buf, sizeof(c->community_id));
+            c->community_id_seed = seed;
         }
     }
 }
@@ -722,6 +905,16 @@ static int MacSetIterateToJSON(uint8_t *val, MacSetSide side, void *data)
     return 0;
 }
 
+static void CreateJSONEtherObject(
+        SCJsonBuilder *js, const EthernetHdr *ethh, const uint8_t *src, const uint8_t *dst)
+{
+    SCJbOpenObject(js, "ether");
+    SCJbSetUint(js, "ether_type", SCNtohs(ethh->eth_type));
+    JSONFormatAndAddMACAddr(js, "src_mac", src, false);
+    JSONFormatAndAddMACAddr(js, "dest_mac", dst, false);
+    SCJbClose(js);
+}
+
 static int CreateJSONEther(
         SCJsonBuilder *js, const Packet *p, const Flow *f, enum SCOutputJsonLogDirection dir)
 {
@@ -729,8 +922,6 @@ static int CreateJSONEther(
         /* this is a packet context, so we need to add scalar fields */
         if (PacketIsEthernet(p)) {
             const EthernetHdr *ethh = PacketGetEthernet(p);
-            SCJbOpenObject(js, "ether");
-            SCJbSetUint(js, "ether_type", SCNtohs(ethh->eth_type));
             const uint8_t *src;
             const uint8_t *dst;
             switch (dir) {
@@ -760,9 +951,34 @@ static int CreateJSONEther(
                     dst = ethh->eth_dst;
                     break;
             }
-            JSONFormatAndAddMACAddr(js, "src_mac", src, false);
-            JSONFormatAndAddMACAddr(js, "dest_mac", dst, false);
-            SCJbClose(js);
+            EveEtherCache *ec = NULL;
+            if (f != NULL) {
+                EveFlowHeaderCache *c = EveFlowHeaderCacheGet(f);
+                if (c != NULL) {
+                    ec = &c->ether[PKT_IS_TOCLIENT(p) ? 1 : 0];
+                    uint8_t key[sizeof(ec->key)];
+                    memcpy(key, &ethh->eth_type, 2);
+                    memcpy(key + 2, src, 6);
+                    memcpy(key + 8, dst, 6);
+                    if (ec->json == NULL || memcmp(ec->key, key, sizeof(key)) != 0) {
+                        /* new or changed mac addresses */
+                        SCJsonBuilder *ejs = SCJbNewObject();
+                        if (ejs != NULL) {
+                            memcpy(ec->key, key, sizeof(key));
+                            CreateJSONEtherObject(ejs, ethh, src, dst);
+                            EveFlowHeaderCacheSetFragment(c, &ec->json, ejs);
+                            SCJbFree(ejs);
+                        } else {
+                            ec = NULL;
+                        }
+                    }
+                }
+            }
+            if (ec != NULL && ec->json != NULL) {
+                SCJbSetFormatted(js, ec->json);
+            } else {
+                CreateJSONEtherObject(js, ethh, src, dst);
+            }
         } else if (f != NULL) {
             /* When pseudopackets do not have associated ethernet metadata,
                use the first set of mac addresses stored with their flow.
@@ -816,6 +1032,109 @@ static int CreateJSONEther(
     return 0;
 }
 
+static void EveAddTuple(SCJsonBuilder *js, const Packet *p, const JsonAddrInfo *addr)
+{
+    if (addr->src_ip[0] != '\0') {
+        SCJbSetString(js, "src_ip", addr->src_ip);
+    }
+    if (addr->log_port) {
+        SCJbSetUint(js, "src_port", addr->sp);
+    }
+    if (addr->dst_ip[0] != '\0') {
+        SCJbSetString(js, "dest_ip", addr->dst_ip);
+    }
+    if (addr->log_port) {
+        SCJbSetUint(js, "dest_port", addr->dp);
+    }
+    if (addr->proto[0] != '\0') {
+        SCJbSetString(js, "proto", addr->proto);
+    }
+
+    /* ip version */
+    if (PacketIsIPv4(p)) {
+        SCJbSetUint(js, "ip_v", 4);
+    } else if (PacketIsIPv6(p)) {
+        SCJbSetUint(js, "ip_v", 6);
+    }
+}
+
+/**
+ * \brief add the 5-tuple and ip version from the flow's header cache
+ *
+ * The addresses and ports are taken from the packet in the same order
+ * JsonAddrInfoInit() uses, so the cached fragment is only reused for
+ * packets that would produce the same fields.
+ *
+ * \retval true fields added
+ * \retval false cache not usable, caller has to add the fields
+ */
+static bool EveAddCachedTuple(SCJsonBuilder *js, const Packet *p, const Flow *f,
+        enum SCOutputJsonLogDirection dir, OutputJsonCommonSettings *cfg)
+{
+    if (f == NULL || !(PacketIsIPv4(p) || PacketIsIPv6(p)))
+        return false;
+    if (!(PKT_IS_TOSERVER(p) || PKT_IS_TOCLIENT(p)))
+        return false;
+    EveFlowHeaderCache *c = EveFlowHeaderCacheGet(f);
+    if (c == NULL)
+        return false;
+
+    bool swap;
+    switch (dir) {
+        case LOG_DIR_PACKET:
+            swap = false;
+            break;
+        case LOG_DIR_FLOW:
+        case LOG_DIR_FLOW_TOSERVER:
+            swap = !PKT_IS_TOSERVER(p);
+            break;
+        case LOG_DIR_FLOW_TOCLIENT:
+            swap = !PKT_IS_TOCLIENT(p);
+            break;
+        default:
+            return false;
+    }
+
+    EveTupleCache key;
+    memset(&key, 0, sizeof(key));
+    key.src = swap ? p->dst : p->src;
+    key.dst = swap ? p->src : p->dst;
+    switch (p->proto) {
+        case IPPROTO_UDP:
+        case IPPROTO_TCP:
+        case IPPROTO_SCTP:
+            key.sp = swap ? p->dp : p->sp;
+            key.dp = swap ? p->sp : p->dp;
+            break;
+    }
+    key.proto = p->proto;
+    key.ipproto = PacketGetIPProto(p);
+    key.compress_ipv6 = cfg->compress_ipv6;
+
+    EveTupleCache *tc = &c->tuple[CMP_ADDR(&key.src, &f->src) ? 0 : 1];
+    if (tc->json == NULL || tc->src.family != key.src.family || !CMP_ADDR(&tc->src, &key.src) ||
+            !CMP_ADDR(&tc->dst, &key.dst) || tc->sp != key.sp || tc->dp != key.dp ||
+            tc->proto != key.proto || tc->ipproto != key.ipproto ||
+            tc->compress_ipv6 != key.compress_ipv6) {
+        SCJsonBuilder *tjs = SCJbNewObject();
+        if (unlikely(tjs == NULL))
+            return false;
+        JsonAddrInfo addr_info = json_addr_info_zero;
+        JsonAddrInfoInit(p, dir, &addr_info, cfg);
+        EveAddTuple(tjs, p, &addr_info);
+
+        char *json = tc->json;
+        *tc = key;
+        tc->json = json;
+        const bool stored = EveFlowHeaderCacheSetFragment(c, &tc->json, tjs);
+        SCJbFree(tjs);
+        if (!stored)
+            return false;
+    }
+    SCJbSetFormatted(js, tc->json);
+    return true;
+}
+
 SCJsonBuilder *CreateEveHeader(const Packet *p, enum SCOutputJsonLogDirection dir,
         const char *event_type, JsonAddrInfo *addr, OutputJsonCtx *eve_ctx)
 {
@@ -867,33 +1186,16 @@ SCJsonBuilder *CreateEveHeader(const Packet *p, enum SCOutputJsonLogDirection di
         SCJbClose(js);
     }
 
-    /* 5-tuple */
-    JsonAddrInfo addr_info = json_addr_info_zero;
-    if (addr == NULL) {
-        JsonAddrInfoInit(p, dir, &addr_info, &eve_ctx->cfg);
-        addr = &addr_info;
-    }
-    if (addr->src_ip[0] != '\0') {
-        SCJbSetString(js, "src_ip", addr->src_ip);
-    }
-    if (addr->log_port) {
-        SCJbSetUint(js, "src_port", addr->sp);
-    }
-    if (addr->dst_ip[0] != '\0') {
-        SCJbSetString(js, "dest_ip", addr->dst_ip);
-    }
-    if (addr->log_port) {
-        SCJbSetUint(js, "dest_port", addr->dp);
-    }
-    if (addr->proto[0] != '\0') {
-        SCJbSetString(js, "proto", addr->proto);
-    }
+    EveFlowHeaderCacheSetup(p, f);
 
-    /* ip version */
-    if (PacketIsIPv4(p)) {
-        SCJbSetUint(js, "ip_v", 4);
-    } else if (PacketIsIPv6(p)) {
-        SCJbSetUint(js, "ip_v", 6);
+    /* 5-tuple and ip version */
+    if (addr != NULL || !EveAddCachedTuple(js, p, f, dir, &eve_ctx->cfg)) {
+        JsonAddrInfo addr_info = json_addr_info_zero;
+        if (addr == NULL) {
+            JsonAddrInfoInit(p, dir, &addr_info, &eve_ctx->cfg);
+            addr = &addr_info;
+        }
+        EveAddTuple(js, p, addr);
     }
 
     /* icmp */
@@ -1018,6 +1320,90 @@ int OutputJSONBuffer(json_t *js, LogFileCtx *file_ctx, MemBuffer **buffer)
     return 0;
 }
 
+/**
+ * \brief Write the batched records of a thread to its file
+ */
+void OutputJsonBatchFlush(ThreadVars *tv, OutputJsonThreadCtx *ctx)
+{
+    OutputJsonBatch *batch = ctx->batch;
+    if (batch == NULL || MEMBUFFER_OFFSET(batch->buffer) == 0) {
+        return;
+    }
+
+    const uint32_t len = MEMBUFFER_OFFSET(batch->buffer);
+    ctx->file_ctx->Write((const char *)MEMBUFFER_BUFFER(batch->buffer), (int)len, ctx->file_ctx);
+    MemBufferReset(batch->buffer);
+
+    StatsCounterIncr(&tv->stats, batch->flushes);
+    StatsCounterAddI64(&tv->stats, batch->bytes, (int64_t)len);
+}
+
+/**
+ * \brief Write the thread's batch if its oldest record is older than the timeout
+ */
+static void OutputJsonBatchFlushDue(ThreadVars *tv, OutputJsonThreadCtx *ctx, const time_t now)
+{
+    OutputJsonBatch *batch = ctx->batch;
+    if (batch == NULL || MEMBUFFER_OFFSET(batch->buffer) == 0) {
+        return;
+    }
+    if (now - batch->first >= (time_t)batch->timeout) {
+        OutputJsonBatchFlush(tv, ctx);
+    }
+}
+
+/**
+ * \brief Periodic check of the thread's batch
+ *
+ * Called from the periodic path of the threads running the flow loggers,
+ * so the records of a thread that stops logging are still written out
+ * after the timeout.
+ *
+ * \retval true if records are still batched
+ */
+bool OutputJsonBatchFlushExpired(ThreadVars *tv, OutputJsonThreadCtx *ctx)
+{
+    if (ctx->batch == NULL || MEMBUFFER_OFFSET(ctx->batch->buffer) == 0) {
+        return false;
+    }
+    OutputJsonBatchFlushDue(tv, ctx, time(NULL));
+    return MEMBUFFER_OFFSET(ctx->batch->buffer) > 0;
+}
+
+/**
+ * \brief Add a formatted record to the thread's batch
+ *
+ * The batch is written when the record doesn't fit, or when its oldest
+ * record is older than the timeout. Records larger than the batch are
+ * written directly.
+ */
+static void OutputJsonBatchAdd(
+        ThreadVars *tv, OutputJsonThreadCtx *ctx, MemBuffer *record, const time_t now)
+{
+    OutputJsonBatch *batch = ctx->batch;
+    /* record and its newline */
+    const uint32_t len = MEMBUFFER_OFFSET(record) + 1;
+
+    if (MEMBUFFER_OFFSET(batch->buffer) + len > MEMBUFFER_SIZE(batch->buffer)) {
+        OutputJsonBatchFlush(tv, ctx);
+        if (len > MEMBUFFER_SIZE(batch->buffer)) {
+            LogFileWrite(ctx->file_ctx, record);
+            return;
+        }
+    }
+
+    if (MEMBUFFER_OFFSET(batch->buffer) == 0) {
+        batch->first = now;
+        /* have the thread flushed on capture timeouts if it goes idle */
+        TmThreadsSetFlag(tv, THV_OUTPUT_FLUSH);
+    }
+    MemBufferWriteRaw(batch->buffer, MEMBUFFER_BUFFER(record), len - 1);
+    MemBufferWriteRaw(batch->buffer, (const uint8_t *)"\n", 1);
+    StatsCounterIncr(&tv->stats, batch->records);
+
+    OutputJsonBatchFlushDue(tv, ctx, now);
+}
+
 void OutputJsonBuilderBuffer(
         ThreadVars *tv, const Packet *p, Flow *f, SCJsonBuilder *js, OutputJsonThreadCtx *ctx)
 {
@@ -1062,6 +1448,10 @@ void OutputJsonBuilderBuffer(
     }
 
     MemBufferWriteRaw((*buffer), SCJbPtr(js), (uint32_t)jslen);
+    if (ctx->batch != NULL) {
+        OutputJsonBatchAdd(tv, ctx, *buffer, time(NULL));
+        return;
+    }
     LogFileWrite(file_ctx, *buffer);
 }
 
@@ -1292,6 +1682,36 @@ OutputInitResult OutputJsonInitCtx(SCConfNode *conf)
             }
         }
 
+        /* Batching of flow and netflow records per thread */
+        const SCConfNode *flow_batch = SCConfNodeLookupChild(conf, "flow-batch");
+        if (flow_batch != NULL && SCConfNodeChildValueIsTrue(flow_batch, "enabled")) {
+            if (log_filetype != LOGFILE_TYPE_FILE) {
+                SCLogWarning("eve-log flow-batch is only supported with filetype regular, "
+                             "disabling");
+            } else {
+                uint32_t size = OUTPUT_JSON_FLOW_BATCH_SIZE;
+                const char *size_s = SCConfNodeLookupChildValue(flow_batch, "size");
+                if (size_s != NULL && (ParseSizeStringU32(size_s, &size) < 0 || size == 0)) {
+                    FatalError("Failed to initialize JSON output, "
+                               "invalid flow-batch.size: %s",
+                            size_s);
+                }
+                intmax_t timeout = 1;
+                if (SCConfGetChildValueInt(flow_batch, "timeout", &timeout) &&
+                        (timeout < 1 || timeout > 60)) {
+                    FatalError("Failed to initialize JSON output, "
+                               "invalid flow-batch.timeout: %" PRIdMAX
+                               ", must be in [1-60] seconds",
+                            timeout);
+                }
+                json_ctx->flow_batch.size = size;
+                json_ctx->flow_batch.timeout = (uint32_t)timeout;
+                SCLogConfig("Enabling eve flow record batching: %" PRIu32 " bytes, %" PRIu32
+                            " seconds timeout",
+                        json_ctx->flow_batch.size, json_ctx->flow_batch.timeout);
+            }
+        }
+
         /* Do we have a global eve xff configuration? */
         const SCConfNode *xff = SCConfNodeLookupChild(conf, "xff");
         if (xff != NULL) {
@@ -1346,3 +1766,7 @@ static void OutputJsonDeInitCtx(OutputCtx *output_ctx)
     SCFree(json_ctx);
     SCFree(output_ctx);
 }
+
+#ifdef UNITTESTS
+#include "tests/output-json.c"
+#endif
@@ -33,6 +33,8 @@
 #include "app-layer-htp-xff.h"
 
 void OutputJsonRegister(void);
+void OutputJsonRegisterFlowStorage(void);
+void OutputJsonRegisterTests(void);
 
 #define JSON_ADDR_LEN 46
 #define JSON_PROTO_LEN 16
@@ -71,6 +73,14 @@ typedef struct OutputJsonCommonSettings_ {
 void JsonAddrInfoInit(const Packet *p, enum SCOutputJsonLogDirection dir, JsonAddrInfo *addr,
         OutputJsonCommonSettings *cfg);
 
+/* Default size of a flow record batch */
+#define OUTPUT_JSON_FLOW_BATCH_SIZE (64 * 1024)
+
+typedef struct OutputJsonFlowBatchCfg_ {
+    uint32_t size;    /**< batch size in bytes, 0 if batching is disabled */
+    uint32_t timeout; /**< max age of a batch in seconds */
+} OutputJsonFlowBatchCfg;
+
 /*
  * Global configuration context data
  */
@@ -78,14 +88,27 @@ typedef struct OutputJsonCtx_ {
     LogFileCtx *file_ctx;
     enum LogFileType json_out;
     OutputJsonCommonSettings cfg;
+    OutputJsonFlowBatchCfg flow_batch;
     HttpXFFCfg *xff_cfg;
     SCEveFileType *filetype;
 } OutputJsonCtx;
 
+/* Per thread batch of records, written to the file in one call */
+typedef struct OutputJsonBatch_ {
+    MemBuffer *buffer;
+    time_t first; /**< time the oldest record in the batch was added */
+    uint32_t timeout;
+    StatsCounterId records;
+    StatsCounterId flushes;
+    StatsCounterId bytes;
+} OutputJsonBatch;
+
 typedef struct OutputJsonThreadCtx_ {
     OutputJsonCtx *ctx;
     LogFileCtx *file_ctx;
     MemBuffer *buffer;
+    /* record batching, NULL if disabled */
+    OutputJsonBatch *batch;
     bool too_large_warning;
 } OutputJsonThreadCtx;
 
@@ -106,7 +129,11 @@ OutputInitResult OutputJsonInitCtx(SCConfNode *);
 
 OutputInitResult OutputJsonLogInitSub(SCConfNode *conf, OutputCtx *parent_ctx);
 TmEcode JsonLogThreadInit(ThreadVars *t, const void *initdata, void **data);
+TmEcode JsonFlowLogThreadInit(ThreadVars *t, const void *initdata, void **data);
 TmEcode JsonLogThreadDeinit(ThreadVars *t, void *data);
+bool JsonFlowLogFlush(ThreadVars *t, void *data);
+void OutputJsonBatchFlush(ThreadVars *tv, OutputJsonThreadCtx *ctx);
+bool OutputJsonBatchFlushExpired(ThreadVars *tv, OutputJsonThreadCtx *ctx);
 
 void EveAddCommonOptions(const OutputJsonCommonSettings *cfg, const Packet *p, const Flow *f,
         SCJsonBuilder *js, enum SCOutputJsonLogDirection dir);
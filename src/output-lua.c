@@ -783,13 +783,16 @@ static OutputInitResult OutputLuaLogInit(SCConfNode *conf)
             om->stream_type = STREAMING_HTTP_BODIES;
             om->alproto = ALPROTO_HTTP1;
             AppLayerHtpEnableRequestBodyCallback();
-            AppLayerHtpEnableResponseBodyCallback();
+            AppLayerHtpEnableResponseBodyLogging();
         } else if (opts.alproto == ALPROTO_HTTP1) {
             om->TxLogFunc = LuaTxLogger;
             om->alproto = ALPROTO_HTTP1;
             om->ts_log_progress = -1;
             om->tc_log_progress = -1;
             SCAppLayerParserRegisterLogger(IPPROTO_TCP, ALPROTO_HTTP1);
+            /* scripts can access the http bodies */
+            AppLayerHtpEnableRequestBodyCallback();
+            AppLayerHtpEnableResponseBodyCallback();
         } else if (opts.alproto == ALPROTO_TLS) {
             om->TxLogFunc = LuaTxLogger;
             om->alproto = ALPROTO_TLS;
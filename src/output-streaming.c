@@ -87,6 +87,9 @@ int SCOutputRegisterStreamingLogger(LoggerId id, const char *name, SCStreamingLo
 
     if (op->type == STREAMING_TCP_DATA) {
         stream_config.streaming_log_api = true;
+    } else if (op->type == STREAMING_HTTP_BODIES) {
+        AppLayerHtpEnableRequestBodyCallback();
+        AppLayerHtpEnableResponseBodyLogging();
     }
 
     SCLogDebug("OutputRegisterStreamingLogger happy");
@@ -333,6 +333,133 @@ static void OutputTxLogCallLoggers(ThreadVars *tv, OutputTxLoggerThreadData *op_
     }
 }
 
+/** per packet constants for OutputTxLogTx */
+struct TxLogParams {
+    void *alstate;
+    uint8_t ipproto;
+    AppProto alproto;
+    LoggerId logger_expectation;
+    bool file_logging_active;
+    bool support_files;
+    uint8_t pkt_dir;
+    uint8_t ts_disrupt_flags;
+    uint8_t tc_disrupt_flags;
+    int complete_ts;
+    int complete_tc;
+    bool ts_eof;
+    bool tc_eof;
+    bool eof;
+};
+
+enum TxLogResult {
+    /** tx skipped, doesn't affect the log id */
+    TX_LOG_SKIP = 0,
+    /** tx is not (fully) logged yet */
+    TX_LOG_GAP,
+    /** all loggers are done with the tx */
+    TX_LOG_COMPLETE,
+};
+
+/** \internal
+ *  \brief run the file and tx loggers for a single tx */
+static enum TxLogResult OutputTxLogTx(ThreadVars *tv, OutputTxLoggerThreadData *op_thread_data,
+        Packet *p, Flow *f, void *tx, const uint64_t tx_id, const struct TxLogParams *lp)
+{
+    SCLogDebug("STARTING tx_id %" PRIu64 ", tx %p", tx_id, tx);
+
+    AppLayerTxData *txd = AppLayerParserGetTxData(lp->ipproto, lp->alproto, tx);
+
+    const int tx_progress_ts =
+            AppLayerParserGetStateProgress(lp->ipproto, lp->alproto, tx, lp->ts_disrupt_flags);
+    const int tx_progress_tc =
+            AppLayerParserGetStateProgress(lp->ipproto, lp->alproto, tx, lp->tc_disrupt_flags);
+    const bool tx_complete =
+            (tx_progress_ts == lp->complete_ts && tx_progress_tc == lp->complete_tc);
+
+    SCLogDebug("file_thread_data %p filedata_thread_data %p", op_thread_data->file,
+            op_thread_data->filedata);
+
+    if (lp->file_logging_active) {
+        if (txd->file_tx != 0) { // need to process each tx that might be a file tx,
+                                 // even if there are not files (yet)
+            const bool ts_ready = (tx_progress_ts == lp->complete_ts);
+            const bool tc_ready = (tx_progress_tc == lp->complete_tc);
+            SCLogDebug("ts_ready %d tc_ready %d", ts_ready, tc_ready);
+
+            const bool eval_files =
+                    ts_ready | tc_ready | tx_complete | lp->ts_eof | lp->tc_eof | lp->eof;
+
+            SCLogDebug("eval_files: %u, ts_ready %u, tc_ready %u, tx_complete %u, ts_eof %u, "
+                       "tc_eof %u, eof %u",
+                    eval_files, ts_ready, tc_ready, tx_complete, lp->ts_eof, lp->tc_eof, lp->eof);
+            SCLogDebug("txd->file_tx & pkt_dir: %02x & %02x -> %02x", txd->file_tx, lp->pkt_dir,
+                    (txd->file_tx & lp->pkt_dir));
+
+            /* call only for the correct direction, except when it looks anything like a end of
+             * transaction or end of stream. Since OutputTxLogFiles has complicated logic around
+             * that, we just leave it to that function to sort things out for now. */
+            if (eval_files || ((txd->file_tx & lp->pkt_dir) != 0)) {
+                OutputTxLogFiles(tv, op_thread_data->file, op_thread_data->filedata, p, f, tx,
+                        tx_id, txd, tx_complete, ts_ready, tc_ready, lp->ts_eof, lp->tc_eof,
+                        lp->eof);
+            }
+        } else if (lp->support_files) {
+            if (op_thread_data->file) {
+                txd->logged |= BIT_U32(LOGGER_FILE);
+                SCLogDebug("not a file_tx: setting LOGGER_FILE => %08x", txd->logged);
+            }
+            if (op_thread_data->filedata) {
+                txd->logged |= BIT_U32(LOGGER_FILEDATA);
+                SCLogDebug("not a file_tx: setting LOGGER_FILEDATA => %08x", txd->logged);
+            }
+        }
+    }
+    SCLogDebug("logger: expect %08x, have %08x", lp->logger_expectation, txd->logged);
+    if (!txd->updated_tc && !txd->updated_ts && !(tx_progress_ts == lp->complete_ts) &&
+            !(tx_progress_tc == lp->complete_tc) && !lp->ts_eof && !lp->tc_eof) {
+        return TX_LOG_GAP;
+    }
+
+    if (list[ALPROTO_UNKNOWN] != 0) {
+        OutputTxLogList0(tv, op_thread_data, p, f, tx, tx_id);
+        if (list[lp->alproto] == NULL)
+            return TX_LOG_SKIP;
+    }
+
+    SCLogDebug("tx %p/%" PRIu64 " txd %p: log_flags %x logger_expectation %x", tx, tx_id, txd,
+            txd->config.log_flags, lp->logger_expectation);
+    if (txd->config.log_flags & BIT_U8(CONFIG_TYPE_TX)) {
+        SCLogDebug("SKIP tx %p/%"PRIu64, tx, tx_id);
+        // so that AppLayerParserTransactionsCleanup can clean this tx
+        txd->logged |= lp->logger_expectation;
+        return TX_LOG_SKIP;
+    }
+
+    if (txd->logged == lp->logger_expectation) {
+        SCLogDebug("fully logged");
+        /* tx already fully logged */
+        return TX_LOG_SKIP;
+    }
+
+    SCLogDebug("logger: expect %08x, have %08x", lp->logger_expectation, txd->logged);
+    const OutputTxLogger *logger = list[lp->alproto];
+    const OutputLoggerThreadStore *store = op_thread_data->store[lp->alproto];
+    struct Ctx ctx = { .tx_logged = txd->logged, .tx_logged_old = txd->logged };
+    SCLogDebug("logger: expect %08x, have %08x", lp->logger_expectation, ctx.tx_logged);
+
+    OutputTxLogCallLoggers(tv, op_thread_data, logger, store, p, f, lp->alstate, tx, tx_id,
+            lp->alproto, lp->eof, tx_progress_ts, tx_progress_tc, &ctx);
+
+    SCLogDebug("logger: expect %08x, have %08x", lp->logger_expectation, ctx.tx_logged);
+    if (ctx.tx_logged != ctx.tx_logged_old) {
+        SCLogDebug("logger: storing %08x (was %08x)", ctx.tx_logged, ctx.tx_logged_old);
+        DEBUG_VALIDATE_BUG_ON(txd == NULL);
+        txd->logged |= ctx.tx_logged;
+    }
+
+    return (ctx.tx_logged == lp->logger_expectation) ? TX_LOG_COMPLETE : TX_LOG_GAP;
+}
+
 static TmEcode OutputTxLog(ThreadVars *tv, Packet *p, void *thread_data)
 {
     DEBUG_VALIDATE_BUG_ON(thread_data == NULL);
@@ -387,16 +514,47 @@ static TmEcode OutputTxLog(ThreadVars *tv, Packet *p, void *thread_data)
     const bool eof = last_pseudo || (ts_eof && tc_eof);
     SCLogDebug("eof %d last_pseudo %d ts_eof %d tc_eof %d", eof, last_pseudo, ts_eof, tc_eof);
 
-    const uint8_t ts_disrupt_flags = FlowGetDisruptionFlags(f, STREAM_TOSERVER);
-    const uint8_t tc_disrupt_flags = FlowGetDisruptionFlags(f, STREAM_TOCLIENT);
-    SCLogDebug("ts_disrupt_flags %02x tc_disrupt_flags %02x", ts_disrupt_flags, tc_disrupt_flags);
+    const struct TxLogParams lp = {
+        .alstate = alstate,
+        .ipproto = ipproto,
+        .alproto = alproto,
+        .logger_expectation = logger_expectation,
+        .file_logging_active = file_logging_active,
+        .support_files = AppLayerParserSupportsFiles(ipproto, alproto),
+        .pkt_dir = STREAM_FLAGS_FOR_PACKET(p),
+        .ts_disrupt_flags = FlowGetDisruptionFlags(f, STREAM_TOSERVER),
+        .tc_disrupt_flags = FlowGetDisruptionFlags(f, STREAM_TOCLIENT),
+        .complete_ts = AppLayerParserGetStateProgressCompletionStatus(alproto, STREAM_TOSERVER),
+        .complete_tc = AppLayerParserGetStateProgressCompletionStatus(alproto, STREAM_TOCLIENT),
+        .ts_eof = ts_eof,
+        .tc_eof = tc_eof,
+        .eof = eof,
+    };
+    SCLogDebug("ts_disrupt_flags %02x tc_disrupt_flags %02x", lp.ts_disrupt_flags,
+            lp.tc_disrupt_flags);
+
+    /* if the parser maintains a tx ready queue, only the txs in it can have
+     * become loggable since the last run. The log id is then left to the
+     * cleanup to move forward. */
+    const uint64_t *ready_ids = NULL;
+    uint16_t ready_cnt = 0;
+    if (!last_pseudo && AppLayerParserGetTxReadyQueue(f, &ready_ids, &ready_cnt)) {
+        SCLogDebug("pcap_cnt %" PRIu64 ": tx ready queue with %u txs", PcapPacketCntGet(p),
+                ready_cnt);
+        for (uint16_t i = 0; i < ready_cnt; i++) {
+            void *tx = AppLayerParserGetTx(ipproto, alproto, alstate, ready_ids[i]);
+            if (tx != NULL) {
+                (void)OutputTxLogTx(tv, op_thread_data, p, f, tx, ready_ids[i], &lp);
+            }
+        }
+        goto end;
+    }
+
     const uint64_t total_txs = AppLayerParserGetTxCnt(f, alstate);
     uint64_t tx_id = AppLayerParserGetTransactionLogId(f->alparser);
     uint64_t max_id = tx_id;
     int logged = 0;
     bool gap = false;
-    const bool support_files = AppLayerParserSupportsFiles(ipproto, alproto);
-    const uint8_t pkt_dir = STREAM_FLAGS_FOR_PACKET(p);
 
     SCLogDebug("pcap_cnt %" PRIu64 ": tx_id %" PRIu64 " total_txs %" PRIu64, PcapPacketCntGet(p),
             tx_id, total_txs);
@@ -405,105 +563,13 @@ static TmEcode OutputTxLog(ThreadVars *tv, Packet *p, void *thread_data)
     AppLayerGetTxIterState state;
     memset(&state, 0, sizeof(state));
 
-    const int complete_ts =
-            AppLayerParserGetStateProgressCompletionStatus(alproto, STREAM_TOSERVER);
-    const int complete_tc =
-            AppLayerParserGetStateProgressCompletionStatus(alproto, STREAM_TOCLIENT);
     while (1) {
         AppLayerGetTxIterTuple ires = IterFunc(ipproto, alproto, alstate, tx_id, total_txs, &state);
         if (ires.tx_ptr == NULL)
             break;
-        void * const tx = ires.tx_ptr;
         tx_id = ires.tx_id;
-        SCLogDebug("STARTING tx_id %" PRIu64 ", tx %p", tx_id, tx);
-
-        AppLayerTxData *txd = AppLayerParserGetTxData(ipproto, alproto, tx);
-
-        const int tx_progress_ts =
-                AppLayerParserGetStateProgress(ipproto, alproto, tx, ts_disrupt_flags);
-        const int tx_progress_tc =
-                AppLayerParserGetStateProgress(ipproto, alproto, tx, tc_disrupt_flags);
-        const bool tx_complete = (tx_progress_ts == complete_ts && tx_progress_tc == complete_tc);
-
-        SCLogDebug("file_thread_data %p filedata_thread_data %p", op_thread_data->file,
-                op_thread_data->filedata);
-
-        if (file_logging_active) {
-            if (txd->file_tx != 0) { // need to process each tx that might be a file tx,
-                                     // even if there are not files (yet)
-                const bool ts_ready = (tx_progress_ts == complete_ts);
-                const bool tc_ready = (tx_progress_tc == complete_tc);
-                SCLogDebug("ts_ready %d tc_ready %d", ts_ready, tc_ready);
-
-                const bool eval_files = ts_ready | tc_ready | tx_complete | ts_eof | tc_eof | eof;
-
-                SCLogDebug("eval_files: %u, ts_ready %u, tc_ready %u, tx_complete %u, ts_eof %u, "
-                           "tc_eof %u, eof %u",
-                        eval_files, ts_ready, tc_ready, tx_complete, ts_eof, tc_eof, eof);
-                SCLogDebug("txd->file_tx & pkt_dir: %02x & %02x -> %02x", txd->file_tx, pkt_dir,
-                        (txd->file_tx & pkt_dir));
-
-                /* call only for the correct direction, except when it looks anything like a end of
-                 * transaction or end of stream. Since OutputTxLogFiles has complicated logic around
-                 * that, we just leave it to that function to sort things out for now. */
-                if (eval_files || ((txd->file_tx & pkt_dir) != 0)) {
-                    OutputTxLogFiles(tv, op_thread_data->file, op_thread_data->filedata, p, f, tx,
-                            tx_id, txd, tx_complete, ts_ready, tc_ready, ts_eof, tc_eof, eof);
-                }
-            } else if (support_files) {
-                if (op_thread_data->file) {
-                    txd->logged |= BIT_U32(LOGGER_FILE);
-                    SCLogDebug("not a file_tx: setting LOGGER_FILE => %08x", txd->logged);
-                }
-                if (op_thread_data->filedata) {
-                    txd->logged |= BIT_U32(LOGGER_FILEDATA);
-                    SCLogDebug("not a file_tx: setting LOGGER_FILEDATA => %08x", txd->logged);
-                }
-            }
-        }
-        SCLogDebug("logger: expect %08x, have %08x", logger_expectation, txd->logged);
-        if (!txd->updated_tc && !txd->updated_ts && !(tx_progress_ts == complete_ts) &&
-                !(tx_progress_tc == complete_tc) && !ts_eof && !tc_eof) {
-            gap = true;
-            goto next_tx;
-        }
-
-        if (list[ALPROTO_UNKNOWN] != 0) {
-            OutputTxLogList0(tv, op_thread_data, p, f, tx, tx_id);
-            if (list[alproto] == NULL)
-                goto next_tx;
-        }
 
-        SCLogDebug("tx %p/%" PRIu64 " txd %p: log_flags %x logger_expectation %x", tx, tx_id, txd,
-                txd->config.log_flags, logger_expectation);
-        if (txd->config.log_flags & BIT_U8(CONFIG_TYPE_TX)) {
-            SCLogDebug("SKIP tx %p/%"PRIu64, tx, tx_id);
-            // so that AppLayerParserTransactionsCleanup can clean this tx
-            txd->logged |= logger_expectation;
-            goto next_tx;
-        }
-
-        if (txd->logged == logger_expectation) {
-            SCLogDebug("fully logged");
-            /* tx already fully logged */
-            goto next_tx;
-        }
-
-        SCLogDebug("logger: expect %08x, have %08x", logger_expectation, txd->logged);
-        const OutputTxLogger *logger = list[alproto];
-        const OutputLoggerThreadStore *store = op_thread_data->store[alproto];
-        struct Ctx ctx = { .tx_logged = txd->logged, .tx_logged_old = txd->logged };
-        SCLogDebug("logger: expect %08x, have %08x", logger_expectation, ctx.tx_logged);
-
-        OutputTxLogCallLoggers(tv, op_thread_data, logger, store, p, f, alstate, tx, tx_id, alproto,
-                eof, tx_progress_ts, tx_progress_tc, &ctx);
-
-        SCLogDebug("logger: expect %08x, have %08x", logger_expectation, ctx.tx_logged);
-        if (ctx.tx_logged != ctx.tx_logged_old) {
-            SCLogDebug("logger: storing %08x (was %08x)", ctx.tx_logged, ctx.tx_logged_old);
-            DEBUG_VALIDATE_BUG_ON(txd == NULL);
-            txd->logged |= ctx.tx_logged;
-        }
+        const enum TxLogResult r = OutputTxLogTx(tv, op_thread_data, p, f, ires.tx_ptr, tx_id, &lp);
 
         /* If all loggers logged set a flag and update the last tx_id
          * that was logged.
@@ -511,15 +577,15 @@ static TmEcode OutputTxLog(ThreadVars *tv, Packet *p, void *thread_data)
          * If not all loggers were logged we flag that there was a gap
          * so any subsequent transactions in this loop don't increase
          * the maximum ID that was logged. */
-        if (!gap && ctx.tx_logged == logger_expectation) {
-            SCLogDebug("no gap %d, %08x == %08x", gap, ctx.tx_logged, logger_expectation);
+        if (r == TX_LOG_COMPLETE && !gap) {
+            SCLogDebug("no gap %d, tx_id %" PRIu64 " fully logged", gap, tx_id);
             logged = 1;
             max_id = tx_id;
             SCLogDebug("max_id %" PRIu64, max_id);
-        } else {
+        } else if (r != TX_LOG_SKIP) {
             gap = true;
         }
-next_tx:
+
         if (!ires.has_next)
             break;
         tx_id++;
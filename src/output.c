@@ -490,6 +490,20 @@ error:
 void OutputRegisterFlowSubModule(LoggerId id, const char *parent_name, const char *name,
         const char *conf_name, OutputInitSubFunc InitFunc, FlowLogger FlowLogFunc,
         ThreadInitFunc ThreadInit, ThreadDeinitFunc ThreadDeinit)
+{
+    OutputRegisterFlowSubModuleWithFlush(id, parent_name, name, conf_name, InitFunc, FlowLogFunc,
+            NULL, ThreadInit, ThreadDeinit);
+}
+
+/**
+ * \brief Register a flow output sub-module with a periodic flush function.
+ *
+ * Like OutputRegisterFlowSubModule(). The flush function is called
+ * periodically by the threads running the flow loggers.
+ */
+void OutputRegisterFlowSubModuleWithFlush(LoggerId id, const char *parent_name, const char *name,
+        const char *conf_name, OutputInitSubFunc InitFunc, FlowLogger FlowLogFunc,
+        FlowLoggerFlush FlowLogFlushFunc, ThreadInitFunc ThreadInit, ThreadDeinitFunc ThreadDeinit)
 {
     if (unlikely(FlowLogFunc == NULL)) {
         goto error;
@@ -506,6 +520,7 @@ void OutputRegisterFlowSubModule(LoggerId id, const char *parent_name, const cha
     module->parent_name = parent_name;
     module->InitSubFunc = InitFunc;
     module->FlowLogFunc = FlowLogFunc;
+    module->FlowLogFlushFunc = FlowLogFlushFunc;
     module->ThreadInit = ThreadInit;
     module->ThreadDeinit = ThreadDeinit;
     TAILQ_INSERT_TAIL(&output_modules, module, entries);
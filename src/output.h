@@ -71,6 +71,7 @@ typedef struct OutputModule_ {
     SCFileLogger FileLogFunc;
     SCFiledataLogger FiledataLogFunc;
     FlowLogger FlowLogFunc;
+    FlowLoggerFlush FlowLogFlushFunc;
     SCStreamingLogger StreamingLogFunc;
     StatsLogger StatsLogFunc;
     AppProto alproto;
@@ -133,6 +134,9 @@ void OutputRegisterFiledataModule(LoggerId id, const char *name, const char *con
 void OutputRegisterFlowSubModule(LoggerId id, const char *parent_name, const char *name,
         const char *conf_name, OutputInitSubFunc InitFunc, FlowLogger FlowLogFunc,
         ThreadInitFunc ThreadInit, ThreadDeinitFunc ThreadDeinit);
+void OutputRegisterFlowSubModuleWithFlush(LoggerId id, const char *parent_name, const char *name,
+        const char *conf_name, OutputInitSubFunc InitFunc, FlowLogger FlowLogFunc,
+        FlowLoggerFlush FlowLogFlushFunc, ThreadInitFunc ThreadInit, ThreadDeinitFunc ThreadDeinit);
 
 void OutputRegisterStreamingModule(LoggerId id, const char *name, const char *conf_name,
         OutputInitFunc InitFunc, SCStreamingLogger StreamingLogFunc,
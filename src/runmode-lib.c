@@ -22,9 +22,25 @@
  *  Library runmode.
  */
 #include "suricata-common.h"
+#include "suricata.h"
 #include "runmode-lib.h"
 #include "runmodes.h"
 #include "tm-threads.h"
+#include "tmqh-packetpool.h"
+#include "action-globals.h"
+#include "packet.h"
+#include "util-time.h"
+
+struct SCLibInjector_ {
+    ThreadVars *tv;
+    LiveDevice *device;
+    uint16_t livedev_id;
+    int datalink;
+    SCLibReleaseFunc Release;
+    void *arg;
+    /** thread timestamps have been initialized from the first packet */
+    bool ts_init;
+};
 
 ThreadVars *SCRunModeLibCreateThreadVars(int worker_id)
 {
@@ -74,3 +90,95 @@ int SCRunModeLibSpawnWorker(void *td)
     TmThreadsSetFlag(tv, THV_RUNNING);
     return 0;
 }
+
+SCLibInjector *SCRunModeLibInjectorNew(
+        ThreadVars *tv, LiveDevice *device, int datalink, SCLibReleaseFunc Release, void *arg)
+{
+    if (tv == NULL || Release == NULL) {
+        SCLogError("injector needs a worker and a release callback");
+        return NULL;
+    }
+    SCLibInjector *inj = SCCalloc(1, sizeof(*inj));
+    if (inj == NULL) {
+        return NULL;
+    }
+    inj->tv = tv;
+    inj->device = device;
+    inj->livedev_id = LiveDeviceGetId(device);
+    inj->datalink = datalink;
+    inj->Release = Release;
+    inj->arg = arg;
+    return inj;
+}
+
+void SCRunModeLibInjectorFree(SCLibInjector *inj)
+{
+    SCFree(inj);
+}
+
+/** \brief release function of injected packets
+ *
+ *  Returns the packet to the pool before handing the buffer back to the
+ *  application, so Suricata no longer references it in the callback. */
+static void LibInjectReleasePacket(Packet *p)
+{
+    const SCLibInjector *inj = p->lib_v.injector;
+    void *user = p->lib_v.user;
+    const SCLibVerdict verdict =
+            PacketCheckAction(p, ACTION_DROP) ? SC_LIB_VERDICT_DROP : SC_LIB_VERDICT_ACCEPT;
+
+    PacketFreeOrRelease(p);
+
+    inj->Release(user, verdict, inj->arg);
+}
+
+uint32_t SCRunModeLibInject(SCLibInjector *inj, const SCLibPacket *pkts, uint32_t cnt)
+{
+    ThreadVars *tv = inj->tv;
+
+    if (cnt == 0 || (suricata_ctl_flags & SURICATA_STOP)) {
+        return 0;
+    }
+
+    /* when replaying, time starts at the first packet */
+    if (!inj->ts_init) {
+        if (!TimeModeIsLive()) {
+            TmThreadsInitThreadsTimestamp(pkts[0].ts);
+        }
+        inj->ts_init = true;
+    }
+
+    uint32_t i = 0;
+    for (; i < cnt; i++) {
+        const SCLibPacket *lp = &pkts[i];
+        if (unlikely(lp->data == NULL)) {
+            SCLogError("packet %u of the batch has no data", i);
+            break;
+        }
+
+        Packet *p = PacketGetFromQueueOrAlloc();
+        if (unlikely(p == NULL)) {
+            break;
+        }
+        p->pkt_src = PKT_SRC_WIRE;
+        p->ts = lp->ts;
+        p->datalink = inj->datalink;
+        p->livedev_id = inj->livedev_id;
+        p->ReleasePacket = LibInjectReleasePacket;
+        p->lib_v.injector = inj;
+        p->lib_v.user = lp->user;
+        (void)PacketSetData(p, lp->data, lp->len);
+
+        if (TmThreadsSlotProcessPkt(tv, tv->tm_slots, p) != TM_ECODE_OK) {
+            /* the packet is consumed and was released by the slot
+             * processing, which called the callback */
+            i++;
+            break;
+        }
+    }
+
+    if (inj->device != NULL) {
+        LiveDevicePktsAdd(inj->device, i);
+    }
+    return i;
+}
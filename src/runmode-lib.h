@@ -26,6 +26,8 @@
 #define SURICATA_RUNMODE_LIB_H
 
 #include "threadvars.h"
+#include "util-device.h"
+#include "util-time.h"
 
 /**
  * \brief Create ThreadVars for use by a user provided thread.
@@ -45,4 +47,82 @@ ThreadVars *SCRunModeLibCreateThreadVars(int worker_id);
  */
 int SCRunModeLibSpawnWorker(void *);
 
+/**
+ * \brief An externally owned packet buffer to inject.
+ *
+ * The data is not copied. It must stay valid and unmodified until the
+ * release callback of the injector is called for it.
+ */
+typedef struct SCLibPacket_ {
+    const uint8_t *data;
+    uint32_t len;
+    SCTime_t ts;
+    /** passed to the release callback, e.g. a ring buffer slot */
+    void *user;
+} SCLibPacket;
+
+/** \brief Verdict for a packet, passed to the release callback. */
+typedef enum SCLibVerdict {
+    SC_LIB_VERDICT_ACCEPT = 0,
+    SC_LIB_VERDICT_DROP,
+} SCLibVerdict;
+
+/**
+ * \brief Release callback for injected packets.
+ *
+ * Called once for every packet consumed by SCRunModeLibInject(), when
+ * Suricata is done with the buffer. Typically this is before
+ * SCRunModeLibInject() returns, but it can be later, e.g. for packets
+ * that are held until their tunneled packets are processed. It is called
+ * from the worker thread.
+ *
+ * \param user the user pointer of the SCLibPacket
+ * \param verdict drop or accept, only meaningful in IPS mode
+ * \param arg the arg passed to SCRunModeLibInjectorNew()
+ */
+typedef void (*SCLibReleaseFunc)(void *user, SCLibVerdict verdict, void *arg);
+
+typedef struct SCLibInjector_ SCLibInjector;
+
+/**
+ * \brief Create a packet injector for a worker.
+ *
+ * To be used from the worker thread, after SCRunModeLibSpawnWorker().
+ *
+ * \param tv the worker's ThreadVars
+ * \param device live device the packets are accounted to, may be NULL
+ * \param datalink datalink type of the packets, e.g. LINKTYPE_ETHERNET
+ * \param Release callback for the packet buffers
+ * \param arg passed to the release callback
+ *
+ * \return injector or NULL on error
+ */
+SCLibInjector *SCRunModeLibInjectorNew(
+        ThreadVars *tv, LiveDevice *device, int datalink, SCLibReleaseFunc Release, void *arg);
+
+/**
+ * \brief Free an injector.
+ *
+ * All packets injected through it must have been released.
+ */
+void SCRunModeLibInjectorFree(SCLibInjector *inj);
+
+/**
+ * \brief Inject a batch of packets without copying their data.
+ *
+ * The packets are processed in order by the worker. The per call work,
+ * such as checking for shutdown and updating the device counters, is done
+ * once per batch.
+ *
+ * \param inj the injector
+ * \param pkts array of packets
+ * \param cnt number of packets in the array
+ *
+ * \return number of packets consumed. Each of them gets exactly one
+ *         release callback. If this is less than cnt, the engine is shutting
+ *         down or an error occurred. The remaining packets are not touched
+ *         and stay owned by the caller.
+ */
+uint32_t SCRunModeLibInject(SCLibInjector *inj, const SCLibPacket *pkts, uint32_t cnt);
+
 #endif /* SURICATA_RUNMODE_LIB_H */
@@ -29,6 +29,7 @@
 #include "detect-parse.h"
 #include "detect-engine.h"
 #include "detect-engine-alert.h"
+#include "detect-engine-analyzer.h"
 #include "detect-engine-address.h"
 #include "detect-engine-proto.h"
 #include "detect-engine-port.h"
@@ -78,6 +79,7 @@
 #include "util-magic.h"
 #include "util-memcmp.h"
 #include "util-misc.h"
+#include "util-capture-poll.h"
 #include "util-signal.h"
 #include "util-affinity.h"
 
@@ -117,6 +119,7 @@
 #include "decode-pppoe.h"
 #include "source-pcap-file-helper.h"
 
+#include "output-json.h"
 #include "output-json-stats.h"
 
 #ifdef OS_WIN32
@@ -175,7 +178,9 @@ static void RegisterUnittests(void)
     SCConfRegisterTests();
     SCConfYamlRegisterTests();
     TmqhFlowRegisterTests();
+    PacketPoolRegisterTests();
     FlowRegisterTests();
+    FlowMgrRegisterTests();
     HostRegisterUnittests();
     IPPairRegisterUnittests();
     SCSigRegisterSignatureOrderingTests();
@@ -199,9 +204,11 @@ static void RegisterUnittests(void)
     DeStateRegisterTests();
     MemcmpRegisterTests();
     DetectEngineRegisterTests();
+    DetectEngineAnalyzerRegisterTests();
     SCLogRegisterTests();
     MagicRegisterTests();
     UtilMiscRegisterTests();
+    CapturePollRegisterTests();
     ThreadingAffinityRegisterTests();
     DetectAddressTests();
     DetectProtoTests();
@@ -223,6 +230,7 @@ static void RegisterUnittests(void)
     SCProtoNameRegisterTests();
     UtilCIDRTests();
     OutputJsonStatsRegisterTests();
+    OutputJsonRegisterTests();
     CoredumpConfigRegisterTests();
 }
 #endif
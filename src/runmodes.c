@@ -611,8 +611,8 @@ static void SetupOutput(
 {
     /* flow logger doesn't run in the packet path */
     if (module->FlowLogFunc) {
-        SCOutputRegisterFlowLogger(module->name, module->FlowLogFunc, output_ctx,
-                module->ThreadInit, module->ThreadDeinit);
+        SCOutputRegisterFlowLoggerWithFlush(module->name, module->FlowLogFunc,
+                module->FlowLogFlushFunc, output_ctx, module->ThreadInit, module->ThreadDeinit);
         return;
     }
     /* stats logger doesn't run in the packet path */
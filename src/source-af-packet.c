@@ -43,6 +43,7 @@
 #include "tm-threads.h"
 #include "tm-threads-common.h"
 #include "conf.h"
+#include "util-capture-poll.h"
 #include "util-cpu.h"
 #include "util-datalink.h"
 #include "util-debug.h"
@@ -297,6 +298,10 @@ typedef struct AFPThreadVars_
     StatsCounterId capture_afp_poll_err;
     StatsCounterId capture_afp_send_err;
 
+    /* idle handling, poll() without timeout while not blocking */
+    CapturePoll cpoll;
+    bool poll_block;
+
     int64_t send_errors_logged; /**< snapshot of send errors logged. */
 
     /* handle state */
@@ -1402,7 +1407,10 @@ TmEcode ReceiveAFPLoop(ThreadVars *tv, void *data, void *slot)
 
         StatsCounterIncr(&ptv->tv->stats, ptv->capture_afp_poll);
 
-        r = poll(&fds, 1, POLL_TIMEOUT);
+        if (ptv->poll_block) {
+            CapturePollBlock(&ptv->cpoll, tv);
+        }
+        r = poll(&fds, 1, ptv->poll_block ? POLL_TIMEOUT : 0);
 
         if (suricata_ctl_flags != 0) {
             break;
@@ -1429,6 +1437,8 @@ TmEcode ReceiveAFPLoop(ThreadVars *tv, void *data, void *slot)
             }
         } else if (r > 0) {
             StatsCounterIncr(&ptv->tv->stats, ptv->capture_afp_poll_data);
+            CapturePollBusy(&ptv->cpoll, tv);
+            ptv->poll_block = !CapturePollEnabled(&ptv->cpoll);
             r = AFPReadFunc(ptv);
             switch (r) {
                 case AFP_READ_OK:
@@ -1451,7 +1461,7 @@ TmEcode ReceiveAFPLoop(ThreadVars *tv, void *data, void *slot)
                     AFPDumpCounters(ptv);
                     break;
             }
-        } else if (unlikely(r == 0)) {
+        } else if (r == 0) {
             StatsCounterIncr(&ptv->tv->stats, ptv->capture_afp_poll_timeout);
             /* Trigger one dump of stats every second */
             current_time = time(NULL);
@@ -1459,8 +1469,13 @@ TmEcode ReceiveAFPLoop(ThreadVars *tv, void *data, void *slot)
                 AFPDumpCounters(ptv);
                 last_dump = current_time;
             }
-            /* poll timed out, lets see handle our timeout path */
-            TmThreadsCaptureHandleTimeout(tv, NULL);
+            /* the poll controller runs our timeout path and decides when
+             * to block again */
+            if (ptv->poll_block) {
+                (void)CapturePollIdle(&ptv->cpoll, tv);
+            } else {
+                ptv->poll_block = CapturePollIdle(&ptv->cpoll, tv);
+            }
 
         } else if ((r < 0) && (errno != EINTR)) {
             StatsCounterIncr(&ptv->tv->stats, ptv->capture_afp_poll_err);
@@ -2630,6 +2645,9 @@ TmEcode ReceiveAFPThreadInit(ThreadVars *tv, const void *initdata, void **data)
             StatsRegisterCounter("capture.afpacket.send_errors", &ptv->tv->stats);
 #endif
 
+    CapturePollInit(&ptv->cpoll, ptv->tv);
+    ptv->poll_block = true;
+
     ptv->copy_mode = afpconfig->copy_mode;
     if (ptv->copy_mode != AFP_COPY_MODE_NONE) {
         strlcpy(ptv->out_iface, afpconfig->out_iface, AFP_IFACE_NAME_LENGTH);
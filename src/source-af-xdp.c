@@ -41,6 +41,7 @@
 #include "tm-threads.h"
 #include "tm-threads-common.h"
 #include "conf.h"
+#include "util-capture-poll.h"
 #include "util-cpu.h"
 #include "util-datalink.h"
 #include "util-debug.h"
@@ -196,6 +197,10 @@ typedef struct AFXDPThreadVars_ {
     StatsCounterId capture_afxdp_empty_reads;
     StatsCounterId capture_afxdp_failed_reads;
     StatsCounterId capture_afxdp_acquire_pkt_failed;
+
+    CapturePoll cpoll;
+    /** wait in poll() before the next peek */
+    bool poll_block;
 } AFXDPThreadVars;
 
 static TmEcode ReceiveAFXDPThreadInit(ThreadVars *, const void *, void **);
@@ -675,6 +680,9 @@ static TmEcode ReceiveAFXDPThreadInit(ThreadVars *tv, const void *initdata, void
     ptv->capture_afxdp_acquire_pkt_failed =
             StatsRegisterCounter("capture.afxdp.acquire_pkt_failed", &ptv->tv->stats);
 
+    CapturePollInit(&ptv->cpoll, ptv->tv);
+    ptv->poll_block = !ptv->xsk.enable_busy_poll;
+
     /* Reserve memory for umem  */
     if (AcquireBuffer(ptv) != TM_ECODE_OK) {
         SCFree(ptv);
@@ -735,16 +743,20 @@ static TmEcode ReceiveAFXDPLoop(ThreadVars *tv, void *data, void *slot)
 
         /* Busy polling is not set, using poll() to maintain (relatively) decent
          * performance. xdp_busy_poll must be disabled for kernels < 5.11
+         * With adaptive polling, poll() is only used once the controller
+         * gives up on polling the ring directly.
          */
-        if (!ptv->xsk.enable_busy_poll) {
+        if (ptv->poll_block) {
             StatsCounterIncr(&ptv->tv->stats, ptv->capture_afxdp_poll);
 
+            CapturePollBlock(&ptv->cpoll, ptv->tv);
             r = poll(&ptv->xsk.fd, 1, POLL_TIMEOUT);
 
             /* Report poll results */
             if (r <= 0) {
                 if (r == 0) {
                     StatsCounterIncr(&ptv->tv->stats, ptv->capture_afxdp_poll_timeout);
+                    (void)CapturePollIdle(&ptv->cpoll, ptv->tv);
                 } else if (r < 0) {
                     StatsCounterIncr(&ptv->tv->stats, ptv->capture_afxdp_poll_failed);
                     SCLogWarning("poll failed with retval %d", r);
@@ -764,9 +776,14 @@ static TmEcode ReceiveAFXDPLoop(ThreadVars *tv, void *data, void *slot)
                 SCLogWarning("recv failed with retval %ld", ret);
                 AFXDPSwitchState(ptv, AFXDP_STATE_DOWN);
             }
+            /* without the controller, busy poll mode never blocks */
+            ptv->poll_block = CapturePollIdle(&ptv->cpoll, ptv->tv) &&
+                              (CapturePollEnabled(&ptv->cpoll) || !ptv->xsk.enable_busy_poll);
             DumpStatsEverySecond(ptv, &last_dump);
             continue;
         }
+        CapturePollBusy(&ptv->cpoll, ptv->tv);
+        ptv->poll_block = !CapturePollEnabled(&ptv->cpoll) && !ptv->xsk.enable_busy_poll;
 
         uint32_t res = xsk_ring_prod__reserve(&ptv->umem.fq, rcvd, &idx_fq);
         while (res != rcvd) {
@@ -87,6 +87,7 @@ TmEcode NoDPDKSupportExit(ThreadVars *tv, const void *initdata, void **data)
 #else /* We have DPDK support */
 
 #include "util-affinity.h"
+#include "util-capture-poll.h"
 #include "util-dpdk.h"
 #include "util-dpdk-i40e.h"
 #include "util-dpdk-ice.h"
@@ -137,6 +138,7 @@ typedef struct DPDKThreadVars_ {
     int32_t port_socket_id;
     struct rte_mbuf *received_mbufs[BURST_SIZE];
     DPDKWorkerSync *workers_sync;
+    CapturePoll cpoll;
 } DPDKThreadVars;
 
 static TmEcode ReceiveDPDKThreadInit(ThreadVars *, const void *, void **);
@@ -363,15 +365,12 @@ static TmEcode ReceiveDPDKLoopInit(ThreadVars *tv, DPDKThreadVars *ptv)
     SCReturnInt(TM_ECODE_OK);
 }
 
-static inline void LoopHandleTimeoutOnIdle(ThreadVars *tv)
+static inline void InterruptsWaitForPackets(DPDKThreadVars *ptv)
 {
-    static thread_local uint64_t last_timeout_msec = 0;
-    SCTime_t t = TimeGet();
-    uint64_t msecs = SCTIME_MSECS(t);
-    if (msecs > last_timeout_msec + 100) {
-        TmThreadsCaptureHandleTimeout(tv, NULL);
-        last_timeout_msec = msecs;
-    }
+    InterruptsTurnOnOff(ptv->port_id, ptv->queue_id, true);
+    struct rte_epoll_event event;
+    rte_epoll_wait(RTE_EPOLL_PER_THREAD, &event, 1, MAX_EPOLL_TIMEOUT_MS);
+    InterruptsTurnOnOff(ptv->port_id, ptv->queue_id, false);
 }
 
 /**
@@ -384,10 +383,23 @@ static inline bool RXPacketCountHeuristic(ThreadVars *tv, DPDKThreadVars *ptv, u
 
     if (nb_rx > 0) {
         zero_pkt_polls_cnt = 0;
+        CapturePollBusy(&ptv->cpoll, tv);
         return false;
     }
 
-    LoopHandleTimeoutOnIdle(tv);
+    /* also runs the capture timeout handling */
+    const bool block = CapturePollIdle(&ptv->cpoll, tv);
+    if (CapturePollEnabled(&ptv->cpoll)) {
+        if (block) {
+            if (ptv->intr_enabled) {
+                InterruptsWaitForPackets(ptv);
+            } else {
+                rte_delay_us_sleep(STANDARD_SLEEP_TIME_US);
+            }
+        }
+        return true;
+    }
+
     if (!ptv->intr_enabled)
         return true;
 
@@ -399,10 +411,7 @@ static inline bool RXPacketCountHeuristic(ThreadVars *tv, DPDKThreadVars *ptv, u
     if (pwd_idle_hint < STANDARD_SLEEP_TIME_US) {
         rte_delay_us(pwd_idle_hint);
     } else {
-        InterruptsTurnOnOff(ptv->port_id, ptv->queue_id, true);
-        struct rte_epoll_event event;
-        rte_epoll_wait(RTE_EPOLL_PER_THREAD, &event, 1, MAX_EPOLL_TIMEOUT_MS);
-        InterruptsTurnOnOff(ptv->port_id, ptv->queue_id, false);
+        InterruptsWaitForPackets(ptv);
         return true;
     }
 
@@ -656,6 +665,7 @@ static TmEcode ReceiveDPDKThreadInit(ThreadVars *tv, const void *initdata, void
     ptv->capture_dpdk_imissed = StatsRegisterCounter("capture.dpdk.imissed", &ptv->tv->stats);
     ptv->capture_dpdk_rx_no_mbufs = StatsRegisterCounter("capture.dpdk.no_mbufs", &ptv->tv->stats);
     ptv->capture_dpdk_ierrors = StatsRegisterCounter("capture.dpdk.ierrors", &ptv->tv->stats);
+    CapturePollInit(&ptv->cpoll, ptv->tv);
 
     ptv->copy_mode = dpdk_config->copy_mode;
     ptv->checksum_mode = dpdk_config->checksum_mode;
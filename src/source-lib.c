@@ -25,6 +25,7 @@
 
 #include "suricata-common.h"
 #include "source-lib.h"
+#include "tm-threads.h"
 #include "util-device-private.h"
 
 /* Set time to the first packet timestamp when replaying a PCAP. */
@@ -26,8 +26,12 @@
 #ifndef SURICATA_SOURCE_LIB_H
 #define SURICATA_SOURCE_LIB_H
 
-#include "tm-threads.h"
-#include "util-device-private.h"
+/** \brief per packet vars of packets injected with SCRunModeLibInject() */
+typedef struct LibPacketVars_ {
+    struct SCLibInjector_ *injector;
+    /** application's pointer for the packet buffer */
+    void *user;
+} LibPacketVars;
 
 /** \brief register a "Decode" module for suricata as a library.
  *
@@ -426,6 +426,12 @@ typedef unsigned char u_char;
 #define BIT_U64(n) (1ULL << (n))
 
 #define WARN_UNUSED __attribute__((warn_unused_result))
+/** force inlining, e.g. to get a copy of a function per value of a constant
+ *  argument */
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+/** keep a function out of line, e.g. to limit the number of copies of a
+ *  large function */
+#define NOINLINE __attribute__((noinline))
 
 #if defined(__MINGW32__)
 #define ATTR_FMT_PRINTF(x, y) __attribute__((format(__MINGW_PRINTF_FORMAT, (x), (y))))
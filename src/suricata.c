@@ -53,6 +53,7 @@
 #include "detect-engine.h"
 #include "detect-engine-address.h"
 #include "detect-engine-alert.h"
+#include "detect-engine-analyzer.h"
 #include "detect-engine-port.h"
 #include "detect-engine-tag.h"
 #include "detect-engine-threshold.h"
@@ -78,6 +79,7 @@
 
 #include "output.h"
 #include "output-filestore.h"
+#include "output-json.h"
 
 #include "respond-reject.h"
 
@@ -2384,6 +2386,7 @@ void PreRunPostPrivsDropInit(const int runmode)
 
     StatsSetupPostConfigPreOutput();
     RunModeInitializeOutputs();
+    DetectEngineTrimFeaturesPostOutputs();
     DatasetsInit();
     StatsSetupPostConfigPostOutput();
 }
@@ -2604,6 +2607,7 @@ static int ConfigGetCaptureValue(SCInstance *suri)
     }
 
     SCLogDebug("Max pending packets set to %" PRIu32, max_pending_packets);
+    PacketPoolConfig();
 
     /* Pull the default packet size from the config, if not found fall
      * back on a sane default. */
@@ -2706,6 +2710,7 @@ static void PostRunStartedDetectSetup(const SCInstance *suri)
 void PostConfLoadedDetectSetup(SCInstance *suri)
 {
     DetectEngineCtx *de_ctx = NULL;
+    DetectRunSelectProfile();
     if (!suri->disabled_detect) {
         SetupDelayedDetect(suri);
         int mt_enabled = 0;
@@ -2871,6 +2876,7 @@ int PostConfLoadedSetup(SCInstance *suri)
     RegisterFlowBypassInfo();
 
     MacSetRegisterFlowStorage();
+    OutputJsonRegisterFlowStorage();
     FlowRateRegisterFlowStorage();
 
     SigTableInit();
@@ -2961,7 +2967,7 @@ int PostConfLoadedSetup(SCInstance *suri)
     }
 
     RegisterAllModules();
-    AppLayerHtpNeedFileInspection();
+    DetectEngineTrimFeaturesSetup();
 
     SCStorageFinalize();
 
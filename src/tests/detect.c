@@ -28,6 +28,7 @@
 #include "../util-unittest.h"
 #include "../util-var-name.h"
 #include "../util-unittest-helper.h"
+#include "../util-storage.h"
 
 static const char *dummy_conf_string =
     "%YAML 1.1\n"
@@ -4466,6 +4467,70 @@ static int SigTestBug01(void)
     PASS;
 }
 
+/** \test rule header summary filtering of the prefilter candidates */
+static int SigTestHeaderSummary01(void)
+{
+    ThreadVars tv;
+    DetectEngineThreadCtx *det_ctx = NULL;
+    uint8_t payload[] = "AAAAAAAAAAAAAAAAAA";
+    memset(&tv, 0, sizeof(ThreadVars));
+    StatsThreadInit(&tv.stats);
+
+    Packet *p1 = UTHBuildPacketReal(
+            payload, sizeof(payload), IPPROTO_TCP, "1.2.3.4", "5.6.7.8", 41424, 80);
+    FAIL_IF_NULL(p1);
+    DetectEngineCtx *de_ctx = DetectEngineCtxInit();
+    FAIL_IF_NULL(de_ctx);
+    de_ctx->flags |= DE_QUIET;
+    Signature *s1 = DetectEngineAppendSig(
+            de_ctx, "alert tcp any any -> any 80 (content:\"AAA\"; sid:1;)");
+    FAIL_IF_NULL(s1);
+    FAIL_IF_NULL(DetectEngineAppendSig(
+            de_ctx, "alert tcp any any -> any 81 (content:\"AAA\"; sid:2;)"));
+    Signature *s3 = DetectEngineAppendSig(
+            de_ctx, "alert tcp 1.2.3.0/24 any -> any any (content:\"AAA\"; sid:3;)");
+    FAIL_IF_NULL(s3);
+    FAIL_IF_NULL(DetectEngineAppendSig(
+            de_ctx, "alert tcp 1.2.4.0/24 any -> any any (content:\"AAA\"; sid:4;)"));
+    Signature *s5 = DetectEngineAppendSig(
+            de_ctx, "alert tcp any any -> 5.6.7.8 [80,443] (content:\"AAA\"; sid:5;)");
+    FAIL_IF_NULL(s5);
+    FAIL_IF_NULL(DetectEngineAppendSig(
+            de_ctx, "alert tcp any any -> any [81,443] (content:\"AAA\"; sid:6;)"));
+    Signature *s7 = DetectEngineAppendSig(
+            de_ctx, "alert ip [1.2.3.4,9.9.9.9] any -> any any (content:\"AAA\"; sid:7;)");
+    FAIL_IF_NULL(s7);
+    FAIL_IF_NULL(DetectEngineAppendSig(
+            de_ctx, "alert tcp any 1024: -> any any (content:\"AAA\"; sid:8;)"));
+    FAIL_IF_NULL(DetectEngineAppendSig(
+            de_ctx, "alert tcp any :1023 -> any any (content:\"AAA\"; sid:9;)"));
+    SigGroupBuild(de_ctx);
+
+    const SigHeaderSummary *hdr = &de_ctx->sig_hdr;
+    FAIL_IF_NOT(hdr->flags[s1->iid] == (SIG_HDR_PORTS | SIG_HDR_DP));
+    FAIL_IF_NOT(hdr->dp[s1->iid][0] == 80 && hdr->dp[s1->iid][1] == 80);
+    FAIL_IF_NOT(hdr->flags[s3->iid] == SIG_HDR_SRC4);
+    FAIL_IF_NOT(hdr->flags[s5->iid] == (SIG_HDR_PORTS | SIG_HDR_DST4));
+    FAIL_IF_NOT(hdr->flags[s7->iid] == 0);
+
+    DetectEngineThreadCtxInit(&tv, (void *)de_ctx, (void *)&det_ctx);
+    SigMatchSignatures(&tv, de_ctx, det_ctx, p1);
+    FAIL_IF_NOT(PacketAlertCheck(p1, 1));
+    FAIL_IF(PacketAlertCheck(p1, 2));
+    FAIL_IF_NOT(PacketAlertCheck(p1, 3));
+    FAIL_IF(PacketAlertCheck(p1, 4));
+    FAIL_IF_NOT(PacketAlertCheck(p1, 5));
+    FAIL_IF(PacketAlertCheck(p1, 6));
+    FAIL_IF_NOT(PacketAlertCheck(p1, 7));
+    FAIL_IF_NOT(PacketAlertCheck(p1, 8));
+    FAIL_IF(PacketAlertCheck(p1, 9));
+    DetectEngineThreadCtxDeinit(&tv, det_ctx);
+    DetectEngineCtxFree(de_ctx);
+    UTHFreePackets(&p1, 1);
+    StatsThreadCleanup(&tv.stats);
+    PASS;
+}
+
 static const char *dummy_conf_string2 =
     "%YAML 1.1\n"
     "---\n"
@@ -4629,6 +4694,102 @@ static int DetectAddressYamlParsing04 (void)
     PASS;
 }
 
+/** \internal
+ *  \brief run a packet in each direction of a flow with protocol \a alproto
+ *         through a rule group built from \a sig with auto-bypass on */
+static int SigTestAutoBypassFlow(const char *sig, const AppProto alproto, const bool bypass)
+{
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(tv));
+    StatsThreadInit(&tv.stats);
+    DetectEngineThreadCtx *det_ctx = NULL;
+    TcpSession ssn;
+    memset(&ssn, 0, sizeof(ssn));
+
+    SCStorageCleanup();
+    SCStorageInit();
+    RegisterFlowBypassInfo();
+    SCStorageFinalize();
+    FlowInitConfig(FLOW_QUIET);
+
+    Flow *f = FlowAlloc();
+    FAIL_IF_NULL(f);
+    f->protoctx = &ssn;
+    f->proto = IPPROTO_TCP;
+    f->protomap = FlowGetProtoMapping(IPPROTO_TCP);
+    f->flags |= FLOW_IPV4;
+    f->alproto = alproto;
+
+    Packet *p1 = UTHBuildPacketReal(NULL, 0, IPPROTO_TCP, "1.2.3.4", "5.6.7.8", 41424, 873);
+    FAIL_IF_NULL(p1);
+    p1->flow = f;
+    p1->flowflags |= FLOW_PKT_TOSERVER | FLOW_PKT_ESTABLISHED;
+    p1->flags |= PKT_HAS_FLOW | PKT_STREAM_EST;
+    Packet *p2 = UTHBuildPacketReal(NULL, 0, IPPROTO_TCP, "5.6.7.8", "1.2.3.4", 873, 41424);
+    FAIL_IF_NULL(p2);
+    p2->flow = f;
+    p2->flowflags |= FLOW_PKT_TOCLIENT | FLOW_PKT_ESTABLISHED;
+    p2->flags |= PKT_HAS_FLOW | PKT_STREAM_EST;
+
+    DetectEngineCtx *de_ctx = DetectEngineCtxInit();
+    FAIL_IF_NULL(de_ctx);
+    de_ctx->flags |= DE_QUIET;
+    de_ctx->auto_bypass = true;
+    FAIL_IF_NULL(DetectEngineAppendSig(de_ctx, sig));
+    SigGroupBuild(de_ctx);
+    DetectEngineThreadCtxInit(&tv, (void *)de_ctx, (void *)&det_ctx);
+    FAIL_IF_NULL(det_ctx);
+
+    /* only decided once the rule groups of both directions are known */
+    SigMatchSignatures(&tv, de_ctx, det_ctx, p1);
+    FAIL_IF(f->flags & FLOW_AUTO_BYPASS_CHECKED);
+    FAIL_IF(f->flow_state == FLOW_STATE_LOCAL_BYPASSED);
+
+    SigMatchSignatures(&tv, de_ctx, det_ctx, p2);
+    FAIL_IF_NOT(f->flags & FLOW_AUTO_BYPASS_CHECKED);
+    FAIL_IF_NOT((f->flow_state == FLOW_STATE_LOCAL_BYPASSED) == bypass);
+
+    DetectEngineThreadCtxDeinit(&tv, (void *)det_ctx);
+    DetectEngineCtxFree(de_ctx);
+    UTHFreePackets(&p1, 1);
+    UTHFreePackets(&p2, 1);
+    f->protoctx = NULL;
+    FlowFree(f);
+    FlowShutdown();
+    SCStorageCleanup();
+    StatsThreadCleanup(&tv.stats);
+    return 1;
+}
+
+/** \test auto-bypass of flows without app-layer rules for their protocol */
+static int SigTestAutoBypass01(void)
+{
+    const char *sig = "alert http any any -> any any (http.uri; content:\"/x\"; sid:1;)";
+    /* no rule left for ssh */
+    FAIL_IF_NOT(SigTestAutoBypassFlow(sig, ALPROTO_SSH, true));
+    /* the http rule can still match */
+    FAIL_IF_NOT(SigTestAutoBypassFlow(sig, ALPROTO_HTTP1, false));
+    /* rules for http could match after a STARTTLS like upgrade */
+    FAIL_IF_NOT(SigTestAutoBypassFlow(sig, ALPROTO_SMTP, false));
+    PASS;
+}
+
+/** \test no auto-bypass while stream or app-layer rules remain */
+static int SigTestAutoBypass02(void)
+{
+    /* raw stream rule */
+    FAIL_IF_NOT(SigTestAutoBypassFlow(
+            "alert tcp any any -> any any (content:\"abc\"; sid:1;)", ALPROTO_SSH, false));
+    /* app-layer rule for the flow's protocol */
+    FAIL_IF_NOT(SigTestAutoBypassFlow(
+            "alert ssh any any -> any any (ssh.proto; content:\"2.0\"; sid:1;)", ALPROTO_SSH,
+            false));
+    /* rules for another port only: nothing to inspect */
+    FAIL_IF_NOT(SigTestAutoBypassFlow(
+            "alert tcp any any -> any 80 (content:\"abc\"; sid:1;)", ALPROTO_SSH, true));
+    PASS;
+}
+
 void SigRegisterTests(void)
 {
     SigParseRegisterTests();
@@ -4734,6 +4895,9 @@ void SigRegisterTests(void)
 
     UtRegisterTest("SigTestPorts01", SigTestPorts01);
     UtRegisterTest("SigTestBug01", SigTestBug01);
+    UtRegisterTest("SigTestHeaderSummary01", SigTestHeaderSummary01);
+    UtRegisterTest("SigTestAutoBypass01", SigTestAutoBypass01);
+    UtRegisterTest("SigTestAutoBypass02", SigTestAutoBypass02);
 
     DetectEngineContentInspectionRegisterTests();
 }
@@ -0,0 +1,388 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "../suricata-common.h"
+#include "../flow-storage.h"
+#include "../flow-util.h"
+#include "../flow-private.h"
+#include "../tm-threads.h"
+#include "../util-unittest.h"
+#include "../util-unittest-helper.h"
+
+/** \brief compare the header of a packet's event with and without the cache */
+static bool OutputJsonHeaderCacheCompare(
+        const Packet *p, enum SCOutputJsonLogDirection dir, OutputJsonCtx *ctx)
+{
+    const SCFlowStorageId id = g_eve_header_storage_id;
+    g_eve_header_storage_id.id = -1;
+    SCJsonBuilder *expected = CreateEveHeader(p, dir, "alert", NULL, ctx);
+    g_eve_header_storage_id = id;
+    SCJsonBuilder *js = CreateEveHeader(p, dir, "alert", NULL, ctx);
+
+    bool ok = expected != NULL && js != NULL && SCJbLen(expected) == SCJbLen(js) &&
+              memcmp(SCJbPtr(expected), SCJbPtr(js), SCJbLen(js)) == 0;
+    if (!ok && expected != NULL && js != NULL) {
+        printf("unexpected header\nexpected=%.*s\ngot=%.*s\n", (int)SCJbLen(expected),
+                (const char *)SCJbPtr(expected), (int)SCJbLen(js), (const char *)SCJbPtr(js));
+    }
+    if (expected != NULL)
+        SCJbFree(expected);
+    if (js != NULL)
+        SCJbFree(js);
+    return ok;
+}
+
+/**
+ * \test cached header fields match the uncached ones for packets in both
+ *       directions, for both log directions and for an icmp error
+ */
+static int OutputJsonHeaderCacheTest01(void)
+{
+    SCStorageCleanup();
+    SCStorageInit();
+    g_eve_header_storage_id = SCFlowStorageRegister("eve-header", EveFlowHeaderCacheFree);
+    FAIL_IF(g_eve_header_storage_id.id < 0);
+    FAIL_IF(SCStorageFinalize() < 0);
+    FlowInitConfig(FLOW_QUIET);
+
+    Flow *f = FlowAlloc();
+    FAIL_IF_NULL(f);
+    Packet *ts = UTHBuildPacketReal(
+            NULL, 0, IPPROTO_UDP, "192.168.1.5", "192.168.1.1", 41424, 53);
+    FAIL_IF_NULL(ts);
+    Packet *tc = UTHBuildPacketReal(
+            NULL, 0, IPPROTO_UDP, "192.168.1.1", "192.168.1.5", 53, 41424);
+    FAIL_IF_NULL(tc);
+    /* port unreachable from a router on the path, mapped to the flow */
+    Packet *icmp = UTHBuildPacketReal(NULL, 0, IPPROTO_ICMP, "10.0.0.1", "192.168.1.5", 0, 0);
+    FAIL_IF_NULL(icmp);
+    icmp->icmp_s.type = ICMP_DEST_UNREACH;
+    icmp->icmp_s.code = ICMP_PORT_UNREACH;
+
+    f->flags |= FLOW_IPV4;
+    f->proto = IPPROTO_UDP;
+    f->src = ts->src;
+    f->dst = ts->dst;
+    f->sp = ts->sp;
+    f->dp = ts->dp;
+    UTHAssignFlow(ts, f);
+    ts->flowflags |= FLOW_PKT_TOSERVER;
+    UTHAssignFlow(tc, f);
+    tc->flowflags |= FLOW_PKT_TOCLIENT;
+    UTHAssignFlow(icmp, f);
+    icmp->flowflags |= FLOW_PKT_TOCLIENT;
+
+    OutputJsonCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.cfg.include_community_id = true;
+
+    /* the first event only marks the flow */
+    const uint64_t memuse = SC_ATOMIC_GET(flow_memuse);
+    FAIL_IF_NOT(OutputJsonHeaderCacheCompare(ts, LOG_DIR_FLOW, &ctx));
+    FAIL_IF_NOT(SCFlowGetStorageById(f, g_eve_header_storage_id) == EVE_HEADER_CACHE_SEEN);
+    FAIL_IF_NOT_NULL(EveFlowHeaderCacheGet(f));
+    FAIL_IF_NOT(SC_ATOMIC_GET(flow_memuse) == memuse);
+
+    /* the second one sets up the cache, accounted in the flow memuse */
+    FAIL_IF_NOT(OutputJsonHeaderCacheCompare(ts, LOG_DIR_FLOW, &ctx));
+    EveFlowHeaderCache *c = EveFlowHeaderCacheGet(f);
+    FAIL_IF_NULL(c);
+    FAIL_IF_NULL(c->tuple[0].json);
+    FAIL_IF(c->community_id[0] == '\0');
+    FAIL_IF_NOT(c->memuse > sizeof(*c));
+    FAIL_IF_NOT(SC_ATOMIC_GET(flow_memuse) == memuse + c->memuse);
+
+    /* mix the packets so the fragments are reused and replaced */
+    for (int i = 0; i < 2; i++) {
+        FAIL_IF_NOT(OutputJsonHeaderCacheCompare(ts, LOG_DIR_FLOW, &ctx));
+        FAIL_IF_NOT(OutputJsonHeaderCacheCompare(tc, LOG_DIR_FLOW, &ctx));
+        FAIL_IF_NOT(OutputJsonHeaderCacheCompare(tc, LOG_DIR_PACKET, &ctx));
+        FAIL_IF_NOT(OutputJsonHeaderCacheCompare(icmp, LOG_DIR_FLOW, &ctx));
+        FAIL_IF_NOT(OutputJsonHeaderCacheCompare(icmp, LOG_DIR_PACKET, &ctx));
+        FAIL_IF_NOT(OutputJsonHeaderCacheCompare(tc, LOG_DIR_FLOW_TOCLIENT, &ctx));
+        FAIL_IF_NOT(SC_ATOMIC_GET(flow_memuse) == memuse + c->memuse);
+    }
+
+    FlowClearMemory(f, FlowGetProtoMapping(f->proto));
+    FAIL_IF_NOT(SC_ATOMIC_GET(flow_memuse) == memuse);
+
+    UTHFreePacket(ts);
+    UTHFreePacket(tc);
+    UTHFreePacket(icmp);
+    FlowFree(f);
+    FlowShutdown();
+    SCStorageCleanup();
+    g_eve_header_storage_id.id = -1;
+    PASS;
+}
+
+/** \test pseudo packets don't set up the cache */
+static int OutputJsonHeaderCacheTest02(void)
+{
+    SCStorageCleanup();
+    SCStorageInit();
+    g_eve_header_storage_id = SCFlowStorageRegister("eve-header", EveFlowHeaderCacheFree);
+    FAIL_IF(g_eve_header_storage_id.id < 0);
+    FAIL_IF(SCStorageFinalize() < 0);
+    FlowInitConfig(FLOW_QUIET);
+
+    Flow *f = FlowAlloc();
+    FAIL_IF_NULL(f);
+    Packet *p = UTHBuildPacketReal(NULL, 0, IPPROTO_UDP, "192.168.1.5", "192.168.1.1", 41424, 53);
+    FAIL_IF_NULL(p);
+    f->flags |= FLOW_IPV4;
+    f->proto = IPPROTO_UDP;
+    f->src = p->src;
+    f->dst = p->dst;
+    f->sp = p->sp;
+    f->dp = p->dp;
+    UTHAssignFlow(p, f);
+    p->flowflags |= FLOW_PKT_TOSERVER;
+    p->flags |= PKT_PSEUDO_STREAM_END;
+
+    OutputJsonCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+
+    for (int i = 0; i < 3; i++) {
+        FAIL_IF_NOT(OutputJsonHeaderCacheCompare(p, LOG_DIR_FLOW, &ctx));
+    }
+    FAIL_IF_NOT_NULL(SCFlowGetStorageById(f, g_eve_header_storage_id));
+
+    FlowClearMemory(f, FlowGetProtoMapping(f->proto));
+    UTHFreePacket(p);
+    FlowFree(f);
+    FlowShutdown();
+    SCStorageCleanup();
+    g_eve_header_storage_id.id = -1;
+    PASS;
+}
+
+/** writes seen by the batch tests */
+static struct {
+    uint32_t writes;
+    uint32_t bytes;
+    char last[256];
+} batch_test_writes;
+
+static int OutputJsonBatchTestWrite(const char *buffer, int buffer_len, LogFileCtx *lf)
+{
+    batch_test_writes.writes++;
+    batch_test_writes.bytes += (uint32_t)buffer_len;
+    const size_t len = MIN(sizeof(batch_test_writes.last) - 1, (size_t)buffer_len);
+    memcpy(batch_test_writes.last, buffer, len);
+    batch_test_writes.last[len] = '\0';
+    return 0;
+}
+
+static OutputJsonThreadCtx *OutputJsonBatchTestSetup(LogFileCtx *lf, uint32_t size)
+{
+    memset(&batch_test_writes, 0, sizeof(batch_test_writes));
+    memset(lf, 0, sizeof(*lf));
+    lf->type = LOGFILE_TYPE_FILE;
+    lf->Write = OutputJsonBatchTestWrite;
+
+    OutputJsonThreadCtx *ctx = SCCalloc(1, sizeof(*ctx));
+    if (ctx == NULL)
+        return NULL;
+    ctx->file_ctx = lf;
+    ctx->buffer = MemBufferCreateNew(JSON_OUTPUT_BUFFER_SIZE);
+    ctx->batch = SCCalloc(1, sizeof(*ctx->batch));
+    if (ctx->buffer == NULL || ctx->batch == NULL) {
+        FreeEveThreadCtx(ctx);
+        return NULL;
+    }
+    ctx->batch->buffer = MemBufferCreateNew(size);
+    if (ctx->batch->buffer == NULL) {
+        FreeEveThreadCtx(ctx);
+        return NULL;
+    }
+    ctx->batch->timeout = 1;
+    return ctx;
+}
+
+/** \brief add a record to the batch, as OutputJsonBuilderBuffer() does */
+static void OutputJsonBatchTestAdd(
+        ThreadVars *tv, OutputJsonThreadCtx *ctx, const char *record, time_t now)
+{
+    MemBufferReset(ctx->buffer);
+    MemBufferWriteRaw(ctx->buffer, (const uint8_t *)record, (uint32_t)strlen(record));
+    OutputJsonBatchAdd(tv, ctx, ctx->buffer, now);
+}
+
+/** \test records are batched and written in one call when they are due */
+static int OutputJsonBatchTest01(void)
+{
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(tv));
+    LogFileCtx lf;
+    OutputJsonThreadCtx *ctx = OutputJsonBatchTestSetup(&lf, 64);
+    FAIL_IF_NULL(ctx);
+
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"a\":1}", 100);
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"b\":2}", 100);
+    FAIL_IF_NOT(batch_test_writes.writes == 0);
+    FAIL_IF_NOT(MEMBUFFER_OFFSET(ctx->batch->buffer) == 16);
+
+    /* not due yet */
+    OutputJsonBatchFlushDue(&tv, ctx, 100);
+    FAIL_IF_NOT(batch_test_writes.writes == 0);
+
+    /* due on the periodic check */
+    OutputJsonBatchFlushDue(&tv, ctx, 101);
+    FAIL_IF_NOT(batch_test_writes.writes == 1);
+    FAIL_IF_NOT(batch_test_writes.bytes == 16);
+    FAIL_IF_NOT(strcmp(batch_test_writes.last, "{\"a\":1}\n{\"b\":2}\n") == 0);
+    FAIL_IF_NOT(MEMBUFFER_OFFSET(ctx->batch->buffer) == 0);
+
+    /* due when adding, the timeout starts at the oldest record */
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"c\":3}", 200);
+    FAIL_IF_NOT(batch_test_writes.writes == 1);
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"d\":4}", 201);
+    FAIL_IF_NOT(batch_test_writes.writes == 2);
+    FAIL_IF_NOT(strcmp(batch_test_writes.last, "{\"c\":3}\n{\"d\":4}\n") == 0);
+
+    /* nothing to write */
+    OutputJsonBatchFlushDue(&tv, ctx, 300);
+    FAIL_IF_NOT(batch_test_writes.writes == 2);
+
+    FreeEveThreadCtx(ctx);
+    PASS;
+}
+
+/** \test the batch is written first if a record doesn't fit */
+static int OutputJsonBatchTest02(void)
+{
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(tv));
+    LogFileCtx lf;
+    OutputJsonThreadCtx *ctx = OutputJsonBatchTestSetup(&lf, 20);
+    FAIL_IF_NULL(ctx);
+
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"a\":1}", 100);
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"b\":2}", 100);
+    FAIL_IF_NOT(batch_test_writes.writes == 0);
+
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"c\":3}", 100);
+    FAIL_IF_NOT(batch_test_writes.writes == 1);
+    FAIL_IF_NOT(strcmp(batch_test_writes.last, "{\"a\":1}\n{\"b\":2}\n") == 0);
+    FAIL_IF_NOT(MEMBUFFER_OFFSET(ctx->batch->buffer) == 8);
+
+    FreeEveThreadCtx(ctx);
+    PASS;
+}
+
+/** \test records larger than the batch are written directly, after the batch */
+static int OutputJsonBatchTest03(void)
+{
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(tv));
+    LogFileCtx lf;
+    OutputJsonThreadCtx *ctx = OutputJsonBatchTestSetup(&lf, 20);
+    FAIL_IF_NULL(ctx);
+
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"a\":1}", 100);
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"large\":\"0123456789\"}", 100);
+    FAIL_IF_NOT(batch_test_writes.writes == 2);
+    FAIL_IF_NOT(batch_test_writes.bytes == 8 + 23);
+    FAIL_IF_NOT(strcmp(batch_test_writes.last, "{\"large\":\"0123456789\"}\n") == 0);
+    FAIL_IF_NOT(MEMBUFFER_OFFSET(ctx->batch->buffer) == 0);
+
+    FreeEveThreadCtx(ctx);
+    PASS;
+}
+
+/** \test the batch is written on thread deinit */
+static int OutputJsonBatchTest04(void)
+{
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(tv));
+    LogFileCtx lf;
+    OutputJsonThreadCtx *ctx = OutputJsonBatchTestSetup(&lf, 64);
+    FAIL_IF_NULL(ctx);
+
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"a\":1}", 100);
+    FAIL_IF_NOT(batch_test_writes.writes == 0);
+
+    FAIL_IF_NOT(JsonLogThreadDeinit(&tv, ctx) == TM_ECODE_OK);
+    FAIL_IF_NOT(batch_test_writes.writes == 1);
+    FAIL_IF_NOT(strcmp(batch_test_writes.last, "{\"a\":1}\n") == 0);
+    PASS;
+}
+
+static uint32_t batch_test_timeout_pkts;
+
+static void OutputJsonBatchTestOut(ThreadVars *tv, Packet *p)
+{
+    if (p->pkt_src == PKT_SRC_CAPTURE_TIMEOUT)
+        batch_test_timeout_pkts++;
+    PacketFreeOrRelease(p);
+}
+
+/** \test an idle worker with batched records gets a packet injected on
+ *        its capture timeouts until the batch is written out */
+static int OutputJsonBatchTest05(void)
+{
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(tv));
+    tv.tmqh_out = OutputJsonBatchTestOut;
+    batch_test_timeout_pkts = 0;
+    LogFileCtx lf;
+    OutputJsonThreadCtx *ctx = OutputJsonBatchTestSetup(&lf, 64);
+    FAIL_IF_NULL(ctx);
+
+    /* nothing batched: the timeout has nothing to do */
+    FAIL_IF(JsonFlowLogFlush(&tv, ctx));
+    TmThreadsCaptureHandleTimeout(&tv, NULL);
+    FAIL_IF_NOT(batch_test_timeout_pkts == 0);
+
+    /* a batched record asks for a packet on the capture timeout */
+    const time_t now = time(NULL);
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"a\":1}", now + 10);
+    FAIL_IF_NOT(TmThreadsCheckFlag(&tv, THV_OUTPUT_FLUSH));
+    TmThreadsCaptureHandleTimeout(&tv, NULL);
+    FAIL_IF_NOT(batch_test_timeout_pkts == 1);
+
+    /* not due yet, so it stays pending */
+    FAIL_IF_NOT(JsonFlowLogFlush(&tv, ctx));
+    FAIL_IF_NOT(batch_test_writes.writes == 0);
+
+    /* once expired the flush writes it and reports nothing pending */
+    MemBufferReset(ctx->batch->buffer);
+    OutputJsonBatchTestAdd(&tv, ctx, "{\"b\":2}", now - 10);
+    FAIL_IF(JsonFlowLogFlush(&tv, ctx));
+    FAIL_IF_NOT(batch_test_writes.writes == 1);
+    FAIL_IF_NOT(strcmp(batch_test_writes.last, "{\"b\":2}\n") == 0);
+
+    /* the flow worker clears the flag, after which the timeouts are idle */
+    TmThreadsUnsetFlag(&tv, THV_OUTPUT_FLUSH);
+    TmThreadsCaptureHandleTimeout(&tv, NULL);
+    FAIL_IF_NOT(batch_test_timeout_pkts == 1);
+
+    FreeEveThreadCtx(ctx);
+    PASS;
+}
+
+void OutputJsonRegisterTests(void)
+{
+    UtRegisterTest("OutputJsonHeaderCacheTest01", OutputJsonHeaderCacheTest01);
+    UtRegisterTest("OutputJsonHeaderCacheTest02", OutputJsonHeaderCacheTest02);
+    UtRegisterTest("OutputJsonBatchTest01", OutputJsonBatchTest01);
+    UtRegisterTest("OutputJsonBatchTest02", OutputJsonBatchTest02);
+    UtRegisterTest("OutputJsonBatchTest03", OutputJsonBatchTest03);
+    UtRegisterTest("OutputJsonBatchTest04", OutputJsonBatchTest04);
+    UtRegisterTest("OutputJsonBatchTest05", OutputJsonBatchTest05);
+}
@@ -102,6 +102,7 @@ extern thread_local uint64_t mutex_lock_cnt;
 #define SCCondSignal pthread_cond_signal
 #define SCCondDestroy pthread_cond_destroy
 #define SCCondWait(cond, mut) pthread_cond_wait(cond, mut)
+#define SCCondTimedwait pthread_cond_timedwait
 
 /* spinlocks */
 
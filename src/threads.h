@@ -139,6 +139,7 @@ enum {
 #define SCCondSignal pthread_cond_signal
 #define SCCondDestroy pthread_cond_destroy
 #define SCCondWait(cond, mut) pthread_cond_wait(cond, mut)
+#define SCCondTimedwait pthread_cond_timedwait
 
 /* ctrl mutex */
 #define SCCtrlMutex pthread_mutex_t
@@ -201,7 +202,7 @@ enum {
 #endif
 
 #if (!defined SCCondT || !defined SCCondInit || !defined SCCondSignal || \
-     !defined SCCondDestroy || !defined SCCondWait)
+     !defined SCCondDestroy || !defined SCCondWait || !defined SCCondTimedwait)
 #error "SCCond types and/or macro's not properly defined"
 #endif
 
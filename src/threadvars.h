@@ -54,6 +54,11 @@ struct TmSlot_;
 #define THV_CAPTURE_INJECT_PKT  BIT_U32(11)
 #define THV_DEAD                BIT_U32(12) /**< thread has been joined with pthread_join() */
 #define THV_RUNNING             BIT_U32(13) /**< thread is running */
+/** thread has buffered output records that are written out after a timeout.
+ *  The capture method injects a packet on its timeouts while this is set,
+ *  so the records of an idle thread are flushed. Set by the loggers, cleared
+ *  by the flow worker once nothing is buffered anymore. */
+#define THV_OUTPUT_FLUSH        BIT_U32(14)
 
 /** \brief Per thread variable structure */
 typedef struct ThreadVars_ {
@@ -121,6 +126,15 @@ typedef struct ThreadVars_ {
     /** private counter store: counter updates modify this */
     StatsThreadContext stats;
 
+    /** sampled packet latency, see stats.latency-sample-rate */
+    struct {
+        uint32_t sample_cnt;
+        /** current packet is sampled */
+        bool sample;
+        StatsCounterHistId pipeline;
+        StatsCounterHistId decode;
+    } latency;
+
     /** pointer to the next thread */
     struct ThreadVars_ *next;
 
@@ -122,7 +122,12 @@ TmEcode TmThreadsProcessDecodePseudoPackets(
             continue;
         DEBUG_VALIDATE_BUG_ON(extra_p->flow != NULL);
 
-        if (TmThreadsSlotProcessPkt(tv, slot, extra_p) != TM_ECODE_OK) {
+        /* the pseudo packet makes its own sampling decision, don't let it
+         * override the one of the packet that is still being processed */
+        const bool sample = tv->latency.sample;
+        TmEcode r = TmThreadsSlotProcessPkt(tv, slot, extra_p);
+        tv->latency.sample = sample;
+        if (r != TM_ECODE_OK) {
             SCReturnInt(TM_ECODE_FAILED);
         }
     }
@@ -135,9 +140,14 @@ TmEcode TmThreadsProcessDecodePseudoPackets(
 TmEcode TmThreadsSlotVarRun(ThreadVars *tv, Packet *p, TmSlot *slot)
 {
     for (TmSlot *s = slot; s != NULL; s = s->slot_next) {
+        const bool sample = unlikely(tv->latency.sample) && (s->tm_flags & TM_FLAG_DECODE_TM);
+        const uint64_t start = sample ? StatsLatencyNow() : 0;
         PACKET_PROFILING_TMM_START(p, s->tm_id);
         TmEcode r = s->SlotFunc(tv, p, SC_ATOMIC_GET(s->slot_data));
         PACKET_PROFILING_TMM_END(p, s->tm_id);
+        if (sample) {
+            StatsCounterHistogramRecord(&tv->stats, tv->latency.decode, StatsLatencyNow() - start);
+        }
         DEBUG_VALIDATE_BUG_ON(p->flow != NULL);
 
         /* handle error */
@@ -217,6 +227,7 @@ static bool TmThreadsSlotPktAcqLoopInit(ThreadVars *tv)
 
     CaptureStatsSetup(tv);
     PacketPoolInit();
+    PacketPoolStatsSetup(tv);
 
     for (TmSlot *slot = s; slot != NULL; slot = slot->slot_next) {
         if (slot->SlotThreadInit != NULL) {
@@ -262,6 +273,11 @@ static bool TmThreadsSlotPktAcqLoopInit(ThreadVars *tv)
         }
     }
 
+    if (stats_latency_sample_rate > 0) {
+        tv->latency.pipeline = StatsRegisterHistogramCounter("latency.pipeline", &tv->stats);
+        tv->latency.decode = StatsRegisterHistogramCounter("latency.decode", &tv->stats);
+    }
+
     StatsSetupPrivate(&tv->stats, tv->printable_name ? tv->printable_name : tv->name);
 
     TmThreadsSetFlag(tv, THV_INIT_DONE);
@@ -322,8 +338,7 @@ static void *TmThreadsSlotPktAcqLoop(void *td)
                    " tmqh_out=%p",
                 s, s ? s->PktAcqLoop : NULL, tv->tmqh_in, tv->tmqh_out);
         TmThreadsSetFlag(tv, THV_CLOSED | THV_RUNNING_DONE);
-        pthread_exit(NULL);
-        return NULL;
+        goto error;
     }
 
     if (!TmThreadsSlotPktAcqLoopInit(td)) {
@@ -355,6 +370,7 @@ static void *TmThreadsSlotPktAcqLoop(void *td)
     return NULL;
 
 error:
+    PacketPoolUnregister();
     pthread_exit(NULL);
     return NULL;
 }
@@ -418,6 +434,7 @@ static void *TmThreadsSlotVar(void *td)
 
     CaptureStatsSetup(tv);
     PacketPoolInit();//Empty();
+    PacketPoolStatsSetup(tv);
 
     SCSetThreadName(tv->name);
 
@@ -430,6 +447,7 @@ static void *TmThreadsSlotVar(void *td)
     /* check if we are setup properly */
     if (s == NULL || tv->tmqh_in == NULL || tv->tmqh_out == NULL) {
         TmThreadsSetFlag(tv, THV_CLOSED | THV_RUNNING_DONE);
+        PacketPoolUnregister();
         pthread_exit(NULL);
         return NULL;
     }
@@ -456,8 +474,7 @@ static void *TmThreadsSlotVar(void *td)
             tv->flow_queue = FlowQueueNew();
             if (tv->flow_queue == NULL) {
                 TmThreadsSetFlag(tv, THV_CLOSED | THV_RUNNING_DONE);
-                pthread_exit(NULL);
-                return NULL;
+                goto error;
             }
         /* setup a queue */
         } else if (s->tm_id == TMM_FLOWWORKER) {
@@ -471,8 +488,7 @@ static void *TmThreadsSlotVar(void *td)
             tv->flow_queue = FlowQueueNew();
             if (tv->flow_queue == NULL) {
                 TmThreadsSetFlag(tv, THV_CLOSED | THV_RUNNING_DONE);
-                pthread_exit(NULL);
-                return NULL;
+                goto error;
             }
         }
     }
@@ -494,7 +510,8 @@ static void *TmThreadsSlotVar(void *td)
 
         /* if we didn't get a packet see if we need to do some housekeeping */
         if (unlikely(p == NULL)) {
-            if (tv->flow_queue && SC_ATOMIC_GET(tv->flow_queue->non_empty)) {
+            if ((tv->flow_queue && SC_ATOMIC_GET(tv->flow_queue->non_empty)) ||
+                    TmThreadsCheckFlag(tv, THV_OUTPUT_FLUSH)) {
                 p = PacketGetFromQueueOrAlloc();
                 if (p != NULL) {
                     p->flags |= PKT_PSEUDO_STREAM_END;
@@ -504,13 +521,17 @@ static void *TmThreadsSlotVar(void *td)
         }
 
         if (p != NULL) {
+            tv->latency.sample = StatsLatencySample(&tv->latency.sample_cnt);
+
             /* run the thread module(s) */
             r = TmThreadsSlotVarRun(tv, p, s);
             if (r == TM_ECODE_FAILED) {
+                tv->latency.sample = false;
                 TmqhOutputPacketpool(tv, p);
                 TmThreadsSetFlag(tv, THV_FAILED);
                 break;
             }
+            tv->latency.sample = false;
 
             /* output the packet */
             tv->tmqh_out(tv, p);
@@ -533,6 +554,7 @@ static void *TmThreadsSlotVar(void *td)
 
 error:
     tv->stream_pq = NULL;
+    PacketPoolUnregister();
     pthread_exit(NULL);
     return NULL;
 }
@@ -198,14 +198,24 @@ static inline TmEcode TmThreadsSlotProcessPkt(ThreadVars *tv, TmSlot *s, Packet
         return TM_ECODE_OK;
     }
 
+    /* the pipeline latency includes the verdict/release of the packet */
+    tv->latency.sample = StatsLatencySample(&tv->latency.sample_cnt);
+    const uint64_t start = tv->latency.sample ? StatsLatencyNow() : 0;
+
     TmEcode r = TmThreadsSlotVarRun(tv, p, s);
     if (unlikely(r == TM_ECODE_FAILED)) {
+        tv->latency.sample = false;
         TmThreadsSlotProcessPktFail(tv, p);
         return TM_ECODE_FAILED;
     }
 
     tv->tmqh_out(tv, p);
 
+    if (tv->latency.sample) {
+        StatsCounterHistogramRecord(&tv->stats, tv->latency.pipeline, StatsLatencyNow() - start);
+        tv->latency.sample = false;
+    }
+
     TmThreadsHandleInjectedPackets(tv);
 
     return TM_ECODE_OK;
@@ -247,7 +257,8 @@ static inline void TmThreadsCaptureHandleTimeout(ThreadVars *tv, Packet *p)
     } else {
         if (!TmThreadsHandleInjectedPackets(tv)) {
             /* see if we have to do some house keeping */
-            if (tv->flow_queue && SC_ATOMIC_GET(tv->flow_queue->non_empty)) {
+            if ((tv->flow_queue && SC_ATOMIC_GET(tv->flow_queue->non_empty)) ||
+                    TmThreadsCheckFlag(tv, THV_OUTPUT_FLUSH)) {
                 TmThreadsCaptureInjectPacket(tv, p); /* consumes 'p' */
                 return;
             }
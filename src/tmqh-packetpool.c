@@ -31,8 +31,11 @@
 #include "decode.h"
 #include "tm-modules.h"
 #include "packet.h"
+#include "counters.h"
+#include "conf.h"
 #include "util-profiling.h"
 #include "util-validate.h"
+#include "util-unittest.h"
 #include "action-globals.h"
 
 extern uint32_t max_pending_packets;
@@ -41,6 +44,24 @@ extern uint32_t max_pending_packets;
 #define MAX_PENDING_RETURN_PACKETS 32
 static uint32_t max_pending_return_packets = MAX_PENDING_RETURN_PACKETS;
 
+/** packet-pool.auto-size: start small and size the pools to their use */
+static bool pool_auto_size = false;
+/** packet-pool.steal: take packets from other pools before waiting */
+static bool pool_steal = false;
+
+/** initial and minimal pool size with auto-size */
+#define PACKET_POOL_MIN_SIZE 64
+/** number of packets a pool grows by at once */
+#define PACKET_POOL_GROW 64
+/** how often the pool sizing is reconsidered */
+#define PACKET_POOL_WINDOW_NS (100 * 1000000ULL)
+/** bounded wait for packets when stealing, so stealing is retried */
+#define PACKET_POOL_STEAL_WAIT_NS (1 * 1000000L)
+
+/** pools to steal from, protected by pool_steal_lock */
+static PktPool *pool_steal_list = NULL;
+static SCMutex pool_steal_lock = SCMUTEX_INITIALIZER;
+
 thread_local PktPool thread_pkt_pool;
 
 static inline PktPool *GetThreadPacketPool(void)
@@ -59,26 +80,207 @@ void TmqhPacketpoolRegister (void)
     tmqh_table[TMQH_PACKETPOOL].OutHandler = TmqhOutputPacketpool;
 }
 
+/**
+ * \brief read the packet-pool settings
+ *
+ * Must be called before the packet threads set up their pools.
+ */
+void PacketPoolConfig(void)
+{
+    int val = 0;
+    if (SCConfGetBool("packet-pool.auto-size", &val) == 1)
+        pool_auto_size = val != 0;
+    val = 0;
+    if (SCConfGetBool("packet-pool.steal", &val) == 1)
+        pool_steal = val != 0;
+    SCLogConfig("packet-pool: auto-size %s, steal %s", BOOL2STR(pool_auto_size),
+            BOOL2STR(pool_steal));
+}
+
 static void UpdateReturnThreshold(PktPool *pool)
 {
-    const float perc = (float)pool->cnt / (float)max_pending_packets;
-    uint32_t threshold = (uint32_t)(perc * (float)max_pending_return_packets);
+    const uint32_t size = pool_auto_size ? MAX(pool->owned, 1) : max_pending_packets;
+    const float perc = (float)pool->cnt / (float)size;
+    const uint32_t batch = MIN(pool->return_batch, max_pending_return_packets);
+    uint32_t threshold = (uint32_t)(perc * (float)batch);
     if (threshold != SC_ATOMIC_GET(pool->return_stack.return_threshold)) {
         SC_ATOMIC_SET(pool->return_stack.return_threshold, threshold);
     }
 }
 
+static void PacketPoolGetReturnedPackets(PktPool *pool)
+{
+    SCMutexLock(&pool->return_stack.mutex);
+    /* Move all the packets from the locked return stack to the local stack. */
+    pool->head = pool->return_stack.head;
+    pool->return_stack.head = NULL;
+    pool->cnt += pool->return_stack.cnt;
+    pool->return_stack.cnt = 0;
+    pool->owned -= pool->return_stack.stolen;
+    pool->return_stack.stolen = 0;
+    SCMutexUnlock(&pool->return_stack.mutex);
+}
+
+/** \internal
+ *  \brief allocate more packets for an empty pool if it may grow
+ *  \retval true if packets were added */
+static bool PacketPoolGrow(PktPool *pool)
+{
+    if (!pool_auto_size || pool->owned >= max_pending_packets)
+        return false;
+
+    const uint32_t n = MIN(PACKET_POOL_GROW, max_pending_packets - pool->owned);
+    for (uint32_t i = 0; i < n; i++) {
+        Packet *p = PacketGetFromAlloc();
+        if (unlikely(p == NULL))
+            break;
+        p->pool = pool;
+        p->ReleasePacket = PacketPoolReturnPacket;
+        p->next = pool->head;
+        pool->head = p;
+        pool->cnt++;
+        pool->owned++;
+    }
+    return pool->head != NULL;
+}
+
+/** \internal
+ *  \brief take half of the returned packets of another pool
+ *
+ *  Pools that are running low themselves, or busy, are skipped.
+ *
+ *  \retval true if packets were added */
+static bool PacketPoolSteal(PktPool *pool)
+{
+    if (!pool_steal)
+        return false;
+
+    Packet *head = NULL;
+    uint32_t got = 0;
+    SCMutexLock(&pool_steal_lock);
+    for (PktPool *o = pool_steal_list; o != NULL && got == 0; o = o->steal_next) {
+        if (o == pool || SC_ATOMIC_GET(o->return_stack.return_threshold) <= 1)
+            continue;
+        if (SCMutexTrylock(&o->return_stack.mutex) != 0)
+            continue;
+        const uint32_t n = o->return_stack.cnt / 2;
+        for (uint32_t i = 0; i < n; i++) {
+            Packet *p = o->return_stack.head;
+            o->return_stack.head = p->next;
+            p->pool = pool;
+            p->next = head;
+            head = p;
+        }
+        o->return_stack.cnt -= n;
+        o->return_stack.stolen += n;
+        SCMutexUnlock(&o->return_stack.mutex);
+        got = n;
+    }
+    SCMutexUnlock(&pool_steal_lock);
+
+    if (got == 0)
+        return false;
+
+    /* only called with an empty local stack */
+    pool->head = head;
+    pool->cnt += got;
+    pool->owned += got;
+    if (pool->stats != NULL)
+        StatsCounterAddI64(pool->stats, pool->counter_stolen, (int64_t)got);
+    return true;
+}
+
+/** \internal
+ *  \brief refill an empty local stack
+ *
+ *  Uses the packets returned to the pool first, then grows the pool if
+ *  it may, then steals from the other pools. */
+static void PacketPoolRefill(PktPool *pool)
+{
+    PacketPoolGetReturnedPackets(pool);
+    if (pool->head == NULL && !PacketPoolGrow(pool))
+        (void)PacketPoolSteal(pool);
+}
+
+/** \internal
+ *  \brief update the pool sizing at the end of a window
+ *
+ *  The return batches are sized to about 1ms worth of packets: large
+ *  batches at high rates to limit the locking, small ones at low rates so
+ *  packets don't linger in other threads. With auto-size, the pool is
+ *  shrunk towards twice the max number of packets in use. */
+static void PacketPoolUpdate(PktPool *pool)
+{
+    const uint64_t now = StatsLatencyNow();
+    const uint64_t elapsed = now - pool->window_start;
+    if (elapsed < PACKET_POOL_WINDOW_NS)
+        return;
+
+    const uint64_t per_ms = (uint64_t)pool->gets * 1000000ULL / elapsed;
+    pool->return_batch = (uint32_t)MAX(1, MIN(per_ms, MAX_PENDING_RETURN_PACKETS));
+
+    if (pool_auto_size) {
+        const uint32_t target =
+                MIN(MAX(pool->in_use_max * 2, PACKET_POOL_MIN_SIZE), max_pending_packets);
+        /* give back half of the excess per window */
+        uint32_t excess = pool->owned > target ? (pool->owned - target + 1) / 2 : 0;
+        while (excess > 0 && pool->head != NULL) {
+            Packet *p = pool->head;
+            pool->head = p->next;
+            pool->cnt--;
+            pool->owned--;
+            PacketFree(p);
+            excess--;
+        }
+    }
+    if (pool->stats != NULL)
+        StatsCounterSetI64(pool->stats, pool->counter_size, (int64_t)pool->owned);
+
+    pool->in_use_max = pool->owned - pool->cnt;
+    pool->gets = 0;
+    pool->window_start = now;
+}
+
 void PacketPoolWait(void)
 {
     PktPool *my_pool = GetThreadPacketPool();
 
     if (my_pool->head == NULL) {
+        PacketPoolRefill(my_pool);
+        if (my_pool->head != NULL) {
+            UpdateReturnThreshold(my_pool);
+            return;
+        }
+
         SC_ATOMIC_SET(my_pool->return_stack.return_threshold, 1);
+        if (my_pool->stats != NULL)
+            StatsCounterIncr(my_pool->stats, my_pool->counter_waits);
 
         SCMutexLock(&my_pool->return_stack.mutex);
         int rc = 0;
         while (my_pool->return_stack.cnt == 0 && rc == 0) {
-            rc = SCCondWait(&my_pool->return_stack.cond, &my_pool->return_stack.mutex);
+            if (!pool_steal) {
+                rc = SCCondWait(&my_pool->return_stack.cond, &my_pool->return_stack.mutex);
+                continue;
+            }
+
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += PACKET_POOL_STEAL_WAIT_NS;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            rc = SCCondTimedwait(&my_pool->return_stack.cond, &my_pool->return_stack.mutex, &ts);
+            if (rc == ETIMEDOUT) {
+                SCMutexUnlock(&my_pool->return_stack.mutex);
+                if (PacketPoolSteal(my_pool)) {
+                    UpdateReturnThreshold(my_pool);
+                    return;
+                }
+                SCMutexLock(&my_pool->return_stack.mutex);
+                rc = 0;
+            }
         }
         SCMutexUnlock(&my_pool->return_stack.mutex);
 
@@ -97,22 +299,21 @@ static void PacketPoolStorePacket(Packet *p)
     PacketPoolReturnPacket(p);
 }
 
-static void PacketPoolGetReturnedPackets(PktPool *pool)
+static inline void PacketPoolAccountGet(PktPool *pool)
 {
-    SCMutexLock(&pool->return_stack.mutex);
-    /* Move all the packets from the locked return stack to the local stack. */
-    pool->head = pool->return_stack.head;
-    pool->return_stack.head = NULL;
-    pool->cnt += pool->return_stack.cnt;
-    pool->return_stack.cnt = 0;
-    SCMutexUnlock(&pool->return_stack.mutex);
+    const uint32_t in_use = pool->owned - pool->cnt;
+    if (in_use > pool->in_use_max)
+        pool->in_use_max = in_use;
+    if ((++pool->gets & 63) == 0)
+        PacketPoolUpdate(pool);
 }
 
 /** \brief Get a new packet from the packet pool
  *
  * Only allocates from the thread's local stack, or mallocs new packets.
  * If the local stack is empty, first move all the return stack packets to
- * the local stack.
+ * the local stack. If that is empty too, the pool may grow or steal from
+ * other pools, depending on the packet-pool settings.
  *  \retval Packet pointer, or NULL on failure.
  */
 Packet *PacketPoolGetPacket(void)
@@ -128,6 +329,7 @@ Packet *PacketPoolGetPacket(void)
         p->pool = pool;
         PacketReinit(p);
 
+        PacketPoolAccountGet(pool);
         UpdateReturnThreshold(pool);
         SCLogDebug("pp: %0.2f cnt:%u max:%d threshold:%u",
                 ((float)pool->cnt / (float)max_pending_packets) * (float)100, pool->cnt,
@@ -137,7 +339,7 @@ Packet *PacketPoolGetPacket(void)
 
     /* Local Stack is empty, so check the return stack, which requires
      * locking. */
-    PacketPoolGetReturnedPackets(pool);
+    PacketPoolRefill(pool);
 
     /* Try to allocate again. Need to check for not empty again, since the
      * return stack might have been empty too.
@@ -150,6 +352,7 @@ Packet *PacketPoolGetPacket(void)
         p->pool = pool;
         PacketReinit(p);
 
+        PacketPoolAccountGet(pool);
         UpdateReturnThreshold(pool);
         SCLogDebug("pp: %0.2f cnt:%u max:%d threshold:%u",
                 ((float)pool->cnt / (float)max_pending_packets) * (float)100, pool->cnt,
@@ -246,22 +449,59 @@ void PacketPoolInit(void)
     SCCondInit(&my_pool->return_stack.cond, NULL);
     SC_ATOMIC_INIT(my_pool->return_stack.return_threshold);
     SC_ATOMIC_SET(my_pool->return_stack.return_threshold, 32);
-
-    /* pre allocate packets */
+    my_pool->return_batch = MAX_PENDING_RETURN_PACKETS;
+    my_pool->in_use_max = 0;
+    my_pool->gets = 0;
+    my_pool->window_start = StatsLatencyNow();
+
+    /* pre allocate packets. With auto-size the pool grows when needed. */
+    const uint32_t size =
+            pool_auto_size ? MIN(PACKET_POOL_MIN_SIZE, max_pending_packets) : max_pending_packets;
     SCLogDebug("preallocating packets... packet size %" PRIuMAX "",
                (uintmax_t)SIZE_OF_PACKET);
-    for (uint32_t i = 0; i < max_pending_packets; i++) {
+    for (uint32_t i = 0; i < size; i++) {
         Packet *p = PacketGetFromAlloc();
         if (unlikely(p == NULL)) {
             FatalError("Fatal error encountered while allocating a packet. Exiting...");
         }
         PacketPoolStorePacket(p);
+        my_pool->owned++;
+    }
+
+    if (pool_steal) {
+        SCMutexLock(&pool_steal_lock);
+        my_pool->steal_next = pool_steal_list;
+        pool_steal_list = my_pool;
+        SCMutexUnlock(&pool_steal_lock);
     }
 
     //SCLogInfo("preallocated %"PRIiMAX" packets. Total memory %"PRIuMAX"",
     //        max_pending_packets, (uintmax_t)(max_pending_packets*SIZE_OF_PACKET));
 }
 
+/**
+ * \brief remove the thread's pool from the pools other threads steal from
+ *
+ * Called by PacketPoolDestroy(). Threads that exit without destroying
+ * their pool must call it.
+ */
+void PacketPoolUnregister(void)
+{
+    if (!pool_steal)
+        return;
+
+    PktPool *my_pool = GetThreadPacketPool();
+    SCMutexLock(&pool_steal_lock);
+    for (PktPool **pp = &pool_steal_list; *pp != NULL; pp = &(*pp)->steal_next) {
+        if (*pp == my_pool) {
+            *pp = my_pool->steal_next;
+            break;
+        }
+    }
+    my_pool->steal_next = NULL;
+    SCMutexUnlock(&pool_steal_lock);
+}
+
 void PacketPoolDestroy(void)
 {
     Packet *p = NULL;
@@ -271,6 +511,8 @@ void PacketPoolDestroy(void)
     BUG_ON(my_pool && my_pool->destroyed);
 #endif /* DEBUG_VALIDATION */
 
+    PacketPoolUnregister();
+
     if (my_pool && my_pool->pending_pool != NULL) {
         p = my_pool->pending_head;
         while (p) {
@@ -287,9 +529,18 @@ void PacketPoolDestroy(void)
         my_pool->pending_tail = NULL;
     }
 
-    while ((p = PacketPoolGetPacket()) != NULL) {
-        PacketFree(p);
-    }
+    /* free the local stack and the returned packets. Don't use
+     * PacketPoolGetPacket() as it could grow the pool. */
+    do {
+        while ((p = my_pool->head) != NULL) {
+            my_pool->head = p->next;
+            PacketFree(p);
+        }
+        my_pool->cnt = 0;
+        PacketPoolGetReturnedPackets(my_pool);
+    } while (my_pool->head != NULL);
+    my_pool->owned = 0;
+    my_pool->stats = NULL;
 
 #ifdef DEBUG_VALIDATION
     my_pool->initialized = 0;
@@ -297,6 +548,20 @@ void PacketPoolDestroy(void)
 #endif /* DEBUG_VALIDATION */
 }
 
+/**
+ * \brief register the packet pool counters of a thread
+ *
+ * Call after PacketPoolInit() in the thread owning the pool.
+ */
+void PacketPoolStatsSetup(ThreadVars *tv)
+{
+    PktPool *my_pool = GetThreadPacketPool();
+    my_pool->counter_waits = StatsRegisterCounter("packet_pool.waits", &tv->stats);
+    my_pool->counter_stolen = StatsRegisterCounter("packet_pool.stolen", &tv->stats);
+    my_pool->counter_size = StatsRegisterCounter("packet_pool.size", &tv->stats);
+    my_pool->stats = &tv->stats;
+}
+
 Packet *TmqhInputPacketpool(ThreadVars *tv)
 {
     return PacketPoolGetPacket();
@@ -471,3 +736,237 @@ void PacketPoolPostRunmodes(void)
     SCLogDebug("detect threads %u, max packets %u, max_pending_return_packets %u",
             threads, packets, max_pending_return_packets);
 }
+
+#ifdef UNITTESTS
+typedef struct PacketPoolTestCtx_ {
+    bool auto_size;
+    bool steal;
+    uint32_t max_pending;
+    PktPool *steal_list;
+} PacketPoolTestCtx;
+
+static void PacketPoolTestSetup(PacketPoolTestCtx *ctx, uint32_t max_pending)
+{
+    ctx->auto_size = pool_auto_size;
+    ctx->steal = pool_steal;
+    ctx->max_pending = max_pending_packets;
+    ctx->steal_list = pool_steal_list;
+    pool_auto_size = true;
+    pool_steal = true;
+    max_pending_packets = max_pending;
+    pool_steal_list = NULL;
+}
+
+static void PacketPoolTestTeardown(const PacketPoolTestCtx *ctx)
+{
+    pool_auto_size = ctx->auto_size;
+    pool_steal = ctx->steal;
+    max_pending_packets = ctx->max_pending;
+    pool_steal_list = ctx->steal_list;
+}
+
+static void PacketPoolTestInitPool(PktPool *pool)
+{
+    memset(pool, 0, sizeof(*pool));
+    SCMutexInit(&pool->return_stack.mutex, NULL);
+    SCCondInit(&pool->return_stack.cond, NULL);
+    SC_ATOMIC_INIT(pool->return_stack.return_threshold);
+    SC_ATOMIC_SET(pool->return_stack.return_threshold, 32);
+}
+
+/** \internal free the packets on the local and return stacks */
+static void PacketPoolTestFreePool(PktPool *pool)
+{
+    do {
+        Packet *p;
+        while ((p = pool->head) != NULL) {
+            pool->head = p->next;
+            PacketFree(p);
+        }
+        pool->cnt = 0;
+        PacketPoolGetReturnedPackets(pool);
+    } while (pool->head != NULL);
+    SCMutexDestroy(&pool->return_stack.mutex);
+    SCCondDestroy(&pool->return_stack.cond);
+}
+
+static uint32_t PacketPoolTestCount(const Packet *p, const PktPool *pool)
+{
+    uint32_t cnt = 0;
+    for (; p != NULL; p = p->next) {
+        if (p->pool != pool)
+            return 0;
+        cnt++;
+    }
+    return cnt;
+}
+
+/** \test grow in steps up to max-pending-packets */
+static int PacketPoolTestGrow(void)
+{
+    PacketPoolTestCtx ctx;
+    PacketPoolTestSetup(&ctx, 100);
+    PktPool pool;
+    PacketPoolTestInitPool(&pool);
+
+    FAIL_IF_NOT(PacketPoolGrow(&pool));
+    FAIL_IF_NOT(pool.owned == PACKET_POOL_GROW);
+    FAIL_IF_NOT(pool.cnt == PACKET_POOL_GROW);
+    FAIL_IF_NOT(PacketPoolTestCount(pool.head, &pool) == PACKET_POOL_GROW);
+
+    FAIL_IF_NOT(PacketPoolGrow(&pool));
+    FAIL_IF_NOT(pool.owned == 100);
+    FAIL_IF_NOT(pool.cnt == 100);
+
+    FAIL_IF(PacketPoolGrow(&pool));
+    FAIL_IF_NOT(pool.owned == 100);
+
+    /* a fixed size pool doesn't grow */
+    pool_auto_size = false;
+    max_pending_packets = 1000;
+    FAIL_IF(PacketPoolGrow(&pool));
+    FAIL_IF_NOT(pool.owned == 100);
+
+    PacketPoolTestFreePool(&pool);
+    PacketPoolTestTeardown(&ctx);
+    PASS;
+}
+
+/** \test shrink towards twice the packets in use */
+static int PacketPoolTestShrink(void)
+{
+    PacketPoolTestCtx ctx;
+    PacketPoolTestSetup(&ctx, 256);
+    PktPool pool;
+    PacketPoolTestInitPool(&pool);
+
+    while (PacketPoolGrow(&pool))
+        ;
+    FAIL_IF_NOT(pool.owned == 256);
+
+    /* 10 packets in use */
+    Packet *in_use = NULL;
+    for (int i = 0; i < 10; i++) {
+        Packet *p = pool.head;
+        pool.head = p->next;
+        pool.cnt--;
+        p->next = in_use;
+        in_use = p;
+    }
+    pool.in_use_max = 10;
+
+    /* window not over yet */
+    pool.window_start = StatsLatencyNow();
+    PacketPoolUpdate(&pool);
+    FAIL_IF_NOT(pool.owned == 256);
+
+    /* half of the excess over the minimal size is given back */
+    pool.window_start = StatsLatencyNow() - PACKET_POOL_WINDOW_NS;
+    PacketPoolUpdate(&pool);
+    FAIL_IF_NOT(pool.owned == 256 - 96);
+    FAIL_IF_NOT(pool.cnt == 256 - 96 - 10);
+    FAIL_IF_NOT(pool.in_use_max == 10);
+
+    pool.window_start = StatsLatencyNow() - PACKET_POOL_WINDOW_NS;
+    PacketPoolUpdate(&pool);
+    FAIL_IF_NOT(pool.owned == 160 - 48);
+
+    /* never below the minimal size */
+    for (int i = 0; i < 10; i++) {
+        pool.window_start = StatsLatencyNow() - PACKET_POOL_WINDOW_NS;
+        PacketPoolUpdate(&pool);
+    }
+    FAIL_IF_NOT(pool.owned == PACKET_POOL_MIN_SIZE);
+    FAIL_IF_NOT(pool.owned == pool.cnt + 10);
+
+    while (in_use != NULL) {
+        Packet *p = in_use;
+        in_use = p->next;
+        p->next = pool.head;
+        pool.head = p;
+        pool.cnt++;
+    }
+    PacketPoolTestFreePool(&pool);
+    PacketPoolTestTeardown(&ctx);
+    PASS;
+}
+
+/** \test stolen packets move from one pool's accounting to the other */
+static int PacketPoolTestSteal(void)
+{
+    PacketPoolTestCtx ctx;
+    PacketPoolTestSetup(&ctx, 64);
+    PktPool victim, thief;
+    PacketPoolTestInitPool(&victim);
+    PacketPoolTestInitPool(&thief);
+
+    /* 10 packets of victim were returned to it by other threads */
+    FAIL_IF_NOT(PacketPoolGrow(&victim));
+    for (int i = 0; i < 10; i++) {
+        Packet *p = victim.head;
+        victim.head = p->next;
+        victim.cnt--;
+        p->next = victim.return_stack.head;
+        victim.return_stack.head = p;
+        victim.return_stack.cnt++;
+    }
+    FAIL_IF_NOT(victim.owned == 64);
+    FAIL_IF_NOT(victim.cnt == 54);
+
+    /* not registered */
+    FAIL_IF(PacketPoolSteal(&thief));
+
+    victim.steal_next = NULL;
+    thief.steal_next = &victim;
+    pool_steal_list = &thief;
+
+    /* victim is running low itself */
+    SC_ATOMIC_SET(victim.return_stack.return_threshold, 1);
+    FAIL_IF(PacketPoolSteal(&thief));
+    SC_ATOMIC_SET(victim.return_stack.return_threshold, 32);
+
+    FAIL_IF_NOT(PacketPoolSteal(&thief));
+    FAIL_IF_NOT(thief.owned == 5);
+    FAIL_IF_NOT(thief.cnt == 5);
+    FAIL_IF_NOT(PacketPoolTestCount(thief.head, &thief) == 5);
+    FAIL_IF_NOT(victim.return_stack.cnt == 5);
+    FAIL_IF_NOT(victim.return_stack.stolen == 5);
+    /* victim only learns about it when it takes its returned packets */
+    FAIL_IF_NOT(victim.owned == 64);
+
+    /* victim's local stack is empty */
+    Packet *local = victim.head;
+    victim.head = NULL;
+    victim.cnt = 0;
+    PacketPoolGetReturnedPackets(&victim);
+    FAIL_IF_NOT(victim.owned == 59);
+    FAIL_IF_NOT(victim.cnt == 5);
+    FAIL_IF_NOT(victim.return_stack.stolen == 0);
+    FAIL_IF_NOT(victim.return_stack.cnt == 0);
+
+    /* total is unchanged */
+    FAIL_IF_NOT(PacketPoolTestCount(local, &victim) == 54);
+    FAIL_IF_NOT(victim.owned + thief.owned == 64);
+
+    while (local != NULL) {
+        Packet *p = local;
+        local = p->next;
+        p->next = victim.head;
+        victim.head = p;
+        victim.cnt++;
+    }
+    PacketPoolTestFreePool(&victim);
+    PacketPoolTestFreePool(&thief);
+    PacketPoolTestTeardown(&ctx);
+    PASS;
+}
+#endif /* UNITTESTS */
+
+void PacketPoolRegisterTests(void)
+{
+#ifdef UNITTESTS
+    UtRegisterTest("PacketPoolTestGrow", PacketPoolTestGrow);
+    UtRegisterTest("PacketPoolTestShrink", PacketPoolTestShrink);
+    UtRegisterTest("PacketPoolTestSteal", PacketPoolTestSteal);
+#endif
+}
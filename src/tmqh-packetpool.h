@@ -37,6 +37,8 @@ typedef struct PktPoolLockedStack_{
      *  on how full the pool is. */
     SC_ATOMIC_DECLARE(uint32_t, return_threshold);
     uint32_t cnt;
+    /** packets taken by other pools, for the owner's accounting */
+    uint32_t stolen;
     Packet *head;
 } __attribute__((aligned(CLS))) PktPoolLockedStack;
 
@@ -57,6 +59,26 @@ typedef struct PktPool_ {
     Packet *pending_tail;
     uint32_t pending_count;
 
+    /* Sizing, see PacketPoolUpdate(). */
+    /** packets belonging to this pool, wherever they are */
+    uint32_t owned;
+    /** max packets in use during the current window */
+    uint32_t in_use_max;
+    /** cap of the return threshold, based on the packet rate */
+    uint32_t return_batch;
+    /** packets handed out during the current window */
+    uint32_t gets;
+    uint64_t window_start;
+
+    /** stats of the owning thread, NULL if it has none */
+    StatsThreadContext *stats;
+    StatsCounterId counter_waits;
+    StatsCounterId counter_stolen;
+    StatsCounterId counter_size;
+
+    /** next pool in the list of pools to steal from */
+    struct PktPool_ *steal_next;
+
 #ifdef DEBUG_VALIDATION
     int initialized;
     int destroyed;
@@ -80,7 +102,11 @@ Packet *PacketPoolGetPacket(void);
 void PacketPoolWait(void);
 void PacketPoolReturnPacket(Packet *p);
 void PacketPoolInit(void);
+void PacketPoolStatsSetup(ThreadVars *tv);
+void PacketPoolConfig(void);
 void PacketPoolDestroy(void);
+void PacketPoolUnregister(void);
 void PacketPoolPostRunmodes(void);
+void PacketPoolRegisterTests(void);
 
 #endif /* SURICATA_TMQH_PACKETPOOL_H */
@@ -0,0 +1,333 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Adaptive polling for the capture threads. See util-capture-poll.h.
+ */
+
+#include "suricata-common.h"
+#include "conf.h"
+#include "counters.h"
+#include "tm-threads.h"
+#include "util-capture-poll.h"
+
+/** run the capture timeout handling at most this often while idle */
+#define CAPTURE_POLL_TIMEOUT_NS (100 * 1000000ULL)
+#define CAPTURE_POLL_STATS_NS   (1000 * 1000000ULL)
+/** weight of a new idle period in the moving average, as a shift */
+#define CAPTURE_POLL_GAP_SHIFT 3
+
+/** what to do after a poll without packets */
+enum CapturePollStage {
+    CAPTURE_POLL_SPIN = 0,
+    CAPTURE_POLL_PAUSE,
+    CAPTURE_POLL_SLEEP,
+    CAPTURE_POLL_BLOCK,
+};
+
+static inline void CapturePollCpuPause(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+/**
+ * \brief set up the controller of a capture thread
+ *
+ * Reads capture.adaptive-poll. Without it, the controller only runs the
+ * capture timeout handling and the capture source keeps its own idle
+ * strategy.
+ */
+void CapturePollInit(CapturePoll *cp, ThreadVars *tv)
+{
+    memset(cp, 0, sizeof(*cp));
+
+    SCConfNode *node = SCConfGetNode("capture.adaptive-poll");
+    if (node != NULL && SCConfNodeChildValueIsTrue(node, "enabled")) {
+        intmax_t spin = 50, pause = 200, sleep = 1000, sleep_time = 50;
+        (void)SCConfGetChildValueInt(node, "spin", &spin);
+        (void)SCConfGetChildValueInt(node, "pause", &pause);
+        (void)SCConfGetChildValueInt(node, "sleep", &sleep);
+        (void)SCConfGetChildValueInt(node, "sleep-time", &sleep_time);
+        if (spin < 0 || pause < spin || sleep < pause || sleep > 1000000 || sleep_time < 1 ||
+                sleep_time > 100000) {
+            FatalError("invalid capture.adaptive-poll settings: 0 <= spin <= pause <= sleep "
+                       "<= 1000000 and 1 <= sleep-time <= 100000 usecs");
+        }
+        cp->enabled = true;
+        cp->spin_ns = (uint64_t)spin * 1000;
+        cp->pause_ns = (uint64_t)pause * 1000;
+        cp->sleep_ns = (uint64_t)sleep * 1000;
+        cp->sleep_usecs = (uint32_t)sleep_time;
+
+        cp->counter_busy_usecs = StatsRegisterCounter("capture.poll.busy_usecs", &tv->stats);
+        cp->counter_idle_usecs = StatsRegisterCounter("capture.poll.idle_usecs", &tv->stats);
+        cp->counter_busy_pct = StatsRegisterCounter("capture.poll.busy_pct", &tv->stats);
+    }
+
+    const uint64_t now = StatsLatencyNow();
+    cp->last_ns = cp->idle_since_ns = cp->timeout_ns = cp->stats_ns = now;
+}
+
+/** \internal
+ *  \brief account the time since the last call to the previous state */
+static inline void CapturePollAccount(CapturePoll *cp, ThreadVars *tv, const uint64_t now)
+{
+    if (cp->busy)
+        cp->busy_ns += now - cp->last_ns;
+    else
+        cp->idle_ns += now - cp->last_ns;
+    cp->last_ns = now;
+
+    if (now - cp->stats_ns >= CAPTURE_POLL_STATS_NS) {
+        const uint64_t total = cp->busy_ns + cp->idle_ns;
+        StatsCounterAddI64(&tv->stats, cp->counter_busy_usecs, (int64_t)(cp->busy_ns / 1000));
+        StatsCounterAddI64(&tv->stats, cp->counter_idle_usecs, (int64_t)(cp->idle_ns / 1000));
+        if (total > 0) {
+            StatsCounterSetI64(
+                    &tv->stats, cp->counter_busy_pct, (int64_t)(cp->busy_ns * 100 / total));
+        }
+        cp->busy_ns = cp->idle_ns = 0;
+        cp->stats_ns = now;
+    }
+}
+
+static void CapturePollBusyAt(CapturePoll *cp, ThreadVars *tv, const uint64_t now)
+{
+    uint64_t gap = 0;
+    if (!cp->busy) {
+        gap = now - cp->idle_since_ns;
+    }
+    /* back to back polls with packets count as no gap */
+    cp->gap_avg_ns += (gap >> CAPTURE_POLL_GAP_SHIFT) - (cp->gap_avg_ns >> CAPTURE_POLL_GAP_SHIFT);
+
+    CapturePollAccount(cp, tv, now);
+    cp->busy = true;
+}
+
+/**
+ * \brief the last poll returned packets
+ */
+void CapturePollBusy(CapturePoll *cp, ThreadVars *tv)
+{
+    if (cp->enabled)
+        CapturePollBusyAt(cp, tv, StatsLatencyNow());
+}
+
+static inline void CapturePollEnterIdle(CapturePoll *cp, ThreadVars *tv, const uint64_t now)
+{
+    CapturePollAccount(cp, tv, now);
+    if (cp->busy) {
+        cp->busy = false;
+        cp->idle_since_ns = now;
+    }
+}
+
+/**
+ * \brief the thread is about to wait for packets in a blocking way
+ *
+ * Only needed if the source blocks without reporting an empty poll
+ * first, so the wait is counted as idle time.
+ */
+void CapturePollBlock(CapturePoll *cp, ThreadVars *tv)
+{
+    if (cp->enabled && cp->busy)
+        CapturePollEnterIdle(cp, tv, StatsLatencyNow());
+}
+
+/** \internal
+ *  \brief stage of the current idle period at \a now
+ *
+ *  Also runs the capture timeout handling if it is due. */
+static enum CapturePollStage CapturePollIdleAt(CapturePoll *cp, ThreadVars *tv, const uint64_t now)
+{
+    if (cp->enabled)
+        CapturePollEnterIdle(cp, tv, now);
+
+    if (now - cp->timeout_ns >= CAPTURE_POLL_TIMEOUT_NS) {
+        TmThreadsCaptureHandleTimeout(tv, NULL);
+        cp->timeout_ns = now;
+    }
+
+    if (!cp->enabled)
+        return CAPTURE_POLL_BLOCK;
+
+    /* packets arrive too far apart for polling to pay off */
+    if (cp->gap_avg_ns > cp->sleep_ns)
+        return CAPTURE_POLL_BLOCK;
+
+    const uint64_t idle = now - cp->idle_since_ns;
+    if (idle < cp->spin_ns)
+        return CAPTURE_POLL_SPIN;
+    if (idle < cp->pause_ns)
+        return CAPTURE_POLL_PAUSE;
+    if (idle < cp->sleep_ns)
+        return CAPTURE_POLL_SLEEP;
+    return CAPTURE_POLL_BLOCK;
+}
+
+/**
+ * \brief the last poll returned no packets
+ *
+ * Waits according to the stage of the current idle period. Runs the
+ * capture timeout handling every 100ms, so flows handed to the thread
+ * are processed and the outputs are flushed.
+ *
+ * \retval true if the caller should wait for packets in its blocking way.
+ *         Always true if adaptive polling is disabled.
+ * \retval false if the caller should poll again right away
+ */
+bool CapturePollIdle(CapturePoll *cp, ThreadVars *tv)
+{
+    switch (CapturePollIdleAt(cp, tv, StatsLatencyNow())) {
+        case CAPTURE_POLL_SPIN:
+            return false;
+        case CAPTURE_POLL_PAUSE:
+            for (int i = 0; i < 16; i++) {
+                CapturePollCpuPause();
+            }
+            return false;
+        case CAPTURE_POLL_SLEEP:
+            SleepUsec(cp->sleep_usecs);
+            return false;
+        case CAPTURE_POLL_BLOCK:
+            break;
+    }
+    return true;
+}
+
+#ifdef UNITTESTS
+#include "util-unittest.h"
+
+#define US(x) ((uint64_t)(x) * 1000)
+
+/** \internal
+ *  \brief controller with the default settings, started at \a now */
+static void CapturePollTestSetup(CapturePoll *cp, const uint64_t now)
+{
+    memset(cp, 0, sizeof(*cp));
+    cp->enabled = true;
+    cp->spin_ns = US(50);
+    cp->pause_ns = US(200);
+    cp->sleep_ns = US(1000);
+    cp->sleep_usecs = 50;
+    cp->last_ns = cp->idle_since_ns = cp->timeout_ns = cp->stats_ns = now;
+}
+
+/** \test spin, pause, sleep and block stages of an idle period */
+static int CapturePollTest01(void)
+{
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(tv));
+    CapturePoll cp;
+    const uint64_t t = US(1000000);
+    CapturePollTestSetup(&cp, t);
+
+    CapturePollBusyAt(&cp, &tv, t);
+    FAIL_IF_NOT(cp.busy);
+    FAIL_IF_NOT(cp.gap_avg_ns == 0);
+
+    /* the idle period starts with the first empty poll */
+    const uint64_t idle = t + US(10);
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, idle) == CAPTURE_POLL_SPIN);
+    FAIL_IF(cp.busy);
+    FAIL_IF_NOT(cp.idle_since_ns == idle);
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, idle + US(49)) == CAPTURE_POLL_SPIN);
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, idle + US(50)) == CAPTURE_POLL_PAUSE);
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, idle + US(199)) == CAPTURE_POLL_PAUSE);
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, idle + US(200)) == CAPTURE_POLL_SLEEP);
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, idle + US(999)) == CAPTURE_POLL_SLEEP);
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, idle + US(1000)) == CAPTURE_POLL_BLOCK);
+    FAIL_IF_NOT(cp.idle_since_ns == idle);
+
+    /* packets again: the gap enters the average, a new idle period
+     * starts with spinning */
+    CapturePollBusyAt(&cp, &tv, idle + US(1600));
+    FAIL_IF_NOT(cp.gap_avg_ns == US(1600) >> CAPTURE_POLL_GAP_SHIFT);
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, idle + US(1610)) == CAPTURE_POLL_SPIN);
+    FAIL_IF_NOT(cp.idle_since_ns == idle + US(1610));
+    PASS;
+}
+
+/** \test block right away if packets arrive further apart than the
+ *        idle window, spin again once they come in quicker */
+static int CapturePollTest02(void)
+{
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(tv));
+    CapturePoll cp;
+    uint64_t t = US(1000000);
+    CapturePollTestSetup(&cp, t);
+
+    /* packets 5ms apart */
+    for (int i = 0; i < 2; i++) {
+        CapturePollBusyAt(&cp, &tv, t);
+        FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, t + US(1)) == CAPTURE_POLL_SPIN);
+        t += US(5000);
+    }
+    CapturePollBusyAt(&cp, &tv, t);
+    FAIL_IF_NOT(cp.gap_avg_ns > cp.sleep_ns);
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, t + US(1)) == CAPTURE_POLL_BLOCK);
+
+    /* back to back polls with packets bring the average down */
+    t += US(10);
+    CapturePollBusyAt(&cp, &tv, t);
+    while (cp.gap_avg_ns > cp.sleep_ns) {
+        t += US(10);
+        CapturePollBusyAt(&cp, &tv, t);
+    }
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, t + US(1)) == CAPTURE_POLL_SPIN);
+    PASS;
+}
+
+/** \test disabled controller always blocks, both run the capture timeout
+ *        handling every 100ms */
+static int CapturePollTest03(void)
+{
+    ThreadVars tv;
+    memset(&tv, 0, sizeof(tv));
+    CapturePoll cp;
+    const uint64_t t = US(1000000);
+    CapturePollTestSetup(&cp, t);
+
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, t + US(99999)) == CAPTURE_POLL_BLOCK);
+    FAIL_IF_NOT(cp.timeout_ns == t);
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, t + US(100000)) == CAPTURE_POLL_BLOCK);
+    FAIL_IF_NOT(cp.timeout_ns == t + US(100000));
+
+    cp.enabled = false;
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, t + US(100001)) == CAPTURE_POLL_BLOCK);
+    FAIL_IF_NOT(cp.timeout_ns == t + US(100000));
+    FAIL_IF_NOT(CapturePollIdleAt(&cp, &tv, t + US(200000)) == CAPTURE_POLL_BLOCK);
+    FAIL_IF_NOT(cp.timeout_ns == t + US(200000));
+    PASS;
+}
+#endif /* UNITTESTS */
+
+void CapturePollRegisterTests(void)
+{
+#ifdef UNITTESTS
+    UtRegisterTest("CapturePollTest01", CapturePollTest01);
+    UtRegisterTest("CapturePollTest02", CapturePollTest02);
+    UtRegisterTest("CapturePollTest03", CapturePollTest03);
+#endif /* UNITTESTS */
+}
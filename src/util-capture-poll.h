@@ -0,0 +1,77 @@
+/* Copyright (C) 2025 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Adaptive polling for the capture threads.
+ *
+ * After the last packet, a capture thread polls again right away for
+ * `spin` usecs, then does CPU pauses between polls until `pause`, then
+ * sleeps between polls until `sleep` before it goes back to its blocking
+ * wait (poll(), interrupts). If packets arrive further apart than the
+ * whole window, the thread blocks right away.
+ *
+ * When enabled, the controller also counts the time the thread spends busy
+ * and idle. In both cases it runs the capture timeout handling while idle.
+ */
+
+#ifndef SURICATA_UTIL_CAPTURE_POLL_H
+#define SURICATA_UTIL_CAPTURE_POLL_H
+
+#include "threadvars.h"
+
+typedef struct CapturePoll_ {
+    /** capture.adaptive-poll is set */
+    bool enabled;
+    /** the previous poll returned packets */
+    bool busy;
+
+    /* end of each stage after the last packet, in ns */
+    uint64_t spin_ns;
+    uint64_t pause_ns;
+    uint64_t sleep_ns;
+    /** length of a single sleep */
+    uint32_t sleep_usecs;
+
+    uint64_t last_ns;
+    /** start of the current idle period */
+    uint64_t idle_since_ns;
+    /** moving average of the idle periods */
+    uint64_t gap_avg_ns;
+    uint64_t timeout_ns;
+
+    uint64_t busy_ns;
+    uint64_t idle_ns;
+    uint64_t stats_ns;
+    StatsCounterId counter_busy_usecs;
+    StatsCounterId counter_idle_usecs;
+    StatsCounterId counter_busy_pct;
+} CapturePoll;
+
+void CapturePollInit(CapturePoll *cp, ThreadVars *tv);
+void CapturePollBusy(CapturePoll *cp, ThreadVars *tv);
+bool CapturePollIdle(CapturePoll *cp, ThreadVars *tv);
+void CapturePollBlock(CapturePoll *cp, ThreadVars *tv);
+void CapturePollRegisterTests(void);
+
+static inline bool CapturePollEnabled(const CapturePoll *cp)
+{
+    return cp->enabled;
+}
+
+#endif /* SURICATA_UTIL_CAPTURE_POLL_H */
@@ -50,6 +50,7 @@
 #include "flow.h"
 #include "flow-hash.h"
 #include "tm-threads.h"
+#include "runmodes.h"
 
 #include <bpf/libbpf.h>
 #include <bpf/bpf.h>
@@ -71,6 +72,15 @@ struct bpf_map_item {
 struct bpf_maps_info {
     struct bpf_map_item array[BPF_MAP_MAX_COUNT];
     int last;
+#ifdef HAVE_RING_BUFFER__NEW
+    /* consumer of the flow_events map, if the eBPF code has it */
+    struct ring_buffer *flow_events;
+    LiveDevice *livedev;
+    /* stats of the running consumer */
+    struct flows_stats *flow_events_stats;
+#endif
+    uint16_t cpus_count;
+    uint8_t mode;
 };
 
 typedef struct BypassedIfaceList_ {
@@ -78,10 +88,17 @@ typedef struct BypassedIfaceList_ {
     struct BypassedIfaceList_ *next;
 } BypassedIfaceList;
 
+static void EBPFSetupFlowEvents(LiveDevice *livedev, struct bpf_maps_info *bpf_maps);
+
 static void BpfMapsInfoFree(void *bpf)
 {
     struct bpf_maps_info *bpfinfo = (struct bpf_maps_info *)bpf;
     int i;
+#ifdef HAVE_RING_BUFFER__NEW
+    if (bpfinfo->flow_events) {
+        ring_buffer__free(bpfinfo->flow_events);
+    }
+#endif
     for (i = 0; i < bpfinfo->last; i ++) {
         if (bpfinfo->array[i].name) {
             if (bpfinfo->array[i].to_unlink) {
@@ -123,10 +140,37 @@ void EBPFDeleteKey(int fd, void *key)
 {
     int ret = bpf_map_delete_elem(fd, key);
     if (ret < 0) {
+        /* entry can already be removed following a flow end event */
+        if (errno == ENOENT) {
+            SCLogDebug("Entry already deleted");
+            return;
+        }
         SCLogWarning("Unable to delete entry: %s (%d)", strerror(errno), errno);
     }
 }
 
+/**
+ * Delete a set of keys from a map
+ *
+ * \param keys array of count keys of size skey
+ */
+static void EBPFDeleteKeys(int fd, uint8_t *keys, uint32_t count, size_t skey)
+{
+    uint32_t done = 0;
+#ifdef HAVE_BPF_MAP_DELETE_BATCH
+    DECLARE_LIBBPF_OPTS(bpf_map_batch_opts, opts, .elem_flags = 0, .flags = 0);
+    done = count;
+    if (bpf_map_delete_batch(fd, keys, &done, &opts) == 0) {
+        return;
+    }
+    /* done is the number of deleted entries, the next one failed */
+    SCLogDebug("batched delete stopped after %u entries: %s", done, strerror(errno));
+#endif
+    for (uint32_t i = done; i < count; i++) {
+        EBPFDeleteKey(fd, keys + i * skey);
+    }
+}
+
 static struct bpf_maps_info *EBPFGetBpfMap(const char *iface)
 {
     LiveDevice *livedev = LiveGetDevice(iface);
@@ -264,11 +308,23 @@ static int EBPFLoadPinnedMaps(LiveDevice *livedev, struct ebpf_timeout_config *c
         }
         bpf_map_data->last++;
     }
+    fd = EBPFLoadPinnedMapsFile(livedev, "flow_events");
+    if (fd >= 0) {
+        bpf_map_data->array[bpf_map_data->last].fd = fd;
+        bpf_map_data->array[bpf_map_data->last].name = SCStrdup("flow_events");
+        if (bpf_map_data->array[bpf_map_data->last].name == NULL) {
+            goto alloc_error;
+        }
+        bpf_map_data->last++;
+    }
+    bpf_map_data->cpus_count = config->cpus_count;
+    bpf_map_data->mode = config->mode;
 
     /* Attach the bpf_maps_info to the LiveDevice via the device storage */
     SCLiveDevSetStorageById(livedev, g_livedev_storage_id, bpf_map_data);
     /* Declare that device will use bypass stats */
     LiveDevUseBypass(livedev);
+    EBPFSetupFlowEvents(livedev, bpf_map_data);
 
     return 0;
 
@@ -454,9 +510,13 @@ int EBPFLoadFile(const char *iface, const char *path, const char * section,
         bpf_map_data->last++;
     }
 
+    bpf_map_data->cpus_count = config->cpus_count;
+    bpf_map_data->mode = config->mode;
+
     /* Attach the bpf_maps_info to the LiveDevice via the device storage */
     SCLiveDevSetStorageById(livedev, g_livedev_storage_id, bpf_map_data);
     LiveDevUseBypass(livedev);
+    EBPFSetupFlowEvents(livedev, bpf_map_data);
 
     /* Finally we get the file descriptor for our eBPF program. We will use
      * the fd to attach the program to the socket (eBPF case) or to the device
@@ -681,250 +741,388 @@ typedef bool (*OpFlowForKey)(struct flows_stats * flowstats, LiveDevice*dev, voi
                             uint64_t pkts_cnt, uint64_t bytes_cnt,
                             int mapfd, int cpus_count);
 
+/** number of entries fetched per batched map lookup */
+#define EBPF_MAP_BATCH_SIZE 1024
+
+static void EBPFFlowKeyFromV4(
+        const struct flowv4_keys *key, uint8_t mode, const LiveDevice *dev, FlowKey *flow_key)
+{
+    if (mode == AFP_MODE_XDP_BYPASS) {
+        flow_key->sp = ntohs(key->port16[0]);
+        flow_key->dp = ntohs(key->port16[1]);
+        flow_key->src.addr_data32[0] = key->src;
+        flow_key->dst.addr_data32[0] = key->dst;
+    } else {
+        flow_key->sp = key->port16[0];
+        flow_key->dp = key->port16[1];
+        flow_key->src.addr_data32[0] = ntohl(key->src);
+        flow_key->dst.addr_data32[0] = ntohl(key->dst);
+    }
+    flow_key->src.family = AF_INET;
+    flow_key->src.addr_data32[1] = 0;
+    flow_key->src.addr_data32[2] = 0;
+    flow_key->src.addr_data32[3] = 0;
+    flow_key->dst.family = AF_INET;
+    flow_key->dst.addr_data32[1] = 0;
+    flow_key->dst.addr_data32[2] = 0;
+    flow_key->dst.addr_data32[3] = 0;
+    flow_key->vlan_id[0] = key->vlan0;
+    flow_key->vlan_id[1] = key->vlan1;
+    if (key->ip_proto == 1) {
+        flow_key->proto = IPPROTO_TCP;
+    } else {
+        flow_key->proto = IPPROTO_UDP;
+    }
+    flow_key->recursion_level = 0;
+    flow_key->livedev_id = dev->id;
+}
+
+static void EBPFFlowKeyFromV6(
+        const struct flowv6_keys *key, uint8_t mode, const LiveDevice *dev, FlowKey *flow_key)
+{
+    flow_key->src.family = AF_INET6;
+    flow_key->dst.family = AF_INET6;
+    if (mode == AFP_MODE_XDP_BYPASS) {
+        flow_key->sp = ntohs(key->port16[0]);
+        flow_key->dp = ntohs(key->port16[1]);
+        for (int i = 0; i < 4; i++) {
+            flow_key->src.addr_data32[i] = key->src[i];
+            flow_key->dst.addr_data32[i] = key->dst[i];
+        }
+    } else {
+        flow_key->sp = key->port16[0];
+        flow_key->dp = key->port16[1];
+        for (int i = 0; i < 4; i++) {
+            flow_key->src.addr_data32[i] = ntohl(key->src[i]);
+            flow_key->dst.addr_data32[i] = ntohl(key->dst[i]);
+        }
+    }
+    flow_key->vlan_id[0] = key->vlan0;
+    flow_key->vlan_id[1] = key->vlan1;
+    if (key->ip_proto == 1) {
+        flow_key->proto = IPPROTO_TCP;
+    } else {
+        flow_key->proto = IPPROTO_UDP;
+    }
+    flow_key->recursion_level = 0;
+    flow_key->livedev_id = dev->id;
+}
+
 /**
- * Bypassed flows iterator for IPv4
+ * Run the callback function on a map entry
  *
- * This function iterates on all the flows of the IPv4 table
- * running a callback function on each flow.
+ * \param values the per CPU values of the entry
+ * \return true if the entry needs to be deleted
  */
-static int EBPFForEachFlowV4Table(ThreadVars *th_v, LiveDevice *dev, const char *name,
-                                  struct timespec *ctime,
-                                  struct ebpf_timeout_config *tcfg,
-                                  OpFlowForKey EBPFOpFlowForKey
-                                  )
+static bool EBPFOpFlowEntry(struct flows_stats *flowstats, LiveDevice *dev, int family, void *key,
+        const struct pair *values, struct timespec *ctime, struct ebpf_timeout_config *tcfg,
+        OpFlowForKey EBPFOpFlowForKey, int mapfd)
 {
-    struct flows_stats flowstats = { 0, 0, 0};
-    int mapfd = EBPFGetMapFDByName(dev->dev, name);
-    if (mapfd == -1)
-        return -1;
+    uint64_t pkts_cnt = 0;
+    uint64_t bytes_cnt = 0;
+    /* We use a per CPU structure so we will get a array of values. But if nr_cpus
+     * is 1 then we have a global hash. */
+    for (unsigned int i = 0; i < tcfg->cpus_count; i++) {
+        /* let's start accumulating value so we can compute the counters */
+        SCLogDebug("%d: Adding pkts %lu bytes %lu", i, values[i].packets, values[i].bytes);
+        pkts_cnt += values[i].packets;
+        bytes_cnt += values[i].bytes;
+    }
+    /* Get the corresponding Flow in the Flow table to compare and update
+     * its counters and lastseen if needed */
+    FlowKey flow_key;
+    size_t skey;
+    if (family == AF_INET) {
+        EBPFFlowKeyFromV4(key, tcfg->mode, dev, &flow_key);
+        skey = sizeof(struct flowv4_keys);
+    } else {
+        EBPFFlowKeyFromV6(key, tcfg->mode, dev, &flow_key);
+        skey = sizeof(struct flowv6_keys);
+    }
+    return EBPFOpFlowForKey(flowstats, dev, key, skey, &flow_key, ctime, pkts_cnt, bytes_cnt,
+            mapfd, tcfg->cpus_count);
+}
 
-    struct flowv4_keys key = {}, next_key;
+#ifdef HAVE_BPF_MAP_LOOKUP_BATCH
+/**
+ * Bypassed flows iterator using batched lookups
+ *
+ * Fetches up to EBPF_MAP_BATCH_SIZE entries per system call instead of
+ * two calls per entry.
+ *
+ * \return 1 if entries were deleted, 0 if not, -1 if batched lookups are
+ *         not supported by the kernel and no entry was handled
+ */
+static int EBPFForEachFlowTableBatch(ThreadVars *th_v, LiveDevice *dev, int mapfd, int family,
+        struct timespec *ctime, struct ebpf_timeout_config *tcfg, OpFlowForKey EBPFOpFlowForKey,
+        struct flows_stats *flowstats, uint64_t *hash_cnt)
+{
+    const size_t skey = family == AF_INET ? sizeof(struct flowv4_keys) : sizeof(struct flowv6_keys);
+    uint8_t *keys = SCCalloc(EBPF_MAP_BATCH_SIZE, skey);
+    uint8_t *dead_keys = SCCalloc(EBPF_MAP_BATCH_SIZE, skey);
+    /* per CPU values are 8 bytes aligned, which struct pair already is */
+    struct pair *values = SCCalloc(EBPF_MAP_BATCH_SIZE * tcfg->cpus_count, sizeof(struct pair));
     int found = 0;
-    unsigned int i;
-    uint64_t hash_cnt = 0;
-
-    if (tcfg->cpus_count == 0) {
-        return 0;
+    if (keys == NULL || dead_keys == NULL || values == NULL) {
+        found = -1;
+        goto end;
     }
 
-    bool dead_flow = false;
-    while (bpf_map_get_next_key(mapfd, &key, &next_key) == 0) {
-        uint64_t bytes_cnt = 0;
-        uint64_t pkts_cnt = 0;
-        hash_cnt++;
-        if (dead_flow) {
-            EBPFDeleteKey(mapfd, &key);
-            dead_flow = false;
-        }
-        /* We use a per CPU structure so we will get a array of values. But if nr_cpus
-         * is 1 then we have a global hash. */
-        BPF_DECLARE_PERCPU(struct pair, values_array, tcfg->cpus_count);
-        memset(values_array, 0, sizeof(values_array));
-        int res = bpf_map_lookup_elem(mapfd, &next_key, values_array);
+    DECLARE_LIBBPF_OPTS(bpf_map_batch_opts, opts, .elem_flags = 0, .flags = 0);
+    /* opaque position in the map, the kernel uses a bucket index for hashes */
+    uint64_t in_batch = 0, out_batch = 0;
+    bool first = true;
+    while (1) {
+        uint32_t count = EBPF_MAP_BATCH_SIZE;
+        bool last = false;
+        int res = bpf_map_lookup_batch(
+                mapfd, first ? NULL : &in_batch, &out_batch, keys, values, &count, &opts);
         if (res < 0) {
-            SCLogDebug("no entry in v4 table for %d -> %d", key.port16[0], key.port16[1]);
-            SCLogDebug("errno: (%d) %s", errno, strerror(errno));
-            key = next_key;
-            continue;
-        }
-        for (i = 0; i < tcfg->cpus_count; i++) {
-            /* let's start accumulating value so we can compute the counters */
-            SCLogDebug("%d: Adding pkts %lu bytes %lu", i,
-                       BPF_PERCPU(values_array, i).packets,
-                       BPF_PERCPU(values_array, i).bytes);
-            pkts_cnt += BPF_PERCPU(values_array, i).packets;
-            bytes_cnt += BPF_PERCPU(values_array, i).bytes;
-        }
-        /* Get the corresponding Flow in the Flow table to compare and update
-         * its counters and lastseen if needed */
-        FlowKey flow_key;
-        if (tcfg->mode == AFP_MODE_XDP_BYPASS) {
-            flow_key.sp = ntohs(next_key.port16[0]);
-            flow_key.dp = ntohs(next_key.port16[1]);
-            flow_key.src.addr_data32[0] = next_key.src;
-            flow_key.dst.addr_data32[0] = next_key.dst;
-        } else {
-            flow_key.sp = next_key.port16[0];
-            flow_key.dp = next_key.port16[1];
-            flow_key.src.addr_data32[0] = ntohl(next_key.src);
-            flow_key.dst.addr_data32[0] = ntohl(next_key.dst);
+            if (errno == ENOENT) {
+                /* end of the map, count holds the last entries */
+                last = true;
+            } else {
+                if (first && (errno == EINVAL || errno == ENOTSUP || errno == EOPNOTSUPP)) {
+                    found = -1;
+                } else {
+                    SCLogWarning("Unable to walk %s flow table: %s (%d)",
+                            family == AF_INET ? "IPv4" : "IPv6", strerror(errno), errno);
+                }
+                break;
+            }
         }
-        flow_key.src.family = AF_INET;
-        flow_key.src.addr_data32[1] = 0;
-        flow_key.src.addr_data32[2] = 0;
-        flow_key.src.addr_data32[3] = 0;
-        flow_key.dst.family = AF_INET;
-        flow_key.dst.addr_data32[1] = 0;
-        flow_key.dst.addr_data32[2] = 0;
-        flow_key.dst.addr_data32[3] = 0;
-        flow_key.vlan_id[0] = next_key.vlan0;
-        flow_key.vlan_id[1] = next_key.vlan1;
-        if (next_key.ip_proto == 1) {
-            flow_key.proto = IPPROTO_TCP;
-        } else {
-            flow_key.proto = IPPROTO_UDP;
+
+        uint32_t dead_cnt = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            (*hash_cnt)++;
+            void *key = keys + i * skey;
+            if (EBPFOpFlowEntry(flowstats, dev, family, key, values + i * tcfg->cpus_count, ctime,
+                        tcfg, EBPFOpFlowForKey, mapfd)) {
+                memcpy(dead_keys + dead_cnt * skey, key, skey);
+                dead_cnt++;
+            }
         }
-        flow_key.recursion_level = 0;
-        flow_key.livedev_id = dev->id;
-        dead_flow = EBPFOpFlowForKey(&flowstats, dev, &next_key, sizeof(next_key), &flow_key,
-                                     ctime, pkts_cnt, bytes_cnt,
-                                     mapfd, tcfg->cpus_count);
-        if (dead_flow) {
+        if (dead_cnt > 0) {
+            EBPFDeleteKeys(mapfd, dead_keys, dead_cnt, skey);
             found = 1;
         }
 
-        if (TmThreadsCheckFlag(th_v, THV_KILL)) {
-            return 0;
+        if (last || TmThreadsCheckFlag(th_v, THV_KILL)) {
+            break;
         }
-
-        key = next_key;
-    }
-    if (dead_flow) {
-        EBPFDeleteKey(mapfd, &key);
-        found = 1;
+        in_batch = out_batch;
+        first = false;
     }
-    SC_ATOMIC_ADD(dev->bypassed, flowstats.packets);
-
-    LiveDevAddBypassStats(dev, flowstats.count, AF_INET);
-    SCLogInfo("IPv4 bypassed flow table size: %" PRIu64, hash_cnt);
-
+end:
+    SCFree(keys);
+    SCFree(dead_keys);
+    SCFree(values);
     return found;
 }
+#endif
 
 /**
- * Bypassed flows iterator for IPv6
+ * Bypassed flows iterator
  *
- * This function iterates on all the flows of the IPv4 table
+ * This function iterates on all the flows of the IPv4 or IPv6 table
  * running a callback function on each flow.
  */
-static int EBPFForEachFlowV6Table(ThreadVars *th_v,
-                                  LiveDevice *dev, const char *name,
-                                  struct timespec *ctime,
-                                  struct ebpf_timeout_config *tcfg,
-                                  OpFlowForKey EBPFOpFlowForKey
-                                  )
+static int EBPFForEachFlowTable(ThreadVars *th_v, LiveDevice *dev, const char *name, int family,
+        struct timespec *ctime, struct ebpf_timeout_config *tcfg, OpFlowForKey EBPFOpFlowForKey)
 {
     struct flows_stats flowstats = { 0, 0, 0};
     int mapfd = EBPFGetMapFDByName(dev->dev, name);
     if (mapfd == -1)
         return -1;
 
-    struct flowv6_keys key = {}, next_key;
-    int found = 0;
-    unsigned int i;
-    uint64_t hash_cnt = 0;
-
     if (tcfg->cpus_count == 0) {
         SCLogWarning("CPU count should not be 0");
         return 0;
     }
 
-    uint64_t pkts_cnt = 0;
-    while (bpf_map_get_next_key(mapfd, &key, &next_key) == 0) {
-        uint64_t bytes_cnt = 0;
-        hash_cnt++;
-        if (pkts_cnt > 0) {
-            EBPFDeleteKey(mapfd, &key);
-        }
-        pkts_cnt = 0;
-        /* We use a per CPU structure so we will get a array of values. But if nr_cpus
-         * is 1 then we have a global hash. */
-        BPF_DECLARE_PERCPU(struct pair, values_array, tcfg->cpus_count);
-        memset(values_array, 0, sizeof(values_array));
-        int res = bpf_map_lookup_elem(mapfd, &next_key, values_array);
-        if (res < 0) {
-            SCLogDebug("no entry in v4 table for %d -> %d", key.port16[0], key.port16[1]);
-            key = next_key;
-            continue;
-        }
-        for (i = 0; i < tcfg->cpus_count; i++) {
-            /* let's start accumulating value so we can compute the counters */
-            SCLogDebug("%d: Adding pkts %lu bytes %lu", i,
-                       BPF_PERCPU(values_array, i).packets,
-                       BPF_PERCPU(values_array, i).bytes);
-            pkts_cnt += BPF_PERCPU(values_array, i).packets;
-            bytes_cnt += BPF_PERCPU(values_array, i).bytes;
-        }
-        /* Get the corresponding Flow in the Flow table to compare and update
-         * its counters and lastseen if needed */
-        FlowKey flow_key;
-        if (tcfg->mode == AFP_MODE_XDP_BYPASS) {
-            flow_key.sp = ntohs(next_key.port16[0]);
-            flow_key.dp = ntohs(next_key.port16[1]);
-            flow_key.src.family = AF_INET6;
-            flow_key.src.addr_data32[0] = next_key.src[0];
-            flow_key.src.addr_data32[1] = next_key.src[1];
-            flow_key.src.addr_data32[2] = next_key.src[2];
-            flow_key.src.addr_data32[3] = next_key.src[3];
-            flow_key.dst.family = AF_INET6;
-            flow_key.dst.addr_data32[0] = next_key.dst[0];
-            flow_key.dst.addr_data32[1] = next_key.dst[1];
-            flow_key.dst.addr_data32[2] = next_key.dst[2];
-            flow_key.dst.addr_data32[3] = next_key.dst[3];
-        } else {
-            flow_key.sp = next_key.port16[0];
-            flow_key.dp = next_key.port16[1];
-            flow_key.src.family = AF_INET6;
-            flow_key.src.addr_data32[0] = ntohl(next_key.src[0]);
-            flow_key.src.addr_data32[1] = ntohl(next_key.src[1]);
-            flow_key.src.addr_data32[2] = ntohl(next_key.src[2]);
-            flow_key.src.addr_data32[3] = ntohl(next_key.src[3]);
-            flow_key.dst.family = AF_INET6;
-            flow_key.dst.addr_data32[0] = ntohl(next_key.dst[0]);
-            flow_key.dst.addr_data32[1] = ntohl(next_key.dst[1]);
-            flow_key.dst.addr_data32[2] = ntohl(next_key.dst[2]);
-            flow_key.dst.addr_data32[3] = ntohl(next_key.dst[3]);
-        }
-        flow_key.vlan_id[0] = next_key.vlan0;
-        flow_key.vlan_id[1] = next_key.vlan1;
-        if (next_key.ip_proto == 1) {
-            flow_key.proto = IPPROTO_TCP;
-        } else {
-            flow_key.proto = IPPROTO_UDP;
+    int found = -1;
+    uint64_t hash_cnt = 0;
+#ifdef HAVE_BPF_MAP_LOOKUP_BATCH
+    found = EBPFForEachFlowTableBatch(
+            th_v, dev, mapfd, family, ctime, tcfg, EBPFOpFlowForKey, &flowstats, &hash_cnt);
+#endif
+    if (found == -1) {
+        /* one entry at a time: the current key can only be deleted once we
+         * got the next one */
+        union {
+            struct flowv4_keys v4;
+            struct flowv6_keys v6;
+        } key, next_key;
+        memset(&key, 0, sizeof(key));
+        const size_t skey = family == AF_INET ? sizeof(key.v4) : sizeof(key.v6);
+        bool dead_flow = false;
+        found = 0;
+        while (bpf_map_get_next_key(mapfd, &key, &next_key) == 0) {
+            hash_cnt++;
+            if (dead_flow) {
+                EBPFDeleteKey(mapfd, &key);
+                dead_flow = false;
+            }
+            BPF_DECLARE_PERCPU(struct pair, values_array, tcfg->cpus_count);
+            memset(values_array, 0, sizeof(values_array));
+            int res = bpf_map_lookup_elem(mapfd, &next_key, values_array);
+            if (res < 0) {
+                SCLogDebug("no entry in flow table: (%d) %s", errno, strerror(errno));
+                memcpy(&key, &next_key, skey);
+                continue;
+            }
+            struct pair values[tcfg->cpus_count];
+            for (unsigned int i = 0; i < tcfg->cpus_count; i++) {
+                values[i] = BPF_PERCPU(values_array, i);
+            }
+            dead_flow = EBPFOpFlowEntry(&flowstats, dev, family, &next_key, values, ctime, tcfg,
+                    EBPFOpFlowForKey, mapfd);
+            if (dead_flow) {
+                found = 1;
+            }
+
+            if (TmThreadsCheckFlag(th_v, THV_KILL)) {
+                return 0;
+            }
+
+            memcpy(&key, &next_key, skey);
         }
-        flow_key.recursion_level = 0;
-        flow_key.livedev_id = dev->id;
-        pkts_cnt = EBPFOpFlowForKey(&flowstats, dev, &next_key, sizeof(next_key), &flow_key,
-                                    ctime, pkts_cnt, bytes_cnt,
-                                    mapfd, tcfg->cpus_count);
-        if (pkts_cnt > 0) {
+        if (dead_flow) {
+            EBPFDeleteKey(mapfd, &key);
             found = 1;
         }
-
-        if (TmThreadsCheckFlag(th_v, THV_KILL)) {
-            return 0;
-        }
-
-        key = next_key;
-    }
-    if (pkts_cnt > 0) {
-        EBPFDeleteKey(mapfd, &key);
-        found = 1;
     }
     SC_ATOMIC_ADD(dev->bypassed, flowstats.packets);
 
-    LiveDevAddBypassStats(dev, flowstats.count, AF_INET6);
-    SCLogInfo("IPv6 bypassed flow table size: %" PRIu64, hash_cnt);
+    LiveDevAddBypassStats(dev, flowstats.count, family);
+    SCLogInfo("%s bypassed flow table size: %" PRIu64, family == AF_INET ? "IPv4" : "IPv6",
+            hash_cnt);
+
     return found;
 }
 
-
 int EBPFCheckBypassedFlowCreate(ThreadVars *th_v, struct timespec *curtime, void *data)
 {
     LiveDevice *ldev = NULL, *ndev;
     struct ebpf_timeout_config *cfg = (struct ebpf_timeout_config *)data;
     while(LiveDeviceForEach(&ldev, &ndev)) {
-        EBPFForEachFlowV4Table(th_v, ldev, "flow_table_v4",
-                curtime,
-                cfg, EBPFCreateFlowForKey);
-        EBPFForEachFlowV6Table(th_v, ldev, "flow_table_v6",
-                curtime,
-                cfg, EBPFCreateFlowForKey);
+        EBPFForEachFlowTable(th_v, ldev, "flow_table_v4", AF_INET, curtime, cfg,
+                EBPFCreateFlowForKey);
+        EBPFForEachFlowTable(th_v, ldev, "flow_table_v6", AF_INET6, curtime, cfg,
+                EBPFCreateFlowForKey);
     }
 
     return 0;
 }
 
+#ifdef HAVE_RING_BUFFER__NEW
+/**
+ * Handle a flow end event from the eBPF code
+ *
+ * The eBPF code saw a TCP FIN or RST on a bypassed half flow. The counters
+ * of the Flow are updated one last time and the entry is removed from the
+ * map so it doesn't take a slot until the flow times out.
+ */
+static int EBPFHandleFlowEvent(void *ctx, void *data, size_t size)
+{
+    struct bpf_maps_info *bpf_maps = (struct bpf_maps_info *)ctx;
+    LiveDevice *dev = bpf_maps->livedev;
+    struct flow_event *ev = (struct flow_event *)data;
+    if (size < sizeof(*ev) || ev->type != EBPF_FLOW_EVENT_END) {
+        return 0;
+    }
+
+    FlowKey flow_key;
+    void *key;
+    size_t skey;
+    int mapfd;
+    if (ev->family == 4) {
+        key = &ev->key.v4;
+        skey = sizeof(struct flowv4_keys);
+        mapfd = EBPFGetMapFDByName(dev->dev, "flow_table_v4");
+        EBPFFlowKeyFromV4(&ev->key.v4, bpf_maps->mode, dev, &flow_key);
+    } else {
+        key = &ev->key.v6;
+        skey = sizeof(struct flowv6_keys);
+        mapfd = EBPFGetMapFDByName(dev->dev, "flow_table_v6");
+        EBPFFlowKeyFromV6(&ev->key.v6, bpf_maps->mode, dev, &flow_key);
+    }
+    if (mapfd == -1) {
+        return 0;
+    }
+
+    Flow *f = FlowGetExistingFlowFromFlowKey(&flow_key, FlowKeyGetHash(&flow_key));
+    if (f != NULL) {
+        FlowBypassInfo *fc = SCFlowGetStorageById(f, GetFlowBypassInfoID());
+        EBPFBypassData *eb = fc ? (EBPFBypassData *)fc->bypass_data : NULL;
+        if (eb != NULL && fc->BypassUpdate == EBPFBypassUpdate) {
+            for (int i = 0; i < 2; i++) {
+                if (eb->key[i] && memcmp(eb->key[i], key, skey) == 0) {
+                    (void)EBPFBypassCheckHalfFlow(f, fc, eb, key, i);
+                    break;
+                }
+            }
+        }
+        FLOWLOCK_UNLOCK(f);
+    }
+    if (bpf_map_delete_elem(mapfd, key) == 0) {
+        bpf_maps->flow_events_stats->count++;
+    }
+    return 0;
+}
+
+/**
+ * Consume the flow events of all the devices
+ */
+static int EBPFCheckBypassedFlowEvents(
+        ThreadVars *th_v, struct flows_stats *bypassstats, struct timespec *curtime, void *data)
+{
+    LiveDevice *ldev = NULL, *ndev;
+    while (LiveDeviceForEach(&ldev, &ndev)) {
+        struct bpf_maps_info *bpf_maps = EBPFGetBpfMap(ldev->dev);
+        if (bpf_maps == NULL || bpf_maps->flow_events == NULL) {
+            continue;
+        }
+        bpf_maps->flow_events_stats = bypassstats;
+        int res = ring_buffer__consume(bpf_maps->flow_events);
+        if (res < 0) {
+            SCLogDebug("%s: unable to consume flow events: %d", ldev->dev, res);
+        }
+        bpf_maps->flow_events_stats = NULL;
+        if (TmThreadsCheckFlag(th_v, THV_KILL)) {
+            break;
+        }
+    }
+    return bypassstats->count > 0;
+}
+
+static void EBPFSetupFlowEvents(LiveDevice *livedev, struct bpf_maps_info *bpf_maps)
+{
+    static bool registered = false;
+    int fd = EBPFGetMapFDByName(livedev->dev, "flow_events");
+    if (fd == -1) {
+        return;
+    }
+    bpf_maps->livedev = livedev;
+    bpf_maps->flow_events = ring_buffer__new(fd, EBPFHandleFlowEvent, bpf_maps, NULL);
+    if (bpf_maps->flow_events == NULL) {
+        SCLogWarning("%s: unable to set up flow events: %s", livedev->dev, strerror(errno));
+        return;
+    }
+    SCLogConfig("%s: removing ended flows from the bypass tables on eBPF events", livedev->dev);
+    if (!registered) {
+        RunModeEnablesBypassManager();
+        BypassedFlowManagerRegisterCheckFunc(EBPFCheckBypassedFlowEvents, NULL, NULL);
+        registered = true;
+    }
+}
+
+#else
+static void EBPFSetupFlowEvents(LiveDevice *livedev, struct bpf_maps_info *bpf_maps)
+{
+}
+#endif
+
 void EBPFRegisterExtension(void)
 {
     g_livedev_storage_id = SCLiveDevStorageRegister("bpfmap", BpfMapsInfoFree);
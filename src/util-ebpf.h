@@ -64,6 +64,21 @@ struct pair {
     uint64_t bytes;
 };
 
+/* event sent by the eBPF code through the flow_events ring buffer when a
+ * bypassed TCP flow sees a FIN or a RST */
+#define EBPF_FLOW_EVENT_END 1
+
+struct flow_event {
+    __u8 type;
+    /* 4 or 6 */
+    __u8 family;
+    __u16 pad;
+    union {
+        struct flowv4_keys v4;
+        struct flowv6_keys v6;
+    } key;
+};
+
 typedef struct EBPFBypassData_ {
     void *key[2];
     int mapfd;
@@ -989,6 +989,11 @@ int FileCloseFilePtr(File *ff, const StreamingBufferConfig *sbcfg, const uint8_t
         SCReturnInt(-1);
     }
 
+    /* caller dropped data of this file */
+    if (flags & FILE_HAS_GAPS) {
+        FileFlagGap(ff);
+    }
+
     ff->size += data_len;
     if (data != NULL) {
         if (AppendData(sbcfg, ff, data, data_len) != 0) {
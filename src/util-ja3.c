@@ -225,13 +225,15 @@ char *Ja3GenerateHash(JA3Buffer *buffer)
         return NULL;
     }
 
-    char *ja3_hash = SCMalloc(SC_MD5_HEX_LEN + 1);
+    char *ja3_hash = SCMalloc(JA3_HEX_LEN + 1);
     if (ja3_hash == NULL) {
         SCLogError("Error allocating memory for JA3 hash");
         return NULL;
     }
 
-    SCMd5HashBufferToHex((unsigned char *)buffer->data, buffer->used, ja3_hash, SC_MD5_HEX_LEN + 1);
+    /* served from the per-thread cache for handshakes seen before */
+    SCJA3GetHash((const uint8_t *)buffer->data, buffer->used, (uint8_t(*)[JA3_HEX_LEN])ja3_hash);
+    ja3_hash[JA3_HEX_LEN] = '\0';
     return ja3_hash;
 }
 
@@ -272,12 +274,11 @@ InspectionBuffer *Ja3DetectGetHash(DetectEngineThreadCtx *det_ctx,
         if (b == NULL || b_len == 0)
             return NULL;
 
-        uint8_t ja3_hash[SC_MD5_HEX_LEN + 1];
-        // this adds a final zero
-        SCMd5HashBufferToHex(b, b_len, (char *)ja3_hash, SC_MD5_HEX_LEN + 1);
+        uint8_t ja3_hash[JA3_HEX_LEN];
+        SCJA3GetHash(b, b_len, &ja3_hash);
 
         InspectionBufferSetup(det_ctx, list_id, buffer, NULL, 0);
-        InspectionBufferCopy(buffer, ja3_hash, SC_MD5_HEX_LEN);
+        InspectionBufferCopy(buffer, ja3_hash, JA3_HEX_LEN);
         InspectionBufferApplyTransforms(det_ctx, buffer, transforms);
     }
     return buffer;
@@ -95,6 +95,8 @@ static int GetCertNotBefore(lua_State *luastate, bool client, const SSLState *ss
         connp = &ssl_state->server_connp;
     }
 
+    SSLStateCertDecode(connp, SSL_CERT0_FIELDS);
+
     if (connp->cert0_not_before == 0)
         return LuaCallbackError(luastate, "error: no certificate NotBefore");
 
@@ -131,6 +133,8 @@ static int GetCertNotAfter(lua_State *luastate, bool client, const SSLState *ssl
         connp = &ssl_state->server_connp;
     }
 
+    SSLStateCertDecode(connp, SSL_CERT0_FIELDS);
+
     if (connp->cert0_not_after == 0)
         return LuaCallbackError(luastate, "error: no certificate NotAfter");
 
@@ -166,6 +170,8 @@ static int GetCertInfo(lua_State *luastate, bool client, const SSLState *ssl_sta
         connp = &ssl_state->server_connp;
     }
 
+    SSLStateCertDecode(connp, SSL_CERT0_ALL);
+
     if (connp->cert0_subject == NULL)
         return LuaCallbackError(luastate, "error: no cert");
 
@@ -288,6 +294,7 @@ static int GetCertSerial(lua_State *luastate, bool client)
     } else {
         connp = &s->state->server_connp;
     }
+    SSLStateCertDecode(connp, SSL_CERT0_FIELDS);
     if (connp->cert0_serial == NULL)
         return LuaCallbackError(luastate, "error: no certificate serial");
 
@@ -38,6 +38,11 @@
  * between all detect engines, detect engine versions and tenants.
  * Each variable name is ref counted.
  *
+ * Flowbits are numbered separately from the other variable types, so their
+ * ids are dense and can be used as index in the per flow bitset. The other
+ * types share a single id space, as e.g. flowvars and flowints are stored in
+ * the same per flow list.
+ *
  * During the freeing of a detect engine / tenant, unregistration decreases
  * the ref cnt.
  *
@@ -68,6 +73,7 @@ typedef struct VarNameStore_ {
     HashListTable *names;
     HashListTable *ids;
     uint32_t max_id;
+    uint32_t max_flowbit_id;
     SCTime_t free_after;
     TAILQ_ENTRY(VarNameStore_) next;
 } VarNameStore;
@@ -85,7 +91,7 @@ typedef struct VariableName_ {
 #define VARID_HASHSIZE 0x1000
 
 static SCMutex base_lock = SCMUTEX_INITIALIZER;
-static VarNameStore base = { .names = NULL, .ids = NULL, .max_id = 0 };
+static VarNameStore base = { .names = NULL, .ids = NULL, .max_id = 0, .max_flowbit_id = 0 };
 static TAILQ_HEAD(, VarNameStore_) free_list = TAILQ_HEAD_INITIALIZER(free_list);
 static SC_ATOMIC_DECLARE(VarNameStorePtr, active);
 
@@ -147,6 +153,7 @@ void VarNameStoreDestroy(void)
     HashListTableFree(base.names);
     base.names = NULL;
     base.max_id = 0;
+    base.max_flowbit_id = 0;
     SCMutexUnlock(&base_lock);
 }
 
@@ -171,7 +178,10 @@ uint32_t VarNameStoreRegister(const char *name, const enum VarTypes type)
             vn->name = SCStrdup(name);
             if (vn->name != NULL) {
                 vn->ref_cnt = 1;
-                id = vn->id = ++base.max_id;
+                if (type == VAR_TYPE_FLOW_BIT)
+                    id = vn->id = ++base.max_flowbit_id;
+                else
+                    id = vn->id = ++base.max_id;
                 HashListTableAdd(base.names, (void *)vn, 0);
                 HashListTableAdd(base.ids, (void *)vn, 0);
                 SCLogDebug(